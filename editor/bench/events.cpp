@@ -0,0 +1,209 @@
+#include "game/ecs/world.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+
+using namespace simcoe;
+using namespace game;
+
+// what events add to spawning and destroying a wave of entities, with nothing listening,
+// with every event sent straight away, and with create and attach events queued for one flush.
+// the channels are also timed on their own against the multimap of std::functions they replaced.
+// usage: bench-events [max wave size]
+
+namespace {
+    using BenchClock = std::chrono::steady_clock;
+
+    constexpr size_t kRuns = 5;
+    constexpr size_t kTypes = 16;
+    constexpr size_t kListeners = 2;
+
+    struct Transform : IComponent {
+        Transform(ComponentData data, float x, float y)
+            : IComponent(data)
+            , x(x)
+            , y(y)
+        { }
+
+        float x;
+        float y;
+    };
+
+    struct Lifetime : IComponent {
+        Lifetime(ComponentData data, float remaining)
+            : IComponent(data)
+            , remaining(remaining)
+        { }
+
+        float remaining;
+    };
+
+    enum Mode { eSilent, eSend, eQueue };
+
+    const char *getModeName(Mode mode) {
+        switch (mode) {
+        case eSilent: return "no listeners";
+        case eSend: return "send";
+        case eQueue: return "queue";
+        default: return "unknown";
+        }
+    }
+
+    double median(std::vector<double>& times) {
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+
+    double nsPerItem(BenchClock::time_point start, BenchClock::time_point end, size_t count) {
+        return std::chrono::duration<double, std::nano>(end - start).count() / double(count);
+    }
+
+    struct Wave {
+        double spawn; ///< ns per entity
+        double flush; ///< ns per entity, only when queueing
+        double destroy; ///< ns per entity
+    };
+
+    Wave benchWave(Mode mode, size_t count) {
+        World world;
+        size_t seen = 0;
+
+        if (mode != eSilent) {
+            for (size_t i = 0; i < kListeners; i++) {
+                world.onCreate<Transform>([&](Transform*) { seen += 1; });
+                world.onAttach<Transform>([&](EntityPtr, Transform*) { seen += 1; });
+                world.onDestroy<Transform>([&](Transform*) { seen += 1; });
+                world.onCreate<Lifetime>([&](Lifetime*) { seen += 1; });
+                world.onDestroy<Lifetime>([&](Lifetime*) { seen += 1; });
+            }
+        }
+
+        world.setQueueEvents(mode == eQueue);
+
+        std::vector<EntityHandle> handles(count);
+        std::vector<double> spawns;
+        std::vector<double> flushes;
+        std::vector<double> destroys;
+
+        for (size_t run = 0; run < kRuns; run++) {
+            auto start = BenchClock::now();
+            for (size_t i = 0; i < count; i++) {
+                handles[i] = world.entity("wave")
+                    .add<Transform>(float(i), 0.f)
+                    .add<Lifetime>(1.f)
+                    .getHandle();
+            }
+
+            auto spawned = BenchClock::now();
+            world.flushEvents();
+
+            auto flushed = BenchClock::now();
+            for (EntityHandle handle : handles) {
+                world.destroy(handle);
+            }
+
+            auto end = BenchClock::now();
+            spawns.push_back(nsPerItem(start, spawned, count));
+            flushes.push_back(nsPerItem(spawned, flushed, count));
+            destroys.push_back(nsPerItem(flushed, end, count));
+        }
+
+        // 2 creates, 1 attach and 2 destroys per entity for each set of listeners
+        size_t expected = (mode == eSilent) ? 0 : kRuns * count * kListeners * 5;
+        if (seen != expected) {
+            std::printf("  %s: listeners saw %zu events, expected %zu\n", getModeName(mode), seen, expected);
+        }
+
+        return { median(spawns), median(flushes), median(destroys) };
+    }
+
+    struct Event {
+        size_t value;
+    };
+
+    // how listeners were stored before the event channels, one lookup per event
+    struct MultimapBus {
+        using ListenerFn = std::function<void(const Event&)>;
+
+        void listen(size_t typeId, ListenerFn fn) {
+            listeners.emplace(typeId, std::move(fn));
+        }
+
+        void send(size_t typeId, const Event& event) {
+            auto [begin, end] = listeners.equal_range(typeId);
+            for (auto it = begin; it != end; ++it) {
+                it->second(event);
+            }
+        }
+
+        std::unordered_multimap<size_t, ListenerFn> listeners;
+    };
+
+    // @return ns per event, delivered to every listener of its type
+    template<typename B, typename F>
+    double benchDispatch(size_t count, F&& dispatch) {
+        B bus;
+        size_t total = 0;
+
+        for (size_t typeId = 0; typeId < kTypes; typeId++) {
+            for (size_t i = 0; i < kListeners; i++) {
+                bus.listen(typeId, [&](const Event& event) { total += event.value; });
+            }
+        }
+
+        std::vector<double> times;
+        for (size_t run = 0; run < kRuns; run++) {
+            auto start = BenchClock::now();
+            dispatch(bus, count);
+            times.push_back(nsPerItem(start, BenchClock::now(), count));
+        }
+
+        if (total == 0) std::printf("  no events delivered\n");
+        return median(times);
+    }
+}
+
+int main(int argc, const char **argv) {
+    size_t most = 100000;
+    if (argc > 1) most = std::max<size_t>(std::strtoull(argv[1], nullptr, 10), 1);
+
+    std::printf("spawn and destroy waves, 2 components per entity, %zu listeners per event\n", kListeners);
+    for (size_t count = 1000; count <= most; count *= 10) {
+        for (Mode mode : { eSilent, eSend, eQueue }) {
+            Wave wave = benchWave(mode, count);
+            std::printf("  wave=%-8zu %-13s spawn=%7.1fns flush=%7.1fns destroy=%7.1fns per entity\n",
+                count, getModeName(mode), wave.spawn, wave.flush, wave.destroy);
+        }
+    }
+
+    std::printf("dispatch alone, %zu types with %zu listeners each\n", kTypes, kListeners);
+    for (size_t count = 1000; count <= most * 10; count *= 10) {
+        double multimap = benchDispatch<MultimapBus>(count, [](MultimapBus& bus, size_t events) {
+            for (size_t i = 0; i < events; i++) {
+                bus.send(i % kTypes, { i });
+            }
+        });
+
+        double send = benchDispatch<EventChannel<Event>>(count, [](EventChannel<Event>& bus, size_t events) {
+            for (size_t i = 0; i < events; i++) {
+                bus.send(i % kTypes, { i });
+            }
+        });
+
+        double queue = benchDispatch<EventChannel<Event>>(count, [](EventChannel<Event>& bus, size_t events) {
+            for (size_t i = 0; i < events; i++) {
+                bus.queue(i % kTypes, { i });
+            }
+
+            bus.flush([](const Event&) { return true; });
+        });
+
+        std::printf("  events=%-9zu multimap=%6.1fns channel send=%6.1fns queue and flush=%6.1fns per event\n",
+            count, multimap, send, queue);
+    }
+
+    return 0;
+}
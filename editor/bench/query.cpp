@@ -0,0 +1,132 @@
+#include "engine/service/service.h"
+#include "engine/threads/service.h"
+
+#include "game/ecs/world.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace simcoe;
+using namespace game;
+
+// time to walk a query as the world grows, serially and across the worker pool,
+// with every entity in one archetype and spread over 16.
+// usage: bench-query [max entities]
+
+namespace {
+    using BenchClock = std::chrono::steady_clock;
+
+    constexpr size_t kRuns = 7;
+
+    struct Position : IComponent {
+        Position(ComponentData data, float x, float y)
+            : IComponent(data)
+            , x(x)
+            , y(y)
+        { }
+
+        float x;
+        float y;
+    };
+
+    struct Velocity : IComponent {
+        Velocity(ComponentData data, float x, float y)
+            : IComponent(data)
+            , x(x)
+            , y(y)
+        { }
+
+        float x;
+        float y;
+    };
+
+    // only there to split entities into more archetypes
+    template<size_t N>
+    struct Tag : IComponent {
+        using IComponent::IComponent;
+    };
+
+    template<size_t N>
+    void addTag(EntityBuilder<IEntity>& builder, size_t bits) {
+        if (bits & (1 << N)) builder.add<Tag<N>>();
+    }
+
+    void spawn(World& world, size_t count, bool bSpread) {
+        for (size_t i = 0; i < count; i++) {
+            EntityBuilder<IEntity> builder = world.entity("bench")
+                .add<Position>(float(i), 0.f)
+                .add<Velocity>(1.f, 0.5f);
+
+            if (bSpread) {
+                addTag<0>(builder, i);
+                addTag<1>(builder, i);
+                addTag<2>(builder, i);
+                addTag<3>(builder, i);
+            }
+        }
+    }
+
+    void step(Position *pPosition, const Velocity *pVelocity) {
+        pPosition->x += pVelocity->x * 0.016f;
+        pPosition->y += pVelocity->y * 0.016f;
+    }
+
+    // @return the median time of @p run in nanoseconds per entity
+    template<typename F>
+    double measure(size_t count, F&& run) {
+        run();
+
+        std::vector<double> times;
+        for (size_t i = 0; i < kRuns; i++) {
+            auto start = BenchClock::now();
+            run();
+            times.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - start).count());
+        }
+
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2] / double(count);
+    }
+
+    void benchQuery(size_t count, bool bSpread) {
+        World world;
+        spawn(world, count, bSpread);
+
+        auto& query = world.query<Position, Velocity>();
+
+        double serial = measure(count, [&] {
+            for (auto [pEntity, pPosition, pVelocity] : query) {
+                step(pPosition, pVelocity);
+            }
+        });
+
+        world.setFrozen(true);
+        double parallel = measure(count, [&] {
+            query.parallelEach([](EntityPtr, Position *pPosition, Velocity *pVelocity) {
+                step(pPosition, pVelocity);
+            });
+        });
+        world.setFrozen(false);
+
+        std::printf("entities=%-8zu archetypes=%-3zu serial=%7.2fns parallel=%7.2fns per entity (%.1fms / %.1fms)\n",
+            count, query.getMatches().size(), serial, parallel,
+            serial * double(count) / 1e6, parallel * double(count) / 1e6);
+    }
+}
+
+int main(int argc, const char **argv) {
+    size_t most = 1000000;
+    if (argc > 1) most = std::max<size_t>(std::strtoull(argv[1], nullptr, 10), 1);
+
+    // the parallel loops need the worker pool
+    ServiceRuntime runtime{{}};
+    std::printf("workers=%zu\n", ThreadService::getWorkerCount());
+
+    for (size_t count = 10000; count <= most; count *= 10) {
+        benchQuery(count, false);
+        benchQuery(count, true);
+    }
+
+    return 0;
+}
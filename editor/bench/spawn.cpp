@@ -0,0 +1,243 @@
+#include "game/ecs/world.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+
+using namespace simcoe;
+using namespace game;
+
+// spawn and destroy throughput of the world against a new and delete per object,
+// then the cost of walking every object after a few hundred frames of churn.
+// theres no portable way to read cache miss counters, so iteration is also timed with
+// the cache flushed first, where the time is mostly spent waiting on memory.
+// usage: bench-spawn [entities] [churn per frame]
+
+namespace {
+    using BenchClock = std::chrono::steady_clock;
+
+    constexpr size_t kRuns = 5;
+    constexpr size_t kChurnFrames = 200;
+    constexpr size_t kFlushSize = 64 * 1024 * 1024;
+
+    struct Transform : IComponent {
+        Transform(ComponentData data, float x, float y)
+            : IComponent(data)
+            , x(x)
+            , y(y)
+        { }
+
+        float x;
+        float y;
+        float dx = 1.f;
+        float dy = 0.5f;
+    };
+
+    struct Lifetime : IComponent {
+        Lifetime(ComponentData data, float remaining)
+            : IComponent(data)
+            , remaining(remaining)
+        { }
+
+        float remaining;
+    };
+
+    // the same objects made the way the world used to, one heap allocation each.
+    // padded out to the size of the world objects so only where they live differs
+    struct HeapObject {
+        virtual ~HeapObject() = default;
+        std::byte header[sizeof(IComponent) - sizeof(void*)];
+    };
+
+    struct HeapTransform : HeapObject { float x = 0.f, y = 0.f, dx = 1.f, dy = 0.5f; };
+    struct HeapLifetime : HeapObject { float remaining = 1.f; };
+
+    struct HeapEntity : HeapObject {
+        HeapEntity(float x)
+            : pTransform(new HeapTransform())
+            , pLifetime(new HeapLifetime())
+        {
+            pTransform->x = x;
+        }
+
+        ~HeapEntity() override {
+            delete pTransform;
+            delete pLifetime;
+        }
+
+        HeapTransform *pTransform;
+        HeapLifetime *pLifetime;
+    };
+
+    static_assert(sizeof(HeapTransform) == sizeof(Transform));
+    static_assert(sizeof(HeapLifetime) == sizeof(Lifetime));
+
+    struct HeapWorld {
+        HeapEntity *spawn(float x) {
+            return entities.emplace_back(new HeapEntity(x));
+        }
+
+        void destroyOldest() {
+            delete entities.front();
+            entities.pop_front();
+        }
+
+        ~HeapWorld() {
+            while (!entities.empty()) destroyOldest();
+        }
+
+        std::deque<HeapEntity*> entities;
+    };
+
+    struct EcsWorld {
+        EntityHandle spawn(float x) {
+            EntityHandle handle = world.entity("bullet")
+                .add<Transform>(x, 0.f)
+                .add<Lifetime>(1.f)
+                .getHandle();
+
+            return entities.emplace_back(handle);
+        }
+
+        void destroyOldest() {
+            world.destroy(entities.front());
+            entities.pop_front();
+        }
+
+        World world;
+        std::deque<EntityHandle> entities;
+    };
+
+    void step(float& x, float& y, float dx, float dy, float& remaining) {
+        x += dx * 0.016f;
+        y += dy * 0.016f;
+        remaining -= 0.016f;
+    }
+
+    void walk(HeapWorld& heap) {
+        for (HeapEntity *pEntity : heap.entities) {
+            HeapTransform *pTransform = pEntity->pTransform;
+            step(pTransform->x, pTransform->y, pTransform->dx, pTransform->dy, pEntity->pLifetime->remaining);
+        }
+    }
+
+    void walk(EcsWorld& ecs) {
+        for (auto [pEntity, pTransform, pLifetime] : ecs.world.query<Transform, Lifetime>()) {
+            step(pTransform->x, pTransform->y, pTransform->dx, pTransform->dy, pLifetime->remaining);
+        }
+    }
+
+    std::vector<std::byte> gFlush(kFlushSize);
+
+    // push everything the walk touched out of the cache
+    void flushCache() {
+        for (size_t i = 0; i < gFlush.size(); i += 64) {
+            gFlush[i] = std::byte(size_t(gFlush[i]) + 1);
+        }
+    }
+
+    double median(std::vector<double>& times) {
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+
+    struct Throughput {
+        double spawn; ///< ns per entity
+        double destroy; ///< ns per entity
+    };
+
+    // spawn then destroy everything, repeated so later runs reuse whatever the first kept
+    template<typename W>
+    Throughput benchThroughput(size_t count) {
+        W world;
+        std::vector<double> spawns;
+        std::vector<double> destroys;
+
+        for (size_t run = 0; run < kRuns; run++) {
+            auto start = BenchClock::now();
+            for (size_t i = 0; i < count; i++) {
+                world.spawn(float(i));
+            }
+
+            auto middle = BenchClock::now();
+            for (size_t i = 0; i < count; i++) {
+                world.destroyOldest();
+            }
+
+            auto end = BenchClock::now();
+            spawns.push_back(std::chrono::duration<double, std::nano>(middle - start).count() / double(count));
+            destroys.push_back(std::chrono::duration<double, std::nano>(end - middle).count() / double(count));
+        }
+
+        return { median(spawns), median(destroys) };
+    }
+
+    struct Churn {
+        double frame; ///< us per frame of destroying and respawning
+        double warm; ///< ns per entity to walk with the cache warm
+        double cold; ///< ns per entity to walk after flushing the cache
+    };
+
+    // a steady population where the oldest objects die and new ones spawn every frame, like bullets
+    template<typename W>
+    Churn benchChurn(size_t count, size_t perFrame) {
+        W world;
+        for (size_t i = 0; i < count; i++) {
+            world.spawn(float(i));
+        }
+
+        auto start = BenchClock::now();
+        for (size_t frame = 0; frame < kChurnFrames; frame++) {
+            for (size_t i = 0; i < perFrame; i++) {
+                world.destroyOldest();
+                world.spawn(float(i));
+            }
+        }
+
+        double frame = std::chrono::duration<double, std::micro>(BenchClock::now() - start).count() / kChurnFrames;
+
+        std::vector<double> warm;
+        std::vector<double> cold;
+        for (size_t run = 0; run < kRuns; run++) {
+            walk(world);
+
+            auto warmStart = BenchClock::now();
+            walk(world);
+            warm.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - warmStart).count() / double(count));
+
+            flushCache();
+
+            auto coldStart = BenchClock::now();
+            walk(world);
+            cold.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - coldStart).count() / double(count));
+        }
+
+        return { frame, median(warm), median(cold) };
+    }
+}
+
+int main(int argc, const char **argv) {
+    size_t count = 100000;
+    size_t perFrame = 2000;
+
+    if (argc > 1) count = std::max<size_t>(std::strtoull(argv[1], nullptr, 10), 1);
+    if (argc > 2) perFrame = std::clamp<size_t>(std::strtoull(argv[2], nullptr, 10), 1, count);
+
+    Throughput heap = benchThroughput<HeapWorld>(count);
+    Throughput ecs = benchThroughput<EcsWorld>(count);
+
+    std::printf("spawn then destroy, entities=%zu (2 components each, %zu and %zu bytes)\n", count, sizeof(Transform), sizeof(Lifetime));
+    std::printf("  new/delete       spawn=%8.1fns destroy=%8.1fns per entity\n", heap.spawn, heap.destroy);
+    std::printf("  world            spawn=%8.1fns destroy=%8.1fns per entity\n", ecs.spawn, ecs.destroy);
+
+    Churn heapChurn = benchChurn<HeapWorld>(count, perFrame);
+    Churn ecsChurn = benchChurn<EcsWorld>(count, perFrame);
+
+    std::printf("churn, entities=%zu replaced per frame=%zu frames=%zu\n", count, perFrame, kChurnFrames);
+    std::printf("  new/delete       frame=%8.1fus walk warm=%6.2fns cold=%6.2fns per entity\n", heapChurn.frame, heapChurn.warm, heapChurn.cold);
+    std::printf("  world            frame=%8.1fus walk warm=%6.2fns cold=%6.2fns per entity\n", ecsChurn.frame, ecsChurn.warm, ecsChurn.cold);
+
+    return 0;
+}
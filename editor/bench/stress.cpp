@@ -0,0 +1,144 @@
+#include "engine/service/service.h"
+#include "engine/threads/service.h"
+
+#include "game/ecs/world.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace simcoe;
+using namespace game;
+
+// spawns a million entities a burst per frame, then destroys and spawns them all again.
+// the same run with pages made whenever a storage runs out, made ahead of time on a worker,
+// and reserved up front, to show how much of each frame goes on growing the storages.
+// usage: bench-stress [entities] [per frame]
+
+namespace {
+    using namespace std::chrono_literals;
+    using BenchClock = std::chrono::steady_clock;
+
+    // the rest of a frame, when the page worker gets to run
+    constexpr auto kFrameGap = 1ms;
+
+    struct Transform : IComponent {
+        Transform(ComponentData data, float x, float y)
+            : IComponent(data)
+            , x(x)
+            , y(y)
+        { }
+
+        float x;
+        float y;
+    };
+
+    enum Mode { eSync, eWorker, eReserve };
+
+    const char *getModeName(Mode mode) {
+        switch (mode) {
+        case eSync: return "sync";
+        case eWorker: return "worker";
+        case eReserve: return "reserve";
+        default: return "unknown";
+        }
+    }
+
+    struct Frames {
+        double mean = 0.0; ///< ms
+        double p99 = 0.0; ///< ms
+        double max = 0.0; ///< ms
+    };
+
+    Frames summarise(std::vector<double>& times) {
+        std::sort(times.begin(), times.end());
+
+        double total = 0.0;
+        for (double time : times) total += time;
+
+        return { total / double(times.size()), times[(times.size() * 99) / 100], times.back() };
+    }
+
+    // run @p frame once per frame until @p count entities have been through it
+    template<typename F>
+    Frames runFrames(size_t count, size_t perFrame, F&& frame) {
+        std::vector<double> times;
+        for (size_t first = 0; first < count; first += perFrame) {
+            size_t last = std::min(first + perFrame, count);
+
+            auto start = BenchClock::now();
+            frame(first, last);
+            times.push_back(std::chrono::duration<double, std::milli>(BenchClock::now() - start).count());
+
+            std::this_thread::sleep_for(kFrameGap);
+        }
+
+        return summarise(times);
+    }
+
+    void printStats(const char *pzName, const StorageStats& stats) {
+        std::printf("    %-10s pages=%-6zu reserved=%-6zu background=%-6zu sync=%-6zu\n",
+            pzName, stats.pages, stats.reservedPages, stats.backgroundPages, stats.syncPages);
+    }
+
+    void benchStress(Mode mode, size_t count, size_t perFrame) {
+        World world;
+
+        if (mode == eWorker) {
+            world.setPageWorker([](std::function<void()> fn) {
+                ThreadService::enqueueWork("ecs-page", std::move(fn));
+            });
+        }
+
+        double reserveTime = 0.0;
+        if (mode == eReserve) {
+            auto start = BenchClock::now();
+            world.reserve<IEntity>(count);
+            world.reserve<Transform>(count);
+            reserveTime = std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+        }
+
+        std::vector<EntityHandle> handles(count);
+
+        Frames spawn = runFrames(count, perFrame, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) {
+                handles[i] = world.entity("stress").add<Transform>(float(i), 0.f).getHandle();
+            }
+        });
+
+        // every slot freed by the destroys is reused, so nothing grows the second time
+        Frames respawn = runFrames(count, perFrame, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) {
+                world.destroy(handles[i]);
+                handles[i] = world.entity("stress").add<Transform>(float(i), 0.f).getHandle();
+            }
+        });
+
+        std::printf("%-8s reserve=%.1fms\n", getModeName(mode), reserveTime);
+        std::printf("  spawn     frame mean=%7.2fms p99=%7.2fms max=%7.2fms\n", spawn.mean, spawn.p99, spawn.max);
+        std::printf("  respawn   frame mean=%7.2fms p99=%7.2fms max=%7.2fms\n", respawn.mean, respawn.p99, respawn.max);
+        printStats("entities", world.entities.getStats());
+        printStats("transform", world.objects.at(makeTypeInfo<Transform>(&world)).getStats());
+        std::printf("    archetype chunks=%zu\n", world.archetypes.getStats().chunks);
+    }
+}
+
+int main(int argc, const char **argv) {
+    size_t count = 1000000;
+    size_t perFrame = 10000;
+
+    if (argc > 1) count = std::max<size_t>(std::strtoull(argv[1], nullptr, 10), 1);
+    if (argc > 2) perFrame = std::clamp<size_t>(std::strtoull(argv[2], nullptr, 10), 1, count);
+
+    // the page worker runs on the worker pool
+    ServiceRuntime runtime{{}};
+
+    std::printf("entities=%zu per frame=%zu\n", count, perFrame);
+    benchStress(eSync, count, perFrame);
+    benchStress(eWorker, count, perFrame);
+    benchStress(eReserve, count, perFrame);
+
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include "editor/ui/components/buffer.h"
 
 #include "engine/threads/mutex.h"
+#include "engine/threads/timer.h"
 #include "vendor/ryzenmonitor/service.h"
 
 namespace editor::ui {
@@ -25,6 +26,7 @@ namespace editor::ui {
 
     struct RyzenMonitorUi final : ServiceUi {
         RyzenMonitorUi();
+        ~RyzenMonitorUi();
 
         void draw() override;
         void drawWindow() override;
@@ -68,5 +70,8 @@ namespace editor::ui {
 
         simcoe::Clock clock;
         float lastUpdate = 0.f;
+
+        // polls the monitor while the panel is alive
+        simcoe::threads::TimerHandle updateJob;
     };
 }
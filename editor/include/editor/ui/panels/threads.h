@@ -13,6 +13,7 @@ namespace editor::ui {
 
     private:
         void drawPackage(const ts::Package& package) const;
+        void drawLocks() const;
         ts::CoreIndex getFastestCore(const ts::Chiplet& chiplet) const;
 
         int workers = 0;
@@ -0,0 +1,291 @@
+#pragma once
+
+#include "engine/core/macros.h"
+
+#include "game/ecs/typeinfo.h"
+
+#include <map>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace game {
+    struct Archetype;
+    struct QueryBase;
+    struct ObjectStorage;
+
+    // the component types an archetype holds, sorted by type id
+    using Signature = std::vector<size_t>;
+
+    // where an entities components live, owned by the entity and kept up to date by the archetype storage
+    struct EntityLocation {
+        Archetype *pArchetype = nullptr;
+        uint32_t row = 0;
+    };
+
+    /**
+     * @brief how one component type is stored in archetype columns
+     * owned components live in the column itself and move whenever their row does,
+     * their storage slot is pointed at the new address each time so handles keep resolving.
+     * shared components, like meshes and textures, have a size of zero and are held by pointer.
+     */
+    struct ColumnLayout {
+        size_t size = 0;
+        size_t align = 0;
+
+        // move the component in @p pSrc into the uninitialized @p pDst and destroy what was left in @p pSrc
+        ComponentPtr (*pfnRelocate)(void *pDst, void *pSrc) = nullptr;
+
+        // the component constructed in @p pSlot
+        ComponentPtr (*pfnGet)(void *pSlot) = nullptr;
+
+        // the storage that hands out handles to these components
+        ObjectStorage *pStorage = nullptr;
+
+        bool isOwned() const { return size != 0; }
+
+        template<typename C>
+        static ColumnLayout of(ObjectStorage *pStorage) {
+            return {
+                .size = sizeof(C),
+                .align = alignof(C),
+                .pfnRelocate = [](void *pDst, void *pSrc) -> ComponentPtr {
+                    C *pComponent = std::launder(static_cast<C*>(pSrc));
+                    C *pMoved = new (pDst) C(std::move(*pComponent));
+                    pComponent->~C();
+                    return pMoved;
+                },
+                .pfnGet = [](void *pSlot) -> ComponentPtr {
+                    return std::launder(static_cast<C*>(pSlot));
+                },
+                .pStorage = pStorage
+            };
+        }
+    };
+
+    struct ArchetypeStats {
+        size_t archetypes = 0; ///< distinct component sets seen so far
+        size_t chunks = 0; ///< chunks allocated across every archetype
+        size_t rows = 0; ///< entities stored across every archetype
+        size_t moves = 0; ///< entities moved between archetypes by adding a component
+    };
+
+    /**
+     * @brief every entity with the same set of components
+     * rows are packed into fixed size chunks, each chunk stores one contiguous column per
+     * component type plus a column of the owning entities.
+     * owned components are stored by value in their column, so iterating a query walks
+     * the components themselves. shared components are stored as pointers.
+     *
+     * the archetype moves owned components between rows but never constructs or destroys them,
+     * a row being erased must have had its owned components destroyed or moved out already.
+     */
+    struct Archetype {
+        SM_NOCOPY(Archetype)
+
+        static constexpr uint32_t kChunkRows = 128;
+        static constexpr uint16_t kInvalidColumn = UINT16_MAX;
+
+        // @param layouts the layout of each type in @param signature
+        Archetype(Signature signature, std::vector<ColumnLayout> layouts);
+
+        const Signature& getSignature() const { return signature; }
+
+        size_t getColumnCount() const { return signature.size(); }
+        size_t getChunkCount() const { return chunks.size(); }
+        uint32_t getSize() const { return used; }
+
+        uint16_t getColumn(size_t typeId) const {
+            return (typeId < columns.size()) ? columns[typeId] : kInvalidColumn;
+        }
+
+        bool has(size_t typeId) const { return getColumn(typeId) != kInvalidColumn; }
+
+        ComponentPtr getComponent(size_t typeId, uint32_t row) const {
+            uint16_t column = getColumn(typeId);
+            if (column == kInvalidColumn) return nullptr;
+
+            return getComponentAt(column, row);
+        }
+
+        ComponentPtr getComponentAt(size_t column, uint32_t row) const {
+            void *pSlot = getSlot(column, row);
+            const ColumnLayout& layout = layouts[column];
+
+            return layout.isOwned() ? layout.pfnGet(pSlot) : *static_cast<ComponentPtr*>(pSlot);
+        }
+
+        // the component in @param column of @param row, @tparam C must be the columns type
+        template<typename C>
+        C *getAt(size_t column, uint32_t row) const {
+            void *pSlot = getSlot(column, row);
+
+            if (layouts[column].isOwned()) {
+                return std::launder(static_cast<C*>(pSlot));
+            }
+
+            return static_cast<C*>(*static_cast<ComponentPtr*>(pSlot));
+        }
+
+        bool isOwnedColumn(size_t column) const { return layouts[column].isOwned(); }
+
+        EntityPtr getEntity(uint32_t row) const {
+            SM_ASSERTF(row < used, "archetype row {} out of range", row);
+            return chunks[row / kChunkRows]->entities[row % kChunkRows];
+        }
+
+        // add a row for @param pEntity with every shared component null
+        // and every owned component unconstructed, @return the row
+        uint32_t insert(EntityPtr pEntity);
+
+        /**
+         * @brief remove a row by moving the last row into it
+         * @return the entity that was moved into @param row, nullptr if it was the last row
+         */
+        EntityPtr erase(uint32_t row);
+
+        // set the shared component in @param column of @param row
+        void setComponentAt(size_t column, uint32_t row, ComponentPtr pComponent);
+
+        // the memory in @param column of @param row
+        void *getSlot(size_t column, uint32_t row) const {
+            SM_ASSERTF(row < used, "archetype row {} out of range", row);
+            SM_ASSERTF(column < getColumnCount(), "archetype column {} out of range", column);
+
+            return chunks[row / kChunkRows]->getSlot(offsets[column], strides[column], row % kChunkRows);
+        }
+
+        // move the owned component in @param srcColumn of @param srcRow in @param pSrc into @param column of @param row
+        void relocate(size_t column, uint32_t row, const Archetype *pSrc, size_t srcColumn, uint32_t srcRow);
+
+        // the archetype with @param typeId added, nullptr if it hasnt been built yet
+        Archetype *getAddEdge(size_t typeId) const {
+            return (typeId < addEdges.size()) ? addEdges[typeId] : nullptr;
+        }
+
+        void setAddEdge(size_t typeId, Archetype *pArchetype);
+
+    private:
+        struct MemoryDelete {
+            size_t align;
+            void operator()(std::byte *pMemory) const { ::operator delete[](pMemory, std::align_val_t(align)); }
+        };
+
+        struct Chunk {
+            Chunk(size_t size, size_t align)
+                : memory(static_cast<std::byte*>(::operator new[](size, std::align_val_t(align))), MemoryDelete{ align })
+            { }
+
+            void *getSlot(size_t offset, size_t stride, size_t slot) const { return memory.get() + offset + slot * stride; }
+
+            EntityPtr entities[kChunkRows] = {};
+
+            // every column back to back, each one kChunkRows slots long
+            std::unique_ptr<std::byte[], MemoryDelete> memory;
+        };
+
+        // move the components of @param src into @param dst, both in this archetype
+        void moveRow(uint32_t dst, uint32_t src);
+
+        Signature signature;
+        std::vector<ColumnLayout> layouts;
+
+        // where each column starts in a chunk and how far apart its slots are
+        std::vector<size_t> offsets;
+        std::vector<size_t> strides;
+
+        size_t chunkSize = 0;
+        size_t chunkAlign = alignof(ComponentPtr);
+
+        // type id -> column, kInvalidColumn for types this archetype doesnt have
+        std::vector<uint16_t> columns;
+
+        // type id -> archetype with that type added
+        std::vector<Archetype*> addEdges;
+
+        std::vector<std::unique_ptr<Chunk>> chunks;
+        uint32_t used = 0;
+    };
+
+    // the components of a single entity, in column order
+    struct RowComponents {
+        struct Iterator {
+            Iterator(const Archetype *pArchetype, uint32_t row, size_t column)
+                : pArchetype(pArchetype)
+                , row(row)
+                , column(column)
+            { }
+
+            Iterator& operator++() { ++column; return *this; }
+            ComponentPtr operator*() const { return pArchetype->getComponentAt(column, row); }
+            bool operator==(const Iterator& other) const { return column == other.column; }
+
+        private:
+            const Archetype *pArchetype;
+            uint32_t row;
+            size_t column;
+        };
+
+        RowComponents(EntityLocation location)
+            : location(location)
+        { }
+
+        Iterator begin() const { return Iterator(location.pArchetype, location.row, 0); }
+        Iterator end() const { return Iterator(location.pArchetype, location.row, size()); }
+
+        size_t size() const { return location.pArchetype ? location.pArchetype->getColumnCount() : 0; }
+
+    private:
+        EntityLocation location;
+    };
+
+    /**
+     * @brief owns every archetype in a world and moves entities between them
+     * archetypes are only ever created, never freed, so an entity location
+     * stays valid until that entity has a component added or is removed,
+     * and a query never has to forget an archetype it matched.
+     */
+    struct ArchetypeStorage {
+        SM_NOCOPY(ArchetypeStorage)
+
+        ArchetypeStorage() = default;
+
+        // how components of @param typeId are stored, set before the first one is attached.
+        // types without a layout are shared and held by pointer
+        void setLayout(size_t typeId, ColumnLayout layout);
+        bool isOwned(size_t typeId) const { return typeId < layouts.size() && layouts[typeId].isOwned(); }
+
+        // set the shared @param pComponent on @param pEntity, moving the entity to a new archetype if it didnt have that type yet
+        void attach(EntityPtr pEntity, ComponentPtr pComponent);
+
+        /**
+         * @brief make room for an owned component of @param typeId on @param pEntity
+         * the entity is moved to a new archetype if it didnt have that type yet.
+         * @return the memory to construct the component in, if the entity already had one
+         *         it must be destroyed before the new one is constructed
+         */
+        void *emplace(EntityPtr pEntity, size_t typeId);
+
+        // drop @param pEntity from whichever archetype it is in
+        void remove(EntityPtr pEntity);
+
+        // match @param pQuery against every archetype now and every archetype created from now on
+        void addQuery(QueryBase *pQuery);
+
+        const std::map<Signature, std::unique_ptr<Archetype>>& getArchetypes() const { return archetypes; }
+
+        ArchetypeStats getStats() const;
+
+    private:
+        Archetype *getArchetype(const Signature& signature);
+        Archetype *getWithAdded(Archetype *pArchetype, size_t typeId);
+
+        // move @param pEntity to the archetype with @param typeId added, @return its column there
+        size_t moveToAdded(EntityPtr pEntity, size_t typeId);
+
+        std::map<Signature, std::unique_ptr<Archetype>> archetypes;
+        std::vector<ColumnLayout> layouts; // type id -> layout
+        std::vector<QueryBase*> queries;
+        size_t moves = 0;
+    };
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "engine/threads/mutex.h"
+
+#include "game/ecs/handle.h"
+
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace game {
+    namespace mt = simcoe::mt;
+
+    using CommandFn = std::function<void(World&)>;
+
+    struct CommandStats {
+        size_t batches = 0; ///< sync points that had anything to apply
+        size_t creates = 0; ///< create commands run
+        size_t attaches = 0; ///< components attached
+        size_t destroys = 0; ///< entities destroyed
+        size_t skipped = 0; ///< commands dropped because their entity was already gone
+        size_t lastBatch = 0; ///< commands in the most recent batch
+        size_t buffers = 0; ///< threads that have recorded into this queue
+    };
+
+    /**
+     * @brief structural changes recorded by one thread, applied later at a sync point
+     * recording never touches the world, so it is safe from inside any system and any query loop.
+     * commands are recorded while holding the world lock, shared is enough.
+     */
+    struct CommandBuffer {
+        // destroy @param handle, destroying the same entity twice is fine
+        void destroy(EntityHandle handle) { destroys.push_back(handle); }
+
+        // attach a shared component, like a mesh or texture, to @param handle
+        void attach(EntityHandle handle, ComponentPtr pComponent) { attaches.push_back({ handle, pComponent }); }
+
+        // run @param fn with the world once it is safe to create entities
+        void create(CommandFn fn) { creates.push_back(std::move(fn)); }
+
+        size_t size() const { return destroys.size() + attaches.size() + creates.size(); }
+
+    private:
+        friend struct CommandQueue;
+
+        CommandBuffer(std::thread::id owner)
+            : owner(owner)
+        { }
+
+        struct Attach {
+            EntityHandle handle;
+            ComponentPtr pComponent;
+        };
+
+        std::vector<CommandFn> creates;
+        std::vector<Attach> attaches;
+        std::vector<EntityHandle> destroys;
+
+        // the thread recording into this buffer, never changes after the buffer is made
+        std::thread::id owner;
+    };
+
+    /**
+     * @brief every command buffer of a world
+     * each thread records into its own buffer, so recording never takes a lock after the
+     * first command from that thread. apply takes everything recorded so far and runs it
+     * as one batch: creates in the order they were recorded, then attaches, then destroys.
+     * the create and attach events of a batch are queued and flushed before the destroys.
+     *
+     * destroys are deduplicated and sorted by archetype and then by row, last row first.
+     * each destroy moves the last row of its archetype into the hole, going backwards means
+     * that row is never one that is about to be destroyed, so nothing is moved twice.
+     */
+    struct CommandQueue {
+        SM_NOCOPY(CommandQueue)
+
+        CommandQueue();
+
+        // the buffer for the calling thread
+        CommandBuffer& get();
+
+        // apply everything recorded, the world must be locked exclusively and not frozen
+        void apply(World& world);
+
+        CommandStats getStats() const;
+
+    private:
+        // thread local caches check this rather than the address, a new world can reuse an old address
+        size_t id;
+
+        mutable mt::Mutex lock{"game.commands"};
+        std::vector<std::unique_ptr<CommandBuffer>> buffers;
+        CommandStats stats;
+
+        // reused between batches to save allocating every frame
+        CommandBuffer batch{std::thread::id()};
+    };
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "game/ecs/typeinfo.h"
+
+#include <functional>
+#include <vector>
+
+namespace game {
+    // an object and the slot it was in, a queued event uses this to tell if the object is gone
+    struct EventObject {
+        ObjectPtr pObject;
+        size_t typeId;
+        uint32_t index;
+        uint32_t generation;
+    };
+
+    struct CreateEvent {
+        EventObject object;
+    };
+
+    // always sent straight away, the object is destroyed right after
+    struct DestroyEvent {
+        ObjectPtr pObject;
+    };
+
+    struct AttachEvent {
+        EventObject entity;
+        EventObject component;
+    };
+
+    struct EventStats {
+        size_t sent = 0; ///< events delivered as soon as they happened
+        size_t queued = 0; ///< events held back for the next flush
+        size_t delivered = 0; ///< queued events delivered by a flush
+        size_t dropped = 0; ///< queued events whose object was destroyed before the flush
+        size_t ignored = 0; ///< events for types nothing listens to
+        size_t flushes = 0; ///< flushes that had anything to deliver
+        size_t lastFlush = 0; ///< events delivered by the most recent flush
+
+        // adds up the per event counts, flushes are counted by the world
+        EventStats& operator+=(const EventStats& other);
+    };
+
+    /**
+     * @brief the listeners and queued events of one kind of event, both indexed by type id
+     * sending an event is an index into the listeners of its type and a loop over them,
+     * an event for a type nothing listens to is dropped before anything else happens.
+     *
+     * queued events are grouped by type, a flush runs the listeners of a type over
+     * all of its events at once. events queued by a listener during a flush are
+     * delivered by that same flush. listeners cant be added from inside a listener.
+     */
+    template<typename E>
+    struct EventChannel {
+        using ListenerFn = std::function<void(const E&)>;
+
+        void listen(size_t typeId, ListenerFn fn) {
+            if (typeId >= listeners.size()) {
+                listeners.resize(typeId + 1);
+                pending.resize(typeId + 1);
+            }
+
+            listeners[typeId].push_back(std::move(fn));
+        }
+
+        bool hasListeners(size_t typeId) const {
+            return typeId < listeners.size() && !listeners[typeId].empty();
+        }
+
+        void send(size_t typeId, const E& event) {
+            if (!hasListeners(typeId)) {
+                stats.ignored += 1;
+                return;
+            }
+
+            for (const ListenerFn& fn : listeners[typeId]) {
+                fn(event);
+            }
+
+            stats.sent += 1;
+        }
+
+        void queue(size_t typeId, const E& event) {
+            if (!hasListeners(typeId)) {
+                stats.ignored += 1;
+                return;
+            }
+
+            std::vector<E>& events = pending[typeId];
+            if (events.empty()) {
+                pendingTypes.push_back(typeId);
+            }
+
+            events.push_back(event);
+            stats.queued += 1;
+        }
+
+        // deliver everything queued, @param isLive drops events whose object is gone
+        // and may update the event, owned components can move while their event is queued
+        // @return how many events were delivered
+        template<typename F>
+        size_t flush(F&& isLive) {
+            size_t count = 0;
+
+            while (!pendingTypes.empty()) {
+                flushTypes.swap(pendingTypes);
+
+                for (size_t typeId : flushTypes) {
+                    delivering.swap(pending[typeId]);
+
+                    for (E& event : delivering) {
+                        if (!isLive(event)) {
+                            stats.dropped += 1;
+                            continue;
+                        }
+
+                        for (const ListenerFn& fn : listeners[typeId]) {
+                            fn(event);
+                        }
+
+                        count += 1;
+                    }
+
+                    delivering.clear();
+                }
+
+                flushTypes.clear();
+            }
+
+            stats.delivered += count;
+            return count;
+        }
+
+        const EventStats& getStats() const { return stats; }
+
+    private:
+        std::vector<std::vector<ListenerFn>> listeners;
+        std::vector<std::vector<E>> pending;
+        std::vector<size_t> pendingTypes;
+
+        // swapped with the pending lists during a flush so listeners can queue more
+        std::vector<size_t> flushTypes;
+        std::vector<E> delivering;
+
+        EventStats stats;
+    };
+
+    inline EventStats& EventStats::operator+=(const EventStats& other) {
+        sent += other.sent;
+        queued += other.queued;
+        delivered += other.delivered;
+        dropped += other.dropped;
+        ignored += other.ignored;
+        return *this;
+    }
+}
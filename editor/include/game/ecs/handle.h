@@ -0,0 +1,35 @@
+#pragma once
+
+#include "game/ecs/typeinfo.h"
+
+namespace game {
+    /**
+     * @brief a reference to an object that knows when the object is gone
+     * a handle is the slot the object was stored in plus the generation of that slot.
+     * destroying an object bumps the generation, so a handle to it stops resolving
+     * even after the slot has been reused. resolving is a compare and a load.
+     *
+     * entity handles use the world wide entity slots, component handles use the
+     * slots of their own component type.
+     */
+    template<typename T>
+    struct Handle {
+        static constexpr uint32_t kInvalidIndex = UINT32_MAX;
+
+        uint32_t index = kInvalidIndex;
+        uint32_t generation = 0;
+
+        // false for a default constructed handle, true even if the object has since been destroyed
+        bool isSet() const { return index != kInvalidIndex; }
+
+        constexpr bool operator==(const Handle& other) const = default;
+    };
+
+    using EntityHandle = Handle<IEntity>;
+
+    static_assert(sizeof(EntityHandle) == 8, "entity handles should stay 8 bytes");
+
+    // defined by the world, usable from code that only has the world forward declared
+    template<typename T>
+    T *resolveHandle(World *pWorld, Handle<T> handle);
+}
@@ -1,15 +1,16 @@
 #pragma once
 
 #include "game/ecs/storage.h"
+#include "game/ecs/archetype.h"
+#include "game/ecs/handle.h"
 
+#include <concepts>
 #include <unordered_map>
 
 namespace game {
     template<typename T>
     using TypeInfoMap = std::unordered_map<TypeInfo, T>;
 
-    using ComponentMap = TypeInfoMap<ComponentPtr>;
-
     struct IObject {
         virtual ~IObject() = default;
 
@@ -19,6 +20,7 @@ namespace game {
 
         size_t getTypeId() const { return data.info.getId(); }
         Index getInstanceId() const { return data.index; }
+        uint32_t getGeneration() const { return data.generation; }
 
         const std::string& getName() const { return data.name; }
         World *getWorld() const { return data.pWorld; }
@@ -34,7 +36,7 @@ namespace game {
     // components
 
     struct ComponentData : ObjectData {
-        
+        size_t tick; // the world tick the component was made in
     };
 
     struct IComponent : IObject {
@@ -42,31 +44,83 @@ namespace game {
 
         IComponent(ComponentData info) 
             : IObject(info)
+            , changeTick(info.tick)
         { }
 
         virtual void onCreate() { }
 
+        /**
+         * @brief tell the world this component was written to
+         * call after changing anything a consumer of the component cares about, consumers
+         * then only have to look at what World::eachChanged gives them. safe to call from
+         * a system running in parallel as long as the system declared it writes the type.
+         */
+        void markChanged();
+
+        // the last tick this component changed in, newly made components count as changed
+        size_t getChangeTick() const { return changeTick; }
+        bool changedSince(size_t tick) const { return changeTick > tick; }
+
+        template<typename C>
+        Handle<C> getHandle() const {
+            SM_ASSERTF(getTypeInfo() == makeTypeInfo<C>(getWorld()), "component type mismatch");
+            return { uint32_t(getInstanceId()), getGeneration() };
+        }
+
+        // only a handle is kept, so the associated component can be destroyed first
         void associate(IComponent *pComponent) {
-            pAssociated = pComponent;
+            if (pComponent == nullptr) {
+                associatedType = SIZE_MAX;
+                hAssociated = {};
+                return;
+            }
+
+            associatedType = pComponent->getTypeId();
+            hAssociated = { uint32_t(pComponent->getInstanceId()), pComponent->getGeneration() };
         }
 
+        // @return nullptr if nothing is associated or it has been destroyed
         template<typename C>
         C *associated() const {
+            if (!hAssociated.isSet()) return nullptr;
+
             auto expectedType = makeTypeInfo<C>(getWorld());
-            auto realType = pAssociated->getTypeInfo();
-            SM_ASSERTF(realType == expectedType, "component type mismatch");
+            SM_ASSERTF(associatedType == expectedType.getId(), "component type mismatch");
 
-            return static_cast<C*>(pAssociated);
+            return resolveHandle(getWorld(), Handle<C>{ hAssociated.index, hAssociated.generation });
         }
 
+        // the entity this component was made for, it gets destroyed along with that entity
+        EntityHandle getOwner() const { return owner; }
+
     private:
-        IComponent *pAssociated = nullptr;
+        template<typename T>
+        friend struct EntityBuilder;
+        friend struct World;
+
+        size_t associatedType = SIZE_MAX;
+        Handle<IComponent> hAssociated;
+
+        size_t changeTick;
+
+        EntityHandle owner;
     };
 
+    /**
+     * @brief a component type made once and attached to many entities, like a mesh or texture
+     * declared with `static constexpr bool kShared = true;`, they live in their own storage and
+     * archetypes hold them by pointer. every other component is owned by the entity it was
+     * made for and stored by value in its archetype, so it moves whenever the entity does.
+     * keep handles rather than pointers to owned components across structural changes.
+     */
+    template<typename T>
+    concept SharedComponent = std::derived_from<T, IComponent> && requires { requires T::kShared; };
+
     // entities
 
     struct EntityData : ObjectData {
         Index entityId;
+        uint32_t entityGeneration;
     };
 
     struct IEntity : IObject {
@@ -75,21 +129,31 @@ namespace game {
         IEntity(EntityData info) 
             : IObject(info)
             , entityId(info.entityId) 
+            , entityGeneration(info.entityGeneration)
         { }
 
         virtual void onCreate() { }
 
         void addComponent(IComponent *pComponent);
 
+        // components live in the archetype the entity is in, this is a pair of array lookups
         template<typename T>
         T *get() const {
+            if (location.pArchetype == nullptr) return nullptr;
+
             TypeInfo expectedType = makeTypeInfo<T>(getWorld());
+            uint16_t column = location.pArchetype->getColumn(expectedType.getId());
+            if (column == Archetype::kInvalidColumn) return nullptr;
 
-            if (auto it = components.find(expectedType); it != components.end()) {
-                return static_cast<T*>(it->second);
-            }
+            return location.pArchetype->template getAt<T>(column, location.row);
+        }
+
+        template<typename T>
+        bool has() const {
+            if (location.pArchetype == nullptr) return false;
 
-            return nullptr;
+            TypeInfo expectedType = makeTypeInfo<T>(getWorld());
+            return location.pArchetype->has(expectedType.getId());
         }
 
         template<typename O>
@@ -98,13 +162,27 @@ namespace game {
             return expectedType == getTypeInfo() ? static_cast<O*>(this) : nullptr;
         }
 
-        const ComponentMap& getComponents() const { return components; }
+        RowComponents getComponents() const { return RowComponents(location); }
+        EntityLocation getLocation() const { return location; }
 
         Index getEntityId() const { return entityId; }
 
+        // entity handles of every type index the world wide entity slots
+        template<typename T = IEntity>
+        Handle<T> getHandle() const {
+            if constexpr (!std::is_same_v<T, IEntity>) {
+                SM_ASSERTF(getTypeInfo() == makeTypeInfo<T>(getWorld()), "entity type mismatch");
+            }
+
+            return { uint32_t(entityId), entityGeneration };
+        }
+
     private:
+        friend ArchetypeStorage;
+
         Index entityId;
-        ComponentMap components;
+        uint32_t entityGeneration;
+        EntityLocation location;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "engine/threads/parallel.h"
+
+#include "game/ecs/archetype.h"
+
+#include <iterator>
+#include <tuple>
+
+namespace game {
+    // an archetype a query matched, with the column of each queried type resolved up front
+    struct QueryMatch {
+        Archetype *pArchetype;
+        std::vector<uint16_t> columns;
+    };
+
+    /**
+     * @brief walks every row of every matched archetype
+     * rows are visited last to first, so destroying the entity being visited
+     * never skips another one. anything else that changes the world structure
+     * while iterating should be deferred until the loop is done.
+     */
+    struct QueryCursor {
+        QueryCursor(const std::vector<QueryMatch> *pMatches)
+            : pMatches(pMatches)
+        {
+            settle();
+        }
+
+        void next() {
+            remaining -= 1;
+            settle();
+        }
+
+        bool done() const { return match >= pMatches->size(); }
+
+        const QueryMatch& getMatch() const { return (*pMatches)[match]; }
+        uint32_t getRow() const { return remaining - 1; }
+
+    private:
+        void settle() {
+            while (match < pMatches->size()) {
+                // rows past the end were destroyed while we were visiting them
+                uint32_t size = getMatch().pArchetype->getSize();
+                if (remaining > size) remaining = size;
+
+                if (remaining > 0) return;
+
+                // clamped to the size of the next archetype on the next pass
+                match += 1;
+                remaining = UINT32_MAX;
+            }
+        }
+
+        const std::vector<QueryMatch> *pMatches;
+        size_t match = 0;
+        uint32_t remaining = UINT32_MAX;
+    };
+
+    /**
+     * @brief every archetype that has a set of component types
+     * queries are registered with the archetype storage and told about new archetypes
+     * as they are created, entities moving between archetypes needs no bookkeeping at all.
+     * iterating only touches matched archetypes, so costs scale with the entities that match.
+     */
+    struct QueryBase {
+        SM_NOCOPY(QueryBase)
+
+        // @param types the queried type ids, in the order the query was declared
+        QueryBase(Signature types);
+
+        bool matches(const Archetype& archetype) const;
+        void addArchetype(Archetype *pArchetype);
+
+        const Signature& getTypes() const { return types; }
+        const std::vector<QueryMatch>& getMatches() const { return matched; }
+
+        // the number of matching entities
+        size_t size() const;
+
+        struct EntityIterator {
+            EntityIterator(const std::vector<QueryMatch> *pMatches)
+                : cursor(pMatches)
+            { }
+
+            EntityIterator& operator++() { cursor.next(); return *this; }
+            EntityPtr operator*() const { return cursor.getMatch().pArchetype->getEntity(cursor.getRow()); }
+            bool operator==(std::default_sentinel_t) const { return cursor.done(); }
+
+        private:
+            QueryCursor cursor;
+        };
+
+        struct EntityRange {
+            EntityIterator begin() const { return EntityIterator(pMatches); }
+            std::default_sentinel_t end() const { return {}; }
+
+            const std::vector<QueryMatch> *pMatches;
+        };
+
+        // just the entities of the query
+        EntityRange entities() const { return { &matched }; }
+
+    private:
+        Signature types;
+        std::vector<QueryMatch> matched;
+    };
+
+    /**
+     * @brief a typed view of a query
+     * iterating yields the entity and a pointer to each queried component,
+     * all read straight out of the archetype columns. owned components are
+     * pointers into the chunk itself, shared ones are the pointer the column holds.
+     *
+     * for (auto [pEntity, pTransform, pShoot] : world.query<TransformComp, ShootComp>())
+     */
+    template<typename... C>
+    struct Query final : QueryBase {
+        using Row = std::tuple<EntityPtr, C*...>;
+
+        using QueryBase::QueryBase;
+
+        struct Iterator {
+            Iterator(const std::vector<QueryMatch> *pMatches)
+                : cursor(pMatches)
+            { }
+
+            Iterator& operator++() { cursor.next(); return *this; }
+            bool operator==(std::default_sentinel_t) const { return cursor.done(); }
+
+            Row operator*() const {
+                return readRow(cursor.getMatch(), cursor.getRow());
+            }
+
+        private:
+            QueryCursor cursor;
+        };
+
+        Iterator begin() const { return Iterator(&getMatches()); }
+        std::default_sentinel_t end() const { return {}; }
+
+        /**
+         * @brief run @param fn(pEntity, C*...) for every row across the worker pool
+         * each archetype chunk is handed out as one piece of work.
+         * @param fn must not change the structure of the world.
+         */
+        template<typename F>
+        void parallelEach(F&& fn) const {
+            struct RowRange {
+                const QueryMatch *pMatch;
+                uint32_t first;
+                uint32_t last;
+            };
+
+            std::vector<RowRange> ranges;
+            for (const QueryMatch& match : getMatches()) {
+                uint32_t size = match.pArchetype->getSize();
+                for (uint32_t first = 0; first < size; first += Archetype::kChunkRows) {
+                    ranges.push_back({ &match, first, std::min(first + Archetype::kChunkRows, size) });
+                }
+            }
+
+            simcoe::threads::parallelEach(ranges, [&](const RowRange& range) {
+                for (uint32_t row = range.first; row < range.last; row++) {
+                    std::apply(fn, readRow(*range.pMatch, row));
+                }
+            }, 1);
+        }
+
+    private:
+        static Row readRow(const QueryMatch& match, uint32_t row) {
+            return readRow(match, row, std::index_sequence_for<C...>{});
+        }
+
+        template<size_t... I>
+        static Row readRow(const QueryMatch& match, uint32_t row, std::index_sequence<I...>) {
+            const Archetype *pArchetype = match.pArchetype;
+
+            return Row(
+                pArchetype->getEntity(row),
+                pArchetype->template getAt<C>(match.columns[I], row)...
+            );
+        }
+    };
+}
@@ -2,34 +2,171 @@
 
 #include "game/ecs/typeinfo.h"
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
 namespace game {
     struct ObjectStorage;
     struct StorageIter;
 
+    // size and alignment of the objects a storage constructs, zero for storages that only index
+    struct ObjectLayout {
+        size_t size = 0;
+        size_t align = 0;
+
+        template<typename T>
+        static constexpr ObjectLayout of() { return { sizeof(T), alignof(T) }; }
+    };
+
+    struct StorageStats {
+        size_t pages = 0; ///< pages allocated so far, they live as long as the storage
+        size_t reservedPages = 0; ///< pages allocated up front by reserve
+        size_t backgroundPages = 0; ///< pages allocated ahead of time on a worker
+        size_t syncPages = 0; ///< pages allocated by whichever allocate ran out of room
+        size_t constructed = 0; ///< objects constructed in this storage
+        size_t destroyed = 0; ///< objects destroyed, their slots get reused by later objects
+        size_t changed = 0; ///< objects marked changed during the last tick
+        size_t unchanged = 0; ///< live objects that were left alone during the last tick
+    };
+
+    // runs the work it is given on another thread
+    using PageWorkFn = std::function<void(std::function<void()>)>;
+
+    /**
+     * @brief the slots of every object of one type
+     * slots are grouped into fixed size pages that hold the objects themselves, the object
+     * pointers and the slot generations. pages are only ever added, so growing never moves
+     * an object and never invalidates a pointer or handle to one.
+     *
+     * the lowest free slot is always handed out first so live objects stay packed
+     * towards the front, and destroyed objects never go back to the heap.
+     * once less than a page of free slots is left a spare page is made on the page worker,
+     * so allocate only makes a page itself if the worker falls behind.
+     *
+     * each page also keeps a set of the objects that changed this tick. marking is
+     * atomic so systems running in parallel can mark their own objects, clearing only
+     * happens between ticks.
+     */
     struct ObjectStorage {
-        ObjectStorage(TypeInfo info, size_t size);
+        static constexpr size_t kPageSlots = 256;
+
+        // @param reserve slots to make room for up front
+        ObjectStorage(TypeInfo info, size_t reserve, ObjectLayout layout = {});
 
         Index allocate();
         void release(Index index);
 
+        // the memory for @param index, the object in it is constructed by the world
+        void *getSlot(Index index);
+
+        // run the destructor of the object in @param index and release the slot
+        void destroy(Index index);
+
         void insert(Index index, ObjectPtr pObject);
         ObjectPtr get(Index index) const;
 
+        // insert @param pObject that was constructed somewhere else, like an archetype chunk.
+        // it still gets destroyed through the storage, but its memory isnt ours
+        void adopt(Index index, ObjectPtr pObject);
+
+        // grow to hold @param count objects in total now rather than when they are allocated
+        void reserve(size_t count);
+
+        void setPageWorker(PageWorkFn fn) { worker = std::move(fn); }
+
+        // remember that the object in @param index changed, safe from any thread
+        void markChanged(Index index) { getPage(size_t(index)).changed.testSet(getSlotIndex(size_t(index))); }
+        bool isChanged(Index index) const { return getPage(size_t(index)).changed.test(ChangeIndex(getSlotIndex(size_t(index)))); }
+
+        // call @param fn with every object marked changed this tick
+        template<typename F>
+        void eachChanged(F&& fn) const {
+            for (const auto& pPage : pages) {
+                if (pPage->changed.countSetBits() == 0) continue;
+
+                pPage->changed.forEachSet([&](size_t slot) {
+                    fn(pPage->objects[slot]);
+                });
+            }
+        }
+
+        // start the next tick with nothing changed, the counts go in the stats
+        void clearChanged();
+
+        // the generation is bumped every time a slot is released
+        uint32_t getGeneration(Index index) const { return getPage(size_t(index)).generations[getSlotIndex(size_t(index))]; }
+
+        // the object in @param index if it is still the one from @param generation
+        ObjectPtr resolve(uint32_t index, uint32_t generation) const {
+            if (index >= getSize()) return nullptr;
+
+            const Page& page = getPage(index);
+            size_t slot = getSlotIndex(index);
+            return (page.generations[slot] == generation) ? page.objects[slot] : nullptr;
+        }
+
         StorageIter begin();
         StorageIter end();
 
-        size_t getUsed() const { return alloc.countSetBits(); }
-        size_t getSize() const { return alloc.getTotalBits(); }
-        bool isAllocated(Index index) const { return alloc.test(index); }
+        size_t getUsed() const { return used; }
+        size_t getSize() const { return pages.size() * kPageSlots; }
+        bool isAllocated(Index index) const { return getPage(size_t(index)).alloc.test(Index(getSlotIndex(size_t(index)))); }
 
-        ObjectPtr at(Index index) const { return objects[size_t(index)]; }
+        ObjectPtr at(Index index) const { return getPage(size_t(index)).objects[getSlotIndex(size_t(index))]; }
 
         size_t getTypeId() const { return info.getId(); }
+        StorageStats getStats() const;
 
     private:
+        struct MemoryDelete {
+            size_t align;
+            void operator()(std::byte *pMemory) const { ::operator delete[](pMemory, std::align_val_t(align)); }
+        };
+
+        using ChangeIndex = simcoe::core::AtomicBitMap::Index;
+
+        struct Page {
+            Page(ObjectLayout layout);
+
+            ObjectPtr objects[kPageSlots] = {};
+            uint32_t generations[kPageSlots] = {};
+            simcoe::core::BitMap alloc{kPageSlots};
+            simcoe::core::AtomicBitMap changed{kPageSlots};
+
+            // room for kPageSlots objects, null for storages that only index
+            std::unique_ptr<std::byte[], MemoryDelete> memory;
+        };
+
+        // a page made on the worker waiting to be picked up, shared so the worker never outlives it
+        struct SparePage {
+            ~SparePage() { delete pPage.load(); }
+
+            std::atomic<Page*> pPage = nullptr;
+            std::atomic_bool bPending = false;
+        };
+
+        static size_t getSlotIndex(size_t index) { return index % kPageSlots; }
+        Page& getPage(size_t index) { return *pages[index / kPageSlots]; }
+        const Page& getPage(size_t index) const { return *pages[index / kPageSlots]; }
+
+        void grow();
+        void requestSpare();
+
         TypeInfo info;
-        simcoe::core::UniquePtr<ObjectPtr[]> objects;
-        simcoe::core::BitMap alloc;
+        ObjectLayout layout;
+
+        std::vector<std::unique_ptr<Page>> pages;
+
+        // every page before this one is full
+        size_t firstFree = 0;
+        size_t used = 0;
+
+        PageWorkFn worker;
+        std::shared_ptr<SparePage> spare = std::make_shared<SparePage>();
+
+        StorageStats stats;
     };
 
     struct StorageIter {
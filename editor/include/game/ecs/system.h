@@ -0,0 +1,132 @@
+#pragma once
+
+#include "engine/threads/mutex.h"
+
+#include "game/ecs/world.h"
+
+#include <chrono>
+
+namespace game {
+    namespace mt = simcoe::mt;
+
+    using SystemFn = std::function<void(World&, float)>;
+
+    struct SystemInfo {
+        std::string name;
+
+        Signature reads; ///< types the system only reads, sorted
+        Signature writes; ///< types the system writes, sorted
+        bool bExclusive = false; ///< the system changes the world structure or touches undeclared state
+
+        SystemFn fn;
+    };
+
+    struct SystemStats {
+        std::string name;
+        size_t phase = 0; ///< the phase the system runs in
+        std::chrono::nanoseconds time = {}; ///< how long the system took last frame
+    };
+
+    struct SchedulerStats {
+        size_t phases = 0; ///< phases each frame is split into
+        size_t widest = 0; ///< the most systems that run at once
+        size_t frames = 0; ///< frames run so far
+
+        std::chrono::nanoseconds frameTime = {}; ///< wall time of the last frame
+        std::chrono::nanoseconds serialTime = {}; ///< what the last frame would have taken run serially
+
+        std::vector<SystemStats> systems;
+    };
+
+    struct SystemScheduler;
+
+    struct SystemBuilder {
+        SystemBuilder(SystemScheduler& scheduler, size_t index)
+            : scheduler(scheduler)
+            , index(index)
+        { }
+
+        // declare component types, or any other type standing in for shared state, the system reads
+        template<typename... T>
+        SystemBuilder& reads() {
+            (addRead(makeTypeInfo<T>(getWorld()).getId()), ...);
+            return *this;
+        }
+
+        // declare types the system writes
+        template<typename... T>
+        SystemBuilder& writes() {
+            (addWrite(makeTypeInfo<T>(getWorld()).getId()), ...);
+            return *this;
+        }
+
+        // build a query now, queries cant be created while systems run in parallel
+        template<typename... C>
+        SystemBuilder& query() {
+            getWorld()->query<C...>();
+            return *this;
+        }
+
+        // run the system on its own with the world locked exclusively
+        SystemBuilder& exclusive();
+
+    private:
+        World *getWorld() const;
+        void addRead(size_t typeId);
+        void addWrite(size_t typeId);
+
+        SystemScheduler& scheduler;
+        size_t index;
+    };
+
+    /**
+     * @brief runs the systems of a world each frame, in parallel where they dont conflict
+     * two systems conflict when one writes a type the other reads or writes,
+     * or when either is exclusive. systems are split into phases so that every
+     * system runs after the earlier ones it conflicts with, which gives the same
+     * result as running them in the order they were added.
+     *
+     * each phase takes the world lock, shared if nothing in it writes. the world
+     * structure is frozen during non exclusive phases, anything that creates or
+     * destroys entities has to be exclusive or be recorded with World::commands,
+     * which are applied after the last phase of every frame.
+     *
+     * each frame is one world tick, systems can use World::eachChanged to
+     * only look at components changed by earlier systems or since the last frame ended.
+     */
+    struct SystemScheduler {
+        SM_NOCOPY(SystemScheduler)
+
+        SystemScheduler(World& world, mt::SharedMutex& lock);
+
+        SystemBuilder system(std::string name, SystemFn fn);
+
+        void run(float delta);
+
+        SchedulerStats getStats() const;
+
+    private:
+        friend SystemBuilder;
+
+        static bool conflicts(const SystemInfo& lhs, const SystemInfo& rhs);
+        void buildPhases();
+
+        void runPhase(const std::vector<size_t>& phase, float delta);
+
+        World& world;
+        mt::SharedMutex& lock;
+
+        std::vector<SystemInfo> systems;
+
+        // rebuilt whenever a system is added
+        bool bDirty = true;
+        std::vector<std::vector<size_t>> phases;
+        std::vector<size_t> systemPhase;
+
+        // written by the systems themselves, each only touches its own slot
+        std::vector<std::chrono::nanoseconds> times;
+
+        mutable mt::Mutex statsLock{"game.systems"};
+        SchedulerStats stats;
+    };
+}
@@ -36,6 +36,7 @@ namespace game {
         TypeInfo info; // type id of this type
 
         Index index; // type id of this instance
+        uint32_t generation; // generation of the storage slot this instance is in
         std::string name;
         World *pWorld;
     };
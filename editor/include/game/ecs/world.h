@@ -1,15 +1,18 @@
 #pragma once
 
-#include "game/render/scene.h"
-
 #include "game/ecs/typeinfo.h"
 #include "game/ecs/storage.h"
 #include "game/ecs/objects.h"
+#include "game/ecs/query.h"
+#include "game/ecs/commands.h"
+#include "game/ecs/events.h"
 
+#include <atomic>
 #include <ranges>
 
 namespace game {
     size_t getUniqueId();
+    size_t getUniqueQueryId();
     TypeInfo makeNameInfo(World *pWorld, const std::string& name);
 
     template<typename T>
@@ -20,12 +23,6 @@ namespace game {
 
     using ObjectStorageMap = TypeInfoMap<ObjectStorage>;
 
-    using EventFn = std::function<void(ObjectPtr)>;
-    using AttachEventFn = std::function<void(EntityPtr, ComponentPtr)>;
-
-    using EventMap = std::unordered_multimap<TypeInfo, EventFn>;
-    using AttachEventMap = std::unordered_multimap<TypeInfo, AttachEventFn>;
-
     template<typename T>
     struct EntityBuilder;
 
@@ -88,7 +85,7 @@ namespace game {
     };
 
     struct World {
-        World() : entities(makeTypeInfo<IEntity>(this), 1024) { }
+        World() : entities(makeTypeInfo<IEntity>(this), ObjectStorage::kPageSlots) { }
 
         // creation
 
@@ -96,14 +93,16 @@ namespace game {
             requires std::derived_from<T, IEntity> 
                   && std::constructible_from<T, EntityData, A...>
         EntityBuilder<T> entity(std::string name, A&&... args) {
+            verifyMutable("entity");
             TypeInfo info = makeTypeInfo<T>(this);
+            ObjectStorage& storage = getStorageOf<T>();
 
-            ObjectData data = allocObject(info, name);
+            ObjectData data = allocObject(storage, info, name);
             Index entityId = entities.allocate();
 
-            EntityData entityData = { data, entityId };
-            T *pEntity = new T(entityData, std::forward<A>(args)...);
-            insertObject(pEntity);
+            EntityData entityData = { data, entityId, entities.getGeneration(entityId) };
+            T *pEntity = new (storage.getSlot(data.index)) T(entityData, std::forward<A>(args)...);
+            storage.insert(data.index, pEntity);
 
             insertEntity(entityId, pEntity);
 
@@ -113,21 +112,20 @@ namespace game {
             return pEntity;
         }
 
+        // a shared component, attach it to as many entities as needed
         template<typename T, typename... A>
-            requires std::derived_from<T, IComponent>
+            requires SharedComponent<T>
                   && std::constructible_from<T, ComponentData, A...>
         T *component(A&&... args) {
+            verifyMutable("component");
             TypeInfo info = makeTypeInfo<T>(this);
+            ObjectStorage& storage = getStorageOf<T>();
 
-            std::string name = "component";
-            if constexpr (requires { T::kTypeName; }) {
-                name = T::kTypeName;
-            }
-
-            ObjectData data = allocObject(info, name);
-            ComponentData componentData = { data };
-            T *pComponent = new T(componentData, std::forward<A>(args)...);
-            insertObject(pComponent);
+            ObjectData data = allocObject(storage, info, getComponentName<T>());
+            ComponentData componentData = { data, tick };
+            T *pComponent = new (storage.getSlot(data.index)) T(componentData, std::forward<A>(args)...);
+            storage.insert(data.index, pComponent);
+            storage.markChanged(data.index);
 
             pComponent->onCreate();
             notifyCreate(pComponent);
@@ -135,6 +133,43 @@ namespace game {
             return pComponent;
         }
 
+        /**
+         * @brief make an owned component in the archetype of @param pEntity
+         * replaces the component of the same type the entity already had.
+         * the entity moves to a new archetype if it didnt have one, and the components
+         * of every entity moved with it or into its old row move too.
+         * @return the component, only valid until the next structural change
+         */
+        template<typename T, typename... A>
+            requires std::derived_from<T, IComponent> && (!SharedComponent<T>)
+                  && std::constructible_from<T, ComponentData, A...>
+                  && std::is_move_constructible_v<T>
+        T *ownedComponent(EntityPtr pEntity, A&&... args) {
+            verifyMutable("ownedComponent");
+            TypeInfo info = makeTypeInfo<T>(this);
+            ObjectStorage& storage = getStorageOf<T>();
+
+            if (T *pOld = pEntity->get<T>()) {
+                destroyComponent(pOld);
+            }
+
+            void *pSlot = archetypes.emplace(pEntity, info.getId());
+
+            ObjectData data = allocObject(storage, info, getComponentName<T>());
+            ComponentData componentData = { data, tick };
+            T *pComponent = new (pSlot) T(componentData, std::forward<A>(args)...);
+            pComponent->owner = pEntity->getHandle();
+            storage.adopt(data.index, pComponent);
+            storage.markChanged(data.index);
+
+            // listeners may add components to the entity and move this one, go back through the storage
+            pComponent->onCreate();
+            notifyCreate(static_cast<T*>(storage.get(data.index)));
+            notifyAttach(pEntity, static_cast<T*>(storage.get(data.index)));
+
+            return static_cast<T*>(storage.get(data.index));
+        }
+
         template<typename T> 
             requires std::derived_from<T, IEntity>
         T *get(Index id) {
@@ -154,51 +189,124 @@ namespace game {
             return nullptr;
         }
 
+        /**
+         * @brief the object @param handle refers to
+         * @return nullptr if the object has been destroyed, even if its slot has been reused since
+         */
+        template<typename T>
+            requires std::derived_from<T, IEntity>
+        T *resolve(Handle<T> handle) {
+            ObjectPtr pObject = entities.resolve(handle.index, handle.generation);
+            return static_cast<T*>(pObject);
+        }
+
+        template<typename T>
+            requires std::derived_from<T, IComponent>
+        T *resolve(Handle<T> handle) {
+            ObjectStorage *pStorage = findStorage(makeTypeInfo<T>(this).getId());
+            if (pStorage == nullptr) return nullptr;
+
+            ObjectPtr pObject = pStorage->resolve(handle.index, handle.generation);
+            return static_cast<T*>(pObject);
+        }
+
+        // @return false if the entity was already gone
+        template<typename T>
+            requires std::derived_from<T, IEntity>
+        bool destroy(Handle<T> handle) {
+            T *pEntity = resolve(handle);
+            if (pEntity == nullptr) return false;
+
+            destroy(pEntity);
+            return true;
+        }
+
         void destroy(EntityPtr pEntity) {
+            verifyMutable("destroy");
             auto info = pEntity->getTypeInfo();
+            EntityHandle handle = pEntity->getHandle();
 
             notifyDestroy(pEntity);
 
+            // components made for this entity go with it, shared ones like meshes stay.
+            // owned components are destroyed in place, removing the row then fills the hole
+            for (ComponentPtr pComponent : pEntity->getComponents()) {
+                if (pComponent->getOwner() == handle) {
+                    destroyComponent(pComponent);
+                }
+            }
+
+            archetypes.remove(pEntity);
             entities.release(pEntity->getEntityId());
-            objects.at(info).release(pEntity->getInstanceId());
 
-            notifyDestroy(pEntity);
-            delete pEntity;
+            getStorage(info).destroy(pEntity->getInstanceId());
         }
 
         // events
 
         template<typename T, typename F>
         void onCreate(F&& func) {
-            EventFn fn = [func](ObjectPtr ptr) {
-                T *pOuter = static_cast<T*>(ptr);
-                func(pOuter);
-            };
-
-            TypeInfo info = makeTypeInfo<T>(this);
-            onCreateEvents.emplace(info, fn);
+            createEvents.listen(makeTypeInfo<T>(this).getId(), [func](const CreateEvent& event) {
+                func(static_cast<T*>(event.object.pObject));
+            });
         }
 
         template<typename T, typename F>
         void onDestroy(F&& func) {
-            EventFn fn = [func](ObjectPtr ptr) {
-                T *pOuter = static_cast<T*>(ptr);
-                func(pOuter);
-            };
-
-            TypeInfo info = makeTypeInfo<T>(this);
-            onDestroyEvents.emplace(info, fn);
+            destroyEvents.listen(makeTypeInfo<T>(this).getId(), [func](const DestroyEvent& event) {
+                func(static_cast<T*>(event.pObject));
+            });
         }
 
         template<typename T, typename F>
         void onAttach(F&& func) {
-            AttachEventFn fn = [func](EntityPtr pEntity, ComponentPtr pComponent) {
-                T *pOuter = static_cast<T*>(pComponent);
-                func(pEntity, pOuter);
+            attachEvents.listen(makeTypeInfo<T>(this).getId(), [func](const AttachEvent& event) {
+                func(static_cast<EntityPtr>(event.entity.pObject), static_cast<T*>(event.component.pObject));
+            });
+        }
+
+        /**
+         * @brief hold create and attach events back until flushEvents
+         * lets a burst of new objects be handed to each listener in one go.
+         * destroy events are always sent straight away, the object is gone right after.
+         */
+        void setQueueEvents(bool bValue) { bQueueEvents = bValue; }
+        bool isQueueingEvents() const { return bQueueEvents; }
+
+        // deliver queued events, anything destroyed since its event was queued is skipped
+        void flushEvents() {
+            // owned components move with their entity, so follow the slot rather than the pointer
+            auto isLive = [this](EventObject& object) {
+                ObjectStorage *pStorage = findStorage(object.typeId);
+                if (pStorage == nullptr) return false;
+
+                object.pObject = pStorage->resolve(object.index, object.generation);
+                return object.pObject != nullptr;
             };
 
-            TypeInfo info = makeTypeInfo<T>(this);
-            onAttachEvents.emplace(info, fn);
+            size_t count = createEvents.flush([&](CreateEvent& event) {
+                return isLive(event.object);
+            });
+
+            count += attachEvents.flush([&](AttachEvent& event) {
+                return isLive(event.entity) && isLive(event.component);
+            });
+
+            if (count == 0) return;
+
+            eventFlushes += 1;
+            lastEventFlush = count;
+        }
+
+        EventStats getEventStats() const {
+            EventStats stats;
+            stats += createEvents.getStats();
+            stats += destroyEvents.getStats();
+            stats += attachEvents.getStats();
+
+            stats.flushes = eventFlushes;
+            stats.lastFlush = lastEventFlush;
+            return stats;
         }
 
         // iteration
@@ -214,18 +322,125 @@ namespace game {
             return WorldStorage<T>(&objects.at(expectedType));
         }
 
+        /**
+         * @brief a cached query over every entity with all of @tparam C
+         * the first call for a set of types builds the query, every call after
+         * that returns the same one. it stays up to date for the life of the world.
+         */
         template<typename... C>
-            requires (std::derived_from<C, IComponent> && ...) 
-        WorldStorage<IEntity> allWith() {
-            auto filter = [](ObjectPtr pObject) {
-                IEntity *pEntity = static_cast<IEntity*>(pObject);
+            requires (std::derived_from<C, IComponent> && ...)
+        Query<C...>& query() {
+            static const size_t kSlot = getUniqueQueryId();
 
-                return ((pEntity->template get<C>()) && ...);
-            };
+            if (kSlot >= queries.size()) {
+                queries.resize(kSlot + 1);
+            }
+
+            auto& pQuery = queries[kSlot];
+            if (pQuery == nullptr) {
+                verifyMutable("query");
+                pQuery = std::make_unique<Query<C...>>(Signature{ makeTypeInfo<C>(this).getId()... });
+                archetypes.addQuery(pQuery.get());
+            }
+
+            return static_cast<Query<C...>&>(*pQuery);
+        }
+
+        template<typename... C>
+            requires (std::derived_from<C, IComponent> && ...)
+        QueryBase::EntityRange allWith() {
+            return query<C...>().entities();
+        }
+
+        /**
+         * @brief make room for @param count more objects of @tparam T up front
+         * storages grow on their own, this moves the page allocations for a known
+         * burst of objects out of the frame. entity types reserve entity slots too.
+         */
+        template<typename T>
+            requires std::derived_from<T, IEntity> || std::derived_from<T, IComponent>
+        void reserve(size_t count) {
+            ObjectStorage& storage = getStorageOf<T>();
+            storage.reserve(storage.getUsed() + count);
 
-            return WorldStorage<IEntity>(&entities, filter);
+            if constexpr (std::derived_from<T, IEntity>) {
+                entities.reserve(entities.getUsed() + count);
+            }
+        }
+
+        // storages ask @param fn to make their next page before they run out of room
+        void setPageWorker(PageWorkFn fn) {
+            pageWorker = std::move(fn);
+
+            entities.setPageWorker(pageWorker);
+            for (auto& [info, storage] : objects) {
+                storage.setPageWorker(pageWorker);
+            }
+        }
+
+        /**
+         * @brief record structural changes to apply at the next sync point
+         * use this from systems instead of changing the world directly,
+         * the system scheduler applies everything after each frame.
+         */
+        CommandBuffer& commands() { return commandQueue.get(); }
+
+        void applyCommands() {
+            verifyMutable("applyCommands");
+            commandQueue.apply(*this);
+        }
+
+        CommandStats getCommandStats() const { return commandQueue.getStats(); }
+
+        // change tracking
+
+        /**
+         * @brief call @param fn with every @tparam T that changed this tick
+         * that is every component made or passed to markChanged since the last advanceTick.
+         * components that were changed and then destroyed are left out.
+         */
+        template<typename T, typename F>
+            requires std::derived_from<T, IComponent>
+        void eachChanged(F&& fn) {
+            ObjectStorage *pStorage = findStorage(makeTypeInfo<T>(this).getId());
+            if (pStorage == nullptr) return;
+
+            pStorage->eachChanged([&](ObjectPtr pObject) {
+                fn(static_cast<T*>(pObject));
+            });
+        }
+
+        void markChanged(ComponentPtr pComponent) {
+            getStorage(pComponent->getTypeInfo()).markChanged(pComponent->getInstanceId());
+        }
+
+        /**
+         * @brief end the current tick and forget what changed in it
+         * the system scheduler does this once the systems of a frame have run,
+         * so the changes made by a frame are seen by every system later in that frame
+         * and anything done between frames is seen by the next one.
+         */
+        void advanceTick() {
+            verifyMutable("advanceTick");
+
+            for (auto& [info, storage] : objects) {
+                storage.clearChanged();
+            }
+
+            tick += 1;
         }
 
+        size_t getTick() const { return tick; }
+
+        /**
+         * @brief stop anything from changing the structure of the world
+         * set by the system scheduler while systems run in parallel,
+         * creating or destroying anything while frozen is a bug.
+         * read only phases only hold the world shared, so the flag is atomic
+         */
+        void setFrozen(bool bValue) { bFrozen.store(bValue, std::memory_order_release); }
+        bool isFrozen() const { return bFrozen.load(std::memory_order_acquire); }
+
         // iterates over all entities of type T
         template<typename T, typename F>
         void each(F&& func) {
@@ -235,16 +450,20 @@ namespace game {
         }
 
         void notifyAttach(EntityPtr pEntity, ComponentPtr pComponent) {
-            auto info = pComponent->getTypeInfo();
-
-            auto [front, back] = onAttachEvents.equal_range(info);
-            for (auto it = front; it != back; ++it) {
-                auto& fn = it->second;
-                fn(pEntity, pComponent);
+            size_t typeId = pComponent->getTypeId();
+            AttachEvent event = { getEventObject(pEntity), getEventObject(pComponent) };
+            if (bQueueEvents) {
+                attachEvents.queue(typeId, event);
+            } else {
+                attachEvents.send(typeId, event);
             }
         }
 
     private:
+        void verifyMutable(std::string_view action) const {
+            SM_ASSERTF(!isFrozen(), "world is frozen, {} has to be deferred or run from an exclusive system", action);
+        }
+
         void each(const TypeInfo& info, std::function<void(ObjectPtr)> func) {
             if (auto it = objects.find(info); it != objects.end()) {
                 auto& storage = it->second;
@@ -255,50 +474,90 @@ namespace game {
             }
         }
 
-        ObjectData allocObject(const TypeInfo& info, const std::string& name) {
-            if (objects.find(info) == objects.end()) {
-                objects.emplace(info, ObjectStorage(info, 1024));
+        ObjectStorage& getStorage(const TypeInfo& info) {
+            ObjectStorage *pStorage = findStorage(info.getId());
+            SM_ASSERTF(pStorage != nullptr, "no storage for type {}", info.getId());
+            return *pStorage;
+        }
+
+        // entities and shared components live in their storage, owned components only have their slot there
+        template<typename T>
+        ObjectStorage& getStorageOf() {
+            TypeInfo info = makeTypeInfo<T>(this);
+            if (ObjectStorage *pStorage = findStorage(info.getId())) {
+                return *pStorage;
             }
 
-            ObjectStorage& storage = objects.at(info);
-            Index index = storage.allocate();
-            return { info, index, name, this };
+            if constexpr (std::derived_from<T, IEntity> || SharedComponent<T>) {
+                return getStorage(info, ObjectLayout::of<T>());
+            } else {
+                ObjectStorage& storage = getStorage(info, ObjectLayout{});
+                archetypes.setLayout(info.getId(), ColumnLayout::of<T>(&storage));
+                return storage;
+            }
         }
 
-        void insertObject(ObjectPtr pObject) {
-            auto info = pObject->getTypeInfo();
-            auto index = pObject->getInstanceId();
+        template<typename T>
+        static std::string getComponentName() {
+            if constexpr (requires { T::kTypeName; }) {
+                return T::kTypeName;
+            } else {
+                return "component";
+            }
+        }
 
-            if (objects.find(info) == objects.end()) {
-                objects.emplace(info, ObjectStorage(info, 1024));
+        ObjectStorage& getStorage(const TypeInfo& info, ObjectLayout layout) {
+            if (ObjectStorage *pStorage = findStorage(info.getId())) {
+                return *pStorage;
             }
 
-            ObjectStorage& storage = objects.at(info);
-            storage.insert(index, pObject);
+            auto [it, inserted] = objects.emplace(info, ObjectStorage(info, ObjectStorage::kPageSlots, layout));
+            it->second.setPageWorker(pageWorker);
+
+            // map nodes never move, so the dense lookup can point straight at them
+            size_t id = info.getId();
+            if (id >= storageByType.size()) {
+                storageByType.resize(id + 1, nullptr);
+            }
+
+            storageByType[id] = &it->second;
+            return it->second;
+        }
+
+        ObjectStorage *findStorage(size_t typeId) const {
+            return (typeId < storageByType.size()) ? storageByType[typeId] : nullptr;
+        }
+
+        ObjectData allocObject(ObjectStorage& storage, const TypeInfo& info, const std::string& name) {
+            Index index = storage.allocate();
+            return { info, index, storage.getGeneration(index), name, this };
+        }
+
+        void destroyComponent(ComponentPtr pComponent) {
+            notifyDestroy(pComponent);
+            getStorage(pComponent->getTypeInfo()).destroy(pComponent->getInstanceId());
         }
 
         void insertEntity(Index index, EntityPtr pEntity) {
             entities.insert(index, pEntity);
         }
 
-        void notifyCreate(ObjectPtr pObject) {
-            auto info = pObject->getTypeInfo();
+        static EventObject getEventObject(ObjectPtr pObject) {
+            return { pObject, pObject->getTypeId(), uint32_t(pObject->getInstanceId()), pObject->getGeneration() };
+        }
 
-            auto [front, back] = onCreateEvents.equal_range(info);
-            for (auto it = front; it != back; ++it) {
-                auto& fn = it->second;
-                fn(pObject);
+        void notifyCreate(ObjectPtr pObject) {
+            size_t typeId = pObject->getTypeId();
+            CreateEvent event = { getEventObject(pObject) };
+            if (bQueueEvents) {
+                createEvents.queue(typeId, event);
+            } else {
+                createEvents.send(typeId, event);
             }
         }
 
         void notifyDestroy(ObjectPtr pObject) {
-            auto info = pObject->getTypeInfo();
-
-            auto [front, back] = onDestroyEvents.equal_range(info);
-            for (auto it = front; it != back; ++it) {
-                auto& fn = it->second;
-                fn(pObject);
-            }
+            destroyEvents.send(pObject->getTypeId(), { pObject });
         }
 
         // TODO: make private
@@ -306,25 +565,56 @@ namespace game {
         ObjectStorage entities;
         ObjectStorageMap objects;
 
-        EventMap onCreateEvents;
-        EventMap onDestroyEvents;
+        // type id -> storage in objects, for resolving handles without hashing
+        std::vector<ObjectStorage*> storageByType;
+
+        // which components each entity has, see IEntity::get
+        ArchetypeStorage archetypes;
+
+        // indexed by the slot each query<C...> was given
+        std::vector<std::unique_ptr<QueryBase>> queries;
+
+    private:
+        std::atomic_bool bFrozen = false;
+        size_t tick = 0;
+
+        CommandQueue commandQueue;
+        PageWorkFn pageWorker;
 
-        AttachEventMap onAttachEvents;
+        bool bQueueEvents = false;
+        size_t eventFlushes = 0;
+        size_t lastEventFlush = 0;
+
+        EventChannel<CreateEvent> createEvents;
+        EventChannel<DestroyEvent> destroyEvents;
+        EventChannel<AttachEvent> attachEvents;
     };
 
+    template<typename T>
+    T *resolveHandle(World *pWorld, Handle<T> handle) {
+        return pWorld->resolve(handle);
+    }
+
     template<typename T>
     struct EntityBuilder {
         EntityBuilder(T *pEntity) 
             : pEntity(pEntity) 
         { }
 
+        // make a component owned by the entity, it is destroyed along with it
         template<typename C, typename... A>
             requires std::derived_from<C, IComponent>
                   && std::constructible_from<C, ComponentData, A...>
         EntityBuilder<T>& add(A&&... args) {
             World *pWorld = pEntity->getWorld();
-            C *pComp = pWorld->component<C>(std::forward<A>(args)...);
-            pEntity->addComponent(pComp);
+            if constexpr (SharedComponent<C>) {
+                C *pComp = pWorld->component<C>(std::forward<A>(args)...);
+                pComp->owner = pEntity->getHandle();
+                pEntity->addComponent(pComp);
+            } else {
+                pWorld->ownedComponent<C>(pEntity, std::forward<A>(args)...);
+            }
+
             return *this;
         }
 
@@ -335,6 +625,8 @@ namespace game {
 
         operator T*() { return pEntity; }
 
+        Handle<T> getHandle() const { return pEntity->template getHandle<T>(); }
+
         T *pEntity = nullptr;
     };
 }
@@ -4,6 +4,8 @@
 
 #include "engine/depot/font.h"
 
+#include "engine/core/arena.h"
+
 #include <vector>
 
 namespace game::ui {
@@ -14,6 +16,8 @@ namespace game::ui {
     using uint8x4 = Vec4<uint8_t>;
     using UiIndex = uint16_t;
 
+    namespace core = simcoe::core;
+
     struct Context;
 
     struct BoxBounds {
@@ -115,9 +119,14 @@ namespace game::ui {
 
     // core ui class
     // generates draw lists
+    // the draw lists live in the frame arena of the thread that builds them,
+    // so they are only valid until that thread resets its frame arena
     struct Context {
         Context(BoxBounds screen);
 
+        // drop the draw lists, must be called after the frame arena is reset
+        void reset();
+
         void begin(IWidget *pWidget);
 
         void box(const BoxBounds& bounds, uint8x4 colour);
@@ -130,8 +139,8 @@ namespace game::ui {
         BoxBounds screen; // the complete bounds of the screen (draws at display resolution)
         BoxBounds user; // the bounds of the user interface
 
-        std::vector<UiVertex> vertices;
-        std::vector<UiIndex> indices;
+        core::ArenaVector<UiVertex> vertices;
+        core::ArenaVector<UiIndex> indices;
 
         FontAtlasLookup atlas;
         std::vector<depot::Text> shapers;
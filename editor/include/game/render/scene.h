@@ -7,6 +7,10 @@
 
 #include "engine/threads/mutex.h"
 
+#include "engine/core/arena.h"
+#include "engine/core/function.h"
+
+#include <array>
 #include <unordered_set>
 
 namespace game::render {
@@ -16,7 +20,7 @@ namespace game::render {
 
     struct ScenePass;
 
-    using SceneAction = std::function<void(ScenePass *, Context *)>;
+    using SceneAction = simcoe::core::UniqueFunction<void(ScenePass *, Context *)>;
 
     struct UNIFORM_BUFFER Model {
         float4x4 model;
@@ -37,12 +41,24 @@ namespace game::render {
         using Super::Super;
     };
 
+    // a batch is built on the game thread and replayed on the render thread until the next one arrives,
+    // so it outlives a single frame on either thread and cant use a frame arena.
+    // actions too big to store inline keep their captures in the batch arena too
     struct CommandBatch {
-        void add(SceneAction&& action) {
-            actions.emplace_back(std::move(action));
+        CommandBatch() = default;
+
+        CommandBatch(simcoe::core::Arena& arena)
+            : actions(arena)
+        { }
+
+        template<typename F>
+        void add(F&& fn) {
+            actions.emplace_back(*getArena(), std::forward<F>(fn));
         }
 
-        std::vector<SceneAction> actions;
+        simcoe::core::Arena *getArena() const { return actions.get_allocator().getArena(); }
+
+        simcoe::core::ArenaVector<SceneAction> actions;
     };
 
     struct ScenePass final : IRenderPass {
@@ -54,6 +70,10 @@ namespace game::render {
 
         void execute() override;
 
+        // start a new batch backed by an arena neither the current or pending batch are using
+        // only one batch may be in flight at a time
+        CommandBatch newCommandBatch();
+
         void update(CommandBatch&& updateBatch);
 
         Graph *getGraph() const { return pGraph; }
@@ -80,5 +100,8 @@ namespace game::render {
         CommandBatch newBatch;
         bool bDirtyBatch = false;
         mt::Mutex lock{"batch"};
+
+        // one for the batch being drawn, one for the pending batch, and one being built
+        std::array<simcoe::core::Arena, 3> arenas;
     };
 }
@@ -3,6 +3,7 @@
 #include "engine/service/service.h"
 
 #include "game/ecs/world.h"
+#include "game/ecs/system.h"
 
 #include "game/render/hud.h"
 #include "game/render/scene.h"
@@ -28,6 +29,9 @@ namespace game {
         static threads::WorkQueue& getWorkQueue();
         static mt::SharedMutex& getWorldMutex();
 
+        // the systems that update the world each frame
+        static game::SystemScheduler& getSystems();
+
         static std::mt19937_64 &getRng();
     };
 }
@@ -89,11 +89,16 @@ RyzenMonitorUi::RyzenMonitorUi()
 
     bInfoDirty = true;
 
-    ThreadService::newJob("ryzenmonitor", 1s, [this] {
+    updateJob = ThreadService::newJob("ryzenmonitor", 1s, [this] {
         updateCoreInfo();
     });
 }
 
+RyzenMonitorUi::~RyzenMonitorUi() {
+    // waits out an update thats already running so it cant outlive us
+    updateJob.cancel();
+}
+
 struct ChildWidget {
     const char *name = nullptr;
     void (RyzenMonitorUi::*draw)() = nullptr;
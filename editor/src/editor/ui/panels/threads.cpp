@@ -2,7 +2,10 @@
 
 #include "engine/core/range.h"
 
+#include "engine/core/arena.h"
 #include "engine/core/units.h"
+#include "engine/log/service.h"
+#include "engine/threads/parallel.h"
 #include "imgui/imgui_internal.h"
 
 using namespace editor;
@@ -58,8 +61,89 @@ void ThreadServiceUi::draw() {
         ThreadService::setWorkerCount(workers);
     }
 
-    mt::ReadLock lock(ThreadService::getPoolLock());
-    auto& pool = ThreadService::getPool();
+    auto stats = ThreadService::getWorkStats();
+    ImGui::Text("jobs executed: %zu", stats.executed);
+    ImGui::Text("jobs injected: %zu", stats.injected);
+    ImGui::Text("jobs stolen: %zu", stats.stolen);
+    ImGui::Text("worker parks: %zu", stats.parked);
+    ImGui::Text("job node allocations: %zu", stats.dequeNodeAllocs);
+    ImGui::Text("jobs on the heap: %zu", stats.heapJobs);
+
+    if (ImGui::BeginTable("##lanes", 6, ImGuiTableFlags_SizingStretchSame | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("lane", ImGuiTableColumnFlags_WidthStretch, 100.f);
+        ImGui::TableSetupColumn("depth", ImGuiTableColumnFlags_WidthStretch, 100.f);
+        ImGui::TableSetupColumn("executed", ImGuiTableColumnFlags_WidthStretch, 100.f);
+        ImGui::TableSetupColumn("promoted", ImGuiTableColumnFlags_WidthStretch, 100.f);
+        ImGui::TableSetupColumn("avg latency (us)", ImGuiTableColumnFlags_WidthStretch, 100.f);
+        ImGui::TableSetupColumn("p99 latency (us)", ImGuiTableColumnFlags_WidthStretch, 100.f);
+        ImGui::TableHeadersRow();
+
+        for (const auto& [index, lane] : core::enumerate(stats.lanes)) {
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", getPriorityName(threads::ThreadType(index)));
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", lane.depth);
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", lane.executed);
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", lane.promoted);
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%lld", lane.avgLatency.count());
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%lld (max %lld)", lane.p99Latency.count(), lane.maxLatency.count());
+        }
+
+        ImGui::EndTable();
+    }
+
+    if (auto scaler = ThreadService::getScalerStats()) {
+        std::vector<float> history(scaler->history.begin(), scaler->history.end());
+        ImGui::Text("workers added: %zu, retired: %zu (latency %lldus)", scaler->grown, scaler->shrunk, scaler->lastLatency.count());
+        ImGui::PlotLines("worker count", history.data(), int(history.size()), 0, nullptr, 0.f, FLT_MAX, ImVec2(0, 60));
+    }
+
+    auto main = ThreadService::getMainStats();
+    ImGui::Text("main queue backlog: %zu (max %zu)", main.backlog, main.maxBacklog);
+    ImGui::Text("main queue latency: %lldus avg, %lldus max", main.avgLatency.count(), main.maxLatency.count());
+    ImGui::Text("main queue drains over budget: %zu", main.overBudget);
+
+    auto logs = LoggingService::getQueueStats();
+    ImGui::Text("log queue: %zu / %zu", logs.depth, logs.capacity);
+    ImGui::Text("log messages: %zu (dropped %zu, rejected %zu, producers blocked %zu)", logs.pushed, logs.dropped, logs.failed, logs.blocked);
+
+    auto timers = ThreadService::getTimerStats();
+    ImGui::Text("active timers: %zu", timers.active);
+    ImGui::Text("timers fired: %zu (skipped %zu, overruns %zu)", timers.fired, timers.skipped, timers.overruns);
+
+    auto parallel = threads::getParallelStats();
+    ImGui::Text("parallel calls: %zu (%zu ran inline)", parallel.calls, parallel.serial);
+    ImGui::Text("parallel chunks: %zu (%zu on workers)", parallel.chunks, parallel.helped);
+
+    auto arenas = core::getFrameArenaStats();
+    ImGui::Text("frame arena allocations: %zu (%zu heap blocks)", arenas.allocs, arenas.blocks);
+    ImGui::Text("frame arena usage: %zu / %zu bytes", arenas.used, arenas.capacity);
+
+    for (const threads::NodeMemoryStats& node : threads::getNodeMemoryStats()) {
+        auto reserved = units::Memory(node.reserved).string();
+        ImGui::Text("node %u memory: %s (%zu allocs, %zu frees)%s", node.id, reserved.c_str(), node.allocs, node.frees, node.bBound ? "" : " unbound");
+    }
+
+    const auto& scheduler = ThreadService::getScheduler();
+    ImGui::Text("worker chiplet spread: %zu", scheduler.getChipletSpread(threads::eWorker));
+
+    if constexpr (mt::isLockProfilingEnabled()) {
+        drawLocks();
+    }
+
+    auto epoch = ThreadService::getThreadEpochStats();
+    ImGui::Text("thread handle epoch: %llu (%zu retired, %zu freed)", epoch.epoch, epoch.pending, epoch.reclaimed);
+
+    auto pool = ThreadService::getThreads();
     ImGui::Text("total threads: %zu", pool.size());
 
     if (ImGui::BeginTable("Threads", 4, ImGuiTableFlags_SizingStretchSame | ImGuiTableFlags_RowBg)) {
@@ -97,6 +181,69 @@ void ThreadServiceUi::draw() {
     }
 }
 
+void ThreadServiceUi::drawLocks() const {
+    ImGui::SeparatorText("locks");
+
+    if (ImGui::Button("Reset")) {
+        mt::resetLockStats();
+    }
+
+    ImGuiTableFlags flags = ImGuiTableFlags_SizingStretchSame | ImGuiTableFlags_RowBg;
+    if (ImGui::BeginTable("##locks", 6, flags)) {
+        ImGui::TableSetupColumn("name", ImGuiTableColumnFlags_WidthStretch, 100.f);
+        ImGui::TableSetupColumn("acquires", ImGuiTableColumnFlags_WidthStretch, 100.f);
+        ImGui::TableSetupColumn("contended", ImGuiTableColumnFlags_WidthStretch, 100.f);
+        ImGui::TableSetupColumn("total wait (us)", ImGuiTableColumnFlags_WidthStretch, 100.f);
+        ImGui::TableSetupColumn("max wait (us)", ImGuiTableColumnFlags_WidthStretch, 100.f);
+        ImGui::TableSetupColumn("max hold (us)", ImGuiTableColumnFlags_WidthStretch, 100.f);
+        ImGui::TableHeadersRow();
+
+        // locks are sorted by total wait, so the interesting ones are at the top
+        for (const mt::LockStats& lock : mt::getLockStats()) {
+            size_t total = lock.acquires + lock.shared;
+            if (total == 0) continue;
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", lock.name.c_str());
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu (%zu shared)", total, lock.shared);
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu (%.2f%%)", lock.contended, double(lock.contended) / double(total) * 100.0);
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", double(lock.totalWait) / 1000.0);
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", double(lock.maxWait) / 1000.0);
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", double(lock.maxHold) / 1000.0);
+
+            if (ImGui::TableGetHoveredRow() == ImGui::TableGetRowIndex()) {
+                std::array<float, mt::kLockBuckets> wait;
+                std::array<float, mt::kLockBuckets> hold;
+                for (size_t i = 0; i < mt::kLockBuckets; i++) {
+                    wait[i] = float(lock.waitHistogram[i]);
+                    hold[i] = float(lock.holdHistogram[i]);
+                }
+
+                ImGui::BeginTooltip();
+                ImGui::PlotHistogram("wait", wait.data(), int(wait.size()), 0, nullptr, 0.f, FLT_MAX, ImVec2(0, 60));
+                ImGui::PlotHistogram("hold", hold.data(), int(hold.size()), 0, nullptr, 0.f, FLT_MAX, ImVec2(0, 60));
+                for (const mt::LockWaiter& waiter : lock.waiters) {
+                    auto name = threads::getThreadName(waiter.id);
+                    ImGui::Text("%s: %zu waits, %.1fus", name.data(), waiter.contended, double(waiter.wait) / 1000.0);
+                }
+                ImGui::EndTooltip();
+            }
+        }
+
+        ImGui::EndTable();
+    }
+}
+
 void ThreadServiceUi::drawPackage(const threads::Package& package) const {
     ImGuiTableFlags flags = ImGuiTableFlags_SizingStretchSame | ImGuiTableFlags_RowBg;
 
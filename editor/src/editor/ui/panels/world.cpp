@@ -19,13 +19,66 @@ void WorldUi::draw() {
 
     ImGui::Text("World (%zu entities)", entities.getUsed());
 
+    if (ImGui::CollapsingHeader("Archetypes")) {
+        game::ArchetypeStats stats = world.archetypes.getStats();
+        ImGui::Text("Archetypes: %zu", stats.archetypes);
+        ImGui::Text("Chunks: %zu", stats.chunks);
+        ImGui::Text("Rows: %zu", stats.rows);
+        ImGui::Text("Moves: %zu", stats.moves);
+
+        for (const auto& [signature, pArchetype] : world.archetypes.getArchetypes()) {
+            ImGui::BulletText("%zu components, %u entities in %zu chunks", signature.size(), pArchetype->getSize(), pArchetype->getChunkCount());
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Storage")) {
+        ImGui::Text("Tick: %zu", world.getTick());
+        for (const auto& [info, storage] : world.objects) {
+            game::StorageStats stats = storage.getStats();
+            ImGui::BulletText("type %zu: %zu/%zu used, %zu made, %zu destroyed", info.getId(), storage.getUsed(), storage.getSize(), stats.constructed, stats.destroyed);
+            ImGui::Text("    %zu pages: %zu reserved, %zu background, %zu in frame", stats.pages, stats.reservedPages, stats.backgroundPages, stats.syncPages);
+            ImGui::Text("    last tick: %zu changed, %zu unchanged", stats.changed, stats.unchanged);
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Systems")) {
+        game::SchedulerStats stats = game::GameService::getSystems().getStats();
+        auto toMs = [](std::chrono::nanoseconds time) { return std::chrono::duration<float, std::milli>(time).count(); };
+
+        ImGui::Text("Phases: %zu (widest %zu)", stats.phases, stats.widest);
+        ImGui::Text("Frame: %.3fms (%.3fms serial)", toMs(stats.frameTime), toMs(stats.serialTime));
+
+        for (const game::SystemStats& system : stats.systems) {
+            ImGui::BulletText("%s: phase %zu, %.3fms", system.name.c_str(), system.phase, toMs(system.time));
+        }
+
+        game::CommandStats commands = world.getCommandStats();
+        ImGui::Text("Commands: %zu last batch, %zu batches, %zu buffers", commands.lastBatch, commands.batches, commands.buffers);
+        ImGui::Text("Created %zu, attached %zu, destroyed %zu, skipped %zu", commands.creates, commands.attaches, commands.destroys, commands.skipped);
+    }
+
+    if (ImGui::CollapsingHeader("Events")) {
+        game::EventStats stats = world.getEventStats();
+        ImGui::Text("Sent: %zu, ignored: %zu", stats.sent, stats.ignored);
+        ImGui::Text("Queued: %zu, delivered: %zu, dropped: %zu", stats.queued, stats.delivered, stats.dropped);
+        ImGui::Text("Flushes: %zu (%zu in the last)", stats.flushes, stats.lastFlush);
+    }
+
+    if (ImGui::CollapsingHeader("Queries")) {
+        for (const auto& pQuery : world.queries) {
+            if (pQuery == nullptr) continue;
+
+            ImGui::BulletText("%zu components, %zu archetypes, %zu entities", pQuery->getTypes().size(), pQuery->getMatches().size(), pQuery->size());
+        }
+    }
+
     if (ImGui::CollapsingHeader("Entities")) {
         for (auto *pEntity : world.all()) {
             const auto& name = pEntity->getName();
             auto info = pEntity->getTypeInfo();
             if (ImGui::TreeNode((void*)pEntity, "Entity: %s (typeid: %zu)", name.c_str(), info.getId())) {
 
-                for (const auto& [id, pComponent] : pEntity->getComponents()) {
+                for (game::ComponentPtr pComponent : pEntity->getComponents()) {
                     auto compInfo = pComponent->getTypeInfo();
                     const auto& compName = pComponent->getName();
 
@@ -0,0 +1,249 @@
+#include "game/ecs/archetype.h"
+
+#include "game/ecs/objects.h"
+#include "game/ecs/query.h"
+
+#include <algorithm>
+
+using namespace game;
+
+// archetype
+
+Archetype::Archetype(Signature signature, std::vector<ColumnLayout> layouts)
+    : signature(std::move(signature))
+    , layouts(std::move(layouts))
+{
+    SM_ASSERTF(this->signature.size() < kInvalidColumn, "archetype has too many components {}", this->signature.size());
+    SM_ASSERTF(this->signature.size() == this->layouts.size(), "archetype has {} types but {} layouts", this->signature.size(), this->layouts.size());
+
+    size_t maxId = this->signature.empty() ? 0 : this->signature.back() + 1;
+    columns.resize(maxId, kInvalidColumn);
+
+    for (size_t i = 0; i < this->signature.size(); ++i) {
+        columns[this->signature[i]] = uint16_t(i);
+
+        const ColumnLayout& layout = this->layouts[i];
+        size_t stride = layout.isOwned() ? layout.size : sizeof(ComponentPtr);
+        size_t align = layout.isOwned() ? layout.align : alignof(ComponentPtr);
+
+        chunkSize = (chunkSize + align - 1) & ~(align - 1);
+        chunkAlign = std::max(chunkAlign, align);
+
+        offsets.push_back(chunkSize);
+        strides.push_back(stride);
+        chunkSize += stride * kChunkRows;
+    }
+
+    chunkSize = std::max<size_t>(chunkSize, 1);
+}
+
+uint32_t Archetype::insert(EntityPtr pEntity) {
+    uint32_t row = used++;
+    size_t chunk = row / kChunkRows;
+
+    if (chunk == chunks.size()) {
+        chunks.push_back(std::make_unique<Chunk>(chunkSize, chunkAlign));
+    }
+
+    chunks[chunk]->entities[row % kChunkRows] = pEntity;
+    for (size_t column = 0; column < getColumnCount(); ++column) {
+        if (!isOwnedColumn(column)) {
+            setComponentAt(column, row, nullptr);
+        }
+    }
+
+    return row;
+}
+
+EntityPtr Archetype::erase(uint32_t row) {
+    SM_ASSERTF(row < used, "archetype row {} out of range", row);
+
+    uint32_t last = used - 1;
+    EntityPtr pMoved = nullptr;
+
+    if (row != last) {
+        pMoved = getEntity(last);
+        chunks[row / kChunkRows]->entities[row % kChunkRows] = pMoved;
+        moveRow(row, last);
+    }
+
+    used -= 1;
+
+    // keep one empty chunk around so an entity bouncing on a chunk boundary doesnt thrash the heap
+    size_t needed = (used + kChunkRows - 1) / kChunkRows;
+    if (chunks.size() > needed + 1) {
+        chunks.pop_back();
+    }
+
+    return pMoved;
+}
+
+void Archetype::setComponentAt(size_t column, uint32_t row, ComponentPtr pComponent) {
+    SM_ASSERTF(!isOwnedColumn(column), "archetype column {} holds owned components, they are constructed in place", column);
+
+    *static_cast<ComponentPtr*>(getSlot(column, row)) = pComponent;
+}
+
+void Archetype::relocate(size_t column, uint32_t row, const Archetype *pSrc, size_t srcColumn, uint32_t srcRow) {
+    const ColumnLayout& layout = layouts[column];
+    SM_ASSERTF(layout.isOwned(), "archetype column {} holds shared components", column);
+
+    // handles resolve through the storage, so it has to follow the component
+    ComponentPtr pComponent = layout.pfnRelocate(getSlot(column, row), pSrc->getSlot(srcColumn, srcRow));
+    layout.pStorage->insert(pComponent->getInstanceId(), pComponent);
+}
+
+void Archetype::moveRow(uint32_t dst, uint32_t src) {
+    for (size_t column = 0; column < getColumnCount(); ++column) {
+        if (isOwnedColumn(column)) {
+            relocate(column, dst, this, column, src);
+        } else {
+            setComponentAt(column, dst, getComponentAt(column, src));
+        }
+    }
+}
+
+void Archetype::setAddEdge(size_t typeId, Archetype *pArchetype) {
+    if (typeId >= addEdges.size()) {
+        addEdges.resize(typeId + 1, nullptr);
+    }
+
+    addEdges[typeId] = pArchetype;
+}
+
+// storage
+
+void ArchetypeStorage::setLayout(size_t typeId, ColumnLayout layout) {
+    if (typeId >= layouts.size()) {
+        layouts.resize(typeId + 1);
+    }
+
+    layouts[typeId] = layout;
+}
+
+void ArchetypeStorage::attach(EntityPtr pEntity, ComponentPtr pComponent) {
+    size_t typeId = pComponent->getTypeId();
+    SM_ASSERTF(!isOwned(typeId), "component type {} is owned, it has to be constructed in place", typeId);
+
+    size_t column = moveToAdded(pEntity, typeId);
+    pEntity->location.pArchetype->setComponentAt(column, pEntity->location.row, pComponent);
+}
+
+void *ArchetypeStorage::emplace(EntityPtr pEntity, size_t typeId) {
+    SM_ASSERTF(isOwned(typeId), "component type {} is shared, attach it by pointer", typeId);
+
+    size_t column = moveToAdded(pEntity, typeId);
+    return pEntity->location.pArchetype->getSlot(column, pEntity->location.row);
+}
+
+size_t ArchetypeStorage::moveToAdded(EntityPtr pEntity, size_t typeId) {
+    EntityLocation& location = pEntity->location;
+
+    if (location.pArchetype == nullptr) {
+        location.pArchetype = getArchetype({});
+        location.row = location.pArchetype->insert(pEntity);
+    }
+
+    Archetype *pOld = location.pArchetype;
+
+    // adding a type the entity already has doesnt change its archetype
+    if (uint16_t column = pOld->getColumn(typeId); column != Archetype::kInvalidColumn) {
+        return column;
+    }
+
+    Archetype *pNew = getWithAdded(pOld, typeId);
+    uint32_t oldRow = location.row;
+    uint32_t newRow = pNew->insert(pEntity);
+    size_t added = pNew->getColumn(typeId);
+
+    // both signatures are sorted, walk them together to carry the existing components over
+    const Signature& oldTypes = pOld->getSignature();
+    for (size_t src = 0; src < oldTypes.size(); ++src) {
+        size_t dst = pNew->getColumn(oldTypes[src]);
+
+        if (pOld->isOwnedColumn(src)) {
+            pNew->relocate(dst, newRow, pOld, src, oldRow);
+        } else {
+            pNew->setComponentAt(dst, newRow, pOld->getComponentAt(src, oldRow));
+        }
+    }
+
+    if (EntityPtr pMoved = pOld->erase(oldRow)) {
+        pMoved->location.row = oldRow;
+    }
+
+    location = { pNew, newRow };
+    moves += 1;
+
+    return added;
+}
+
+void ArchetypeStorage::remove(EntityPtr pEntity) {
+    EntityLocation& location = pEntity->location;
+    if (location.pArchetype == nullptr) return;
+
+    if (EntityPtr pMoved = location.pArchetype->erase(location.row)) {
+        pMoved->location.row = location.row;
+    }
+
+    location = {};
+}
+
+void ArchetypeStorage::addQuery(QueryBase *pQuery) {
+    for (const auto& [signature, pArchetype] : archetypes) {
+        if (pQuery->matches(*pArchetype)) {
+            pQuery->addArchetype(pArchetype.get());
+        }
+    }
+
+    queries.push_back(pQuery);
+}
+
+ArchetypeStats ArchetypeStorage::getStats() const {
+    ArchetypeStats stats = {
+        .archetypes = archetypes.size(),
+        .moves = moves
+    };
+
+    for (const auto& [signature, pArchetype] : archetypes) {
+        stats.chunks += pArchetype->getChunkCount();
+        stats.rows += pArchetype->getSize();
+    }
+
+    return stats;
+}
+
+Archetype *ArchetypeStorage::getArchetype(const Signature& signature) {
+    if (auto it = archetypes.find(signature); it != archetypes.end()) {
+        return it->second.get();
+    }
+
+    std::vector<ColumnLayout> columns;
+    for (size_t typeId : signature) {
+        columns.push_back((typeId < layouts.size()) ? layouts[typeId] : ColumnLayout{});
+    }
+
+    auto [it, inserted] = archetypes.emplace(signature, std::make_unique<Archetype>(signature, std::move(columns)));
+    Archetype *pArchetype = it->second.get();
+
+    for (QueryBase *pQuery : queries) {
+        if (pQuery->matches(*pArchetype)) {
+            pQuery->addArchetype(pArchetype);
+        }
+    }
+
+    return pArchetype;
+}
+
+Archetype *ArchetypeStorage::getWithAdded(Archetype *pArchetype, size_t typeId) {
+    if (Archetype *pEdge = pArchetype->getAddEdge(typeId)) {
+        return pEdge;
+    }
+
+    Signature signature = pArchetype->getSignature();
+    signature.insert(std::upper_bound(signature.begin(), signature.end(), typeId), typeId);
+
+    Archetype *pResult = getArchetype(signature);
+    pArchetype->setAddEdge(typeId, pResult);
+    return pResult;
+}
@@ -0,0 +1,140 @@
+#include "game/ecs/commands.h"
+
+#include "game/ecs/world.h"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace game;
+
+namespace {
+    template<typename T>
+    void append(std::vector<T>& dst, std::vector<T>& src) {
+        dst.insert(dst.end(), std::make_move_iterator(src.begin()), std::make_move_iterator(src.end()));
+        src.clear();
+    }
+
+    struct Doomed {
+        EntityPtr pEntity;
+        EntityLocation location;
+    };
+}
+
+static std::atomic_size_t gNextQueueId = 1;
+
+CommandQueue::CommandQueue()
+    : id(gNextQueueId++)
+{ }
+
+CommandBuffer& CommandQueue::get() {
+    // the queue this thread recorded into last, so a run of commands into one world never locks
+    thread_local size_t tlsQueueId = 0;
+    thread_local CommandBuffer *tlsBuffer = nullptr;
+
+    if (tlsQueueId == id) {
+        return *tlsBuffer;
+    }
+
+    // a thread moving between worlds picks its old buffer back up rather than making another
+    std::thread::id self = std::this_thread::get_id();
+
+    std::lock_guard guard(lock);
+    auto it = std::find_if(buffers.begin(), buffers.end(), [&](const auto& pBuffer) {
+        return pBuffer->owner == self;
+    });
+
+    if (it == buffers.end()) {
+        it = buffers.insert(buffers.end(), std::unique_ptr<CommandBuffer>(new CommandBuffer(self)));
+    }
+
+    tlsBuffer = it->get();
+    tlsQueueId = id;
+    return *tlsBuffer;
+}
+
+void CommandQueue::apply(World& world) {
+    {
+        std::lock_guard guard(lock);
+        for (auto& pBuffer : buffers) {
+            append(batch.creates, pBuffer->creates);
+            append(batch.attaches, pBuffer->attaches);
+            append(batch.destroys, pBuffer->destroys);
+        }
+    }
+
+    size_t total = batch.size();
+    if (total == 0) return;
+
+    size_t attached = 0;
+    size_t skipped = 0;
+
+    // listeners get every new object and attachment in one go once they have all been made
+    world.setQueueEvents(true);
+
+    // creates may record more commands, those go in the next batch
+    for (CommandFn& fn : batch.creates) {
+        fn(world);
+    }
+
+    for (const auto& [handle, pComponent] : batch.attaches) {
+        if (IEntity *pEntity = world.resolve(handle)) {
+            pEntity->addComponent(pComponent);
+            attached += 1;
+        } else {
+            skipped += 1;
+        }
+    }
+
+    world.setQueueEvents(false);
+    world.flushEvents();
+
+    // the same entity is often destroyed by more than one system in a frame
+    std::sort(batch.destroys.begin(), batch.destroys.end(), [](EntityHandle lhs, EntityHandle rhs) {
+        return std::tie(lhs.index, lhs.generation) < std::tie(rhs.index, rhs.generation);
+    });
+
+    auto last = std::unique(batch.destroys.begin(), batch.destroys.end());
+    skipped += std::distance(last, batch.destroys.end());
+    batch.destroys.erase(last, batch.destroys.end());
+
+    std::vector<Doomed> doomed;
+    doomed.reserve(batch.destroys.size());
+    for (EntityHandle handle : batch.destroys) {
+        if (IEntity *pEntity = world.resolve(handle)) {
+            doomed.push_back({ pEntity, pEntity->getLocation() });
+        } else {
+            skipped += 1;
+        }
+    }
+
+    std::sort(doomed.begin(), doomed.end(), [](const Doomed& lhs, const Doomed& rhs) {
+        if (lhs.location.pArchetype != rhs.location.pArchetype) {
+            return std::less<Archetype*>()(lhs.location.pArchetype, rhs.location.pArchetype);
+        }
+
+        return lhs.location.row > rhs.location.row;
+    });
+
+    for (const Doomed& entry : doomed) {
+        world.destroy(entry.pEntity);
+    }
+
+    std::lock_guard guard(lock);
+    stats.batches += 1;
+    stats.creates += batch.creates.size();
+    stats.attaches += attached;
+    stats.destroys += doomed.size();
+    stats.skipped += skipped;
+    stats.lastBatch = total;
+
+    batch.creates.clear();
+    batch.attaches.clear();
+    batch.destroys.clear();
+}
+
+CommandStats CommandQueue::getStats() const {
+    std::lock_guard guard(lock);
+    CommandStats result = stats;
+    result.buffers = buffers.size();
+    return result;
+}
@@ -0,0 +1,35 @@
+#include "game/ecs/query.h"
+
+#include <algorithm>
+
+using namespace game;
+
+QueryBase::QueryBase(Signature types)
+    : types(std::move(types))
+{ }
+
+bool QueryBase::matches(const Archetype& archetype) const {
+    return std::all_of(types.begin(), types.end(), [&](size_t typeId) {
+        return archetype.has(typeId);
+    });
+}
+
+void QueryBase::addArchetype(Archetype *pArchetype) {
+    SM_ASSERTF(matches(*pArchetype), "archetype does not match query");
+
+    QueryMatch match = { .pArchetype = pArchetype, .columns = {} };
+    for (size_t typeId : types) {
+        match.columns.push_back(pArchetype->getColumn(typeId));
+    }
+
+    matched.push_back(std::move(match));
+}
+
+size_t QueryBase::size() const {
+    size_t result = 0;
+    for (const QueryMatch& match : matched) {
+        result += match.pArchetype->getSize();
+    }
+
+    return result;
+}
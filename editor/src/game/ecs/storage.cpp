@@ -3,47 +3,158 @@
 #include "engine/log/service.h"
 #include "game/ecs/objects.h"
 
+#include <algorithm>
+
 using namespace game;
 
-ObjectStorage::ObjectStorage(TypeInfo info, size_t size)
+ObjectStorage::Page::Page(ObjectLayout layout)
+    : memory(nullptr, MemoryDelete{ layout.align })
+{
+    if (layout.size != 0) {
+        memory.reset(static_cast<std::byte*>(::operator new[](layout.size * kPageSlots, std::align_val_t(layout.align))));
+    }
+}
+
+ObjectStorage::ObjectStorage(TypeInfo info, size_t reserve, ObjectLayout layout)
     : info(info)
-    , objects(size)
-    , alloc(size)
-{ }
+    , layout(layout)
+{
+    this->reserve(reserve);
+}
 
 Index ObjectStorage::allocate() {
-    Index index = alloc.alloc();
-    SM_ASSERTF(index != Index::eInvalid, "storage {} is full", getTypeId());
-    return index;
+    while (firstFree < pages.size() && pages[firstFree]->alloc.countSetBits() == kPageSlots) {
+        firstFree += 1;
+    }
+
+    if (firstFree == pages.size()) {
+        grow();
+    }
+
+    Index slot = pages[firstFree]->alloc.alloc();
+    SM_ASSERTF(slot != Index::eInvalid, "storage {} page {} is full", getTypeId(), firstFree);
+
+    used += 1;
+    if (getSize() - used < kPageSlots) {
+        requestSpare();
+    }
+
+    return Index(firstFree * kPageSlots + size_t(slot));
 }
 
 void ObjectStorage::release(Index index) {
     SM_ASSERTF(isAllocated(index), "storage {} index {} is not allocated", getTypeId(), size_t(index));
-    
-    alloc.release(index);
+
+    Page& page = getPage(size_t(index));
+    size_t slot = getSlotIndex(size_t(index));
+
+    // anything still holding a handle to this slot will fail to resolve from now on
+    page.objects[slot] = nullptr;
+    page.generations[slot] += 1;
+    page.alloc.release(Index(slot));
+    page.changed.release(ChangeIndex(slot));
+
+    used -= 1;
+    firstFree = std::min(firstFree, size_t(index) / kPageSlots);
+}
+
+void *ObjectStorage::getSlot(Index index) {
+    SM_ASSERTF(isAllocated(index), "storage {} index {} is not allocated", getTypeId(), size_t(index));
+    SM_ASSERTF(layout.size != 0, "storage {} does not hold objects", getTypeId());
+
+    stats.constructed += 1;
+    return getPage(size_t(index)).memory.get() + getSlotIndex(size_t(index)) * layout.size;
+}
+
+void ObjectStorage::destroy(Index index) {
+    ObjectPtr pObject = get(index);
+    SM_ASSERTF(pObject != nullptr, "storage {} index {} has no object", getTypeId(), size_t(index));
+
+    pObject->~IObject();
+    stats.destroyed += 1;
+
+    release(index);
 }
 
 void ObjectStorage::insert(Index index, ObjectPtr pObject) {
     SM_ASSERTF(isAllocated(index), "storage {} index {} is not allocated", getTypeId(), size_t(index));
 
-    objects[size_t(index)] = pObject;
+    getPage(size_t(index)).objects[getSlotIndex(size_t(index))] = pObject;
+}
+
+void ObjectStorage::adopt(Index index, ObjectPtr pObject) {
+    insert(index, pObject);
+    stats.constructed += 1;
 }
 
 ObjectPtr ObjectStorage::get(Index index) const {
     SM_ASSERTF(isAllocated(index), "storage {} index {} is not allocated", getTypeId(), size_t(index));
 
-    return objects[size_t(index)];
+    return at(index);
+}
+
+void ObjectStorage::reserve(size_t count) {
+    while (getSize() < count) {
+        pages.push_back(std::make_unique<Page>(layout));
+        stats.reservedPages += 1;
+    }
+}
+
+void ObjectStorage::clearChanged() {
+    size_t changed = 0;
+    for (auto& pPage : pages) {
+        size_t count = pPage->changed.countSetBits();
+        if (count == 0) continue;
+
+        changed += count;
+        pPage->changed.reset();
+    }
+
+    stats.changed = changed;
+    stats.unchanged = used - changed;
+}
+
+StorageStats ObjectStorage::getStats() const {
+    StorageStats result = stats;
+    result.pages = pages.size();
+    return result;
+}
+
+void ObjectStorage::grow() {
+    if (Page *pPage = spare->pPage.exchange(nullptr)) {
+        pages.emplace_back(pPage);
+        stats.backgroundPages += 1;
+    } else {
+        pages.push_back(std::make_unique<Page>(layout));
+        stats.syncPages += 1;
+    }
+}
+
+void ObjectStorage::requestSpare() {
+    if (!worker || spare->pPage.load() != nullptr) return;
+    if (spare->bPending.exchange(true)) return;
+
+    worker([spare = spare, layout = layout] {
+        Page *pPage = new Page(layout);
+
+        Page *pExpected = nullptr;
+        if (!spare->pPage.compare_exchange_strong(pExpected, pPage)) {
+            delete pPage;
+        }
+
+        spare->bPending = false;
+    });
 }
 
 StorageIter ObjectStorage::begin() { return StorageIter(this, 0); }
-StorageIter ObjectStorage::end() { return StorageIter(this, alloc.getTotalBits()); }
+StorageIter ObjectStorage::end() { return StorageIter(this, getSize()); }
 
 StorageIter::StorageIter(ObjectStorage *pStorage, size_t index)
     : pStorage(pStorage)
     , index(index)
 { 
-    while (*this && !pStorage->isAllocated(Index(index))) {
-        ++index;
+    while (*this && !pStorage->isAllocated(Index(this->index))) {
+        ++this->index;
     }
 }
 
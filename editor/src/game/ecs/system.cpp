@@ -0,0 +1,177 @@
+#include "game/ecs/system.h"
+
+#include "engine/threads/parallel.h"
+
+#include <algorithm>
+
+using namespace simcoe;
+using namespace game;
+
+namespace {
+    void insertSorted(Signature& types, size_t typeId) {
+        auto it = std::lower_bound(types.begin(), types.end(), typeId);
+        if (it == types.end() || *it != typeId) {
+            types.insert(it, typeId);
+        }
+    }
+
+    bool intersects(const Signature& lhs, const Signature& rhs) {
+        auto l = lhs.begin();
+        auto r = rhs.begin();
+
+        while (l != lhs.end() && r != rhs.end()) {
+            if (*l < *r) ++l;
+            else if (*r < *l) ++r;
+            else return true;
+        }
+
+        return false;
+    }
+}
+
+// builder
+
+SystemBuilder& SystemBuilder::exclusive() {
+    scheduler.systems[index].bExclusive = true;
+    scheduler.bDirty = true;
+    return *this;
+}
+
+World *SystemBuilder::getWorld() const {
+    return &scheduler.world;
+}
+
+void SystemBuilder::addRead(size_t typeId) {
+    insertSorted(scheduler.systems[index].reads, typeId);
+    scheduler.bDirty = true;
+}
+
+void SystemBuilder::addWrite(size_t typeId) {
+    insertSorted(scheduler.systems[index].writes, typeId);
+    scheduler.bDirty = true;
+}
+
+// scheduler
+
+SystemScheduler::SystemScheduler(World& world, mt::SharedMutex& lock)
+    : world(world)
+    , lock(lock)
+{ }
+
+SystemBuilder SystemScheduler::system(std::string name, SystemFn fn) {
+    size_t index = systems.size();
+    systems.push_back({ .name = std::move(name), .reads = {}, .writes = {}, .fn = std::move(fn) });
+    bDirty = true;
+
+    return SystemBuilder(*this, index);
+}
+
+bool SystemScheduler::conflicts(const SystemInfo& lhs, const SystemInfo& rhs) {
+    if (lhs.bExclusive || rhs.bExclusive) return true;
+
+    return intersects(lhs.writes, rhs.writes)
+        || intersects(lhs.writes, rhs.reads)
+        || intersects(lhs.reads, rhs.writes);
+}
+
+void SystemScheduler::buildPhases() {
+    systemPhase.assign(systems.size(), 0);
+    phases.clear();
+
+    // each system goes in the phase after the last earlier system it conflicts with
+    for (size_t i = 0; i < systems.size(); i++) {
+        size_t phase = 0;
+        for (size_t j = 0; j < i; j++) {
+            if (conflicts(systems[i], systems[j])) {
+                phase = std::max(phase, systemPhase[j] + 1);
+            }
+        }
+
+        systemPhase[i] = phase;
+        if (phase >= phases.size()) {
+            phases.resize(phase + 1);
+        }
+
+        phases[phase].push_back(i);
+    }
+
+    times.assign(systems.size(), {});
+    bDirty = false;
+}
+
+void SystemScheduler::runPhase(const std::vector<size_t>& phase, float delta) {
+    bool bExclusive = phase.size() == 1 && systems[phase[0]].bExclusive;
+    bool bWrites = std::any_of(phase.begin(), phase.end(), [&](size_t i) {
+        return systems[i].bExclusive || !systems[i].writes.empty();
+    });
+
+    auto runSystem = [&](size_t i) {
+        auto start = std::chrono::steady_clock::now();
+        systems[i].fn(world, delta);
+        times[i] = std::chrono::steady_clock::now() - start;
+    };
+
+    auto runAll = [&] {
+        world.setFrozen(!bExclusive);
+
+        if (phase.size() == 1) {
+            runSystem(phase[0]);
+        } else {
+            threads::parallelEach(phase, runSystem, 1);
+        }
+
+        world.setFrozen(false);
+    };
+
+    if (bWrites) {
+        mt::WriteLock guard(lock);
+        runAll();
+    } else {
+        mt::ReadLock guard(lock);
+        runAll();
+    }
+}
+
+void SystemScheduler::run(float delta) {
+    if (bDirty) {
+        buildPhases();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (const auto& phase : phases) {
+        runPhase(phase, delta);
+    }
+
+    // the sync point, everything the systems deferred happens here in one batch
+    // and counts as a change in the next tick
+    {
+        mt::WriteLock guard(lock);
+        world.advanceTick();
+        world.applyCommands();
+    }
+
+    auto frameTime = std::chrono::steady_clock::now() - start;
+
+    std::lock_guard guard(statsLock);
+    stats.phases = phases.size();
+    stats.widest = 0;
+    for (const auto& phase : phases) {
+        stats.widest = std::max(stats.widest, phase.size());
+    }
+
+    stats.frames += 1;
+    stats.frameTime = frameTime;
+    stats.serialTime = {};
+    stats.systems.resize(systems.size());
+
+    for (size_t i = 0; i < systems.size(); i++) {
+        stats.systems[i] = { systems[i].name, systemPhase[i], times[i] };
+        stats.serialTime += times[i];
+    }
+}
+
+SchedulerStats SystemScheduler::getStats() const {
+    std::lock_guard guard(statsLock);
+    return stats;
+}
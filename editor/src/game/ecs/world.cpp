@@ -7,6 +7,11 @@ size_t game::getUniqueId() {
     return gUniqueId++;
 }
 
+static size_t gUniqueQueryId = 0;
+size_t game::getUniqueQueryId() {
+    return gUniqueQueryId++;
+}
+
 TypeInfo game::makeNameInfo(World *pWorld, const std::string &name) {
     static std::unordered_map<std::string, TypeInfo> infos;
     
@@ -20,9 +25,13 @@ TypeInfo game::makeNameInfo(World *pWorld, const std::string &name) {
 }
 
 void IEntity::addComponent(IComponent *pComponent) {
-    auto info = pComponent->getTypeInfo();
-    components.insert_or_assign(info, pComponent);
-
     auto *pWorld = getWorld();
+    pWorld->archetypes.attach(this, pComponent);
     pWorld->notifyAttach(this, pComponent);
 }
+
+void IComponent::markChanged() {
+    auto *pWorld = getWorld();
+    changeTick = pWorld->getTick();
+    pWorld->markChanged(this);
+}
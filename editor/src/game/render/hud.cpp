@@ -154,7 +154,7 @@ void HudPass::execute() {
 
 void HudPass::update(const ui::Context& layout) {
     std::lock_guard guard(lock);
-    vertices = layout.vertices;
-    indices = layout.indices;
+    vertices.assign(layout.vertices.begin(), layout.vertices.end());
+    indices.assign(layout.indices.begin(), layout.indices.end());
     bDirty = true;
 }
@@ -94,9 +94,15 @@ Layout::Context(BoxBounds screenBounds)
     , user(screenBounds)
 { }
 
+void Layout::reset() {
+    // the old lists point into memory the arena may have already freed,
+    // so they have to be replaced rather than cleared
+    vertices = core::ArenaVector<UiVertex>(core::getFrameArena());
+    indices = core::ArenaVector<UiIndex>(core::getFrameArena());
+}
+
 void Layout::begin(IWidget *pWidget) {
-    vertices.clear();
-    indices.clear();
+    reset();
 
     DrawInfo info = {
         .bounds = user,
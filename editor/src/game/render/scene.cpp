@@ -94,6 +94,19 @@ void ScenePass::execute() {
     }
 }
 
+CommandBatch ScenePass::newCommandBatch() {
+    std::lock_guard guard(lock);
+
+    for (simcoe::core::Arena& arena : arenas) {
+        if (&arena == batch.getArena() || &arena == newBatch.getArena()) continue;
+
+        arena.reset();
+        return CommandBatch(arena);
+    }
+
+    SM_NEVER("all command batch arenas are in use");
+}
+
 void ScenePass::update(CommandBatch&& updateBatch) {
     std::lock_guard guard(lock);
     newBatch = std::move(updateBatch);
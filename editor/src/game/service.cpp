@@ -24,6 +24,7 @@ namespace {
 
     threads::WorkQueue *pWorkQueue = nullptr;
     mt::SharedMutex *pWorldMutex = nullptr;
+    game::SystemScheduler *pSystems = nullptr;
 
     std::mt19937_64 *pRng = nullptr;
 }
@@ -33,6 +34,7 @@ bool GameService::createService() {
     pRng = new std::mt19937_64(cfgWorkSeed.getCurrentValue());
     pWorkQueue = new threads::WorkQueue(64);
     pWorldMutex = new mt::SharedMutex("game");
+    pSystems = new game::SystemScheduler(*pWorld, *pWorldMutex);
     return true;
 }
 
@@ -65,6 +67,10 @@ mt::SharedMutex& GameService::getWorldMutex() {
     return *pWorldMutex;
 }
 
+game::SystemScheduler& GameService::getSystems() {
+    return *pSystems;
+}
+
 std::mt19937_64 &GameService::getRng() {
     return *pRng;
 }
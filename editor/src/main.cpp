@@ -3,6 +3,7 @@
 
 // core
 #include "editor/graph/mesh.h"
+#include "engine/core/arena.h"
 #include "engine/core/mt.h"
 
 // math
@@ -29,6 +30,7 @@
 // threads
 #include "engine/threads/schedule.h"
 #include "engine/threads/queue.h"
+#include "engine/threads/parallel.h"
 
 // util
 #include "engine/util/time.h"
@@ -219,6 +221,8 @@ struct CameraEntity : public IEntity { using IEntity::IEntity; };
 // asset types
 
 struct IAssetComp : public IComponent {
+    static constexpr bool kShared = true;
+
     IAssetComp(ComponentData data, fs::path path)
         : IComponent(data)
         , path(path)
@@ -507,26 +511,44 @@ struct TransformComp : public IComponent {
         float3 tr = rotation.degrees();
         float3 ts = scale;
 
+        // jobs run later on another thread, so they find us again through a handle
+        auto hSelf = getHandle<TransformComp>();
         auto& queue = GameService::getWorkQueue();
 
         if (ImGui::DragFloat3("position", tp.data(), 0.1f)) {
-            queue.add("update transform", [this, tp] {
+            queue.add("update transform", [hSelf, tp] {
                 mt::WriteLock lock(GameService::getWorldMutex());
-                position = tp;
+
+                // the component may have been destroyed and its slot reused before we ran
+                TransformComp *pSelf = GameService::getWorld().resolve(hSelf);
+                if (pSelf == nullptr) return;
+
+                pSelf->position = tp;
+                pSelf->markChanged();
             });
         }
 
         if (ImGui::DragFloat3("rotation", tr.data(), 5.f)) {
-            queue.add("update transform", [this, tr] {
+            queue.add("update transform", [hSelf, tr] {
                 mt::WriteLock lock(GameService::getWorldMutex());
-                rotation = tr.radians();
+
+                TransformComp *pSelf = GameService::getWorld().resolve(hSelf);
+                if (pSelf == nullptr) return;
+
+                pSelf->rotation = tr.radians();
+                pSelf->markChanged();
             });
         }
 
         if (ImGui::DragFloat3("scale", ts.data(), 0.1f)) {
-            queue.add("update transform", [this, ts] {
+            queue.add("update transform", [hSelf, ts] {
                 mt::WriteLock lock(GameService::getWorldMutex());
-                scale = ts;
+
+                TransformComp *pSelf = GameService::getWorld().resolve(hSelf);
+                if (pSelf == nullptr) return;
+
+                pSelf->scale = ts;
+                pSelf->markChanged();
             });
         }
     }
@@ -540,9 +562,12 @@ struct GpuTransformComp : public IComponent {
     using IComponent::IComponent;
     static constexpr const char *kTypeName = "gpu_transform";
 
-    GpuTransformComp(ComponentData data, TransformComp *pTransform)
+    // recycled between transforms rather than owned by one
+    static constexpr bool kShared = true;
+
+    GpuTransformComp(ComponentData data, Handle<TransformComp> hTransform)
         : IComponent(data)
-        , pTransform(pTransform)
+        , hTransform(hTransform)
     { }
 
     void onCreate() override {
@@ -550,8 +575,16 @@ struct GpuTransformComp : public IComponent {
         pModel = pGraph->addResource<game_render::ModelUniform>("uniform.model");
     }
 
-    TransformComp *pTransform = nullptr;
+    Handle<TransformComp> hTransform;
     ResourceWrapper<game_render::ModelUniform> *pModel = nullptr;
+
+    // rebuilt by the game thread when the transform changes, the version goes up every time
+    game_render::Model model;
+    size_t modelVersion = 0;
+
+    // what the render thread last wrote to the uniform, batches get replayed so most draws skip the write
+    size_t uploadedVersion = SIZE_MAX;
+    rhi::UniformBuffer *pUploadedBuffer = nullptr;
 };
 
 // camera transform
@@ -570,22 +603,31 @@ struct OrthoCameraComp : public IComponent {
         float3 tp = position;
         float3 tr = direction.degrees();
 
+        auto hSelf = getHandle<OrthoCameraComp>();
         auto& queue = GameService::getWorkQueue();
 
         ImGui::Text("near: %f", 0.1f);
         ImGui::Text("far: %f", 100.f);
 
         if (ImGui::DragFloat3("position", tp.data(), 0.1f)) {
-            queue.add("update camera", [this, tp] {
+            queue.add("update camera", [hSelf, tp] {
                 mt::WriteLock lock(GameService::getWorldMutex());
-                position = tp;
+
+                OrthoCameraComp *pSelf = GameService::getWorld().resolve(hSelf);
+                if (pSelf == nullptr) return;
+
+                pSelf->position = tp;
             });
         }
 
         if (ImGui::DragFloat3("direction", tr.data(), 0.1f)) {
-            queue.add("update camera", [this, tr] {
+            queue.add("update camera", [hSelf, tr] {
                 mt::WriteLock lock(GameService::getWorldMutex());
-                direction = tr.radians();
+
+                OrthoCameraComp *pSelf = GameService::getWorld().resolve(hSelf);
+                if (pSelf == nullptr) return;
+
+                pSelf->direction = tr.radians();
             });
         }
     }
@@ -597,10 +639,11 @@ struct OrthoCameraComp : public IComponent {
 struct GpuOrthoCameraComp : public IComponent {
     using IComponent::IComponent;
     static constexpr const char *kTypeName = "gpu_ortho_camera";
+    static constexpr bool kShared = true;
 
-    GpuOrthoCameraComp(ComponentData data, OrthoCameraComp *pCamera)
+    GpuOrthoCameraComp(ComponentData data, Handle<OrthoCameraComp> hCamera)
         : IComponent(data)
-        , pCamera(pCamera)
+        , hCamera(hCamera)
     { }
 
     void onCreate() override {
@@ -608,12 +651,15 @@ struct GpuOrthoCameraComp : public IComponent {
         pCameraUniform = pGraph->addResource<game_render::CameraUniform>("uniform.camera");
     }
 
-    OrthoCameraComp *pCamera = nullptr;
+    Handle<OrthoCameraComp> hCamera;
     ResourceWrapper<game_render::CameraUniform> *pCameraUniform = nullptr;
 };
 
-static CameraEntity *gCamera = nullptr;
-static IEntity *gPlayerEntity = nullptr;
+// each gpu transform holds a graph resource, they are recycled rather than made for every bullet
+static std::vector<GpuTransformComp*> gFreeGpuTransforms;
+
+static Handle<CameraEntity> gCamera;
+static EntityHandle gPlayerEntity;
 
 static AudioComp *gSwarmNoise1 = nullptr;
 static AudioComp *gSwarmNoise2 = nullptr;
@@ -714,7 +760,8 @@ static void initGameEntities(game::World& world) {
         .add<ShootComp>(0.3f, 9.f, gShootSound)
         .add<HealthComp>(3, 5, gPlayerHitSound, gPlayerDeathSound, true)
         .add(gPlayerMesh).add(gPlayerTexture)
-        .add<TransformComp>(float3(0.f, 0.f, 20.4f), float3(-90.f, 0.f, 90.f).radians(), 0.5f);
+        .add<TransformComp>(float3(0.f, 0.f, 20.4f), float3(-90.f, 0.f, 90.f).radians(), 0.5f)
+        .getHandle();
 
     world.entity("alien")
         .add<AlienShipBehaviour>(0.7f, 1.5f, 1.5f)
@@ -737,21 +784,44 @@ static void destroyAliens(game::World& world) {
 }
 
 static void initEntities(game::World& world) {
+    // storages make their next page on a worker before they run out of room
+    world.setPageWorker([](std::function<void()> fn) {
+        ThreadService::enqueueWork("ecs-page", std::move(fn));
+    });
+
+    // bullets and eggs come in bursts, start with room for a screen full of them
+    world.reserve<IEntity>(1024);
+    world.reserve<TransformComp>(1024);
+    world.reserve<ProjectileComp>(512);
+
     world.onCreate<TransformComp>([](TransformComp *pTransform) {
         World *pWorld = pTransform->getWorld();
+        Handle<TransformComp> hTransform = pTransform->getHandle<TransformComp>();
+
+        GpuTransformComp *pGpu = nullptr;
+        if (gFreeGpuTransforms.empty()) {
+            pGpu = pWorld->component<GpuTransformComp>(hTransform);
+        } else {
+            pGpu = gFreeGpuTransforms.back();
+            gFreeGpuTransforms.pop_back();
+            pGpu->hTransform = hTransform;
+        }
 
-        auto *pGpu = pWorld->component<GpuTransformComp>(pTransform);
         pTransform->associate(pGpu);
     });
 
     world.onCreate<OrthoCameraComp>([](OrthoCameraComp *pCamera) {
         World *pWorld = pCamera->getWorld();
 
-        auto *pGpu = pWorld->component<GpuOrthoCameraComp>(pCamera);
+        auto *pGpu = pWorld->component<GpuOrthoCameraComp>(pCamera->getHandle<OrthoCameraComp>());
         pCamera->associate(pGpu);
     });
 
     world.onDestroy<TransformComp>([](TransformComp *pTransform) {
+        if (GpuTransformComp *pGpu = pTransform->associated<GpuTransformComp>()) {
+            gFreeGpuTransforms.push_back(pGpu);
+        }
+
         pTransform->associate(nullptr);
     });
 
@@ -793,7 +863,8 @@ static void initEntities(game::World& world) {
     initGameEntities(world);
 
     gCamera = world.entity<CameraEntity>("camera")
-        .add<OrthoCameraComp>(float3(14.f, -10.f, 10.6f), (kWorldForward * 90.f).radians());
+        .add<OrthoCameraComp>(float3(14.f, -10.f, 10.6f), (kWorldForward * 90.f).radians())
+        .getHandle();
 
     world.entity("grid")
         .add(gGridMesh).add(gGridTexture)
@@ -838,26 +909,30 @@ static float distance(float2 a, float2 b) {
 }
 
 static IEntity *getBulletHit(game::World& world, float2 position) {
-    for (IEntity *pEntity : world.allWith<TransformComp>()) {
-        // bullets cant hit themselves
-        if (pEntity->get<ProjectileComp>()) continue;
-
-        if (pEntity->get<SwarmBehaviour>() || pEntity->get<EggBehaviour>()) {
-            TransformComp *pTransform = pEntity->get<TransformComp>();
-            if (distance(pTransform->position.xz(), position) < 0.7f) {
-                return pEntity;
-            }
+    // only swarmers and eggs can be shot
+    for (auto [pEntity, pSwarm, pTransform] : world.query<SwarmBehaviour, TransformComp>()) {
+        if (distance(pTransform->position.xz(), position) < 0.7f) {
+            return pEntity;
+        }
+    }
+
+    for (auto [pEntity, pEgg, pTransform] : world.query<EggBehaviour, TransformComp>()) {
+        if (distance(pTransform->position.xz(), position) < 0.7f) {
+            return pEntity;
         }
     }
 
     return nullptr;
 }
 
-static IEntity *getAlienHit(float2 position) {
-    TransformComp *pTransform = gPlayerEntity->get<TransformComp>();
+static IEntity *getAlienHit(game::World& world, float2 position) {
+    IEntity *pPlayer = world.resolve(gPlayerEntity);
+    if (pPlayer == nullptr) return nullptr;
+
+    TransformComp *pTransform = pPlayer->get<TransformComp>();
 
     if (distance(pTransform->position.xz(), position) < 0.3f) {
-        return gPlayerEntity;
+        return pPlayer;
     }
 
     return nullptr;
@@ -931,9 +1006,8 @@ float squareWave(float time, float frequency) {
     }
 }
 
-static void runGameSystems(game::World& world, float delta) {
-    auto& workQueue = GameService::getWorkQueue();
-
+// update the hud and the score timers
+static void runHudSystem(SM_UNUSED game::World& world, float delta) {
     // update the score, always has a base of 10 and 8 zeros
     snprintf(gScoreBuffer, 32, "%010d", gScore.load());
     gScoreBoard.text = (const char8_t*)gScoreBuffer;
@@ -970,13 +1044,11 @@ static void runGameSystems(game::World& world, float delta) {
     } else if (totalTime > 10.f) {
         bScore10Seconds = true;
     }
+}
 
-    // do movement and shooting input
-    for (IEntity *pEntity : world.allWith<PlayerInputComp, ShootComp, TransformComp>()) {
-        PlayerInputComp *pInput = pEntity->get<PlayerInputComp>();
-        TransformComp *pTransform = pEntity->get<TransformComp>();
-        ShootComp *pShoot = pEntity->get<ShootComp>();
-
+// do movement and shooting input
+static void runPlayerSystem(game::World& world, float delta) {
+    for (auto [pEntity, pInput, pShoot, pTransform] : world.query<PlayerInputComp, ShootComp, TransformComp>()) {
         if (gPlayerHealth == 0) {
             destroyAliens(world);
 
@@ -992,6 +1064,7 @@ static void runGameSystems(game::World& world, float delta) {
 
                 // scale to 0 over 3 seconds (initial scale is 0.6 for reasons)
                 pTransform->scale = 0.6f * (1.f - (timeDead / 3.f));
+                pTransform->markChanged();
             } else {
                 gScene = eScoreScene;
             }
@@ -1031,6 +1104,7 @@ static void runGameSystems(game::World& world, float delta) {
 
         if (mv != 0.f || mh != 0.f) {
             pTransform->rotation.x = -angle; // = float3(0.f, -angle, 0.f);
+            pTransform->markChanged();
         }
 
         pShoot->lastShot += delta;
@@ -1043,51 +1117,50 @@ static void runGameSystems(game::World& world, float delta) {
 
                 pShoot->pSound->playSound();
 
-                workQueue.add("bullet", [playerAngle, pTransform, pEntity, speed = pShoot->bulletSpeed] {
+                // the player can be gone by the time this runs, take what the bullet needs now
+                world.commands().create([playerAngle, position = pTransform->position, rotation = pTransform->rotation, speed = pShoot->bulletSpeed](game::World& world) {
                     float2 direction = float2(std::cos(playerAngle), std::sin(playerAngle));
 
-                    World *pWorld = pEntity->getWorld();
-
-                    pWorld->entity("bullet")
+                    world.entity("bullet")
                         .add(gBulletMesh).add(gBulletTexture)
-                        .add<TransformComp>(pTransform->position, pTransform->rotation, 0.2f)
+                        .add<TransformComp>(position, rotation, 0.2f)
                         .add<ProjectileComp>(direction * speed);
                 });
             }
         }
     }
+}
 
-    // do bullet movement
-    for (IEntity *pEntity : world.allWith<ProjectileComp, TransformComp>()) {
-        ProjectileComp *pProjectile = pEntity->get<ProjectileComp>();
-        TransformComp *pTransform = pEntity->get<TransformComp>();
-
+// do bullet movement
+static void runBulletSystem(game::World& world, float delta) {
+    // each bullet only touches its own components, and every worker records into its own command buffer
+    world.query<ProjectileComp, TransformComp>().parallelEach([&](IEntity *pEntity, ProjectileComp *pProjectile, TransformComp *pTransform) {
         pTransform->position.x += pProjectile->speed.x * delta;
         pTransform->position.z += pProjectile->speed.y * delta;
+        pTransform->markChanged();
 
         if (!isBulletInBounds(pTransform->position.xz())) {
-            workQueue.add("delete", [pEntity] {
-                World *pWorld = pEntity->getWorld();
-                pWorld->destroy(pEntity);
-            });
+            // a bullet can be destroyed twice in one frame, the second one is dropped
+            world.commands().destroy(pEntity->getHandle());
         }
-    }
-
-    // move the mothership
-    for (IEntity *pEntity : world.allWith<AlienShipBehaviour, TransformComp>()) {
-        AlienShipBehaviour *pBehaviour = pEntity->get<AlienShipBehaviour>();
-        TransformComp *pTransform = pEntity->get<TransformComp>();
+    });
+}
 
+// move the mothership
+static void runMothershipSystem(game::World& world, float delta) {
+    for (auto [pEntity, pBehaviour, pTransform] : world.query<AlienShipBehaviour, TransformComp>()) {
         pBehaviour->lastMove += delta;
         pBehaviour->lastSpawn += delta;
 
         if (pBehaviour->lastMove >= pBehaviour->moveDelay) {
             pBehaviour->lastMove = 0.f;
             pTransform->position.x += kTileSize.x;
+            pTransform->markChanged();
         }
 
         if (pTransform->position.x > kWorldBounds.x) {
             pTransform->position.x = 0.f;
+            pTransform->markChanged();
         }
 
         if (pBehaviour->lastSpawn > pBehaviour->spawnDelay) {
@@ -1100,59 +1173,65 @@ static void runGameSystems(game::World& world, float delta) {
 
             gEggSpawnSound->playSound();
 
-            workQueue.add("egg", [pEntity, pTransform, pos] {
-                World *pWorld = pEntity->getWorld();
-
+            world.commands().create([rotation = pTransform->rotation, pos](game::World& world) {
                 gCurrentAliveEggs += 1;
-                pWorld->entity("egg")
+                world.entity("egg")
                     .add<HealthComp>(1, 1, nullptr, gEggDeathSound)
-                    .add<TransformComp>(pos, pTransform->rotation, 0.6f)
+                    .add<TransformComp>(pos, rotation, 0.6f)
                     .add(gEggSmallMesh).add(gAlienTexture)
                     .add<EggBehaviour>(1.f, 3.f, 4.5f);
             });
         }
     }
+}
 
-    // hatch eggs
-    for (IEntity *pEntity : world.allWith<EggBehaviour, TransformComp>()) {
-        EggBehaviour *pBehaviour = pEntity->get<EggBehaviour>();
-        TransformComp *pTransform = pEntity->get<TransformComp>();
-
+// hatch eggs
+static void runEggSystem(game::World& world, float delta) {
+    for (auto [pEntity, pBehaviour, pTransform] : world.query<EggBehaviour, TransformComp>()) {
         pBehaviour->currentTimeAlive += delta;
         if (pBehaviour->currentTimeAlive >= pBehaviour->timeToHatch) {
             gEggHatchSound->playSound();
 
-            workQueue.add("hatch", [pEntity, pTransform] {
-                World *pWorld = pEntity->getWorld();
+            world.commands().create([hEgg = pEntity->getHandle()](game::World& world) {
+                // the egg may have been shot before it got to hatch
+                IEntity *pEgg = world.resolve(hEgg);
+                if (pEgg == nullptr) return;
+
+                // the eggs transform is destroyed along with it, the swarmer gets a copy.
+                // copied up front, making the swarmer can move components around
+                TransformComp *pTransform = pEgg->get<TransformComp>();
+                float3 position = pTransform->position;
+                float3 rotation = pTransform->rotation;
+                float3 scale = pTransform->scale;
 
                 gCurrentAliveSwarm += 1;
-                pWorld->entity("swarmer")
+                world.entity("swarmer")
                     .add<SwarmBehaviour>(getSwarmMovement(), 0.3f)
                     .add<HealthComp>(1, 1, nullptr, gAlienDeathSound)
-                    .add(pTransform).add(gAlienTexture).add(gAlienMesh);
+                    .add<TransformComp>(position, rotation, scale)
+                    .add(gAlienTexture).add(gAlienMesh);
 
-                pWorld->destroy(pEntity);
+                world.destroy(pEgg);
             });
         } else if (pBehaviour->currentTimeAlive >= pBehaviour->timeToGrowLarge) {
             if (pBehaviour->state != eEggLarge) {
-                pEntity->addComponent(gEggLargeMesh);
+                world.commands().attach(pEntity->getHandle(), gEggLargeMesh);
                 pBehaviour->state = eEggLarge;
                 gEggGrowLargeSound->playSound();
             }
         } else if (pBehaviour->currentTimeAlive >= pBehaviour->timeToGrowMedium) {
             if (pBehaviour->state != eEggMedium) {
-                pEntity->addComponent(gEggMediumMesh);
+                world.commands().attach(pEntity->getHandle(), gEggMediumMesh);
                 pBehaviour->state = eEggMedium;
                 gEggGrowMediumSound->playSound();
             }
         }
     }
+}
 
-    // move swarmers
-    for (IEntity *pEntity : world.allWith<SwarmBehaviour, TransformComp>()) {
-        SwarmBehaviour *pBehaviour = pEntity->get<SwarmBehaviour>();
-        TransformComp *pTransform = pEntity->get<TransformComp>();
-
+// move swarmers
+static void runSwarmSystem(game::World& world, float delta) {
+    for (auto [pEntity, pBehaviour, pTransform] : world.query<SwarmBehaviour, TransformComp>()) {
         pBehaviour->lastMove += delta;
         if (pBehaviour->lastMove < pBehaviour->timeToMove) continue;
 
@@ -1172,11 +1251,13 @@ static void runGameSystems(game::World& world, float delta) {
 
         pTransform->position.x += pBehaviour->direction.x * kTileSize.x;
         pTransform->position.z += pBehaviour->direction.y * kTileSize.y;
+        pTransform->markChanged();
     }
+}
 
-    // check for bullet hits
-    for (IEntity *pEntity : world.allWith<ProjectileComp, TransformComp>()) {
-        TransformComp *pTransform = pEntity->get<TransformComp>();
+// check for bullet hits
+static void runBulletHitSystem(game::World& world, SM_UNUSED float delta) {
+    for (auto [pEntity, pProjectile, pTransform] : world.query<ProjectileComp, TransformComp>()) {
         float2 pos = pTransform->position.xz();
 
         if (IEntity *pHit = getBulletHit(world, pos)) {
@@ -1192,18 +1273,15 @@ static void runGameSystems(game::World& world, float delta) {
                 gScore += 250;
             }
 
-            workQueue.add("delete", [pEntity] {
-                World *pWorld = pEntity->getWorld();
-                pWorld->destroy(pEntity);
-            });
+            world.commands().destroy(pEntity->getHandle());
         }
     }
+}
 
-    // did a swarmer hit the player
-    for (IEntity *pEntity : world.allWith<SwarmBehaviour, TransformComp>()) {
-        TransformComp *pTransform = pEntity->get<TransformComp>();
-
-        if (IEntity *pHit = getAlienHit(pTransform->position.xz())) {
+// did a swarmer hit the player
+static void runSwarmHitSystem(game::World& world, SM_UNUSED float delta) {
+    for (auto [pEntity, pBehaviour, pTransform] : world.query<SwarmBehaviour, TransformComp>()) {
+        if (IEntity *pHit = getAlienHit(world, pTransform->position.xz())) {
             if (HealthComp *pHealth = pHit->get<HealthComp>()) {
                 pHealth->takeHit();
                 gPlayerHealth = pHealth->currentHealth;
@@ -1216,32 +1294,34 @@ static void runGameSystems(game::World& world, float delta) {
                 }
             }
 
-            workQueue.add("delete", [pEntity] {
-                World *pWorld = pEntity->getWorld();
-                pWorld->destroy(pEntity);
-            });
+            world.commands().destroy(pEntity->getHandle());
         }
     }
+}
 
-    // if anything is dead remove it
-    for (IEntity *pEntity : world.allWith<HealthComp>()) {
-        HealthComp *pHealth = pEntity->get<HealthComp>();
-
+// if anything is dead remove it
+static void runCleanupSystem(game::World& world, SM_UNUSED float delta) {
+    for (auto [pEntity, pHealth] : world.query<HealthComp>()) {
         if (!pHealth->isAlive() && !pHealth->bIsPlayer) {
-            workQueue.add("delete", [pEntity] {
-                World *pWorld = pEntity->getWorld();
-                pWorld->destroy(pEntity);
-            });
+            world.commands().destroy(pEntity->getHandle());
         }
     }
+}
 
-    game_render::CommandBatch batch;
+// draw everything
+static void runRenderSystem(game::World& world, SM_UNUSED float delta) {
+    game_render::CommandBatch batch = GameService::getScene()->newCommandBatch();
 
-    if (CameraEntity *pCamera = world.get<CameraEntity>(gCamera->getInstanceId())) {
+    if (CameraEntity *pCamera = world.resolve(gCamera)) {
         OrthoCameraComp *pCameraComp = pCamera->get<OrthoCameraComp>();
         GpuOrthoCameraComp *pGpuCameraComp = pCameraComp->associated<GpuOrthoCameraComp>();
+        SM_ASSERTF(pGpuCameraComp != nullptr, "camera has no gpu data");
 
-        batch.add([pGpuCameraComp, pCameraComp](game_render::ScenePass *pScene, Context *pContext) {
+        // the camera component lives in its entitys archetype and can move before the batch is drawn
+        float3 position = pCameraComp->position;
+        float3 direction = pCameraComp->direction;
+
+        batch.add([pGpuCameraComp, position, direction](game_render::ScenePass *pScene, Context *pContext) {
             auto *pCommands = pContext->getDirectCommands();
 
             auto display = pContext->getCreateInfo();
@@ -1250,7 +1330,7 @@ static void runGameSystems(game::World& world, float delta) {
 
             float aspect = float(width) / float(height);
 
-            float4x4 view = float4x4::lookToRH(pCameraComp->position, pCameraComp->direction, kWorldUp);
+            float4x4 view = float4x4::lookToRH(position, direction, kWorldUp);
             float4x4 proj = float4x4::orthographicRH(26.f * aspect, 26.f, 0.1f, 100.f);
 
             auto *pBuffer = pGpuCameraComp->pCameraUniform->getInner();
@@ -1266,13 +1346,21 @@ static void runGameSystems(game::World& world, float delta) {
         });
     }
 
-    for (IEntity *pEntity : world.allWith<TransformComp, MeshComp>()) {
-        TransformComp *pTransformComp = pEntity->get<TransformComp>();
-        MeshComp *pMeshComp = pEntity->get<MeshComp>();
-        TextureComp *pTextureComp = pEntity->get<TextureComp>();
+    // only transforms that changed need a new model matrix, the grid and anything else standing still keeps its old one
+    world.eachChanged<TransformComp>([](TransformComp *pTransformComp) {
+        if (GpuTransformComp *pGpuTransformComp = pTransformComp->associated<GpuTransformComp>()) {
+            pGpuTransformComp->model.model = float4x4::transform(pTransformComp->position, pTransformComp->rotation, pTransformComp->scale);
+            pGpuTransformComp->modelVersion += 1;
+        }
+    });
+
+    for (auto [pEntity, pTransformComp, pMeshComp, pTextureComp] : world.query<TransformComp, MeshComp, TextureComp>()) {
+        // the transform can be destroyed before the batch is drawn, so take what the draw needs now
+        GpuTransformComp *pGpuTransformComp = pTransformComp->associated<GpuTransformComp>();
+        game_render::Model model = pGpuTransformComp->model;
+        size_t version = pGpuTransformComp->modelVersion;
 
-        batch.add([pMeshComp, pTransformComp, pTextureComp](game_render::ScenePass *pScene, Context *pContext) {
-            GpuTransformComp *pGpuTransformComp = pTransformComp->associated<GpuTransformComp>();
+        batch.add([pMeshComp, pGpuTransformComp, pTextureComp, model, version](game_render::ScenePass *pScene, Context *pContext) mutable {
             auto *pCommands = pContext->getDirectCommands();
             auto *pMesh = pMeshComp->pMesh;
             pCommands->setVertexBuffer(pMesh->getVertexBuffer());
@@ -1282,10 +1370,12 @@ static void runGameSystems(game::World& world, float delta) {
             auto *pTexture = pTextureComp->pTexture->getInner();
             auto *pHeap = pContext->getSrvHeap();
 
-            game_render::Model model = {
-                .model = float4x4::transform(pTransformComp->position, pTransformComp->rotation, pTransformComp->scale)
-            };
-            pBuffer->update(&model);
+            // a recreated buffer starts out empty, so it needs the write even if the model is the same
+            if (pGpuTransformComp->uploadedVersion != version || pGpuTransformComp->pUploadedBuffer != pBuffer->asResource()) {
+                pBuffer->update(&model);
+                pGpuTransformComp->uploadedVersion = version;
+                pGpuTransformComp->pUploadedBuffer = pBuffer->asResource();
+            }
 
             pCommands->setGraphicsShaderInput(pScene->textureReg(), pHeap->deviceOffset(pTexture->getSrvIndex()));
             pCommands->setGraphicsShaderInput(pScene->modelReg(), pHeap->deviceOffset(pBuffer->getSrvIndex()));
@@ -1298,6 +1388,63 @@ static void runGameSystems(game::World& world, float delta) {
         ->update(std::move(batch));
 }
 
+// stands in for the score, timers, counters and hud text the game systems share
+struct GameState;
+
+static void initGameSystems(game::SystemScheduler& systems) {
+    systems.system("music", [](SM_UNUSED game::World& world, float delta) { updatePlayingMusic(delta); })
+        .writes<GameState>();
+
+    systems.system("hud", runHudSystem)
+        .writes<GameState>();
+
+    // destroys the aliens when the player dies
+    systems.system("player", runPlayerSystem)
+        .query<PlayerInputComp, ShootComp, TransformComp>()
+        .exclusive();
+
+    systems.system("bullets", runBulletSystem)
+        .query<ProjectileComp, TransformComp>()
+        .reads<ProjectileComp>()
+        .writes<TransformComp>();
+
+    // sounds share one pool of voices, so anything that plays one writes AudioComp
+    systems.system("mothership", runMothershipSystem)
+        .query<AlienShipBehaviour, TransformComp>()
+        .writes<AlienShipBehaviour, TransformComp, AudioComp, GameState>();
+
+    // growing an egg swaps its mesh through the command buffer, which doesnt change its archetype
+    systems.system("eggs", runEggSystem)
+        .query<EggBehaviour, TransformComp>()
+        .reads<TransformComp>()
+        .writes<EggBehaviour, AudioComp>();
+
+    systems.system("swarm", runSwarmSystem)
+        .query<SwarmBehaviour, TransformComp>()
+        .writes<SwarmBehaviour, TransformComp>();
+
+    systems.system("bullet hits", runBulletHitSystem)
+        .query<ProjectileComp, TransformComp>()
+        .query<SwarmBehaviour, TransformComp>()
+        .query<EggBehaviour, TransformComp>()
+        .reads<ProjectileComp, TransformComp, SwarmBehaviour, EggBehaviour>()
+        .writes<HealthComp, AudioComp, GameState>();
+
+    systems.system("swarm hits", runSwarmHitSystem)
+        .query<SwarmBehaviour, TransformComp>()
+        .reads<SwarmBehaviour, TransformComp>()
+        .writes<HealthComp, AudioComp, GameState>();
+
+    systems.system("cleanup", runCleanupSystem)
+        .query<HealthComp>()
+        .reads<HealthComp>();
+
+    systems.system("render", runRenderSystem)
+        .query<TransformComp, MeshComp, TextureComp>()
+        .reads<TransformComp, MeshComp, TextureComp, OrthoCameraComp>()
+        .writes<GpuTransformComp>();
+}
+
 static void runMenuSystems(game::World& world, float delta) {
 
 }
@@ -1309,7 +1456,7 @@ static void runScoreSystems(game::World& world, float delta) {
         PlayerInputComp *comp = ent->get<PlayerInputComp>();
         if (comp->isShootPressed()) {
             world.destroy(gPlayerEntity);
-            gPlayerEntity = nullptr;
+            gPlayerEntity = {};
 
             initGameEntities(world);
 
@@ -1345,23 +1492,24 @@ static void runSystems(game::World& world, float delta) {
     auto& workQueue = GameService::getWorkQueue();
     for (size_t i = 0; i < 16 && workQueue.tryGetMessage(); i++) { }
 
+    // the game systems lock the world for themselves, one phase at a time
+    if (gScene == eGameScene) {
+        GameService::getSystems().run(delta);
+        return;
+    }
+
     mt::WriteLock lock(GameService::getWorldMutex());
-    // LOG_INFO("=== update ===");
 
     switch (gScene) {
-    case eGameScene:
-        updatePlayingMusic(delta);
-        runGameSystems(world, delta);
-        break;
     case eMenuScene:
         runMenuSystems(world, delta);
         break;
     case eScoreScene:
         runScoreSystems(world, delta);
         break;
+    default:
+        break;
     }
-
-    // LOG_INFO("=== render ===");
 }
 
 ///
@@ -1439,12 +1587,14 @@ static void commonMain() {
     scores.add(&retry);
 
     initEntities(world);
+    initGameSystems(GameService::getSystems());
 
     Clock clock;
     float last = 0.f;
 
     while (bRunning) {
         ThreadService::pollMain();
+        core::endFrame();
 
         switch (gScene) {
         case eGameScene:
@@ -1455,6 +1605,7 @@ static void commonMain() {
             break;
 
         default:
+            layout.reset();
             break;
         }
 
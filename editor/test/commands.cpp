@@ -0,0 +1,102 @@
+#include "test.h"
+
+#include "game/ecs/world.h"
+
+#include <thread>
+
+using namespace simcoe;
+using namespace game;
+
+// command buffers recorded from threads that move between worlds
+
+namespace {
+    constexpr size_t kSwitches = 100;
+
+    struct Health : IComponent {
+        using IComponent::IComponent;
+    };
+
+    std::vector<EntityHandle> spawn(World& world, size_t count) {
+        std::vector<EntityHandle> handles;
+        for (size_t i = 0; i < count; i++) {
+            handles.push_back(world.entity("entity").add<Health>().getHandle());
+        }
+
+        return handles;
+    }
+
+    // a thread alternating between two worlds keeps using one buffer in each
+    void testSwitchWorlds() {
+        World first;
+        World second;
+
+        std::vector<EntityHandle> firstHandles = spawn(first, kSwitches);
+        std::vector<EntityHandle> secondHandles = spawn(second, kSwitches);
+
+        for (size_t i = 0; i < kSwitches; i++) {
+            first.commands().destroy(firstHandles[i]);
+            second.commands().destroy(secondHandles[i]);
+        }
+
+        SM_CHECK(first.getCommandStats().buffers == 1);
+        SM_CHECK(second.getCommandStats().buffers == 1);
+
+        first.applyCommands();
+        second.applyCommands();
+
+        SM_CHECK(first.getCommandStats().destroys == kSwitches);
+        SM_CHECK(second.getCommandStats().destroys == kSwitches);
+        SM_CHECK(first.query<Health>().size() == 0);
+        SM_CHECK(second.query<Health>().size() == 0);
+    }
+
+    // the buffer survives a batch, the next frame records into the same one
+    void testReuseAfterApply() {
+        World world;
+        std::vector<EntityHandle> handles = spawn(world, 4);
+
+        World other;
+        for (EntityHandle handle : handles) {
+            world.commands().destroy(handle);
+            world.applyCommands();
+
+            other.commands().create([](World&) { });
+        }
+
+        SM_CHECK(world.getCommandStats().buffers == 1);
+        SM_CHECK(world.getCommandStats().batches == 4);
+        SM_CHECK(world.query<Health>().size() == 0);
+    }
+
+    // every thread records into its own buffer, a thread that ends leaves its buffer behind
+    void testThreadBuffers() {
+        World first;
+        World second;
+
+        std::vector<EntityHandle> handles = spawn(first, 4);
+
+        for (EntityHandle handle : handles) {
+            std::jthread thread([&] {
+                first.commands().destroy(handle);
+                second.commands().create([](World&) { });
+                first.commands().destroy(handle);
+            });
+        }
+
+        // threads that have ended can have their ids reused, so there may be fewer buffers than threads
+        size_t buffers = first.getCommandStats().buffers;
+        SM_CHECK(buffers >= 1 && buffers <= handles.size());
+
+        first.applyCommands();
+        SM_CHECK(first.query<Health>().size() == 0);
+        SM_CHECK(first.getCommandStats().destroys == handles.size());
+    }
+}
+
+int main() {
+    testSwitchWorlds();
+    testReuseAfterApply();
+    testThreadBuffers();
+
+    return test::finish("commands");
+}
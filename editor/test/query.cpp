@@ -0,0 +1,227 @@
+#include "test.h"
+
+#include "game/ecs/world.h"
+
+using namespace simcoe;
+using namespace game;
+
+// queries against a world whose archetypes change under them
+
+namespace {
+    constexpr size_t kEntities = 1000;
+
+    struct Position : IComponent {
+        Position(ComponentData data, size_t value)
+            : IComponent(data)
+            , value(value)
+        { }
+
+        size_t value;
+    };
+
+    struct Velocity : IComponent {
+        Velocity(ComponentData data, size_t value)
+            : IComponent(data)
+            , value(value)
+        { }
+
+        size_t value;
+    };
+
+    struct Health : IComponent {
+        using IComponent::IComponent;
+    };
+
+    struct Mesh : IComponent {
+        using IComponent::IComponent;
+        static constexpr bool kShared = true;
+    };
+
+    // a query made before any entity exists picks up every archetype made after it
+    void testLateArchetypes() {
+        World world;
+        auto& positions = world.query<Position>();
+        SM_CHECK(positions.size() == 0);
+        SM_CHECK(positions.getMatches().empty());
+
+        Mesh *pMesh = world.component<Mesh>();
+
+        world.entity("a").add<Position>(0);
+        world.entity("b").add<Position>(1).add<Velocity>(1);
+        world.entity("c").add<Velocity>(2);
+        world.entity("d").add<Position>(3).add(pMesh);
+
+        SM_CHECK(positions.size() == 3);
+
+        // made after the archetypes it matches
+        auto& moving = world.query<Position, Velocity>();
+        SM_CHECK(moving.size() == 1);
+
+        // a type neither query has seen yet still makes an archetype both match
+        world.entity("e").add<Position>(4).add<Velocity>(4).add<Health>();
+        SM_CHECK(positions.size() == 4);
+        SM_CHECK(moving.size() == 2);
+
+        // entities moving between existing archetypes need no bookkeeping
+        EntityBuilder<IEntity> late = world.entity("f").add<Velocity>(5);
+        SM_CHECK(moving.size() == 2);
+        late.add<Position>(5);
+        SM_CHECK(moving.size() == 3);
+
+        size_t total = 0;
+        for (auto [pEntity, pPosition, pVelocity] : moving) {
+            SM_CHECK(pEntity->get<Position>() == pPosition);
+            SM_CHECK(pPosition->value == pVelocity->value);
+            total += pPosition->value;
+        }
+
+        SM_CHECK(total == 1 + 4 + 5);
+
+        size_t meshes = 0;
+        for (auto [pEntity, pPosition, pShared] : world.query<Position, Mesh>()) {
+            SM_CHECK(pShared == pMesh);
+            meshes += 1;
+        }
+
+        SM_CHECK(meshes == 1);
+    }
+
+    struct Spawned {
+        std::vector<EntityHandle> handles;
+        std::vector<Handle<Position>> positions;
+    };
+
+    // spread over a few archetypes, so destroys move rows in more than one of them
+    Spawned spawn(World& world, size_t count) {
+        Spawned result;
+        for (size_t i = 0; i < count; i++) {
+            EntityBuilder<IEntity> builder = world.entity("entity").add<Position>(i);
+            if (i % 3 == 0) builder.add<Velocity>(i);
+            if (i % 5 == 0) builder.add<Health>();
+
+            result.handles.push_back(builder.getHandle());
+            result.positions.push_back(builder.pEntity->get<Position>()->getHandle<Position>());
+        }
+
+        return result;
+    }
+
+    // destroying the entity being visited never skips or repeats another
+    void testDestroyWhileIterating() {
+        World world;
+        Spawned spawned = spawn(world, kEntities);
+
+        std::vector<size_t> visits(kEntities, 0);
+        for (auto [pEntity, pPosition] : world.query<Position>()) {
+            size_t value = pPosition->value;
+            visits[value] += 1;
+
+            if (value % 2 == 1) {
+                world.destroy(pEntity);
+            }
+        }
+
+        for (size_t i = 0; i < kEntities; i++) {
+            if (!SM_CHECK(visits[i] == 1)) break;
+        }
+
+        SM_CHECK(world.query<Position>().size() == kEntities / 2);
+
+        // the survivors moved into the holes and kept their values
+        for (size_t i = 0; i < kEntities; i++) {
+            IEntity *pEntity = world.resolve(spawned.handles[i]);
+            Position *pPosition = world.resolve(spawned.positions[i]);
+
+            if (i % 2 == 1) {
+                if (!SM_CHECK(pEntity == nullptr && pPosition == nullptr)) break;
+                continue;
+            }
+
+            if (!SM_CHECK(pEntity != nullptr && pPosition != nullptr)) break;
+            if (!SM_CHECK(pEntity->get<Position>() == pPosition)) break;
+            if (!SM_CHECK(pPosition->value == i)) break;
+
+            if (i % 3 == 0) {
+                Velocity *pVelocity = pEntity->get<Velocity>();
+                if (!SM_CHECK(pVelocity != nullptr && pVelocity->value == i)) break;
+            }
+        }
+    }
+
+    void testDestroyEverything() {
+        World world;
+        spawn(world, kEntities);
+
+        auto& moving = world.query<Position, Velocity>();
+
+        size_t visited = 0;
+        for (auto [pEntity, pPosition, pVelocity] : moving) {
+            SM_CHECK(pPosition->value == pVelocity->value);
+            world.destroy(pEntity);
+            visited += 1;
+        }
+
+        SM_CHECK(visited == (kEntities + 2) / 3);
+        SM_CHECK(moving.size() == 0);
+        SM_CHECK(world.query<Position>().size() == kEntities - visited);
+
+        // the emptied archetypes are still matched and refill as normal
+        world.entity("again").add<Position>(7).add<Velocity>(7);
+        SM_CHECK(moving.size() == 1);
+    }
+
+    // a visit that destroys more than its own entity ends the loop early rather than reading dead rows
+    void testDestroyAhead() {
+        World world;
+        Spawned spawned = spawn(world, kEntities);
+
+        size_t visited = 0;
+        for (auto [pEntity, pPosition] : world.query<Position>()) {
+            visited += 1;
+
+            for (EntityHandle handle : spawned.handles) {
+                world.destroy(handle);
+            }
+        }
+
+        // the first visit emptied every archetype the query matches
+        SM_CHECK(visited == 1);
+        SM_CHECK(world.query<Position>().size() == 0);
+    }
+
+    // destroys recorded from a parallel loop happen at the next sync point
+    void testDeferredDestroy() {
+        World world;
+        spawn(world, kEntities);
+
+        auto& positions = world.query<Position>();
+
+        world.setFrozen(true);
+        positions.parallelEach([&](EntityPtr pEntity, Position *pPosition) {
+            if (pPosition->value % 4 == 0) {
+                world.commands().destroy(pEntity->getHandle());
+                world.commands().destroy(pEntity->getHandle());
+            }
+        });
+        world.setFrozen(false);
+
+        SM_CHECK(positions.size() == kEntities);
+
+        world.applyCommands();
+        SM_CHECK(positions.size() == kEntities - kEntities / 4);
+
+        for (auto [pEntity, pPosition] : positions) {
+            if (!SM_CHECK(pPosition->value % 4 != 0)) break;
+        }
+    }
+}
+
+int main() {
+    testLateArchetypes();
+    testDestroyWhileIterating();
+    testDestroyEverything();
+    testDestroyAhead();
+    testDeferredDestroy();
+
+    return test::finish("query");
+}
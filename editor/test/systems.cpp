@@ -0,0 +1,145 @@
+#include "test.h"
+
+#include "game/ecs/system.h"
+
+using namespace simcoe;
+using namespace game;
+
+// how the system scheduler splits systems into phases from what they read and write
+
+namespace {
+    struct Position { };
+    struct Velocity { };
+    struct Health { };
+    struct Score { };
+
+    struct Scheduler {
+        Scheduler()
+            : scheduler(world, lock)
+        { }
+
+        // records the order systems ran in, so phases can be checked against it
+        SystemBuilder add(std::string name) {
+            return scheduler.system(name, [this, name](World&, float) {
+                order.push_back(name);
+            });
+        }
+
+        SchedulerStats run() {
+            order.clear();
+            scheduler.run(0.f);
+            return scheduler.getStats();
+        }
+
+        World world;
+        mt::SharedMutex lock{"test.systems"};
+        SystemScheduler scheduler;
+
+        std::vector<std::string> order;
+    };
+
+    std::vector<size_t> getPhases(const SchedulerStats& stats) {
+        std::vector<size_t> result;
+        for (const SystemStats& system : stats.systems) {
+            result.push_back(system.phase);
+        }
+
+        return result;
+    }
+
+    // readers never conflict with each other
+    void testSharedReads() {
+        Scheduler test;
+        test.add("a").reads<Position>();
+        test.add("b").reads<Position, Velocity>();
+        test.add("c").reads<Velocity>();
+
+        SchedulerStats stats = test.run();
+        SM_CHECK(stats.phases == 1);
+        SM_CHECK(stats.widest == 3);
+        SM_CHECK(getPhases(stats) == std::vector<size_t>({ 0, 0, 0 }));
+    }
+
+    // a write conflicts with any earlier read or write of the same type, in either order
+    void testWriteConflicts() {
+        Scheduler test;
+        test.add("read").reads<Position>();
+        test.add("write").writes<Position>();
+        test.add("read again").reads<Position>();
+        test.add("write again").writes<Position>();
+
+        SchedulerStats stats = test.run();
+        SM_CHECK(stats.phases == 4);
+        SM_CHECK(stats.widest == 1);
+        SM_CHECK(getPhases(stats) == std::vector<size_t>({ 0, 1, 2, 3 }));
+        SM_CHECK(test.order == std::vector<std::string>({ "read", "write", "read again", "write again" }));
+    }
+
+    // systems land in the earliest phase after everything they conflict with
+    void testEarliestPhase() {
+        Scheduler test;
+        test.add("move").reads<Velocity>().writes<Position>();
+        test.add("collide").reads<Position>().writes<Health>();
+        test.add("score").writes<Score>();
+        test.add("die").reads<Health>().writes<Score>();
+        test.add("steer").writes<Velocity>();
+
+        SchedulerStats stats = test.run();
+        SM_CHECK(getPhases(stats) == std::vector<size_t>({ 0, 1, 0, 2, 1 }));
+        SM_CHECK(stats.phases == 3);
+        SM_CHECK(stats.widest == 2);
+    }
+
+    // an exclusive system conflicts with everything and splits the systems around it
+    void testExclusive() {
+        Scheduler test;
+        test.add("a").reads<Position>();
+        test.add("spawn").exclusive();
+        test.add("b").reads<Velocity>();
+        test.add("c").writes<Health>();
+        test.add("undeclared");
+
+        SchedulerStats stats = test.run();
+        SM_CHECK(getPhases(stats) == std::vector<size_t>({ 0, 1, 2, 2, 2 }));
+        SM_CHECK(test.order[0] == "a");
+        SM_CHECK(test.order[1] == "spawn");
+    }
+
+    // declaring a type twice, or as both read and write, is still one conflict
+    void testDuplicateTypes() {
+        Scheduler test;
+        test.add("a").reads<Position, Position>().writes<Position>();
+        test.add("b").reads<Velocity>().reads<Velocity>();
+        test.add("c").writes<Position>();
+
+        SchedulerStats stats = test.run();
+        SM_CHECK(getPhases(stats) == std::vector<size_t>({ 0, 0, 1 }));
+    }
+
+    // adding a system after a frame rebuilds the phases
+    void testRebuild() {
+        Scheduler test;
+        test.add("a").writes<Position>();
+        test.add("b").writes<Velocity>();
+        SM_CHECK(test.run().phases == 1);
+
+        test.add("c").reads<Position, Velocity>();
+        SchedulerStats stats = test.run();
+        SM_CHECK(stats.phases == 2);
+        SM_CHECK(getPhases(stats) == std::vector<size_t>({ 0, 0, 1 }));
+        SM_CHECK(test.order.size() == 3);
+        SM_CHECK(test.order.back() == "c");
+        SM_CHECK(stats.frames == 2);
+    }
+}
+
+int main() {
+    testSharedReads();
+    testWriteConflicts();
+    testEarliestPhase();
+    testExclusive();
+    testDuplicateTypes();
+    testRebuild();
+
+    return test::finish("systems");
+}
@@ -0,0 +1,218 @@
+#include "engine/threads/pool.h"
+
+#include "engine/core/arena.h"
+#include "engine/core/function.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+// heap allocations per frame for the scene command batches and for worker jobs using frame memory.
+// usage: bench-arena [actions] [jobs]
+
+namespace {
+    std::atomic_size_t gHeapAllocs = 0;
+}
+
+void *operator new(size_t size) {
+    gHeapAllocs.fetch_add(1, std::memory_order_relaxed);
+    if (void *pData = std::malloc(std::max<size_t>(size, 1))) return pData;
+    throw std::bad_alloc();
+}
+
+// arena blocks come from std::pmr::new_delete_resource, which uses the aligned overloads
+void *operator new(size_t size, std::align_val_t align) {
+    gHeapAllocs.fetch_add(1, std::memory_order_relaxed);
+    size_t alignment = std::max(size_t(align), sizeof(void*));
+    if (void *pData = std::aligned_alloc(alignment, (std::max<size_t>(size, 1) + alignment - 1) & ~(alignment - 1))) return pData;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pData) noexcept { std::free(pData); }
+void operator delete(void *pData, size_t) noexcept { std::free(pData); }
+void operator delete(void *pData, std::align_val_t) noexcept { std::free(pData); }
+void operator delete(void *pData, size_t, std::align_val_t) noexcept { std::free(pData); }
+
+namespace {
+    using BenchClock = std::chrono::steady_clock;
+
+    constexpr size_t kWarmup = 10;
+    constexpr size_t kFrames = 200;
+    constexpr size_t kWorkers = 4;
+
+    // stand ins for the render system captures, a camera and a mesh with its model matrix
+    struct Camera { void *pGpu; void *pCamera; };
+    struct Mesh { void *pMesh; void *pTransform; void *pTexture; float model[16]; uint32_t version; };
+
+    using StdAction = std::function<void(void*, void*)>;
+    using ArenaAction = core::UniqueFunction<void(void*, void*)>;
+
+    struct Result {
+        double heapAllocs; ///< per frame, after warmup
+        double micros; ///< per frame
+    };
+
+    // run @p frame once per frame, counting every heap allocation after warmup
+    template<typename F>
+    Result measure(F&& frame) {
+        for (size_t i = 0; i < kWarmup; i++) {
+            frame(i);
+        }
+
+        size_t allocs = gHeapAllocs.load();
+        auto start = BenchClock::now();
+
+        for (size_t i = 0; i < kFrames; i++) {
+            frame(kWarmup + i);
+        }
+
+        auto elapsed = std::chrono::duration<double, std::micro>(BenchClock::now() - start);
+        return { double(gHeapAllocs.load() - allocs) / kFrames, elapsed.count() / kFrames };
+    }
+
+    // build a batch like runRenderSystem, then replay it like ScenePass::execute
+    template<typename B, typename A>
+    void runBatch(B& batch, A&& add, size_t actions, size_t& sink) {
+        add(batch, [camera = Camera{ &sink, &sink }](void *, void *) { (void)camera; });
+
+        for (size_t i = 0; i < actions; i++) {
+            Mesh mesh = { &sink, &sink, &sink, {}, uint32_t(i) };
+            add(batch, [mesh, &sink](void *, void *) mutable { sink += mesh.version; });
+        }
+
+        for (auto& action : batch) {
+            action(nullptr, nullptr);
+        }
+    }
+
+    void benchBatches(size_t actions) {
+        size_t sink = 0;
+
+        // std::vector of std::function, how batches started out
+        Result heap = measure([&](size_t) {
+            std::vector<StdAction> batch;
+            runBatch(batch, [](auto& it, auto&& fn) { it.emplace_back(std::move(fn)); }, actions, sink);
+        });
+
+        // the vector in an arena but every capture bigger than std::function keeps on the heap
+        std::array<core::Arena, 3> stdArenas;
+        Result arenaVector = measure([&](size_t frame) {
+            core::Arena& arena = stdArenas[frame % stdArenas.size()];
+            arena.reset();
+
+            core::ArenaVector<StdAction> batch{arena};
+            runBatch(batch, [](auto& it, auto&& fn) { it.emplace_back(std::move(fn)); }, actions, sink);
+        });
+
+        // the vector and the captures in the arena
+        std::array<core::Arena, 3> arenas;
+        Result arenaAll = measure([&](size_t frame) {
+            core::Arena& arena = arenas[frame % arenas.size()];
+            arena.reset();
+
+            core::ArenaVector<ArenaAction> batch{arena};
+            runBatch(batch, [&](auto& it, auto&& fn) { it.emplace_back(arena, std::move(fn)); }, actions, sink);
+        });
+
+        std::printf("command batch, actions=%zu\n", actions);
+        std::printf("  std::vector<std::function>        %10.1f heap allocs %10.1fus per frame\n", heap.heapAllocs, heap.micros);
+        std::printf("  ArenaVector<std::function>        %10.1f heap allocs %10.1fus per frame\n", arenaVector.heapAllocs, arenaVector.micros);
+        std::printf("  ArenaVector<UniqueFunction>       %10.1f heap allocs %10.1fus per frame\n", arenaAll.heapAllocs, arenaAll.micros);
+    }
+
+    struct Latch {
+        Latch(size_t count)
+            : remaining(count)
+        { }
+
+        void countDown() {
+            if (remaining.fetch_sub(1) == 1) {
+                remaining.notify_all();
+            }
+        }
+
+        void wait() {
+            size_t current = remaining.load();
+            while (current != 0) {
+                remaining.wait(current);
+                current = remaining.load();
+            }
+        }
+
+        std::atomic_size_t remaining;
+    };
+
+    // jobs that need a scratch buffer for the length of the job, the frame ends once they all finish
+    void benchWorkers(size_t jobs) {
+        WorkPool pool{kWorkers, 256, 64, std::chrono::milliseconds(20)};
+
+        std::vector<std::jthread> threads;
+        for (size_t i = 0; i < kWorkers; i++) {
+            threads.emplace_back([&pool, i](std::stop_token token) {
+                pool.runWorker(i, token);
+            });
+        }
+
+        std::atomic_size_t sink = 0;
+
+        auto runFrame = [&](auto&& scratch) {
+            Latch latch{jobs};
+            for (size_t i = 0; i < jobs; i++) {
+                pool.add("bench", [&, i] {
+                    auto buffer = scratch();
+                    if constexpr (requires { buffer.resize(512, i); }) {
+                        buffer.resize(512, i);
+                        sink += buffer.back();
+                    }
+                    latch.countDown();
+                });
+            }
+
+            latch.wait();
+            core::endFrame();
+        };
+
+        // the pools own allocations, so theyre not mistaken for the scratch buffers
+        Result none = measure([&](size_t) {
+            runFrame([] { return std::array<size_t, 0>(); });
+        });
+
+        Result heap = measure([&](size_t) {
+            runFrame([] { return std::vector<size_t>(); });
+        });
+
+        Result arena = measure([&](size_t) {
+            runFrame([] { return core::ArenaVector<size_t>(core::getFrameArena()); });
+        });
+
+        std::printf("worker scratch, workers=%zu jobs=%zu\n", kWorkers, jobs);
+        std::printf("  no scratch                        %10.1f heap allocs %10.1fus per frame\n", none.heapAllocs, none.micros);
+        std::printf("  std::vector                       %10.1f heap allocs %10.1fus per frame\n", heap.heapAllocs, heap.micros);
+        std::printf("  worker frame arena                %10.1f heap allocs %10.1fus per frame\n", arena.heapAllocs, arena.micros);
+
+        for (std::jthread& thread : threads) {
+            thread.request_stop();
+        }
+    }
+}
+
+int main(int argc, const char **argv) {
+    size_t actions = 1000;
+    size_t jobs = 256;
+    if (argc > 1) actions = std::strtoull(argv[1], nullptr, 10);
+    if (argc > 2) jobs = std::max<size_t>(std::strtoull(argv[2], nullptr, 10), 1);
+
+    benchBatches(actions);
+    benchWorkers(jobs);
+
+    return 0;
+}
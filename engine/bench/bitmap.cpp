@@ -0,0 +1,141 @@
+#include "engine/core/bitmap.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace simcoe;
+using namespace simcoe::core;
+
+// descriptor heap sized bitmaps, allocating through the summary against scanning from bit 0.
+// usage: bench-bitmap [bits]
+
+namespace {
+    using BenchClock = std::chrono::steady_clock;
+
+    constexpr size_t kRuns = 5;
+    constexpr size_t kChurn = 100000;
+
+    // how alloc worked before the summary, test every bit from the start
+    template<typename M>
+    typename M::Index scanAlloc(M& map) {
+        for (size_t i = 0; i < map.getTotalBits(); i++) {
+            if (map.testSet(i)) {
+                return typename M::Index(i);
+            }
+        }
+
+        return M::Index::eInvalid;
+    }
+
+    struct Summary {
+        template<typename M>
+        typename M::Index operator()(M& map) const { return map.alloc(); }
+    };
+
+    struct Scan {
+        template<typename M>
+        typename M::Index operator()(M& map) const { return scanAlloc(map); }
+    };
+
+    double toNanos(BenchClock::duration duration, size_t ops) {
+        return std::chrono::duration<double, std::nano>(duration).count() / double(ops);
+    }
+
+    // fill an empty map, returns ns per alloc.
+    // scanning is quadratic here so only the summary gets measured
+    template<typename M, typename A>
+    double runFill(size_t bits, A&& alloc) {
+        M map{bits};
+
+        auto start = BenchClock::now();
+        for (size_t i = 0; i < bits; i++) {
+            alloc(map);
+        }
+
+        return toNanos(BenchClock::now() - start, bits);
+    }
+
+    // a full map releasing one random slot and allocating it straight back, like a heap at steady state
+    template<typename M, typename A>
+    double runChurn(size_t bits, size_t ops, A&& alloc) {
+        M map{bits};
+        for (size_t i = 0; i < bits; i++) {
+            map.alloc();
+        }
+
+        std::mt19937_64 rng{bits};
+        std::vector<size_t> order(ops);
+        for (size_t& it : order) {
+            it = rng() % bits;
+        }
+
+        auto start = BenchClock::now();
+        for (size_t bit : order) {
+            map.release(typename M::Index(bit));
+            alloc(map);
+        }
+
+        return toNanos(BenchClock::now() - start, ops);
+    }
+
+    template<typename M>
+    double runCount(size_t bits) {
+        M map{bits};
+        for (size_t i = 0; i < bits / 2; i++) {
+            map.alloc();
+        }
+
+        constexpr size_t kCounts = 100000;
+        size_t total = 0;
+
+        auto start = BenchClock::now();
+        for (size_t i = 0; i < kCounts; i++) {
+            total += map.countSetBits();
+        }
+
+        auto elapsed = BenchClock::now() - start;
+        if (total != kCounts * (bits / 2)) std::printf("unexpected count %zu\n", total);
+
+        return toNanos(elapsed, kCounts);
+    }
+
+    template<typename F>
+    double median(F&& run) {
+        std::vector<double> times;
+        for (size_t i = 0; i < kRuns; i++) {
+            times.push_back(run());
+        }
+
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+
+    template<typename M>
+    void benchMap(const char *pzName, size_t bits) {
+        // scanning a full map is slow enough that it gets far fewer ops
+        size_t scanOps = std::max<size_t>(kChurn / std::max<size_t>(bits / 256, 1), 100);
+
+        double fill = median([&] { return runFill<M>(bits, Summary{}); });
+        double churnSummary = median([&] { return runChurn<M>(bits, kChurn, Summary{}); });
+        double churnScan = median([&] { return runChurn<M>(bits, scanOps, Scan{}); });
+        double count = median([&] { return runCount<M>(bits); });
+
+        std::printf("%-12s bits=%zu\n", pzName, bits);
+        std::printf("  fill     summary=%10.1fns per alloc\n", fill);
+        std::printf("  churn    summary=%10.1fns scan=%10.1fns per release+alloc\n", churnSummary, churnScan);
+        std::printf("  count    %10.1fns per countSetBits\n", count);
+    }
+}
+
+int main(int argc, const char **argv) {
+    size_t bits = 0x10000;
+    if (argc > 1) bits = std::max<size_t>(std::strtoull(argv[1], nullptr, 10), 1);
+
+    benchMap<BitMap>("BitMap", bits);
+    benchMap<AtomicBitMap>("AtomicBitMap", bits);
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "engine/threads/messages.h"
+
+#include "engine/log/log.h"
+#include "engine/threads/thread.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace simcoe;
+using namespace simcoe::mt;
+
+// pushes messages through the channels and through the moodycamel queue the logger used before.
+// usage: bench-channel [messages]
+
+namespace {
+    using namespace std::chrono_literals;
+    using BenchClock = std::chrono::steady_clock;
+
+    constexpr size_t kQueueSize = 1024;
+    constexpr size_t kBatchSize = 32;
+    constexpr size_t kRuns = 5;
+
+    // shaped like the loggers queue entry
+    struct LogMessage {
+        log::Level level;
+        threads::ThreadId id;
+        log::MessageTime time;
+        std::string msg;
+    };
+
+    template<typename T>
+    T makeMessage(size_t i);
+
+    template<>
+    size_t makeMessage<size_t>(size_t i) {
+        return i;
+    }
+
+    template<>
+    LogMessage makeMessage<LogMessage>(size_t i) {
+        return { log::eInfo, threads::ThreadId(i), log::MessageTime(), "a log message long enough to not fit inline" };
+    }
+
+    template<typename T>
+    struct ChannelAdapter {
+        ChannelAdapter(size_t producers)
+            : pSpsc(producers == 1 ? new SpscChannel<T>("bench.spsc", kQueueSize) : nullptr)
+            , pMpsc(producers == 1 ? nullptr : new MpscChannel<T>("bench.mpsc", kQueueSize))
+        { }
+
+        void push(T&& item) {
+            if (pSpsc) pSpsc->push(std::move(item));
+            else pMpsc->push(std::move(item));
+        }
+
+        size_t pop(T *pItems, size_t count) {
+            if (pSpsc) return pSpsc->popBatch(pItems, count, 5ms);
+            return pMpsc->popBatch(pItems, count, 5ms);
+        }
+
+        std::unique_ptr<SpscChannel<T>> pSpsc;
+        std::unique_ptr<MpscChannel<T>> pMpsc;
+    };
+
+    template<typename T>
+    struct QueueAdapter {
+        QueueAdapter(size_t)
+            : queue(kQueueSize)
+        { }
+
+        void push(T&& item) {
+            queue.enqueue(std::move(item));
+        }
+
+        size_t pop(T *pItems, size_t count) {
+            return queue.tryGetBulk(pItems, count, 5ms);
+        }
+
+        BlockingMessageQueue<T> queue;
+    };
+
+    template<typename A, typename T>
+    double runOnce(size_t producers, size_t messages) {
+        A adapter{producers};
+        size_t each = messages / producers;
+
+        auto start = BenchClock::now();
+
+        std::vector<std::jthread> threads;
+        for (size_t i = 0; i < producers; i++) {
+            threads.emplace_back([&] {
+                for (size_t j = 0; j < each; j++) {
+                    adapter.push(makeMessage<T>(j));
+                }
+            });
+        }
+
+        std::vector<T> items(kBatchSize);
+        size_t total = 0;
+        while (total < each * producers) {
+            total += adapter.pop(items.data(), items.size());
+        }
+
+        auto elapsed = BenchClock::now() - start;
+        return std::chrono::duration<double, std::milli>(elapsed).count();
+    }
+
+    template<typename A, typename T>
+    void report(const char *pzType, const char *pzQueue, size_t producers, size_t messages) {
+        std::vector<double> times;
+        for (size_t i = 0; i < kRuns; i++) {
+            times.push_back(runOnce<A, T>(producers, messages));
+        }
+
+        std::sort(times.begin(), times.end());
+        std::printf("%-10s producers=%zu %-10s best=%8.2fms median=%8.2fms\n",
+            pzType, producers, pzQueue, times.front(), times[times.size() / 2]);
+    }
+
+    template<typename T>
+    void benchType(const char *pzType, size_t messages) {
+        for (size_t producers : { 1, 4 }) {
+            const char *pzChannel = (producers == 1) ? "spsc" : "mpsc";
+            report<ChannelAdapter<T>, T>(pzType, pzChannel, producers, messages);
+            report<QueueAdapter<T>, T>(pzType, "moodycamel", producers, messages);
+        }
+    }
+}
+
+int main(int argc, const char **argv) {
+    size_t messages = 2000000;
+    if (argc > 1) messages = std::max<size_t>(std::strtoull(argv[1], nullptr, 10), 4);
+
+    benchType<size_t>("size_t", messages);
+    benchType<LogMessage>("LogMessage", messages);
+
+    return 0;
+}
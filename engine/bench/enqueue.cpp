@@ -0,0 +1,219 @@
+#include "engine/threads/pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+// heap allocations per enqueue for the message every queue used to carry, a std::string name
+// and a std::function, against WorkName and WorkItem through the work queues and the pool.
+// every allocation is counted, on the thread that enqueues and on whichever thread runs the job.
+// usage: bench-enqueue [jobs]
+
+namespace {
+    std::atomic_size_t gHeapAllocs = 0;
+}
+
+void *operator new(size_t size) {
+    gHeapAllocs.fetch_add(1, std::memory_order_relaxed);
+    if (void *pData = std::malloc(std::max<size_t>(size, 1))) return pData;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pData) noexcept { std::free(pData); }
+void operator delete(void *pData, size_t) noexcept { std::free(pData); }
+
+namespace {
+    using BenchClock = std::chrono::steady_clock;
+
+    constexpr size_t kWarmup = 4;
+    constexpr size_t kRounds = 20;
+    constexpr size_t kWorkers = 2;
+
+    // what TransformComp::onDebugDraw captures for its update job
+    struct Transform { void *pGpu; void *pTransform; void *pCamera; size_t version; };
+
+    // too big for the inline storage of a WorkItem
+    struct Large { size_t values[8]; };
+
+    struct OldMessage {
+        std::string name;
+        std::function<void()> item;
+    };
+
+    struct Result {
+        double heapAllocs; ///< per job, after warmup
+        double nanos; ///< per job, enqueue and run
+    };
+
+    // run @p round once per round, each round enqueues and runs @p jobs jobs
+    template<typename F>
+    Result measure(size_t jobs, F&& round) {
+        for (size_t i = 0; i < kWarmup; i++) {
+            round();
+        }
+
+        size_t allocs = gHeapAllocs.load();
+        auto start = BenchClock::now();
+
+        for (size_t i = 0; i < kRounds; i++) {
+            round();
+        }
+
+        auto elapsed = std::chrono::duration<double, std::nano>(BenchClock::now() - start);
+        double total = double(jobs * kRounds);
+        return { double(gHeapAllocs.load() - allocs) / total, elapsed.count() / total };
+    }
+
+    void print(const char *pzName, const Result& result) {
+        std::printf("  %-36s %6.2f heap allocs %8.1fns per job\n", pzName, result.heapAllocs, result.nanos);
+    }
+
+    void benchQueues(size_t jobs) {
+        size_t sink = 0;
+        Transform transform = { &sink, &sink, &sink, 1 };
+        Large large = {};
+
+        moodycamel::ConcurrentQueue<OldMessage> oldQueue{256};
+        Result old = measure(jobs, [&] {
+            for (size_t i = 0; i < jobs; i++) {
+                oldQueue.enqueue({ "update transform", [transform, &sink] { sink += transform.version; } });
+            }
+
+            OldMessage message;
+            while (oldQueue.try_dequeue(message)) {
+                message.item();
+            }
+        });
+
+        WorkQueue queue{256};
+        auto drain = [&] {
+            queue.drain(std::chrono::microseconds::max());
+        };
+
+        Result literal = measure(jobs, [&] {
+            for (size_t i = 0; i < jobs; i++) {
+                queue.add("update transform", [transform, &sink] { sink += transform.version; });
+            }
+
+            drain();
+        });
+
+        // names built at runtime are interned the first time theyre seen
+        std::string name = "update transform " + std::to_string(jobs);
+        Result runtime = measure(jobs, [&] {
+            for (size_t i = 0; i < jobs; i++) {
+                queue.add(name, [transform, &sink] { sink += transform.version; });
+            }
+
+            drain();
+        });
+
+        Result heap = measure(jobs, [&] {
+            for (size_t i = 0; i < jobs; i++) {
+                queue.add("large", [large, &sink] { sink += large.values[0]; });
+            }
+
+            drain();
+        });
+
+        std::printf("work queue, jobs=%zu (%zu byte capture)\n", jobs, sizeof(Transform) + sizeof(void*));
+        print("std::string and std::function", old);
+        print("WorkItem, literal name", literal);
+        print("WorkItem, runtime name", runtime);
+        print("WorkItem, capture too big to inline", heap);
+    }
+
+    struct Latch {
+        Latch(size_t count)
+            : remaining(count)
+        { }
+
+        void countDown() {
+            if (remaining.fetch_sub(1) == 1) {
+                remaining.notify_all();
+            }
+        }
+
+        void wait() {
+            size_t current = remaining.load();
+            while (current != 0) {
+                remaining.wait(current);
+                current = remaining.load();
+            }
+        }
+
+        std::atomic_size_t remaining;
+    };
+
+    void benchPool(size_t jobs) {
+        WorkPool pool{kWorkers, 256, 64, std::chrono::milliseconds(20)};
+
+        std::vector<std::jthread> threads;
+        for (size_t i = 0; i < kWorkers; i++) {
+            threads.emplace_back([&pool, i](std::stop_token token) {
+                pool.runWorker(i, token);
+            });
+        }
+
+        std::atomic_size_t sink = 0;
+        Transform transform = { &sink, &sink, &sink, 1 };
+
+        // every job goes through a lane queue
+        Result outside = measure(jobs, [&] {
+            Latch latch{jobs};
+            for (size_t i = 0; i < jobs; i++) {
+                pool.add("update transform", [transform, &latch] {
+                    static_cast<std::atomic_size_t*>(transform.pGpu)->fetch_add(transform.version);
+                    latch.countDown();
+                });
+            }
+
+            latch.wait();
+        });
+
+        // every job but the first goes on the submitting workers deque
+        Result inside = measure(jobs, [&] {
+            Latch latch{jobs};
+            pool.add("spawn", [&] {
+                for (size_t i = 0; i < jobs; i++) {
+                    pool.add("update transform", [transform, &latch] {
+                        static_cast<std::atomic_size_t*>(transform.pGpu)->fetch_add(transform.version);
+                        latch.countDown();
+                    });
+                }
+            });
+
+            latch.wait();
+        });
+
+        for (std::jthread& thread : threads) {
+            thread.request_stop();
+        }
+
+        WorkPoolStats stats = pool.getStats();
+
+        std::printf("work pool, workers=%zu jobs=%zu\n", kWorkers, jobs);
+        print("from outside the pool", outside);
+        print("from a worker", inside);
+        std::printf("  deque node allocs=%zu heap jobs=%zu over %zu jobs\n", stats.dequeNodeAllocs, stats.heapJobs, stats.executed);
+    }
+}
+
+int main(int argc, const char **argv) {
+    size_t jobs = 1000;
+    if (argc > 1) jobs = std::max<size_t>(std::strtoull(argv[1], nullptr, 10), 1);
+
+    benchQueues(jobs);
+    benchPool(jobs);
+
+    return 0;
+}
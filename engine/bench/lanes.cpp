@@ -0,0 +1,138 @@
+#include "engine/threads/pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+// latency of a steady trickle of small jobs while the pool is flooded with background work.
+// the trickle is queued as background work, which waits behind the whole flood like the old single queue,
+// then in the responsive and realtime lanes, which should only wait for a worker to finish its current job.
+// usage: bench-lanes [workers] [flood depth] [probes]
+
+namespace {
+    using BenchClock = std::chrono::steady_clock;
+    using namespace std::chrono_literals;
+
+    constexpr auto kFloodJob = 20us;
+    constexpr auto kProbeGap = 1ms;
+    constexpr auto kAging = 20ms;
+
+    // keep a worker busy for @p duration without sleeping
+    void spinFor(BenchClock::duration duration) {
+        auto end = BenchClock::now() + duration;
+        while (BenchClock::now() < end) { }
+    }
+
+    struct Percentiles {
+        double p50; ///< us
+        double p99; ///< us
+        double max; ///< us
+    };
+
+    Percentiles summarise(std::vector<double>& latencies) {
+        std::sort(latencies.begin(), latencies.end());
+        size_t count = latencies.size();
+        return { latencies[count / 2], latencies[(count * 99) / 100], latencies.back() };
+    }
+
+    struct Result {
+        Percentiles probes;
+        size_t flood; ///< background jobs run while the probes were sent
+        WorkPoolStats stats;
+    };
+
+    Result benchLane(size_t workers, size_t depth, size_t probes, ThreadType priority, bool bFlood) {
+        WorkPool pool{workers, 256, 64, kAging};
+
+        std::vector<std::jthread> threads;
+        for (size_t i = 0; i < workers; i++) {
+            threads.emplace_back([&pool, i](std::stop_token token) {
+                pool.runWorker(i, token);
+            });
+        }
+
+        // keep the background lane topped up to the flood depth
+        std::atomic_size_t flooded = 0;
+        std::jthread flood;
+        if (bFlood) {
+            flood = std::jthread([&](std::stop_token token) {
+                while (!token.stop_requested()) {
+                    if (pool.getPendingApprox() >= depth) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    pool.add("flood", [&flooded] {
+                        spinFor(kFloodJob);
+                        flooded += 1;
+                    });
+                }
+            });
+
+            while (pool.getPendingApprox() < depth) {
+                std::this_thread::yield();
+            }
+        }
+
+        std::vector<double> latencies(probes);
+        std::atomic_size_t done = 0;
+        size_t start = flooded.load();
+
+        for (size_t i = 0; i < probes; i++) {
+            auto queued = BenchClock::now();
+            pool.add("probe", [&latencies, &done, queued, i] {
+                latencies[i] = std::chrono::duration<double, std::micro>(BenchClock::now() - queued).count();
+                done += 1;
+            }, priority);
+
+            std::this_thread::sleep_for(kProbeGap);
+        }
+
+        // background probes can be stuck behind the whole flood
+        while (done.load() < probes) {
+            std::this_thread::sleep_for(kProbeGap);
+        }
+
+        size_t count = flooded.load() - start;
+
+        flood = {};
+        for (std::jthread& thread : threads) {
+            thread.request_stop();
+        }
+
+        return { summarise(latencies), count, pool.getStats() };
+    }
+
+    void report(const char *pzName, size_t workers, size_t depth, size_t probes, ThreadType priority, bool bFlood) {
+        Result result = benchLane(workers, depth, probes, priority, bFlood);
+        const WorkLaneStats& lane = result.stats.lanes[getWorkLane(priority)];
+
+        std::printf("  %-22s p50=%9.1fus p99=%9.1fus max=%9.1fus lane p99<=%6lldus promoted=%-5zu flood jobs=%zu\n",
+            pzName, result.probes.p50, result.probes.p99, result.probes.max,
+            (long long)lane.p99Latency.count(), result.stats.lanes[eBackground].promoted, result.flood);
+    }
+}
+
+int main(int argc, const char **argv) {
+    size_t workers = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 4);
+    size_t depth = 1000;
+    size_t probes = 500;
+
+    if (argc > 1) workers = std::max<size_t>(std::strtoull(argv[1], nullptr, 10), 1);
+    if (argc > 2) depth = std::max<size_t>(std::strtoull(argv[2], nullptr, 10), 1);
+    if (argc > 3) probes = std::max<size_t>(std::strtoull(argv[3], nullptr, 10), 1);
+
+    std::printf("workers=%zu flood depth=%zu probes=%zu\n", workers, depth, probes);
+    report("idle, background", workers, depth, probes, eBackground, false);
+    report("flood, background", workers, depth, probes, eBackground, true);
+    report("flood, responsive", workers, depth, probes, eResponsive, true);
+    report("flood, realtime", workers, depth, probes, eRealtime, true);
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "engine/threads/memory.h"
+#include "engine/threads/service.h"
+
+#include "engine/service/service.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#if SM_OS_LINUX
+#   include <sched.h>
+#endif
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+// read and write bandwidth from threads on every numa node to memory on every other node.
+// a host with a single node has nothing to compare, so the bench skips itself there.
+// usage: bench-numa [megabytes] [threads per node]
+
+namespace {
+    using BenchClock = std::chrono::steady_clock;
+
+    // meson treats this exit code as a skipped test
+    constexpr int kSkipped = 77;
+
+    constexpr size_t kRuns = 5;
+
+    // keep the calling thread on the cores of @p node, and its own allocations on the node too
+    void pinToNode(const Geometry& geometry, NodeIndex index) {
+        const ScheduleMask& mask = geometry.getNode(index).masks.front();
+
+#if SM_OS_WINDOWS
+        GROUP_AFFINITY affinity = mask;
+        SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr);
+#elif SM_OS_LINUX
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+
+        for (size_t bit = 0; bit < 64; ++bit) {
+            if (mask.Mask & (1ull << bit)) {
+                CPU_SET(size_t(mask.Group) * 64 + bit, &cpus);
+            }
+        }
+
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus);
+#endif
+
+        setCurrentNode(index);
+    }
+
+    // run @p fn on @p threads threads pinned to @p node, each given its own slice of [0, count)
+    template<typename F>
+    void runOnNode(const Geometry& geometry, NodeIndex node, size_t threads, size_t count, F&& fn) {
+        std::vector<std::jthread> workers;
+        for (size_t i = 0; i < threads; i++) {
+            workers.emplace_back([&, i] {
+                pinToNode(geometry, node);
+                fn((count * i) / threads, (count * (i + 1)) / threads);
+            });
+        }
+    }
+
+    struct Bandwidth {
+        double read; ///< GB/s
+        double write; ///< GB/s
+    };
+
+    Bandwidth benchNodes(const Geometry& geometry, NodeIndex reader, NodeIndex owner, size_t bytes, size_t threads) {
+        std::pmr::memory_resource *pMemory = getNodeMemory(owner);
+        auto *pData = static_cast<uint64_t*>(pMemory->allocate(bytes, 64));
+        size_t count = bytes / sizeof(uint64_t);
+
+        // fault the pages in from the node they belong to
+        runOnNode(geometry, owner, 1, count, [&](size_t, size_t) {
+            firstTouch(pData, bytes);
+        });
+
+        std::atomic_uint64_t sink = 0;
+        auto measure = [&](auto&& fn) {
+            std::vector<double> rates;
+            for (size_t run = 0; run < kRuns; run++) {
+                auto start = BenchClock::now();
+                runOnNode(geometry, reader, threads, count, fn);
+                double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+                rates.push_back(double(bytes) / seconds / 1e9);
+            }
+
+            std::sort(rates.begin(), rates.end());
+            return rates[rates.size() / 2];
+        };
+
+        double read = measure([&](size_t begin, size_t end) {
+            uint64_t total = 0;
+            for (size_t i = begin; i < end; i++) {
+                total += pData[i];
+            }
+
+            sink += total;
+        });
+
+        double write = measure([&](size_t begin, size_t end) {
+            std::fill(pData + begin, pData + end, uint64_t(begin));
+        });
+
+        pMemory->deallocate(pData, bytes, 64);
+        return { read, write };
+    }
+}
+
+int main(int argc, const char **argv) {
+    size_t megabytes = 256;
+    size_t threads = 1;
+
+    if (argc > 1) megabytes = std::max<size_t>(std::strtoull(argv[1], nullptr, 10), 1);
+    if (argc > 2) threads = std::max<size_t>(std::strtoull(argv[2], nullptr, 10), 1);
+
+    // the thread service builds the geometry and the per node heaps
+    ServiceRuntime runtime{{}};
+
+    const Geometry& geometry = ThreadService::getGeometry();
+    size_t nodes = geometry.nodes.size();
+    if (nodes < 2) {
+        std::printf("skipping, this host has %zu numa node%s\n", nodes, nodes == 1 ? "" : "s");
+        return kSkipped;
+    }
+
+    size_t bytes = megabytes * 1024 * 1024;
+    std::printf("nodes=%zu buffer=%zuMB threads per node=%zu\n", nodes, megabytes, threads);
+
+    for (size_t reader = 0; reader < nodes; reader++) {
+        Bandwidth local = {};
+        for (size_t owner = 0; owner < nodes; owner++) {
+            Bandwidth bandwidth = benchNodes(geometry, NodeIndex(reader), NodeIndex(owner), bytes, threads);
+            if (owner == reader) local = bandwidth;
+
+            std::printf("  threads on node %-3u memory on node %-3u read=%7.2fGB/s write=%7.2fGB/s\n",
+                geometry.nodes[reader].id, geometry.nodes[owner].id, bandwidth.read, bandwidth.write);
+        }
+
+        std::printf("  local read=%.2fGB/s write=%.2fGB/s\n", local.read, local.write);
+    }
+
+    // the os can refuse to place pages, then every buffer lands wherever it likes and the numbers mean little
+    for (const NodeMemoryStats& stats : getNodeMemoryStats()) {
+        if (!stats.bBound) {
+            std::printf("memory could not be bound to node %u\n", stats.id);
+        }
+    }
+
+    return 0;
+}
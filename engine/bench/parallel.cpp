@@ -0,0 +1,184 @@
+#include "engine/threads/parallel.h"
+#include "engine/threads/service.h"
+
+#include "engine/config/system.h"
+#include "engine/service/service.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+// parallelFor, parallelReduce and parallelSort with 1 to N workers against a plain loop on one thread.
+// the autoscaler is turned off so the worker count stays where each step puts it.
+// usage: bench-parallel [max workers] [elements]
+
+namespace {
+    using BenchClock = std::chrono::steady_clock;
+
+    constexpr size_t kRuns = 5;
+
+    // the autoscaler is only started if this is set when the thread service starts
+    void disableAutoscale() {
+        const auto& threads = config::getConfig()->getChildren().at("threads")->getChildren();
+        config::IConfigEntry *pEntry = threads.at("workers")->getChildren().at("autoscale");
+
+        bool bValue = false;
+        pEntry->loadCurrentValue(&bValue, sizeof(bool));
+    }
+
+    // enough math per element that the loop isnt just waiting on memory
+    float kernel(float value) {
+        return std::sqrt(value) * std::sin(value) + std::cos(value * 0.5f);
+    }
+
+    // @return the median time of @p run in milliseconds, @p setup runs untimed before each run
+    template<typename S, typename F>
+    double measure(S&& setup, F&& run) {
+        setup();
+        run();
+
+        std::vector<double> times;
+        for (size_t i = 0; i < kRuns; i++) {
+            setup();
+
+            auto start = BenchClock::now();
+            run();
+            times.push_back(std::chrono::duration<double, std::milli>(BenchClock::now() - start).count());
+        }
+
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+
+    struct Times {
+        double each; ///< ms
+        double reduce; ///< ms
+        double sort; ///< ms
+    };
+
+    struct Data {
+        Data(size_t count)
+            : input(count)
+            , output(count)
+            , keys(count)
+            , shuffled(count)
+        {
+            std::iota(input.begin(), input.end(), 0.f);
+            std::iota(shuffled.begin(), shuffled.end(), 0u);
+            std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(1234));
+        }
+
+        void resetKeys() {
+            std::copy(shuffled.begin(), shuffled.end(), keys.begin());
+        }
+
+        std::vector<float> input;
+        std::vector<float> output;
+        std::vector<uint32_t> keys;
+        std::vector<uint32_t> shuffled;
+    };
+
+    Times benchSerial(Data& data) {
+        size_t count = data.input.size();
+        auto none = [] { };
+
+        double each = measure(none, [&] {
+            for (size_t i = 0; i < count; i++) {
+                data.output[i] = kernel(data.input[i]);
+            }
+        });
+
+        double sum = 0.0;
+        double reduce = measure(none, [&] {
+            double total = 0.0;
+            for (size_t i = 0; i < count; i++) {
+                total += kernel(data.input[i]);
+            }
+            sum += total;
+        });
+
+        double sort = measure([&] { data.resetKeys(); }, [&] {
+            std::sort(data.keys.begin(), data.keys.end());
+        });
+
+        if (sum == 0.0) std::printf("  empty reduce\n");
+        return { each, reduce, sort };
+    }
+
+    Times benchParallel(Data& data) {
+        size_t count = data.input.size();
+        auto none = [] { };
+
+        double each = measure(none, [&] {
+            parallelFor(0, count, [&](size_t i) {
+                data.output[i] = kernel(data.input[i]);
+            });
+        });
+
+        double sum = 0.0;
+        double reduce = measure(none, [&] {
+            sum += parallelReduce(0, count, 0.0, [&](size_t begin, size_t end) {
+                double total = 0.0;
+                for (size_t i = begin; i < end; i++) {
+                    total += kernel(data.input[i]);
+                }
+                return total;
+            }, std::plus<>());
+        });
+
+        double sort = measure([&] { data.resetKeys(); }, [&] {
+            parallelSort(data.keys.begin(), data.keys.end());
+        });
+
+        if (sum == 0.0) std::printf("  empty reduce\n");
+        if (!std::is_sorted(data.keys.begin(), data.keys.end())) std::printf("  keys not sorted\n");
+        return { each, reduce, sort };
+    }
+
+    void print(const char *pzName, size_t workers, size_t threads, const Times& times, const Times& serial) {
+        std::printf("%-10s workers=%-3zu threads=%-3zu for=%8.2fms (%5.2fx) reduce=%8.2fms (%5.2fx) sort=%8.2fms (%5.2fx)\n",
+            pzName, workers, threads,
+            times.each, serial.each / times.each,
+            times.reduce, serial.reduce / times.reduce,
+            times.sort, serial.sort / times.sort);
+    }
+}
+
+int main(int argc, const char **argv) {
+    disableAutoscale();
+    ServiceRuntime runtime{{}};
+
+    size_t most = ThreadService::getGeometry().cores.size();
+    size_t count = 4000000;
+
+    if (argc > 1) most = std::max<size_t>(std::strtoull(argv[1], nullptr, 10), 1);
+    if (argc > 2) count = std::max<size_t>(std::strtoull(argv[2], nullptr, 10), 1);
+
+    Data data{count};
+
+    std::printf("elements=%zu cores=%zu autoscale=%s\n", count, ThreadService::getGeometry().cores.size(),
+        ThreadService::getScalerStats().has_value() ? "on" : "off");
+
+    Times serial = benchSerial(data);
+    print("serial", 0, 1, serial, serial);
+
+    for (size_t workers = 1; workers <= most; workers++) {
+        ThreadService::setWorkerCount(workers);
+
+        // parallelism counts the caller and is capped to the physical core count
+        Times times = benchParallel(data);
+        print("parallel", ThreadService::getWorkerCount(), getParallelism(), times, serial);
+    }
+
+    ParallelStats stats = getParallelStats();
+    std::printf("calls=%zu serial=%zu chunks=%zu helped=%zu\n", stats.calls, stats.serial, stats.chunks, stats.helped);
+
+    return 0;
+}
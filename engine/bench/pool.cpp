@@ -0,0 +1,212 @@
+#include "engine/threads/pool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+// compares the work stealing pool against the single blocking queue every worker used to poll,
+// for throughput and for how long a job sent to an idle pool waits before it starts.
+// usage: bench-pool [workers] [jobs]
+
+namespace {
+    using BenchClock = std::chrono::steady_clock;
+
+    constexpr size_t kRuns = 7;
+    constexpr size_t kFanout = 64;
+
+    // long enough for every worker to run out of spins and go to sleep
+    constexpr auto kIdleGap = std::chrono::milliseconds(5);
+    constexpr size_t kWakeups = 200;
+
+    // the old worker body, one shared queue polled with a timed wait
+    struct SingleQueuePool {
+        SingleQueuePool(size_t workers)
+            : queue(256)
+        {
+            for (size_t i = 0; i < workers; ++i) {
+                threads.emplace_back([this](std::stop_token token) {
+                    WorkMessage message;
+                    while (!token.stop_requested()) {
+                        if (queue.tryGetMessage(message, std::chrono::milliseconds(50))) {
+                            message.item();
+                        }
+                    }
+                });
+            }
+        }
+
+        void add(WorkName name, WorkItem&& item) {
+            queue.add(name, std::move(item));
+        }
+
+        BlockingWorkQueue queue;
+        std::vector<std::jthread> threads;
+    };
+
+    struct StealingPool {
+        StealingPool(size_t workers)
+            : pool(workers, 256, 64, std::chrono::milliseconds(20))
+        {
+            for (size_t i = 0; i < workers; ++i) {
+                threads.emplace_back([this, i](std::stop_token token) {
+                    pool.runWorker(i, token);
+                });
+            }
+        }
+
+        void add(WorkName name, WorkItem&& item) {
+            pool.add(name, std::move(item));
+        }
+
+        WorkPool pool;
+        std::vector<std::jthread> threads;
+    };
+
+    struct Latch {
+        Latch(size_t count)
+            : remaining(count)
+        { }
+
+        void countDown() {
+            if (remaining.fetch_sub(1) == 1) {
+                remaining.notify_all();
+            }
+        }
+
+        void wait() {
+            size_t current = remaining.load();
+            while (current != 0) {
+                remaining.wait(current);
+                current = remaining.load();
+            }
+        }
+
+        std::atomic_size_t remaining;
+    };
+
+    // a few hundred nanoseconds of work, small enough that queueing dominates
+    void spinWork(std::atomic_size_t& sink) {
+        size_t value = 0;
+        for (size_t i = 0; i < 64; ++i) {
+            value += i * i;
+        }
+
+        sink.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    // every job comes from a thread outside the pool
+    template<typename P>
+    BenchClock::duration runBurst(P& pool, size_t jobs) {
+        std::atomic_size_t sink = 0;
+        Latch latch{jobs};
+
+        auto start = BenchClock::now();
+        for (size_t i = 0; i < jobs; ++i) {
+            pool.add("burst", [&] {
+                spinWork(sink);
+                latch.countDown();
+            });
+        }
+
+        latch.wait();
+        return BenchClock::now() - start;
+    }
+
+    // a few outside jobs that each submit their children from inside the pool
+    template<typename P>
+    BenchClock::duration runFanout(P& pool, size_t jobs) {
+        size_t roots = std::max<size_t>(jobs / kFanout, 1);
+
+        std::atomic_size_t sink = 0;
+        Latch latch{roots * kFanout};
+
+        auto start = BenchClock::now();
+        for (size_t i = 0; i < roots; ++i) {
+            pool.add("fanout", [&] {
+                for (size_t j = 0; j < kFanout; ++j) {
+                    pool.add("child", [&] {
+                        spinWork(sink);
+                        latch.countDown();
+                    });
+                }
+            });
+        }
+
+        latch.wait();
+        return BenchClock::now() - start;
+    }
+
+    template<typename P, typename F>
+    void report(const char *pzPool, const char *pzCase, size_t workers, size_t jobs, F&& run) {
+        P pool{workers};
+
+        // the first run pays for thread startup and node caches
+        run(pool, jobs);
+
+        std::vector<double> times;
+        for (size_t i = 0; i < kRuns; ++i) {
+            times.push_back(std::chrono::duration<double, std::milli>(run(pool, jobs)).count());
+        }
+
+        std::sort(times.begin(), times.end());
+        double best = times.front();
+        double median = times[times.size() / 2];
+        double rate = double(jobs) / (median / 1000.0);
+
+        std::printf("%-8s %-8s workers=%-3zu jobs=%-8zu best=%8.2fms median=%8.2fms (%.0f jobs/s)\n",
+            pzCase, pzPool, workers, jobs, best, median, rate);
+    }
+
+    // one job at a time into a pool that has gone idle, timed from the submit until the job starts
+    template<typename P>
+    void reportWakeup(const char *pzPool, size_t workers) {
+        P pool{workers};
+
+        std::vector<double> latencies;
+        for (size_t i = 0; i < kWakeups; ++i) {
+            std::this_thread::sleep_for(kIdleGap);
+
+            std::atomic<BenchClock::time_point> started = {};
+            auto queued = BenchClock::now();
+            pool.add("wakeup", [&] {
+                started = BenchClock::now();
+                started.notify_one();
+            });
+
+            started.wait({});
+            latencies.push_back(std::chrono::duration<double, std::micro>(started.load() - queued).count());
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        double p50 = latencies[latencies.size() / 2];
+        double p99 = latencies[(latencies.size() * 99) / 100];
+
+        std::printf("%-8s %-8s workers=%-3zu jobs=%-8zu p50=%8.1fus p99=%8.1fus max=%8.1fus\n",
+            "wakeup", pzPool, workers, kWakeups, p50, p99, latencies.back());
+    }
+
+    template<typename P>
+    void benchPool(const char *pzName, size_t workers, size_t jobs) {
+        report<P>(pzName, "burst", workers, jobs, [](P& pool, size_t count) { return runBurst(pool, count); });
+        report<P>(pzName, "fanout", workers, jobs, [](P& pool, size_t count) { return runFanout(pool, count); });
+        reportWakeup<P>(pzName, workers);
+    }
+}
+
+int main(int argc, const char **argv) {
+    size_t workers = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 8);
+    size_t jobs = 100000;
+
+    if (argc > 1) workers = std::max<size_t>(std::strtoull(argv[1], nullptr, 10), 1);
+    if (argc > 2) jobs = std::max<size_t>(std::strtoull(argv[2], nullptr, 10), 1);
+
+    benchPool<SingleQueuePool>("queue", workers, jobs);
+    benchPool<StealingPool>("pool", workers, jobs);
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "engine/threads/pool.h"
+#include "engine/threads/scaler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+// drives a real pool with the worker scaler through quiet stretches and bursts of work,
+// printing how many workers it had over time.
+// usage: bench-scaler [max workers] [jobs per burst tick, 0 for half the max] [tick ms]
+
+namespace {
+    using namespace std::chrono_literals;
+    using BenchClock = std::chrono::steady_clock;
+
+    constexpr size_t kCycles = 3;
+    constexpr size_t kQuietTicks = 150; // long enough to retire a few workers
+    constexpr size_t kBurstTicks = 50;
+    constexpr size_t kPrintEvery = 5;
+
+    constexpr auto kJobTime = 20us;
+
+    // resizes like ThreadService::setWorkerCount, always from the back
+    struct ScaledPool {
+        ScaledPool(size_t slots)
+            : pool(slots, 256, 64, std::chrono::milliseconds(20))
+        { }
+
+        ~ScaledPool() {
+            resize(0);
+        }
+
+        void resize(size_t count) {
+            while (workers.size() < count) {
+                workers.emplace_back([this, slot = workers.size()](std::stop_token token) {
+                    pool.runWorker(slot, token);
+                });
+            }
+
+            while (workers.size() > count) {
+                workers.pop_back();
+            }
+        }
+
+        WorkPool pool;
+        std::vector<std::jthread> workers;
+    };
+
+    void spinFor(BenchClock::duration time) {
+        auto end = BenchClock::now() + time;
+        while (BenchClock::now() < end) { }
+    }
+
+    ScalerSample takeSample(ScaledPool& pool) {
+        WorkPoolStats stats = pool.pool.getStats();
+
+        std::chrono::microseconds latency{0};
+        for (const WorkLaneStats& lane : stats.lanes) {
+            latency += lane.totalLatency;
+        }
+
+        return {
+            .workers = pool.workers.size(),
+            .pending = pool.pool.getPendingApprox(),
+            .sleeping = stats.sleeping,
+            .executed = stats.executed,
+            .latency = latency
+        };
+    }
+
+    struct PhaseTotals {
+        size_t ticks = 0;
+        size_t workerTicks = 0;
+        size_t changes = 0;
+    };
+}
+
+int main(int argc, const char **argv) {
+    size_t maxWorkers = std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 8);
+    size_t jobs = 0;
+    size_t tickMs = 10;
+
+    if (argc > 1) maxWorkers = std::max<size_t>(std::strtoull(argv[1], nullptr, 10), 1);
+    if (argc > 2) jobs = std::strtoull(argv[2], nullptr, 10);
+    if (argc > 3) tickMs = std::max<size_t>(std::strtoull(argv[3], nullptr, 10), 1);
+
+    auto tick = std::chrono::milliseconds(tickMs);
+
+    // by default a burst keeps about half of the most workers busy
+    if (jobs == 0) {
+        jobs = std::max<size_t>(maxWorkers * size_t(tick / kJobTime) / 2, 1);
+    }
+
+    ScalerConfig config = {
+        .minWorkers = 1,
+        .maxWorkers = maxWorkers,
+        .growLatency = 2ms
+    };
+
+    WorkerScaler scaler{config};
+    ScaledPool pool{maxWorkers};
+    pool.resize(config.minWorkers);
+
+    std::printf("max workers=%zu jobs per burst tick=%zu (%lldus each) tick=%zums\n",
+        maxWorkers, jobs, (long long)kJobTime.count(), tickMs);
+    std::printf("%7s %6s %8s %8s %10s\n", "time", "phase", "workers", "pending", "latency");
+
+    PhaseTotals quiet;
+    PhaseTotals burst;
+
+    auto start = BenchClock::now();
+    auto next = start;
+    for (size_t cycle = 0; cycle < kCycles; cycle++) {
+        for (size_t i = 0; i < kQuietTicks + kBurstTicks; i++) {
+            bool bBurst = i >= kQuietTicks;
+            PhaseTotals& totals = bBurst ? burst : quiet;
+
+            // quiet ticks still trickle in a little work
+            size_t count = bBurst ? jobs : 1;
+            for (size_t j = 0; j < count; j++) {
+                pool.pool.add("bench", [] { spinFor(kJobTime); });
+            }
+
+            next += tick;
+            std::this_thread::sleep_until(next);
+
+            ScalerSample sample = takeSample(pool);
+            size_t target = scaler.update(sample);
+            if (target != sample.workers) {
+                pool.resize(target);
+                totals.changes += 1;
+            }
+
+            totals.ticks += 1;
+            totals.workerTicks += target;
+
+            if (i % kPrintEvery == 0) {
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(BenchClock::now() - start);
+                std::printf("%5lldms %6s %8zu %8zu %8lldus\n",
+                    (long long)elapsed.count(), bBurst ? "burst" : "quiet", target,
+                    sample.pending, (long long)scaler.getStats().lastLatency.count());
+            }
+        }
+    }
+
+    ScalerStats stats = scaler.getStats();
+    std::printf("grown=%zu shrunk=%zu\n", stats.grown, stats.shrunk);
+    std::printf("quiet mean workers=%.2f changes=%zu\n", double(quiet.workerTicks) / double(quiet.ticks), quiet.changes);
+    std::printf("burst mean workers=%.2f changes=%zu\n", double(burst.workerTicks) / double(burst.ticks), burst.changes);
+
+    return 0;
+}
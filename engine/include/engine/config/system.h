@@ -63,7 +63,7 @@ namespace simcoe::config {
         std::string_view description;
         VisibleType defaultValue;
 
-        NotifyConfigUpdate notify;
+        NotifyConfigUpdate notify = {};
         ValueFlag flags = eDefault;
     };
 
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "engine/core/macros.h"
+#include "engine/core/panic.h"
+
+#include <memory_resource>
+#include <vector>
+
+namespace simcoe::core {
+    struct ArenaStats {
+        size_t allocs = 0; ///< allocations served since the last reset
+        size_t used = 0; ///< bytes handed out since the last reset
+        size_t capacity = 0; ///< bytes reserved across every block
+        size_t blocks = 0; ///< blocks allocated from the heap since the last reset
+    };
+
+    /**
+     * @brief linear allocator for data that all dies at the same time
+     * allocations bump a pointer through a chain of blocks and are never freed individually,
+     * everything is released at once by reset.
+     * if a frame needed more than one block they are merged into a single block on reset,
+     * so once an arena has seen its largest frame it stops touching the heap.
+     */
+    struct Arena {
+        SM_NOCOPY(Arena)
+
+        static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+        Arena(size_t blockSize = kDefaultBlockSize, std::pmr::memory_resource *pUpstream = std::pmr::new_delete_resource());
+        ~Arena();
+
+        void *allocate(size_t size, size_t align);
+
+        // invalidates everything allocated from the arena
+        void reset();
+
+        // move future blocks to @param pMemory, the arena must have been reset since it was last used
+        void setUpstream(std::pmr::memory_resource *pMemory);
+
+        ArenaStats getStats() const { return stats; }
+
+    private:
+        struct Block;
+
+        void newBlock(size_t size);
+        void freeBlocks();
+
+        size_t blockSize;
+        std::pmr::memory_resource *pUpstream; ///< where blocks come from
+
+        Block *pBlock = nullptr; ///< the block we're allocating from, links to older blocks
+        char *pCursor = nullptr;
+        char *pEnd = nullptr;
+
+        ArenaStats stats;
+    };
+
+    /**
+     * @brief std allocator adapter for an Arena
+     * deallocate does nothing, memory comes back when the arena is reset.
+     * a default constructed allocator has no arena and asserts if anything is allocated from it.
+     */
+    template<typename T>
+    struct ArenaAllocator {
+        using value_type = T;
+
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        ArenaAllocator() = default;
+
+        ArenaAllocator(Arena& arena)
+            : pArena(&arena)
+        { }
+
+        template<typename O>
+        ArenaAllocator(const ArenaAllocator<O>& other)
+            : pArena(other.getArena())
+        { }
+
+        T *allocate(size_t count) {
+            SM_ASSERTF(pArena != nullptr, "allocating {} bytes from an allocator without an arena", count * sizeof(T));
+            return static_cast<T*>(pArena->allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T*, size_t) { }
+
+        Arena *getArena() const { return pArena; }
+
+        template<typename O>
+        bool operator==(const ArenaAllocator<O>& other) const { return pArena == other.getArena(); }
+
+    private:
+        Arena *pArena = nullptr;
+    };
+
+    template<typename T>
+    using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+    // the calling threads frame arena, created on first use
+    Arena& getFrameArena();
+
+    // called by a thread at the start of each of its frames,
+    // anything allocated from its frame arena during the last frame is gone after this
+    void resetFrameArena();
+
+    // ends the frame for every thread, resets the calling threads frame arena now.
+    // threads without frames of their own, like workers, reset theirs in resetStaleFrameArena
+    void endFrame();
+
+    // reset the calling threads frame arena if a frame has ended since it was last reset.
+    // workers call this between jobs, so nothing a job allocates outlives the frame it ran in
+    void resetStaleFrameArena();
+
+    // the last completed frame of every thread with a frame arena, summed
+    ArenaStats getFrameArenaStats();
+
+    // where the calling threads frame arena gets its blocks from, takes effect immediately
+    // so it should be called before a frame starts allocating
+    void setFrameArenaMemory(std::pmr::memory_resource *pMemory);
+}
@@ -3,95 +3,151 @@
 #include "engine/core/unique.h"
 
 #include <memory>
+#include <atomic>
 #include <bit>
 namespace simcoe::core {
     namespace detail {
-        template<typename T, typename Super>
+        /**
+         * @brief a fixed size set of bits with fast find first free
+         * on top of the bits are summary levels, each has one bit per word of the level
+         * below which is set when that word is completely full. finding a free bit scans
+         * the top level, which is only a word or two for any size we use, then does one
+         * count trailing ones per level on the way down.
+         *
+         * @tparam T the word type, plain or atomic
+         * @tparam TCount the type of the cached population count
+         */
+        template<typename T, typename TCount, typename Super>
         struct BitMapStorage {
             enum struct Index : size_t { eInvalid = SIZE_MAX };
 
-            constexpr BitMapStorage(size_t bits)
+            constexpr static inline size_t kBitPerWord = sizeof(T) * CHAR_BIT;
+            constexpr static inline size_t kSummaryLevels = 3;
+
+            BitMapStorage(size_t bits)
                 : size(bits)
-                , pBits(wordCount())
+                , pBits(levelWords(0))
+                , pSummary{ levelWords(1), levelWords(2), levelWords(3) }
             {
                 reset();
             }
 
-            constexpr size_t countSetBits() const { 
-                size_t count = 0;
-                for (size_t i = 0; i < wordCount(); i++) {
-                    count += std::popcount(pBits[i]);
-                }
-                return count;
-            }
+            size_t countSetBits() const { return used; }
 
             constexpr size_t getTotalBits() const { return size; }
-            constexpr size_t getCapacity() const { return wordCount() * kBitPerWord; }
+            constexpr size_t getCapacity() const { return levelWords(0) * kBitPerWord; }
 
-            constexpr bool test(Index index) const {
+            bool test(Index index) const {
                 verifyIndex(index);
 
-                return pBits[getWord(size_t(index))] & getMask(size_t(index));
+                return loadWord(pBits[getWord(size_t(index))]) & getMask(size_t(index));
             }
 
-            constexpr Index alloc() {
-                Super *self = static_cast<Super*>(this);
-                for (size_t i = 0; i < getTotalBits(); i++) {
-                    if (self->testSet(i)) {
-                        return Index(i);
-                    }
+            void reset() {
+                for (size_t level = 0; level <= kSummaryLevels; level++) {
+                    std::fill_n(getLevel(level), levelWords(level), 0);
                 }
 
-                return Index::eInvalid;
+                used = 0;
             }
 
-            constexpr void release(Index index) {
-                clear(size_t(index));
+            // call @param fn with the index of every set bit, lowest first
+            template<typename F>
+            void forEachSet(F&& fn) const {
+                for (size_t word = 0; word < levelWords(0); word++) {
+                    std::uint64_t bits = loadWord(pBits[word]);
+                    while (bits != 0) {
+                        fn(word * kBitPerWord + std::countr_zero(bits));
+                        bits &= bits - 1;
+                    }
+                }
             }
 
-            constexpr void reset() {
-                std::fill_n(pBits.get(), wordCount(), 0);
+        protected:
+            constexpr std::uint64_t getMask(size_t bit) const { return std::uint64_t(1) << (bit % kBitPerWord); }
+            constexpr size_t getWord(size_t bit) const { return bit / kBitPerWord; }
+
+            // level 0 is the bits themselves, every level above is a summary
+            constexpr size_t levelWords(size_t level) const {
+                size_t words = (getTotalBits() + kBitPerWord - 1) / kBitPerWord;
+                for (size_t i = 0; i < level; i++) {
+                    words = (words + kBitPerWord - 1) / kBitPerWord;
+                }
+                return words;
             }
 
-            constexpr static inline size_t kBitPerWord = sizeof(T) * CHAR_BIT;
+            T *getLevel(size_t level) { return (level == 0) ? pBits.get() : pSummary[level - 1].get(); }
+            const T *getLevel(size_t level) const { return (level == 0) ? pBits.get() : pSummary[level - 1].get(); }
 
-        protected:
-            constexpr void set(size_t index) {
-                verifyIndex(Index(index));
-                pBits[getWord(index)] |= getMask(index);
-            }
+            static std::uint64_t loadWord(const T& word) { return word; }
 
-            constexpr void clear(size_t index) {
-                verifyIndex(Index(index));
-                pBits[getWord(index)] &= ~getMask(index);
-            }
+            // the lowest word that may have a free bit, SIZE_MAX if the summary says they are all full
+            size_t findFreeWord() const {
+                const T *pTop = getLevel(kSummaryLevels);
+                size_t word = SIZE_MAX;
+                for (size_t i = 0; i < levelWords(kSummaryLevels); i++) {
+                    if (~loadWord(pTop[i]) != 0) {
+                        word = i;
+                        break;
+                    }
+                }
 
-        protected:
-            constexpr T getMask(size_t bit) const { return T(1) << (bit % kBitPerWord); }
-            constexpr size_t getWord(size_t bit) const { return bit / kBitPerWord; }
-            constexpr size_t wordCount() const { return (getTotalBits() / kBitPerWord) + 1; }
+                if (word == SIZE_MAX) return SIZE_MAX;
+
+                for (size_t level = kSummaryLevels; level > 0; level--) {
+                    word = word * kBitPerWord + std::countr_one(loadWord(getLevel(level)[word]));
+
+                    // the first non full word is past the end, so every real one is full
+                    if (word >= levelWords(level - 1)) return SIZE_MAX;
+                }
+
+                return word;
+            }
 
             size_t size;
             core::UniquePtr<T[]> pBits;
+            core::UniquePtr<T[]> pSummary[kSummaryLevels];
+            TCount used = 0;
 
             void verifyIndex(Index index) const {
                 SM_ASSERTF(index != Index::eInvalid, "invalid index");
-                SM_ASSERTF(size_t(index) <= getTotalBits(), "bit {} is out of bounds", size_t(index));
+                SM_ASSERTF(size_t(index) < getTotalBits(), "bit {} is out of bounds", size_t(index));
             }
         };
     }
 
-    struct BitMap final : detail::BitMapStorage<std::uint64_t, BitMap> {
-        using Super = detail::BitMapStorage<std::uint64_t, BitMap>;
+    struct BitMap final : detail::BitMapStorage<std::uint64_t, size_t, BitMap> {
+        using Super = detail::BitMapStorage<std::uint64_t, size_t, BitMap>;
         using Super::BitMapStorage;
 
+        Index alloc();
+        void release(Index index);
+
         bool testSet(size_t index);
+
+    private:
+        void set(size_t index);
+        void clear(size_t index);
     };
 
-    struct AtomicBitMap final : detail::BitMapStorage<std::atomic_uint64_t, AtomicBitMap> {
-        using Super = detail::BitMapStorage<std::atomic_uint64_t, AtomicBitMap>;
+    /**
+     * @brief a bitmap that can be allocated from and released to by any thread
+     * the summary is only a hint here, a release racing with an alloc in the same word can
+     * leave it stale for a moment. alloc retries a few times and falls back to scanning
+     * the bits directly, so a stale summary only costs time.
+     */
+    struct AtomicBitMap final : detail::BitMapStorage<std::atomic_uint64_t, std::atomic_size_t, AtomicBitMap> {
+        using Super = detail::BitMapStorage<std::atomic_uint64_t, std::atomic_size_t, AtomicBitMap>;
         using Super::BitMapStorage;
 
+        Index alloc();
+        void release(Index index);
+
         bool testSet(size_t index);
+
+    private:
+        Index claim(size_t word);
+        void markFull(size_t word);
+        void markFree(size_t word);
     };
 }
@@ -13,9 +13,15 @@
 #if SM_CC_MSVC
 #   define SM_ENSURE(...) __assume(__VA_ARGS__)
 #   define SM_UNREACHABLE() __assume(0)
-#elif SM_CC_CLANG || SM_CC_GCC
+#   define SM_DEBUGBREAK() __debugbreak()
+#elif SM_CC_CLANG
 #   define SM_ENSURE(...) __builtin_assume(__VA_ARGS__)
 #   define SM_UNREACHABLE() __builtin_unreachable()
+#   define SM_DEBUGBREAK() __builtin_debugtrap()
+#elif SM_CC_GCC
+#   define SM_ENSURE(...) do { if (!(__VA_ARGS__)) __builtin_unreachable(); } while (0)
+#   define SM_UNREACHABLE() __builtin_unreachable()
+#   define SM_DEBUGBREAK() __builtin_trap()
 #else
 #   error "Unsupported compiler"
 #endif
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "engine/core/macros.h"
+#include "engine/core/panic.h"
+#include "engine/core/arena.h"
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace simcoe::core {
+    template<typename TSig, size_t TSize = 48>
+    struct UniqueFunction;
+
+    /**
+     * @brief a move only std::function replacement with inline storage
+     * callables that fit in @a TSize bytes and can be moved without throwing
+     * are stored inline, anything larger falls back to the heap,
+     * or to an arena when one is given
+     */
+    template<typename R, typename... A, size_t TSize>
+    struct UniqueFunction<R(A...), TSize> {
+        SM_NOCOPY(UniqueFunction)
+
+        static constexpr size_t kInlineSize = TSize;
+        static constexpr size_t kInlineAlign = alignof(std::max_align_t);
+
+        template<typename F>
+        static constexpr bool kStoredInline = sizeof(F) <= kInlineSize
+                                           && alignof(F) <= kInlineAlign
+                                           && std::is_nothrow_move_constructible_v<F>;
+
+        constexpr UniqueFunction() noexcept = default;
+        constexpr UniqueFunction(std::nullptr_t) noexcept { }
+
+        template<typename F>
+            requires (!std::is_same_v<std::decay_t<F>, UniqueFunction>)
+                  && std::is_invocable_r_v<R, std::decay_t<F>&, A...>
+        UniqueFunction(F&& fn) {
+            using Fn = std::decay_t<F>;
+
+            if constexpr (kStoredInline<Fn>) {
+                new (storage) Fn(std::forward<F>(fn));
+            } else {
+                new (storage) Fn*(new Fn(std::forward<F>(fn)));
+            }
+
+            pVTable = &kVTable<Fn>;
+        }
+
+        // anything too big to store inline goes in @p arena, which must outlive this function.
+        // the callable is still destroyed with the function, the arena only provides the memory
+        template<typename F>
+            requires (!std::is_same_v<std::decay_t<F>, UniqueFunction>)
+                  && std::is_invocable_r_v<R, std::decay_t<F>&, A...>
+        UniqueFunction(Arena& arena, F&& fn) {
+            using Fn = std::decay_t<F>;
+
+            if constexpr (kStoredInline<Fn>) {
+                new (storage) Fn(std::forward<F>(fn));
+                pVTable = &kVTable<Fn>;
+            } else {
+                void *pMemory = arena.allocate(sizeof(Fn), alignof(Fn));
+                new (storage) Fn*(new (pMemory) Fn(std::forward<F>(fn)));
+                pVTable = &kVTable<Fn, true>;
+            }
+        }
+
+        UniqueFunction(UniqueFunction&& other) noexcept {
+            moveFrom(other);
+        }
+
+        UniqueFunction& operator=(UniqueFunction&& other) noexcept {
+            if (this != &other) {
+                reset();
+                moveFrom(other);
+            }
+
+            return *this;
+        }
+
+        UniqueFunction& operator=(std::nullptr_t) noexcept {
+            reset();
+            return *this;
+        }
+
+        ~UniqueFunction() {
+            reset();
+        }
+
+        R operator()(A... args) {
+            SM_ASSERTF(pVTable != nullptr, "calling an empty UniqueFunction");
+            return pVTable->pfnInvoke(storage, std::forward<A>(args)...);
+        }
+
+        explicit operator bool() const noexcept { return pVTable != nullptr; }
+
+        // does this function need to touch the heap
+        bool isInline() const noexcept { return pVTable == nullptr || pVTable->bInline; }
+
+        // is the callable stored in an arena
+        bool isArena() const noexcept { return pVTable != nullptr && pVTable->bArena; }
+
+        void reset() noexcept {
+            if (pVTable != nullptr) {
+                pVTable->pfnDestroy(storage);
+                pVTable = nullptr;
+            }
+        }
+
+    private:
+        struct VTable {
+            R (*pfnInvoke)(void *pStorage, A&&... args);
+            void (*pfnMove)(void *pDst, void *pSrc) noexcept;
+            void (*pfnDestroy)(void *pStorage) noexcept;
+            bool bInline;
+            bool bArena;
+        };
+
+        template<typename Fn>
+        static Fn *getFunction(void *pStorage) noexcept {
+            if constexpr (kStoredInline<Fn>) {
+                return std::launder(static_cast<Fn*>(pStorage));
+            } else {
+                return *std::launder(static_cast<Fn**>(pStorage));
+            }
+        }
+
+        // @a TArena functions are never stored inline, their memory belongs to an arena
+        template<typename Fn, bool TArena = false>
+        static constexpr VTable kVTable = {
+            .pfnInvoke = [](void *pStorage, A&&... args) -> R {
+                return std::invoke(*getFunction<Fn>(pStorage), std::forward<A>(args)...);
+            },
+            .pfnMove = [](void *pDst, void *pSrc) noexcept {
+                if constexpr (kStoredInline<Fn>) {
+                    Fn *pFn = getFunction<Fn>(pSrc);
+                    new (pDst) Fn(std::move(*pFn));
+                    pFn->~Fn();
+                } else {
+                    // heap storage only needs the pointer moved
+                    new (pDst) Fn*(getFunction<Fn>(pSrc));
+                }
+            },
+            .pfnDestroy = [](void *pStorage) noexcept {
+                if constexpr (kStoredInline<Fn> || TArena) {
+                    getFunction<Fn>(pStorage)->~Fn();
+                } else {
+                    delete getFunction<Fn>(pStorage);
+                }
+            },
+            .bInline = kStoredInline<Fn> || TArena,
+            .bArena = TArena
+        };
+
+        void moveFrom(UniqueFunction& other) noexcept {
+            if (other.pVTable != nullptr) {
+                other.pVTable->pfnMove(storage, other.storage);
+                pVTable = std::exchange(other.pVTable, nullptr);
+            }
+        }
+
+        const VTable *pVTable = nullptr;
+        alignas(kInlineAlign) std::byte storage[kInlineSize];
+    };
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <span>
+#include <utility>
 
 namespace simcoe::core {
     template<typename T>
@@ -59,8 +60,8 @@ namespace simcoe::core {
 
         constexpr auto operator*() const {
             struct {
-                decltype(*left) left;
-                decltype(*right) right;
+                decltype(*std::declval<const TL&>()) left;
+                decltype(*std::declval<const TR&>()) right;
             } it = { *left, *right };
             return it;
         }
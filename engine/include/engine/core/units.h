@@ -1,6 +1,5 @@
 #pragma once
 
-#include "engine/core/win32.h"
 #include "engine/core/macros.h"
 
 #include <string_view>
@@ -6,16 +6,19 @@
 
 #include "engine/config/service.h"
 
-#include "engine/core/win32.h"
-
 #include "engine/threads/thread.h"
 
+#if SM_OS_WINDOWS
+#   include "engine/core/win32.h"
+#endif
+
 #include <array>
 
 namespace simcoe {
     namespace debug {
         void setThreadName(std::string_view name);
 
+#if SM_OS_WINDOWS
         std::string getResultName(HRESULT hr);
         std::string getErrorName(DWORD err = GetLastError());
 
@@ -25,6 +28,7 @@ namespace simcoe {
         void throwSystemError(DWORD err, std::string_view fmt, A&&... args) {
             throwLastError(fmt::vformat(fmt, fmt::make_format_args(args...)), err);
         }
+#endif
 
         bool isAttached();
     }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "engine/service/service.h"
+#include "engine/service/platform.h"
 #include "engine/threads/service.h"
 
 #include "engine/depot/vfs.h"
@@ -3,7 +3,7 @@
 #include "engine/core/mt.h"
 
 #include "engine/service/service.h"
-#include "engine/service/platform.h"
+#include "engine/config/service.h"
 
 #include "engine/log/log.h"
 
@@ -12,13 +12,21 @@
 
 #include <array>
 
+#if SM_OS_WINDOWS
+#   include "engine/service/platform.h"
+#endif
+
 namespace simcoe {
     struct LoggingService final : IStaticService<LoggingService> {
         LoggingService();
 
         // IStaticService
         static constexpr std::string_view kServiceName = "logging";
+#if SM_OS_WINDOWS
         static inline auto kServiceDeps = depends(ConfigService::service(), PlatformService::service(), ThreadService::service());
+#else
+        static inline auto kServiceDeps = depends(ConfigService::service(), ThreadService::service());
+#endif
 
         // IService
         bool createService() override;
@@ -69,6 +77,9 @@ namespace simcoe {
         static bool shouldSend(log::Level level);
         static void addSink(log::ISink *pSink);
 
+        // how the queue between logging threads and the logger thread is holding up
+        static mt::ChannelStats getQueueStats();
+
     private:
         static void sendMessageAlways(log::Level msgLevel, std::string msg);
         static void throwAssert(std::string msg);
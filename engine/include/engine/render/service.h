@@ -20,7 +20,7 @@ namespace simcoe {
         static void start();
         static void shutdown();
 
-        static void enqueueWork(std::string name, threads::WorkItem&& work);
+        static void enqueueWork(threads::WorkName name, threads::WorkItem&& work);
 
         static void draw();
 
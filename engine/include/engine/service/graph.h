@@ -0,0 +1,82 @@
+#pragma once
+
+#include "engine/service/service.h"
+
+#include "engine/threads/messages.h"
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <unordered_map>
+#include <vector>
+
+namespace simcoe {
+    /**
+     * @brief dependency graph of services built from their kServiceDeps
+     * services are launched as soon as everything they depend on is ready,
+     * and torn down as soon as everything that depends on them is gone.
+     * nothing in the graph ever blocks a worker waiting on another service.
+     */
+    struct ServiceGraph {
+        SM_NOCOPY(ServiceGraph)
+
+        using TimePoint = std::chrono::steady_clock::time_point;
+
+        struct Node {
+            IService *pService;
+
+            std::vector<size_t> deps; // nodes we depend on
+            std::vector<size_t> dependents; // nodes that depend on us
+
+            std::atomic_size_t pending = 0; // deps still loading, or dependents still alive during teardown
+            bool bExternal = false; // started and stopped outside of the graph
+
+            TimePoint start = {};
+            TimePoint end = {};
+        };
+
+        struct TimingInfo {
+            IService *pService;
+            std::chrono::microseconds time;
+        };
+
+        ServiceGraph(ServiceSpan services);
+
+        // mark a service that will be created and destroyed by the caller
+        void setExternal(IService *pService, TimePoint start, TimePoint end);
+
+        // create every service, returns once all of them have loaded or faulted
+        void create();
+
+        // destroy every service in reverse dependency order
+        void destroy();
+
+        // the longest chain of dependent services during startup
+        std::vector<TimingInfo> getCriticalPath() const;
+
+    private:
+        size_t addNode(IService *pService);
+        size_t getNode(IService *pService) const;
+
+        void launchCreate(size_t index);
+        void launchDestroy(size_t index);
+
+        // run a node, then launch everything it unblocked
+        void runCreate(size_t index);
+        void runDestroy(size_t index);
+
+        void finishNode();
+        void waitForNodes();
+
+        std::vector<std::unique_ptr<Node>> nodes;
+        std::unordered_map<IService*, size_t> indices;
+
+        // services that asked to be loaded on the main thread
+        mt::BlockingMessageQueue<size_t> mainQueue{64};
+
+        bool bTeardown = false;
+        std::atomic_size_t remaining = 0;
+        std::exception_ptr pFatalError = nullptr;
+        mt::Mutex errorLock{"services.error"};
+    };
+}
@@ -105,7 +105,7 @@ namespace simcoe {
         // PlatformService
         static void setup(HINSTANCE hInstance, int nCmdShow, IWindowCallbacks *pCallbacks);
 
-        static void enqueue(std::string name, threads::WorkItem&& task);
+        static void enqueue(threads::WorkName name, threads::WorkItem&& task);
 
         // win32 event loop
         static void quit(int code = 0);
@@ -2,10 +2,12 @@
 
 #include "engine/core/macros.h"
 #include "engine/core/panic.h"
+#include "engine/core/unique.h"
 
 #include "engine/threads/mutex.h"
 
 #include <array>
+#include <condition_variable>
 #include <span>
 #include <string_view>
 
@@ -118,11 +120,14 @@ namespace simcoe {
         std::string failure;
     };
 
+    struct ServiceGraph;
+
     struct ServiceRuntime {
         ServiceRuntime(std::span<IService*> services);
         ~ServiceRuntime();
 
     private:
         std::span<IService*> services;
+        core::UniquePtr<ServiceGraph> pGraph;
     };
 }
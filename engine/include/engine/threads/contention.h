@@ -0,0 +1,75 @@
+#pragma once
+
+#include "engine/core/filesystem.h"
+
+#include "engine/threads/thread.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace simcoe::mt {
+    // bucket 0 holds everything under 256ns, each bucket after that doubles,
+    // the last bucket holds everything over ~16ms
+    constexpr size_t kLockBuckets = 18;
+
+    using LockHistogram = std::array<size_t, kLockBuckets>;
+
+    struct LockWaiter {
+        threads::ThreadId id = 0;
+        size_t contended = 0; ///< times this thread had to wait for the lock
+        uint64_t wait = 0; ///< total time this thread spent waiting (in ns)
+    };
+
+    /**
+     * @brief a snapshot of every lock sharing a name
+     * locks are keyed by name, so per service locks like "{}.cv" are tracked separately
+     * but short lived locks like "parallel.reduce" are summed together.
+     * hold times are only tracked for exclusive acquires, any number of readers can hold a shared lock.
+     */
+    struct LockStats {
+        std::string name;
+
+        size_t acquires = 0; ///< exclusive acquires
+        size_t shared = 0; ///< shared acquires
+        size_t contended = 0; ///< acquires of either kind that had to wait
+
+        uint64_t totalWait = 0; ///< ns spent waiting for the lock
+        uint64_t maxWait = 0;
+        uint64_t totalHold = 0; ///< ns the lock was held exclusively
+        uint64_t maxHold = 0;
+
+        LockHistogram waitHistogram = {};
+        LockHistogram holdHistogram = {};
+
+        std::vector<LockWaiter> waiters = {}; ///< threads that waited the longest, longest first
+    };
+
+    namespace detail {
+        struct LockCounters;
+
+        // find or create the counters for locks named @param name, never freed
+        LockCounters *getLockCounters(std::string_view name);
+
+        // monotonic time in ns
+        uint64_t getLockTime();
+
+        void addAcquire(LockCounters *pCounters, bool bShared);
+        void addContended(LockCounters *pCounters, bool bShared, uint64_t wait);
+        void addHold(LockCounters *pCounters, uint64_t hold);
+    }
+
+    // true if the engine was built with lock profiling, otherwise every other function returns nothing
+    constexpr bool isLockProfilingEnabled() { return SM_PROFILE_LOCKS; }
+
+    // upper bound of histogram bucket @param index in ns, UINT64_MAX for the last bucket
+    uint64_t getLockBucketLimit(size_t index);
+
+    // snapshot every named lock, sorted by total wait time
+    std::vector<LockStats> getLockStats(size_t maxWaiters = 4);
+
+    void resetLockStats();
+
+    // write every lock with any acquires to @param path
+    bool dumpLockStats(const fs::path& path);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "engine/core/function.h"
+#include "engine/core/macros.h"
+
+#include "engine/threads/mutex.h"
+
+#include <atomic>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace simcoe::mt {
+    struct EpochStats {
+        uint64_t epoch = 0; ///< the current global epoch
+        size_t readers = 0; ///< readers pinned when the stats were taken
+        size_t pending = 0; ///< retired objects still waiting on readers
+        size_t reclaimed = 0; ///< retired objects freed since the epoch was created
+    };
+
+    /**
+     * @brief epoch based reclamation for data that is read far more than it is written
+     * readers pin the current epoch for as long as they hold pointers into shared data,
+     * writers unlink things and retire them rather than freeing them.
+     * a retired object is only freed once the epoch has moved on twice, and the epoch
+     * can only move on once every pinned reader has seen the current one,
+     * so nothing a reader could still be looking at is ever freed.
+     *
+     * readers never block and never touch the retire lock, pinning is a single
+     * compare exchange on a slot that the same thread will usually get again next time.
+     */
+    struct Epoch {
+        SM_NOCOPY(Epoch)
+        SM_NOMOVE(Epoch)
+
+        using Deleter = core::UniqueFunction<void()>;
+
+        static constexpr size_t kDefaultReaders = 64;
+
+        Epoch(std::string_view name, size_t maxReaders = kDefaultReaders);
+
+        // frees everything still retired, there must be no pinned readers left
+        ~Epoch();
+
+        // @return the slot that has to be passed back to exit
+        size_t enter();
+        void exit(size_t slot);
+
+        /**
+         * @brief free something once no reader can be holding it
+         * the object must already be unreachable for new readers
+         *
+         * @param deleter called to free the object, on whichever thread reclaims it
+         */
+        void retire(Deleter&& deleter);
+
+        template<typename T>
+        void retire(T *pObject) {
+            retire([pObject] { delete pObject; });
+        }
+
+        /**
+         * @brief try to move the epoch on and free whatever that makes safe
+         * @return the number of objects freed
+         */
+        size_t collect();
+
+        // wait for every current reader to leave, then free everything retired so far
+        void synchronize();
+
+        EpochStats getStats() const;
+
+    private:
+        struct alignas(64) Slot {
+            std::atomic_uint64_t epoch = 0; ///< the epoch the reader pinned, 0 when the slot is free
+        };
+
+        struct Retired {
+            uint64_t epoch;
+            Deleter deleter;
+        };
+
+        bool tryAdvance();
+
+        std::atomic_uint64_t current = 1;
+        std::atomic_size_t reclaimed = 0;
+
+        size_t maxReaders;
+        std::unique_ptr<Slot[]> pSlots;
+
+        mutable Mutex lock;
+        std::vector<Retired> retired;
+    };
+
+    // pins an epoch for the lifetime of the guard
+    struct EpochGuard {
+        SM_NOCOPY(EpochGuard)
+        SM_NOMOVE(EpochGuard)
+
+        EpochGuard(Epoch& epoch)
+            : epoch(epoch)
+            , slot(epoch.enter())
+        { }
+
+        ~EpochGuard() {
+            epoch.exit(slot);
+        }
+
+    private:
+        Epoch& epoch;
+        size_t slot;
+    };
+}
@@ -1,7 +1,5 @@
 #pragma once
 
-#include "engine/debug/service.h"
-
 #include "engine/threads/service.h"
 
 namespace simcoe::threads {
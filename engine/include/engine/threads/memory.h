@@ -0,0 +1,96 @@
+#pragma once
+
+#include "engine/core/macros.h"
+
+#include "engine/threads/thread.h"
+
+#include <atomic>
+#include <memory_resource>
+#include <vector>
+
+namespace simcoe::threads {
+    struct NodeMemoryStats {
+        uint32_t id = 0; ///< the os node number
+        bool bBound = true; ///< false if the os refused to place any of our pages on this node
+
+        size_t reserved = 0; ///< bytes of pages currently held from the os
+        size_t allocs = 0; ///< page runs requested from the os
+        size_t frees = 0; ///< page runs handed back to the os
+    };
+
+    /**
+     * @brief hands out whole pages placed on a single numa node
+     * every allocation goes to the os, so this is meant to sit under a pool rather than be used directly.
+     * if the os cant place pages on the node we still hand out memory, it just lands wherever the os wants.
+     */
+    struct NodePageResource final : std::pmr::memory_resource {
+        SM_NOCOPY(NodePageResource)
+
+        NodePageResource(uint32_t node);
+
+        uint32_t getNode() const { return node; }
+        NodeMemoryStats getStats() const;
+
+    private:
+        void *do_allocate(size_t bytes, size_t align) override;
+        void do_deallocate(void *pMemory, size_t bytes, size_t align) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+        uint32_t node;
+
+        std::atomic_bool bBound = true;
+        std::atomic_size_t reserved = 0;
+        std::atomic_size_t allocs = 0;
+        std::atomic_size_t frees = 0;
+    };
+
+    // build a heap for every node in @param geometry, called once by the thread service
+    void setupMemory(const Geometry& geometry);
+
+    // the node a subcore belongs to, eInvalid before setupMemory or for unknown subcores
+    NodeIndex getSubcoreNode(SubcoreIndex subcore);
+
+    /**
+     * heaps local to part of the cpu. a package or chiplet shares its memory controller
+     * with the rest of its node, so they all resolve to the heap of the node they sit in.
+     * each heap is thread safe and lives for the rest of the program.
+     * before setupMemory, or for an unknown index, these return the default heap.
+     */
+    std::pmr::memory_resource *getNodeMemory(NodeIndex node);
+    std::pmr::memory_resource *getPackageMemory(PackageIndex package);
+    std::pmr::memory_resource *getChipletMemory(ChipletIndex chiplet);
+
+    /**
+     * @brief mark the calling thread as running on @param node
+     * memory from getLocalMemory comes from that node afterwards.
+     * on linux the threads memory policy is also set to prefer the node,
+     * so ordinary heap allocations it first touches end up there too.
+     */
+    void setCurrentNode(NodeIndex node);
+    NodeIndex getCurrentNode();
+
+    // the heap local to the calling thread, the default heap for threads without a node
+    std::pmr::memory_resource *getLocalMemory();
+
+    /**
+     * @brief fault in every page of a buffer from the calling thread
+     * the os places a page on the node of whichever thread touches it first,
+     * so a buffer that will be used by one thread should be touched by that thread.
+     * the contents are not preserved.
+     */
+    void firstTouch(void *pMemory, size_t size);
+
+    std::vector<NodeMemoryStats> getNodeMemoryStats();
+
+    namespace detail {
+        // platform specific
+        size_t getPageSize();
+
+        // @param bBound set to false if the pages could not be placed on @param node
+        void *allocateNodePages(size_t size, uint32_t node, bool& bBound);
+        void freeNodePages(void *pMemory, size_t size);
+
+        // @return false if the platform doesnt support per thread memory policies
+        bool setThreadMemoryNode(uint32_t node);
+    }
+}
@@ -1,8 +1,21 @@
 #pragma once
 
 #include "engine/core/macros.h"
+#include "engine/core/panic.h"
+
+#include "engine/threads/mutex.h"
 
 #include "vendor/moodycamel/concurrent.h"
+#include "vendor/moodycamel/blocking.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <new>
+#include <thread>
 
 namespace simcoe::mt {
     template<typename T, template<typename...> typename TQueue> 
@@ -68,3 +81,393 @@ namespace simcoe::mt {
         }
     };
 }
+
+namespace simcoe::mt {
+    constexpr size_t kCacheLineSize = 64;
+    constexpr size_t kChannelSpin = 16;
+
+    // what a channel does when a producer finds it full
+    enum BackPressure {
+        eDropOldest, ///< discard the oldest queued item to make room
+        eBlock, ///< wait for the consumer to make room
+        eFail, ///< reject the new item
+
+        eBackPressureCount
+    };
+
+    struct ChannelStats {
+        size_t capacity = 0;
+        size_t depth = 0; ///< items queued when the stats were taken
+
+        size_t pushed = 0; ///< items accepted by the channel
+        size_t popped = 0; ///< items handed to the consumer
+        size_t dropped = 0; ///< queued items discarded to make room
+        size_t failed = 0; ///< new items rejected because the channel was full
+        size_t blocked = 0; ///< times a producer had to wait for room
+        size_t waits = 0; ///< times the consumer had to wait for an item
+    };
+
+    /**
+     * @brief bounded ring buffer for a fixed producer/consumer pair
+     * each cell carries a sequence number so producers and the consumer never share a lock,
+     * they only meet on the cells themselves. the producer and consumer ends live on separate
+     * cache lines so they dont bounce each other around.
+     * nobody takes the wait lock unless one side actually has to sleep.
+     *
+     * @tparam T the message type, must be default constructible and movable
+     * @tparam bMultiProducer whether producers need to race for a slot
+     */
+    template<typename T, bool bMultiProducer>
+    struct BaseChannel {
+        SM_NOCOPY(BaseChannel)
+        SM_NOMOVE(BaseChannel)
+
+        BaseChannel(std::string_view name, size_t size, BackPressure policy = eBlock)
+            : capacity(std::bit_ceil(std::max<size_t>(size, 2)))
+            , policy(policy)
+            , pCells(new Cell[capacity])
+            , lock(name)
+        {
+            SM_ASSERTF(policy < eBackPressureCount, "invalid back pressure policy {}", int(policy));
+
+            for (size_t i = 0; i < capacity; i++) {
+                pCells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ~BaseChannel() {
+            T item;
+            while (popOne(item)) { }
+        }
+
+        /**
+         * @brief add an item without waiting
+         * a full channel drops its oldest item under eDropOldest and rejects the new one otherwise
+         *
+         * @param item the item to add
+         * @return true if the item was queued
+         */
+        bool tryPush(T&& item) {
+            return tryPushBatch(&item, 1) == 1;
+        }
+
+        /**
+         * @brief add an item, applying the channels back pressure policy
+         *
+         * @param item the item to add
+         * @return true if the item was queued, only false under eFail
+         */
+        bool push(T&& item) {
+            return pushBatch(&item, 1) == 1;
+        }
+
+        /**
+         * @brief move a run of items into the channel without waiting
+         * @return the number of items queued, always a prefix of the input
+         */
+        size_t tryPushBatch(T *pItems, size_t count) {
+            size_t pushed = 0;
+            while (pushed < count && pushOne(pItems[pushed], policy == eDropOldest)) {
+                pushed += 1;
+            }
+
+            if (pushed > 0) {
+                producer.pushed.fetch_add(pushed, std::memory_order_relaxed);
+                wakeConsumer();
+            }
+
+            producer.failed.fetch_add(count - pushed, std::memory_order_relaxed);
+            return pushed;
+        }
+
+        /**
+         * @brief move a run of items into the channel, applying the back pressure policy
+         * the consumer is woken at most once per batch rather than once per item
+         * @return the number of items queued, always a prefix of the input
+         */
+        size_t pushBatch(T *pItems, size_t count) {
+            if (policy != eBlock) {
+                return tryPushBatch(pItems, count);
+            }
+
+            size_t pushed = 0;
+            while (pushed < count) {
+                while (pushed < count && pushOne(pItems[pushed], false)) {
+                    pushed += 1;
+                }
+
+                if (pushed > 0) {
+                    wakeConsumer();
+                }
+
+                if (pushed < count) {
+                    producer.blocked.fetch_add(1, std::memory_order_relaxed);
+                    waitFor(notFull, producer.waiting, [&] { return !isFull(); });
+                }
+            }
+
+            producer.pushed.fetch_add(count, std::memory_order_relaxed);
+            return count;
+        }
+
+        // take the oldest item if there is one
+        bool tryPop(T& dst) {
+            if (!popOne(dst)) return false;
+
+            consumer.popped.fetch_add(1, std::memory_order_relaxed);
+            wakeProducers();
+            return true;
+        }
+
+        // wait up to timeout for an item
+        template<typename Rep, typename Period>
+        bool pop(T& dst, std::chrono::duration<Rep, Period> timeout) {
+            return popBatch(&dst, 1, timeout) == 1;
+        }
+
+        // take up to count items without waiting
+        size_t popBatch(T *pItems, size_t count) {
+            size_t popped = 0;
+            while (popped < count && popOne(pItems[popped])) {
+                popped += 1;
+            }
+
+            if (popped > 0) {
+                consumer.popped.fetch_add(popped, std::memory_order_relaxed);
+                wakeProducers();
+            }
+
+            return popped;
+        }
+
+        // wait up to timeout for at least one item, then take up to count items
+        template<typename Rep, typename Period>
+        size_t popBatch(T *pItems, size_t count, std::chrono::duration<Rep, Period> timeout) {
+            if (size_t popped = popBatch(pItems, count); popped > 0) {
+                return popped;
+            }
+
+            consumer.waits.fetch_add(1, std::memory_order_relaxed);
+            if (!waitFor(notEmpty, consumer.waiting, [&] { return !isEmpty(); }, timeout)) {
+                return 0;
+            }
+
+            return popBatch(pItems, count);
+        }
+
+        size_t getCapacity() const { return capacity; }
+        BackPressure getPolicy() const { return policy; }
+
+        // only a hint while producers or the consumer are running
+        size_t getDepthApprox() const {
+            size_t tail = producer.position.load(std::memory_order_relaxed);
+            size_t head = consumer.position.load(std::memory_order_relaxed);
+            return (tail > head) ? tail - head : 0;
+        }
+
+        ChannelStats getStats() const {
+            return {
+                .capacity = capacity,
+                .depth = getDepthApprox(),
+                .pushed = producer.pushed.load(std::memory_order_relaxed),
+                .popped = consumer.popped.load(std::memory_order_relaxed),
+                .dropped = producer.dropped.load(std::memory_order_relaxed),
+                .failed = producer.failed.load(std::memory_order_relaxed),
+                .blocked = producer.blocked.load(std::memory_order_relaxed),
+                .waits = consumer.waits.load(std::memory_order_relaxed)
+            };
+        }
+
+    private:
+        struct Cell {
+            std::atomic_size_t sequence;
+            alignas(T) std::byte storage[sizeof(T)];
+
+            T *get() { return std::launder(reinterpret_cast<T*>(storage)); }
+        };
+
+        struct alignas(kCacheLineSize) ProducerEnd {
+            std::atomic_size_t position = 0;
+            std::atomic_size_t waiting = 0;
+
+            std::atomic_size_t pushed = 0;
+            std::atomic_size_t dropped = 0;
+            std::atomic_size_t failed = 0;
+            std::atomic_size_t blocked = 0;
+        };
+
+        struct alignas(kCacheLineSize) ConsumerEnd {
+            std::atomic_size_t position = 0;
+            std::atomic_size_t waiting = 0;
+
+            std::atomic_size_t popped = 0;
+            std::atomic_size_t waits = 0;
+        };
+
+        bool isEmpty() const {
+            size_t head = consumer.position.load(std::memory_order_acquire);
+            return pCells[head & (capacity - 1)].sequence.load(std::memory_order_acquire) != head + 1;
+        }
+
+        bool isFull() const {
+            size_t tail = producer.position.load(std::memory_order_acquire);
+            return pCells[tail & (capacity - 1)].sequence.load(std::memory_order_acquire) != tail;
+        }
+
+        bool pushOne(T& item, bool bDropOldest) {
+            size_t pos = producer.position.load(std::memory_order_relaxed);
+            Cell *pCell = nullptr;
+
+            while (true) {
+                pCell = &pCells[pos & (capacity - 1)];
+                size_t sequence = pCell->sequence.load(std::memory_order_acquire);
+                auto diff = intptr_t(sequence) - intptr_t(pos);
+
+                if (diff == 0) {
+                    if constexpr (bMultiProducer) {
+                        if (producer.position.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                    } else {
+                        producer.position.store(pos + 1, std::memory_order_relaxed);
+                        break;
+                    }
+                } else if (diff < 0) {
+                    if (!bDropOldest) return false;
+
+                    // full, make room by acting as the consumer for one item.
+                    // the pop can miss if another producer is still writing the head, so just go around again
+                    T oldest;
+                    if (popOne(oldest)) {
+                        producer.dropped.fetch_add(1, std::memory_order_relaxed);
+                    }
+
+                    pos = producer.position.load(std::memory_order_relaxed);
+                } else {
+                    pos = producer.position.load(std::memory_order_relaxed);
+                }
+            }
+
+            new (pCell->storage) T(std::move(item));
+            pCell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool popOne(T& dst) {
+            size_t pos = consumer.position.load(std::memory_order_relaxed);
+            Cell *pCell = nullptr;
+
+            while (true) {
+                pCell = &pCells[pos & (capacity - 1)];
+                size_t sequence = pCell->sequence.load(std::memory_order_acquire);
+                auto diff = intptr_t(sequence) - intptr_t(pos + 1);
+
+                if (diff == 0) {
+                    // producers only pop when dropping the oldest item, otherwise the consumer owns the head
+                    if (policy == eDropOldest) {
+                        if (consumer.position.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                    } else {
+                        consumer.position.store(pos + 1, std::memory_order_relaxed);
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = consumer.position.load(std::memory_order_relaxed);
+                }
+            }
+
+            T *pItem = pCell->get();
+            dst = std::move(*pItem);
+            pItem->~T();
+
+            pCell->sequence.store(pos + capacity, std::memory_order_release);
+            return true;
+        }
+
+        // pairs with the fence in waitFor so either the sleeper sees the new state or we see the sleeper
+        void wakeConsumer() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (consumer.waiting.load(std::memory_order_relaxed) == 0) return;
+
+            std::lock_guard guard(lock);
+            notEmpty.notify_one();
+        }
+
+        void wakeProducers() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (producer.waiting.load(std::memory_order_relaxed) == 0) return;
+
+            std::lock_guard guard(lock);
+            notFull.notify_all();
+        }
+
+        // yielding a few times first lets the other side fill or empty a batch
+        // before we pay for a sleep and a wake
+        template<typename F>
+        bool spinFor(F&& ready) {
+            for (size_t i = 0; i < kChannelSpin; i++) {
+                if (ready()) return true;
+                std::this_thread::yield();
+            }
+
+            return false;
+        }
+
+        template<typename F>
+        void waitFor(std::condition_variable_any& signal, std::atomic_size_t& waiting, F&& ready) {
+            if (spinFor(ready)) return;
+
+            waiting.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            {
+                std::unique_lock guard(lock);
+                signal.wait(guard, ready);
+            }
+
+            waiting.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        template<typename F, typename Rep, typename Period>
+        bool waitFor(std::condition_variable_any& signal, std::atomic_size_t& waiting, F&& ready, std::chrono::duration<Rep, Period> timeout) {
+            if (spinFor(ready)) return true;
+
+            waiting.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            bool bReady = false;
+            {
+                std::unique_lock guard(lock);
+                bReady = signal.wait_for(guard, timeout, ready);
+            }
+
+            waiting.fetch_sub(1, std::memory_order_relaxed);
+            return bReady;
+        }
+
+        size_t capacity;
+        BackPressure policy;
+        std::unique_ptr<Cell[]> pCells;
+
+        ProducerEnd producer;
+        ConsumerEnd consumer;
+
+        // only used when one side has to sleep
+        Mutex lock;
+        std::condition_variable_any notEmpty;
+        std::condition_variable_any notFull;
+    };
+
+    // one producer thread to one consumer thread
+    template<typename T>
+    struct SpscChannel : BaseChannel<T, false> {
+        using Super = BaseChannel<T, false>;
+        using Super::Super;
+    };
+
+    // any number of producer threads to one consumer thread
+    template<typename T>
+    struct MpscChannel : BaseChannel<T, true> {
+        using Super = BaseChannel<T, true>;
+        using Super::Super;
+    };
+}
@@ -5,6 +5,7 @@
 #include "engine/profile/profile.h"
 
 #include "engine/threads/thread.h"
+#include "engine/threads/contention.h"
 
 #include <string>
 
@@ -29,6 +30,25 @@ namespace simcoe::mt {
         void verifyOwner();
         void resetOwner();
 
+        // lock @param mutex, recording the acquire and any time spent waiting when lock profiling is enabled
+        template<typename T> void acquire(T& mutex);
+        template<typename T> void acquireShared(T& mutex);
+
+        // record a successful try_lock
+        void acquired() {
+#if SM_PROFILE_LOCKS
+            detail::addAcquire(pCounters, false);
+            lockedAt = detail::getLockTime();
+#endif
+        }
+
+        // record how long the lock was held, must be called before unlocking
+        void released() {
+#if SM_PROFILE_LOCKS
+            detail::addHold(pCounters, detail::getLockTime() - lockedAt);
+#endif
+        }
+
 #if SM_DEBUG_THREADS
         std::string_view getName() const { return name; }
         threads::ThreadId getOwner() const { return owner; }
@@ -39,6 +59,11 @@ namespace simcoe::mt {
         std::string name; /// the name of the mutex
         threads::ThreadId owner; /// the thread that currently owns the mutex
 #endif
+
+#if SM_PROFILE_LOCKS
+        detail::LockCounters *pCounters; /// shared with every other lock of the same name
+        uint64_t lockedAt = 0; /// when the current exclusive owner took the lock
+#endif
     };
 
     struct Mutex : public BaseMutex {
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "engine/core/macros.h"
+
+#include "engine/threads/mutex.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <ranges>
+
+namespace simcoe::threads {
+    struct ParallelStats {
+        size_t calls = 0; ///< parallel algorithm invocations
+        size_t serial = 0; ///< invocations small enough to run inline on the caller
+        size_t chunks = 0; ///< chunks executed in total
+        size_t helped = 0; ///< chunks executed by workers rather than the caller
+    };
+
+    namespace detail {
+        using ChunkFn = void(*)(void *pUser, size_t begin, size_t end);
+
+        // splits [first, last) into chunks and runs them on the caller and the worker pool,
+        // returns once every chunk has finished
+        void runParallel(size_t first, size_t last, size_t grain, ChunkFn pfnChunk, void *pUser);
+    }
+
+    // how many threads a parallel algorithm will spread across, including the caller.
+    // capped to the number of physical cores, smt siblings dont help much with the loops we run
+    size_t getParallelism();
+
+    ParallelStats getParallelStats();
+
+    /**
+     * @brief run @param fn over [first, last) in chunks across the worker pool
+     * the calling thread works on chunks too rather than blocking.
+     * chunks start large and shrink as the range runs out so stragglers are rare.
+     *
+     * @param fn called as fn(begin, end) for each chunk
+     * @param grain the smallest chunk worth handing to another thread, 0 picks one from the range size
+     */
+    template<typename F>
+    void parallelForChunks(size_t first, size_t last, F&& fn, size_t grain = 0) {
+        auto thunk = [](void *pUser, size_t begin, size_t end) {
+            (*static_cast<std::remove_reference_t<F>*>(pUser))(begin, end);
+        };
+
+        detail::runParallel(first, last, grain, thunk, &fn);
+    }
+
+    // run @param fn(i) for every i in [first, last) across the worker pool
+    template<typename F>
+    void parallelFor(size_t first, size_t last, F&& fn, size_t grain = 0) {
+        parallelForChunks(first, last, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                fn(i);
+            }
+        }, grain);
+    }
+
+    // run @param fn(item) for every element of @param range across the worker pool
+    template<std::ranges::random_access_range R, typename F>
+    void parallelEach(R&& range, F&& fn, size_t grain = 0) {
+        auto it = std::ranges::begin(range);
+        parallelFor(0, size_t(std::ranges::size(range)), [&](size_t i) {
+            fn(it[i]);
+        }, grain);
+    }
+
+    /**
+     * @brief reduce [first, last) across the worker pool
+     * chunk results are combined in whatever order they finish,
+     * so @param reduce must be associative and commutative
+     *
+     * @param fn called as fn(begin, end) and returns the result of a chunk
+     * @param reduce combines two results
+     */
+    template<typename T, typename F, typename R>
+    T parallelReduce(size_t first, size_t last, T identity, F&& fn, R&& reduce, size_t grain = 0) {
+        mt::Mutex lock{"parallel.reduce"};
+        T result = identity;
+
+        parallelForChunks(first, last, [&](size_t begin, size_t end) {
+            T partial = fn(begin, end);
+
+            std::lock_guard guard(lock);
+            result = reduce(std::move(result), std::move(partial));
+        }, grain);
+
+        return result;
+    }
+
+    /**
+     * @brief sort [first, last) across the worker pool
+     * sorts one block per thread then merges neighbouring blocks in parallel rounds
+     */
+    template<std::random_access_iterator It, typename C = std::less<>>
+    void parallelSort(It first, It last, C&& comp = C{}) {
+        // below this its not worth waking anyone up
+        constexpr size_t kMinSortSize = 4096;
+
+        size_t count = size_t(std::distance(first, last));
+        size_t blocks = std::min(getParallelism(), count / kMinSortSize);
+        if (blocks <= 1) {
+            std::sort(first, last, comp);
+            return;
+        }
+
+        auto getBlock = [&](size_t index) {
+            return first + std::ptrdiff_t(std::min(count, (count * index) / blocks));
+        };
+
+        parallelFor(0, blocks, [&](size_t i) {
+            std::sort(getBlock(i), getBlock(i + 1), comp);
+        }, 1);
+
+        // merge pairs of sorted runs until only one is left
+        for (size_t width = 1; width < blocks; width *= 2) {
+            size_t pairs = (blocks + (width * 2) - 1) / (width * 2);
+            parallelFor(0, pairs, [&](size_t i) {
+                size_t lo = i * width * 2;
+                size_t mid = std::min(lo + width, blocks);
+                size_t hi = std::min(lo + width * 2, blocks);
+                if (mid >= hi) return;
+
+                std::inplace_merge(getBlock(lo), getBlock(mid), getBlock(hi), comp);
+            }, 1);
+        }
+    }
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "engine/core/macros.h"
+
+#include "engine/threads/queue.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace simcoe::threads {
+    /**
+     * @brief chase-lev work stealing deque
+     * only the owning worker may push or pop, any thread may steal
+     * based on "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al. 2013)
+     */
+    struct WorkDeque {
+        SM_NOCOPY(WorkDeque)
+        SM_NOMOVE(WorkDeque)
+
+        WorkDeque(size_t capacity = 256);
+        ~WorkDeque();
+
+        // owner only
+        void push(WorkMessage *pMessage);
+        WorkMessage *pop();
+
+        // any thread
+        WorkMessage *steal();
+
+        size_t sizeApprox() const;
+
+    private:
+        struct Buffer {
+            Buffer(size_t capacity);
+
+            WorkMessage *get(int64_t index) const { return pItems[index & mask].load(std::memory_order_relaxed); }
+            void put(int64_t index, WorkMessage *pMessage) { pItems[index & mask].store(pMessage, std::memory_order_relaxed); }
+
+            size_t getCapacity() const { return capacity; }
+
+        private:
+            size_t capacity;
+            int64_t mask;
+            std::unique_ptr<std::atomic<WorkMessage*>[]> pItems;
+        };
+
+        Buffer *grow(Buffer *pOld, int64_t bottom, int64_t top);
+
+        alignas(64) std::atomic_int64_t top = 0;
+        alignas(64) std::atomic_int64_t bottom = 0;
+        alignas(64) std::atomic<Buffer*> pBuffer;
+
+        // old buffers may still be read by thieves, so we keep them around until the deque dies
+        std::vector<std::unique_ptr<Buffer>> buffers;
+    };
+
+    // realtime, responsive and background. worker priority work shares the background lane
+    constexpr size_t kWorkLaneCount = eBackground + 1;
+
+    constexpr size_t getWorkLane(ThreadType type) {
+        return (type < eBackground) ? size_t(type) : size_t(eBackground);
+    }
+
+    struct WorkLaneStats {
+        size_t depth = 0; ///< jobs waiting in the lane, approximate
+        size_t executed = 0; ///< jobs from this lane that have finished
+        size_t promoted = 0; ///< jobs run ahead of higher lanes because this lane was starving
+
+        std::chrono::microseconds totalLatency = {}; ///< summed time jobs spent queued
+        std::chrono::microseconds avgLatency = {}; ///< mean time between a job being queued and starting
+        std::chrono::microseconds p99Latency = {}; ///< upper bound, latencies are bucketed by powers of 2
+        std::chrono::microseconds maxLatency = {};
+    };
+
+    struct WorkPoolStats {
+        size_t executed = 0; ///< total jobs run by workers
+        size_t stolen = 0; ///< jobs taken from another workers deque
+        size_t injected = 0; ///< jobs submitted from outside the pool
+        size_t parked = 0; ///< times a worker ran out of spins and went to sleep
+        size_t sleeping = 0; ///< workers currently parked
+        size_t dequeNodeAllocs = 0; ///< deque nodes that had to come from the heap rather than a cache
+        size_t heapJobs = 0; ///< jobs whose callable was too big to store inline and went on the heap
+
+        std::array<WorkLaneStats, kWorkLaneCount> lanes;
+    };
+
+    /**
+     * @brief a pool of per-worker deques with a shared injection queue per priority lane
+     * workers submitting background work push onto their own deque,
+     * everything else goes into the injection queue for its lane.
+     * workers take from the highest priority lane with work in it,
+     * unless a lower lane has gone @param aging without running anything, then it goes first
+     */
+    struct WorkPool {
+        SM_NOCOPY(WorkPool)
+
+        WorkPool(size_t slots, size_t injectSize, size_t spinCount, WorkClock::duration aging);
+        ~WorkPool();
+
+        void add(WorkName name, WorkItem&& item, ThreadType priority = eBackground);
+
+        // run the worker loop for @param slot until @param token is stopped
+        void runWorker(size_t slot, std::stop_token token);
+
+        size_t getSlotCount() const { return slots; }
+        size_t getPendingApprox() const;
+        WorkPoolStats getStats() const;
+
+    private:
+        // bucket i holds latencies under 2^i us, the last holds everything else
+        static constexpr size_t kLatencyBuckets = 24;
+
+        struct Lane {
+            Lane(size_t size)
+                : queue(size)
+            { }
+
+            moodycamel::ConcurrentQueue<WorkMessage> queue;
+
+            // the last time anything was taken from the lane, or when it stopped being empty
+            std::atomic<WorkClock::rep> lastServed = 0;
+
+            std::atomic_size_t executed = 0;
+            std::atomic_size_t promoted = 0;
+            std::atomic_uint64_t totalLatency = 0; // in us
+            std::atomic_uint64_t maxLatency = 0; // in us
+            std::array<std::atomic_size_t, kLatencyBuckets> latencies = {};
+        };
+
+        // @param lane is set to the lane the work came from
+        bool findWork(size_t slot, WorkMessage& dst, size_t& lane);
+        bool takeFromLane(size_t lane, WorkMessage& dst, WorkClock::rep now);
+        bool isStarving(size_t lane, WorkClock::rep now) const;
+
+        void execute(WorkMessage& message, size_t lane);
+
+        WorkLaneStats getLaneStats(size_t lane) const;
+
+        // deque nodes are recycled through a per thread cache so steady state submission never allocates
+        WorkMessage *newNode(WorkName name, WorkItem&& item);
+        void takeNode(WorkMessage *pNode, WorkMessage& dst);
+
+        void park(std::stop_token token);
+        void wakeOne();
+        void wakeAll();
+
+        size_t slots;
+        size_t spinCount;
+        WorkClock::duration aging;
+
+        std::unique_ptr<WorkDeque[]> pDeques;
+        std::array<std::unique_ptr<Lane>, kWorkLaneCount> lanes;
+
+        // idle workers wait on this value changing
+        std::atomic_uint32_t wakeEpoch = 0;
+        std::atomic_size_t sleepers = 0;
+
+        // the highest slot that has been started, thieves only look below this
+        std::atomic_size_t activeSlots = 0;
+
+        std::atomic_size_t executed = 0;
+        std::atomic_size_t stolen = 0;
+        std::atomic_size_t injected = 0;
+        std::atomic_size_t parked = 0;
+        std::atomic_size_t dequeNodeAllocs = 0;
+        std::atomic_size_t heapJobs = 0;
+    };
+}
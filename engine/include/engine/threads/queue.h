@@ -1,8 +1,12 @@
 #pragma once
 
-#include <functional>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <string>
+#include <string_view>
 
+#include "engine/core/function.h"
 #include "engine/core/unique.h"
 
 #include "engine/threads/thread.h"
@@ -10,11 +14,49 @@
 #include "vendor/moodycamel/blocking.h"
 
 namespace simcoe::threads {
-    using WorkItem = std::function<void()>;
+    using WorkItem = core::UniqueFunction<void()>;
+    using WorkClock = std::chrono::steady_clock;
+
+    /**
+     * @brief a name for a unit of work that never allocates when enqueued
+     * string literals are used directly, runtime strings are interned once
+     * and then shared by every message with the same name
+     */
+    struct WorkName {
+        constexpr WorkName() = default;
+
+        // string literals have static storage so we can point at them directly
+        template<size_t N>
+        consteval WorkName(const char (&str)[N])
+            : name(str, N - 1)
+        { }
+
+        WorkName(std::string_view str);
+        WorkName(const std::string& str) : WorkName(std::string_view(str)) { }
+
+        std::string_view get() const { return name; }
+        const char *c_str() const { return name.data(); }
+
+        bool operator==(const WorkName& other) const = default;
+
+    private:
+        std::string_view name = "";
+    };
 
     struct WorkMessage {
-        std::string name;
+        WorkName name;
         WorkItem item;
+        WorkClock::time_point queued = {}; ///< only set by work queues, the pool doesnt track latency
+    };
+
+    struct WorkQueueStats {
+        size_t executed = 0; ///< messages run
+        size_t backlog = 0; ///< messages waiting to run, approximate
+        size_t maxBacklog = 0; ///< most messages seen waiting at the start of a drain
+        size_t overBudget = 0; ///< drains that ran out of time before the queue was empty
+
+        std::chrono::microseconds avgLatency = {}; ///< mean time between a message being queued and starting
+        std::chrono::microseconds maxLatency = {};
     };
 
     template<typename T, template<class...> typename TQueue>
@@ -23,8 +65,8 @@ namespace simcoe::threads {
             : workQueue(size)
         { }
 
-        void add(std::string name, WorkItem item) {
-            workQueue.enqueue({ name, item });
+        void add(WorkName name, WorkItem&& item) {
+            workQueue.enqueue({ name, std::move(item), WorkClock::now() });
         }
 
     protected:
@@ -40,6 +82,33 @@ namespace simcoe::threads {
 
         // try and process a message immediately
         bool tryGetMessage();
+
+        /**
+         * @brief run messages until the queue is empty or @param budget has passed
+         * the budget is checked after every message and at least one message always runs,
+         * so every call makes progress even when the budget is already spent.
+         * messages are taken in batches, whatever is left of a batch runs first next time
+         *
+         * @return the number of messages run
+         */
+        size_t drain(std::chrono::microseconds budget);
+
+        WorkQueueStats getStats() const;
+
+    private:
+        static constexpr size_t kBatchSize = 16;
+
+        void execute(WorkMessage& msg);
+
+        std::array<WorkMessage, kBatchSize> batch;
+        size_t batchHead = 0; ///< the next message in the batch to run
+        size_t batchCount = 0; ///< messages taken into the batch
+
+        std::atomic_size_t executed = 0;
+        std::atomic_size_t maxBacklog = 0;
+        std::atomic_size_t overBudget = 0;
+        std::atomic_uint64_t totalLatency = 0; // in us
+        std::atomic_uint64_t maxLatency = 0; // in us
     };
 
     struct BlockingWorkQueue : public BaseWorkQueue<WorkMessage, moodycamel::BlockingConcurrentQueue> {
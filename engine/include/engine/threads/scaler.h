@@ -0,0 +1,68 @@
+#pragma once
+
+#include "engine/core/macros.h"
+
+#include "engine/threads/mutex.h"
+
+#include <chrono>
+#include <vector>
+
+namespace simcoe::threads {
+    struct ScalerConfig {
+        size_t minWorkers = 1;
+        size_t maxWorkers = 1;
+
+        std::chrono::microseconds growLatency; ///< queueing latency over a tick that counts as pressure
+
+        size_t growTicks = 2; ///< ticks of pressure before a worker is added
+        size_t shrinkTicks = 40; ///< ticks of idleness before a worker is retired
+        size_t cooldownTicks = 4; ///< ticks to ignore after any change so the pool can settle
+    };
+
+    // what the pool looked like at the end of a tick
+    struct ScalerSample {
+        size_t workers = 0;
+        size_t pending = 0; ///< jobs waiting in any lane or deque
+        size_t sleeping = 0; ///< workers parked waiting for work
+        size_t executed = 0; ///< total jobs run since the pool started
+        std::chrono::microseconds latency = {}; ///< total queueing latency since the pool started
+    };
+
+    struct ScalerStats {
+        size_t grown = 0; ///< workers added
+        size_t shrunk = 0; ///< workers retired
+        std::chrono::microseconds lastLatency = {}; ///< mean queueing latency during the last tick
+
+        std::vector<uint16_t> history; ///< worker count at each tick, oldest first
+    };
+
+    /**
+     * @brief decides how many workers the pool should have
+     * adds a worker quickly when jobs start waiting and retires one slowly once workers sit idle.
+     * the gap between the two and a cooldown after every change keep the count from flapping.
+     */
+    struct WorkerScaler {
+        SM_NOCOPY(WorkerScaler)
+
+        static constexpr size_t kHistorySize = 256;
+
+        WorkerScaler(const ScalerConfig& config);
+
+        // @return the number of workers the pool should have after this tick
+        size_t update(const ScalerSample& sample);
+
+        ScalerStats getStats() const;
+
+    private:
+        ScalerConfig config;
+
+        ScalerSample last;
+        size_t hotTicks = 0;
+        size_t coldTicks = 0;
+        size_t cooldown = 0;
+
+        mutable mt::Mutex lock{"scaler"};
+        ScalerStats stats;
+        size_t historyHead = 0; // next slot to write once the history is full
+    };
+}
@@ -1,52 +1,87 @@
 #pragma once
 
-#include "engine/threads/service.h"
+#include "engine/threads/thread.h"
+#include "engine/threads/mutex.h"
+
+#include <array>
+#include <span>
 
 namespace simcoe::threads {
-#if 0
+    /**
+     * @brief decides which subcore a new thread should run on
+     * the scheduler only looks at the geometry its given, so synthetic topologies
+     * can be placed against without touching the thread service.
+     *
+     * - realtime threads get a fast core to themselves, the fastest cores are
+     *   reserved for them up front so threads made earlier cant take them first
+     * - responsive threads go on the fastest cores that arent reserved
+     * - background and worker threads go on the most efficient free cores,
+     *   filling one package and one chiplet in it before spilling onto the next
+     */
     struct Scheduler {
-        Scheduler();
-        ~Scheduler();
+        SM_NOCOPY(Scheduler)
 
-        Thread& newThread(ThreadType type, std::string_view name, ThreadStart&& start);
+        /**
+         * @param geometry the topology to place threads on
+         * @param realtimeCores how many of the fastest cores to keep for realtime threads,
+         *        at least one core is always left for everything else
+         */
+        Scheduler(const Geometry& geometry, size_t realtimeCores = 0);
 
-        template<typename Rep, typename Period, typename F>
-        Thread& newJob(std::string_view name, std::chrono::duration<Rep, Period> interval, F&& tick) {
-            return newThread(eWorker, name, [tick, interval](std::stop_token stop) {
-                while (!stop.stop_requested()) {
-                    tick();
-                    std::this_thread::sleep_for(interval);
-                }
-            });
-        }
+        // reserve a subcore for a new thread, returns eInvalid if the geometry is empty
+        SubcoreIndex addThread(ThreadType type, std::string_view name);
 
-    private:
-        struct ThreadData {
-            ThreadType type;
+        // release a subcore previously returned by addThread
+        void removeThread(ThreadType type, SubcoreIndex index);
+
+        ScheduleMask getMask(SubcoreIndex index) const;
+
+        uint32_t getCoreLoad(CoreIndex index) const;
+        bool isRealtimeCore(CoreIndex index) const;
 
-            SubcoreIndex subcoreIdx;
-            CoreIndex coreIdx;
+        // only realtime threads are placed on reserved cores while any are left
+        bool isReservedCore(CoreIndex index) const;
 
-            std::string_view name;
+        // how many chiplets threads of @param type are spread across
+        // workers talk to each other a lot, so fewer means less cross chiplet traffic
+        size_t getChipletSpread(ThreadType type) const;
+
+        std::span<const CoreIndex> getCoreRanking() const { return coreRanking; }
+        std::span<const ChipletIndex> getChipletRanking() const { return chipletRanking; }
+        std::span<const PackageIndex> getPackageRanking() const { return packageRanking; }
+
+    private:
+        struct SubcoreData {
+            CoreIndex core = CoreIndex::eInvalid;
+            uint32_t load = 0;
+            std::array<uint16_t, eCount> threads = {}; // threads of each type placed here
         };
 
-        void setupThreadData();
+        struct CoreData {
+            ChipletIndex chiplet = ChipletIndex::eInvalid;
+            uint16_t rank = 0; // position in coreRanking
+            uint16_t chipletRank = UINT16_MAX; // position of our chiplet in chipletRanking
+            uint16_t packageRank = UINT16_MAX; // position of our package in packageRanking
+            uint16_t realtime = 0; // realtime threads pinned here
+            bool reserved = false; // kept free for realtime threads
+        };
 
-        CoreIndices coreRanking; // core indices sorted from fastest to slowest
-        ChipletIndices chipletRanking; // cluster indices sorted from fastest to slowest
-        PackageIndices packageRanking; // package indices sorted from fastest to slowest
+        void setupThreadData(size_t realtimeCores);
 
-        uint16_t getCoreLoad(CoreIndex coreIdx) const;
+        uint32_t getLoad(CoreIndex index) const;
 
-        SubcoreIndex getLeastLoadedSubcore(CoreIndex coreIdx) const;
-        SubcoreIndex getBestSubcore(ThreadType type, std::string_view name) const;
+        SubcoreIndex getLeastLoadedSubcore(CoreIndex index) const;
+        CoreIndex getBestCore(ThreadType type) const;
 
-        mt::Mutex lock{"scheduler"};
+        Geometry geometry;
+
+        CoreIndices coreRanking; // core indices sorted from fastest to slowest
+        ChipletIndices chipletRanking; // chiplet indices sorted from fastest to slowest
+        PackageIndices packageRanking; // package indices sorted from fastest to slowest
 
-        // the number of system threads running on each logical thread
-        std::unordered_map<SubcoreIndex, uint16_t> subcoreUsage = {};
+        mutable mt::Mutex lock{"scheduler"};
 
-        std::vector<threads::Thread> threads;
+        std::vector<SubcoreData> subcoreData;
+        std::vector<CoreData> coreData;
     };
-#endif
 }
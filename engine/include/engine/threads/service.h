@@ -3,15 +3,47 @@
 #include "engine/core/unique.h"
 #include "engine/core/mt.h"
 
-#include "engine/service/platform.h"
+#include "engine/service/service.h"
+#include "engine/config/service.h"
 
 #include "engine/threads/queue.h"
+#include "engine/threads/pool.h"
+#include "engine/threads/timer.h"
 #include "engine/threads/thread.h"
+#include "engine/threads/schedule.h"
 #include "engine/threads/mutex.h"
+#include "engine/threads/scaler.h"
+#include "engine/threads/epoch.h"
+#include "engine/threads/memory.h"
 
+#include <optional>
 #include <unordered_set>
 
 namespace simcoe {
+    namespace threads {
+        using ThreadList = std::vector<ThreadHandle*>;
+
+        /**
+         * @brief a lock free view of every running thread
+         * the view keeps the handles it can see alive, so it should be dropped quickly.
+         * threads started or stopped while it is held wont show up in it
+         */
+        struct ThreadView {
+            ThreadView(mt::Epoch& epoch, const std::atomic<const ThreadList*>& list)
+                : guard(epoch)
+                , pList(list.load(std::memory_order_acquire))
+            { }
+
+            auto begin() const { return pList->begin(); }
+            auto end() const { return pList->end(); }
+            size_t size() const { return pList->size(); }
+
+        private:
+            mt::EpochGuard guard;
+            const ThreadList *pList;
+        };
+    }
+
     // collects thread geometry at startup
     struct ThreadService : IStaticService<ThreadService> {
         // IStaticService
@@ -24,18 +56,29 @@ namespace simcoe {
 
         // geometry data
         static const threads::Geometry& getGeometry();
+        static const threads::Scheduler& getScheduler();
         static threads::ThreadId getCurrentThreadId();
 
         /** talking to the main thread */
-        static void enqueueMain(std::string name, threads::WorkItem&& task);
+        static void enqueueMain(threads::WorkName name, threads::WorkItem&& task);
+
+        // run queued main thread work until the queue is empty or the configured budget runs out
         static void pollMain();
+        static threads::WorkQueueStats getMainStats();
 
         /** worker api */
 
         static void setWorkerCount(size_t count);
+
+        // never takes the pool lock, so workers can ask while the pool is resizing
         static size_t getWorkerCount();
 
-        static void enqueueWork(std::string name, threads::WorkItem&& func);
+        // @param priority picks the lane the work is queued in, worker priority shares the background lane
+        static void enqueueWork(threads::WorkName name, threads::WorkItem&& func, threads::ThreadType priority = threads::eBackground);
+        static threads::WorkPoolStats getWorkStats();
+
+        // empty if autoscaling is disabled
+        static std::optional<threads::ScalerStats> getScalerStats();
 
         /** scheduling api */
 
@@ -49,37 +92,69 @@ namespace simcoe {
          */
         static threads::ThreadHandle *newThread(threads::ThreadType type, std::string name, threads::ThreadStart&& start);
 
+        /** timer api */
+
         /**
-         * @brief create a new job thread and schedule it
+         * @brief run a function once on the worker pool after a delay
+         *
+         * @param name the name of the timer
+         * @param delay how long to wait before running
+         * @param fn the function to run
+         * @return threads::TimerHandle a handle that can cancel the timer
+         */
+        static threads::TimerHandle addTimer(threads::WorkName name, threads::TimerClock::duration delay, threads::WorkItem&& fn);
+
+        /**
+         * @brief run a function on the worker pool at a fixed interval
+         *
+         * @param name the name of the timer
+         * @param period the time between each run
+         * @param fn the function to run
+         * @return threads::TimerHandle a handle that can cancel the timer
+         */
+        static threads::TimerHandle addPeriodic(threads::WorkName name, threads::TimerClock::duration period, threads::WorkItem&& fn);
+
+        static threads::TimerStats getTimerStats();
+
+        /**
+         * @brief create a new periodic job
+         * jobs share the timer thread and run on the worker pool
          *
          * @param name the name of the job
          * @param delay the delay between each iteration
          * @param step the function to run each iteration
-         * @return threads::ThreadHandle* the handle to the thread
+         * @return threads::TimerHandle a handle that can cancel the job
          */
         template<typename Rep, typename Period>
-        static threads::ThreadHandle *newJob(std::string name, std::chrono::duration<Rep, Period> delay, auto&& step) {
-            return newThread(threads::eWorker, name, [delay, step](std::stop_token stop) {
-                while (!stop.stop_requested()) {
-                    step();
-                    std::this_thread::sleep_for(delay);
-                }
-            });
+        static threads::TimerHandle newJob(threads::WorkName name, std::chrono::duration<Rep, Period> delay, auto&& step) {
+            auto period = std::chrono::duration_cast<threads::TimerClock::duration>(delay);
+            return addPeriodic(name, period, std::forward<decltype(step)>(step));
         }
 
         /**
          * @brief terminate all threads and cleanup
-         * @note this leaves dangling pointers to thread handles, we should fix that
+         * handles of stopped threads are freed once no ThreadView can see them
          */
         static void shutdown();
 
         // getters
         static mt::SharedMutex &getPoolLock();
-        static std::vector<threads::ThreadHandle*> &getPool();
+
+        // every thread started through the service, readers never wait on writers
+        static threads::ThreadView getThreads();
+        static mt::EpochStats getThreadEpochStats();
 
     private:
+        // publish a new copy of the thread list, call with the pool lock held
+        static void publishThreads();
+
         static threads::ThreadHandle *newWorkerThread();
         static threads::ThreadHandle *newThreadInner(threads::ThreadType type, std::string name, threads::ThreadStart&& start);
+        // remove a thread from the published list then join it, takes the pool lock
+        static void unpublishThread(threads::ThreadHandle *pHandle);
+
+        // join a thread that is no longer published, call without the pool lock held
+        static void deleteThread(threads::ThreadHandle *pHandle);
     };
 
     namespace threads {
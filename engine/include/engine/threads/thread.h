@@ -7,28 +7,55 @@
 #include "vendor/fmtlib/fmt.h"
 
 #include "engine/core/macros.h"
-#include "engine/core/win32.h"
+
+#if SM_OS_WINDOWS
+#   include "engine/core/win32.h"
+#elif SM_OS_LINUX
+#   include <pthread.h>
+#   include <sys/types.h>
+#   include <atomic>
+#endif
 
 namespace simcoe { struct ThreadService; }
 
 namespace simcoe::threads {
+#if SM_OS_WINDOWS
     using ThreadId = DWORD;
+    using NativeThread = HANDLE;
+#elif SM_OS_LINUX
+    using ThreadId = pid_t;
+    using NativeThread = pthread_t;
+#endif
+
     using ThreadStart = std::function<void(std::stop_token)>;
 
     enum struct SubcoreIndex : uint16_t { eInvalid = UINT16_MAX };
     enum struct CoreIndex : uint16_t { eInvalid = UINT16_MAX };
     enum struct ChipletIndex : uint16_t { eInvalid = UINT16_MAX };
     enum struct PackageIndex : uint16_t { eInvalid = UINT16_MAX };
+    enum struct NodeIndex : uint16_t { eInvalid = UINT16_MAX };
 
     using SubcoreIndices = std::vector<SubcoreIndex>;
     using CoreIndices = std::vector<CoreIndex>;
     using ChipletIndices = std::vector<ChipletIndex>;
     using PackageIndices = std::vector<PackageIndex>;
+    using NodeIndices = std::vector<NodeIndex>;
 
+#if SM_OS_WINDOWS
     struct ScheduleMask : GROUP_AFFINITY {
         using GROUP_AFFINITY::Mask;
         using GROUP_AFFINITY::Group;
     };
+#elif SM_OS_LINUX
+    // linux has no processor groups, we split cpus into groups of 64 to match windows
+    struct ScheduleMask {
+        uint64_t Mask = 0;
+        uint16_t Group = 0;
+    };
+#endif
+
+    // anything bigger than a single thread can span more than one group
+    using ScheduleMasks = std::vector<ScheduleMask>;
 
     struct LogicalThread {
         ScheduleMask mask;
@@ -41,19 +68,29 @@ namespace simcoe::threads {
         uint16_t schedule; ///< the threads schedule speed (lower is faster)
         uint8_t efficiency; ///< the threads efficiency (higher is more efficient)
 
-        ScheduleMask mask;
+        ScheduleMasks masks;
         SubcoreIndices subcoreIds;
     };
 
     // equivalent to a ryzen ccx or ccd
     struct Chiplet {
-        ScheduleMask mask;
+        ScheduleMasks masks;
         CoreIndices coreIds;
     };
 
     // a single cpu package
     struct Package {
-        ScheduleMask mask;
+        ScheduleMasks masks;
+
+        CoreIndices cores;
+        SubcoreIndices subcores;
+        ChipletIndices chiplets;
+    };
+
+    // a numa node, memory attached to it is cheapest to reach from its own cores
+    struct Node {
+        uint32_t id; ///< the os node number
+        ScheduleMasks masks;
 
         CoreIndices cores;
         SubcoreIndices subcores;
@@ -66,11 +103,13 @@ namespace simcoe::threads {
         std::vector<Core> cores;
         std::vector<Chiplet> chiplets;
         std::vector<Package> packages;
+        std::vector<Node> nodes;
 
         const Subcore& getSubcore(SubcoreIndex idx) const { return subcores[size_t(idx)]; }
         const Core& getCore(CoreIndex idx) const { return cores[size_t(idx)]; }
         const Chiplet& getChiplet(ChipletIndex idx) const { return chiplets[size_t(idx)]; }
         const Package& getPackage(PackageIndex idx) const { return packages[size_t(idx)]; }
+        const Node& getNode(NodeIndex idx) const { return nodes[size_t(idx)]; }
     };
 
     enum ThreadType {
@@ -108,10 +147,11 @@ namespace simcoe::threads {
         friend struct simcoe::ThreadService;
 
         std::string_view getName() const { return name; }
-        HANDLE getHandle() const { return hThread; }
+        NativeThread getHandle() const { return hThread; }
         ThreadId getId() const { return id; }
         ThreadType getType() const { return type; }
         ScheduleMask getAffinity() const { return mask; }
+        SubcoreIndex getSubcore() const { return subcore; }
 
         void requestStop() { stopper.request_stop(); }
         void join();
@@ -122,15 +162,24 @@ namespace simcoe::threads {
         ThreadHandle(ThreadInfo&& info);
 
         // starter thunk
+#if SM_OS_WINDOWS
         static DWORD WINAPI threadThunk(LPVOID lpParameter);
+#elif SM_OS_LINUX
+        static void *threadThunk(void *pParameter);
+#endif
 
         // os data
-        HANDLE hThread = nullptr;
+        NativeThread hThread = {};
         ThreadId id = 0;
 
+#if SM_OS_LINUX
+        bool bJoined = false;
+#endif
+
         // schedule data
         ThreadType type;
         ScheduleMask mask;
+        SubcoreIndex subcore = SubcoreIndex::eInvalid;
 
         // thread data
         std::string name;
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "engine/core/macros.h"
+
+#include "engine/threads/mutex.h"
+#include "engine/threads/queue.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <stop_token>
+#include <vector>
+
+namespace simcoe::threads {
+    struct WorkPool;
+
+    using TimerClock = std::chrono::steady_clock;
+
+    struct TimerStats {
+        size_t active = 0; ///< timers currently in the wheel
+        size_t fired = 0; ///< callbacks dispatched to the worker pool
+        size_t skipped = 0; ///< periodic fires dropped because the last one was still running
+        size_t overruns = 0; ///< periods missed entirely because the timer thread fell behind
+        size_t cascades = 0; ///< timers moved down a level of the wheel
+    };
+
+    namespace detail {
+        struct TimerEntry;
+    }
+
+    /**
+     * @brief a handle to a timer in a TimerWheel
+     * dropping the handle does not cancel the timer
+     */
+    struct TimerHandle {
+        TimerHandle() = default;
+        TimerHandle(std::shared_ptr<detail::TimerEntry> pEntry)
+            : pEntry(std::move(pEntry))
+        { }
+
+        /**
+         * @brief stop the timer from firing again
+         * waits for a callback that is already running to finish,
+         * unless called from inside that callback
+         */
+        void cancel();
+
+        bool isActive() const;
+
+    private:
+        std::shared_ptr<detail::TimerEntry> pEntry;
+    };
+
+    /**
+     * @brief hierarchical timer wheel
+     * a single thread advances the wheel and dispatches expired timers onto the worker pool.
+     * periodic timers are rescheduled from their previous deadline rather than
+     * from when they ran, so they dont drift.
+     * based on "Hashed and Hierarchical Timing Wheels" (Varghese & Lauck 1987)
+     */
+    struct TimerWheel {
+        SM_NOCOPY(TimerWheel)
+        SM_NOMOVE(TimerWheel)
+
+        using Duration = TimerClock::duration;
+        using TimePoint = TimerClock::time_point;
+
+        // @param start is tick 0 of the wheel
+        TimerWheel(WorkPool& pool, Duration resolution, TimePoint start = TimerClock::now());
+
+        // run @param fn once after @param delay
+        TimerHandle addOnce(WorkName name, Duration delay, WorkItem&& fn);
+
+        // run @param fn once at @param deadline
+        TimerHandle addAt(WorkName name, TimePoint deadline, WorkItem&& fn);
+
+        // run @param fn every @param period, the first run is one period from now
+        TimerHandle addPeriodic(WorkName name, Duration period, WorkItem&& fn);
+
+        // advance the wheel until @param token is stopped
+        void run(std::stop_token token);
+
+        // dispatch everything due by @param now, run does this as time passes
+        void poll(TimePoint now);
+
+        TimerStats getStats() const;
+
+    private:
+        using EntryPtr = std::shared_ptr<detail::TimerEntry>;
+
+        // 4 levels of 64 slots covers 2^24 ticks, ~4.6 hours at 1ms
+        static constexpr size_t kLevelBits = 6;
+        static constexpr size_t kSlotCount = 1 << kLevelBits;
+        static constexpr size_t kSlotMask = kSlotCount - 1;
+        static constexpr size_t kLevelCount = 4;
+
+        using Slot = std::vector<EntryPtr>;
+        using Level = std::array<Slot, kSlotCount>;
+
+        TimerHandle addEntry(EntryPtr pEntry);
+
+        uint64_t getTick(TimePoint time) const;
+        TimePoint getTime(uint64_t tick) const;
+
+        void insert(EntryPtr pEntry);
+        void cascade(size_t level);
+        void advance();
+        void advanceTo(TimePoint now);
+        void fire(EntryPtr pEntry, TimePoint now);
+
+        // the next tick that has work to do, either a level 0 slot or a cascade
+        uint64_t getNextTick() const;
+
+        WorkPool& pool;
+        Duration resolution;
+        TimePoint start;
+
+        mutable mt::Mutex lock{"timers"};
+        std::condition_variable_any signal;
+        bool bChanged = false; ///< set when a timer is added so the thread can recalculate its wait
+
+        uint64_t currentTick = 0;
+        size_t active = 0;
+        std::array<Level, kLevelCount> levels;
+
+        std::atomic_size_t fired = 0;
+        std::atomic_size_t skipped = 0;
+        std::atomic_size_t overruns = 0;
+        std::atomic_size_t cascades = 0;
+    };
+}
@@ -0,0 +1,188 @@
+#include "engine/core/arena.h"
+
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <mutex>
+
+using namespace simcoe;
+using namespace simcoe::core;
+
+struct Arena::Block {
+    Block *pNext;
+    size_t size;
+
+    char *getData() { return reinterpret_cast<char*>(this + 1); }
+};
+
+namespace {
+    // the last finished frame of a thread, published so other threads can read it
+    struct FrameArena {
+        FrameArena();
+        ~FrameArena();
+
+        Arena arena;
+        size_t frame = 0; ///< the value of gFrame when this was last reset
+
+        std::atomic_size_t allocs = 0;
+        std::atomic_size_t used = 0;
+        std::atomic_size_t capacity = 0;
+        std::atomic_size_t blocks = 0;
+    };
+
+    // bumped every time a frame ends
+    std::atomic_size_t gFrame = 0;
+
+    std::mutex gFrameLock;
+    std::vector<FrameArena*> gFrameArenas;
+
+    thread_local FrameArena tlsFrameArena;
+
+    FrameArena::FrameArena() {
+        std::lock_guard guard(gFrameLock);
+        gFrameArenas.push_back(this);
+    }
+
+    FrameArena::~FrameArena() {
+        std::lock_guard guard(gFrameLock);
+        std::erase(gFrameArenas, this);
+    }
+}
+
+// arena
+
+Arena::Arena(size_t blockSize, std::pmr::memory_resource *pUpstream)
+    : blockSize(blockSize)
+    , pUpstream(pUpstream)
+{
+    SM_ASSERTF(blockSize > 0, "arena block size must be positive");
+    SM_ASSERTF(pUpstream != nullptr, "arena needs an upstream resource");
+}
+
+Arena::~Arena() {
+    freeBlocks();
+}
+
+void *Arena::allocate(size_t size, size_t align) {
+    SM_ASSERTF(std::has_single_bit(align), "arena alignment {} is not a power of 2", align);
+
+    auto aligned = [&] {
+        auto address = reinterpret_cast<uintptr_t>(pCursor);
+        return reinterpret_cast<char*>((address + align - 1) & ~(align - 1));
+    };
+
+    char *pData = aligned();
+    if (pBlock == nullptr || pData + size > pEnd) {
+        newBlock(std::max(blockSize, size + align));
+        pData = aligned();
+    }
+
+    pCursor = pData + size;
+
+    stats.allocs += 1;
+    stats.used += size;
+
+    return pData;
+}
+
+void Arena::reset() {
+    // fold a frame that spilled over into one block big enough for all of it
+    if (pBlock != nullptr && pBlock->pNext != nullptr) {
+        size_t capacity = stats.capacity;
+        freeBlocks();
+
+        blockSize = std::max(blockSize, capacity);
+        stats = {};
+        newBlock(blockSize);
+    } else {
+        stats.blocks = 0;
+    }
+
+    stats.allocs = 0;
+    stats.used = 0;
+
+    if (pBlock != nullptr) {
+        pCursor = pBlock->getData();
+    }
+}
+
+void Arena::setUpstream(std::pmr::memory_resource *pMemory) {
+    SM_ASSERTF(pMemory != nullptr, "arena needs an upstream resource");
+    SM_ASSERTF(stats.allocs == 0, "cant move an arena with {} live allocations", stats.allocs);
+
+    if (pMemory == pUpstream) return;
+
+    freeBlocks();
+    stats = {};
+    pUpstream = pMemory;
+}
+
+void Arena::newBlock(size_t size) {
+    void *pMemory = pUpstream->allocate(sizeof(Block) + size, alignof(std::max_align_t));
+    pBlock = new (pMemory) Block { pBlock, size };
+
+    pCursor = pBlock->getData();
+    pEnd = pCursor + size;
+
+    stats.capacity += size;
+    stats.blocks += 1;
+}
+
+void Arena::freeBlocks() {
+    while (pBlock != nullptr) {
+        Block *pNext = pBlock->pNext;
+        pUpstream->deallocate(pBlock, sizeof(Block) + pBlock->size, alignof(std::max_align_t));
+        pBlock = pNext;
+    }
+
+    pCursor = nullptr;
+    pEnd = nullptr;
+}
+
+// frame arenas
+
+Arena& core::getFrameArena() {
+    return tlsFrameArena.arena;
+}
+
+void core::resetFrameArena() {
+    FrameArena& frame = tlsFrameArena;
+    ArenaStats stats = frame.arena.getStats();
+
+    frame.allocs = stats.allocs;
+    frame.used = stats.used;
+    frame.capacity = stats.capacity;
+    frame.blocks = stats.blocks;
+    frame.frame = gFrame.load(std::memory_order_relaxed);
+
+    frame.arena.reset();
+}
+
+void core::endFrame() {
+    gFrame.fetch_add(1, std::memory_order_relaxed);
+    resetFrameArena();
+}
+
+void core::resetStaleFrameArena() {
+    if (tlsFrameArena.frame != gFrame.load(std::memory_order_relaxed)) {
+        resetFrameArena();
+    }
+}
+
+void core::setFrameArenaMemory(std::pmr::memory_resource *pMemory) {
+    tlsFrameArena.arena.setUpstream(pMemory);
+}
+
+ArenaStats core::getFrameArenaStats() {
+    ArenaStats result;
+
+    std::lock_guard guard(gFrameLock);
+    for (const FrameArena *pFrame : gFrameArenas) {
+        result.allocs += pFrame->allocs;
+        result.used += pFrame->used;
+        result.capacity += pFrame->capacity;
+        result.blocks += pFrame->blocks;
+    }
+
+    return result;
+}
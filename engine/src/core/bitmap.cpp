@@ -3,21 +3,162 @@
 using namespace simcoe;
 using namespace simcoe::core;
 
+namespace {
+    constexpr std::uint64_t kFullWord = ~std::uint64_t(0);
+}
+
 // BitMap
 
+BitMap::Index BitMap::alloc() {
+    size_t word = findFreeWord();
+    if (word == SIZE_MAX) return Index::eInvalid;
+
+    size_t index = word * kBitPerWord + std::countr_one(pBits[word]);
+    if (index >= getTotalBits()) return Index::eInvalid;
+
+    set(index);
+    used += 1;
+    return Index(index);
+}
+
+void BitMap::release(Index index) {
+    if (!test(index)) return;
+
+    clear(size_t(index));
+    used -= 1;
+}
+
 bool BitMap::testSet(size_t index) {
     if (test(Index(index))) {
         return false;
     }
 
     set(index);
+    used += 1;
     return true;
 }
 
+void BitMap::set(size_t index) {
+    // filling a word fills its bit in the level above, and so on up
+    for (size_t level = 0; level <= kSummaryLevels; level++) {
+        std::uint64_t& word = getLevel(level)[getWord(index)];
+        word |= getMask(index);
+
+        if (word != kFullWord) break;
+        index = getWord(index);
+    }
+}
+
+void BitMap::clear(size_t index) {
+    for (size_t level = 0; level <= kSummaryLevels; level++) {
+        std::uint64_t& word = getLevel(level)[getWord(index)];
+        bool bWasFull = word == kFullWord;
+        word &= ~getMask(index);
+
+        if (!bWasFull) break;
+        index = getWord(index);
+    }
+}
+
 // AtomicBitMap
 
+AtomicBitMap::Index AtomicBitMap::alloc() {
+    for (size_t attempt = 0; attempt < 4; attempt++) {
+        size_t word = findFreeWord();
+        if (word == SIZE_MAX) break;
+
+        if (Index index = claim(word); index != Index::eInvalid) {
+            return index;
+        }
+
+        // the word filled up under us, make sure the summary knows before trying again
+        if (pBits[word].load() == kFullWord) {
+            markFull(word);
+        }
+    }
+
+    for (size_t word = 0; word < levelWords(0); word++) {
+        if (Index index = claim(word); index != Index::eInvalid) {
+            return index;
+        }
+    }
+
+    return Index::eInvalid;
+}
+
+void AtomicBitMap::release(Index index) {
+    verifyIndex(index);
+
+    size_t bit = size_t(index);
+    std::uint64_t mask = getMask(bit);
+    std::uint64_t prev = pBits[getWord(bit)].fetch_and(~mask);
+    if (!(prev & mask)) return;
+
+    used.fetch_sub(1);
+
+    if (prev == kFullWord) {
+        markFree(getWord(bit));
+    }
+}
+
 bool AtomicBitMap::testSet(size_t index) {
-    auto mask = getMask(index);
+    verifyIndex(Index(index));
+
+    std::uint64_t mask = getMask(index);
+    std::uint64_t prev = pBits[getWord(index)].fetch_or(mask);
+    if (prev & mask) return false;
+
+    used.fetch_add(1);
+
+    if ((prev | mask) == kFullWord) {
+        markFull(getWord(index));
+    }
+
+    return true;
+}
+
+AtomicBitMap::Index AtomicBitMap::claim(size_t word) {
+    std::atomic_uint64_t& bits = pBits[word];
+    std::uint64_t current = bits.load();
+
+    while (current != kFullWord) {
+        size_t index = word * kBitPerWord + std::countr_one(current);
+        if (index >= getTotalBits()) break;
 
-    return !(pBits[getWord(index)].fetch_or(mask) & mask);
+        std::uint64_t mask = getMask(index);
+        std::uint64_t prev = bits.fetch_or(mask);
+        if (!(prev & mask)) {
+            used.fetch_add(1);
+
+            if ((prev | mask) == kFullWord) {
+                markFull(word);
+            }
+
+            return Index(index);
+        }
+
+        current = prev | mask;
+    }
+
+    return Index::eInvalid;
+}
+
+void AtomicBitMap::markFull(size_t word) {
+    for (size_t level = 1; level <= kSummaryLevels; level++) {
+        std::uint64_t mask = getMask(word);
+        std::uint64_t prev = getLevel(level)[getWord(word)].fetch_or(mask);
+
+        if ((prev | mask) != kFullWord) break;
+        word = getWord(word);
+    }
+}
+
+void AtomicBitMap::markFree(size_t word) {
+    for (size_t level = 1; level <= kSummaryLevels; level++) {
+        std::uint64_t mask = getMask(word);
+        std::uint64_t prev = getLevel(level)[getWord(word)].fetch_and(~mask);
+
+        if (prev != kFullWord) break;
+        word = getWord(word);
+    }
 }
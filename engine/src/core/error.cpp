@@ -1,4 +1,5 @@
 #include "engine/core/error.h"
+#include "engine/core/compiler.h"
 
 #include "engine/debug/service.h"
 #include "engine/log/service.h"
@@ -20,5 +21,5 @@ Error::Error(bool bFatal, std::string msg) noexcept
     , message(std::move(msg))
     , stacktrace(getBacktrace())
 { 
-    if (bFatal) __debugbreak();
+    if (bFatal) SM_DEBUGBREAK();
 }
@@ -2,7 +2,11 @@
 
 #include "engine/core/error.h"
 #include "engine/log/service.h"
-#include "engine/service/platform.h"
+#include "engine/debug/service.h"
+
+#if SM_OS_WINDOWS
+#   include "engine/service/platform.h"
+#endif
 
 #include <iostream>
 
@@ -22,11 +26,13 @@ void core::panic(const PanicInfo &info, std::string_view msg) {
         LOG_ERROR("backtrace unavailable (pre service init error)");
     }
 
+#if SM_OS_WINDOWS
     if (PlatformService::getState() & ~eServiceFaulted) {
         auto title = fmt::format("PANIC {}:{} @ {}", info.file, info.line, info.fn);
         PlatformService::message(title, msg);
         core::throwFatal(msg);
     }
+#endif
 
     std::cout << "[PANIC " << info.file << ":" << info.line << " @ " << info.fn << "] " << msg << std::endl;
     core::throwFatal(msg);
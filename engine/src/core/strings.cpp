@@ -1,10 +1,17 @@
 #include "engine/core/strings.h"
 
-#include "engine/core/win32.h"
+#include "engine/core/macros.h"
+
+#if SM_OS_WINDOWS
+#   include "engine/core/win32.h"
+#else
+#   include <cstdlib>
+#endif
 
 using namespace simcoe;
 using namespace simcoe::util;
 
+#if SM_OS_WINDOWS
 std::string util::narrow(std::wstring_view wstr) {
     std::string result(wstr.size() + 1, '\0');
     size_t size = result.size();
@@ -24,6 +31,32 @@ std::wstring util::widen(std::string_view str) {
     MultiByteToWideChar(CP_UTF8, 0, str.data(), (int)str.size(), result.data(), (int)result.size());
     return result;
 }
+#else
+// wchar_t is utf32 here, the conversion goes through the current locale
+std::string util::narrow(std::wstring_view wstr) {
+    std::wstring terminated(wstr);
+    size_t needed = std::wcstombs(nullptr, terminated.c_str(), 0);
+    if (needed == size_t(-1)) {
+        return "";
+    }
+
+    std::string result(needed, '\0');
+    std::wcstombs(result.data(), terminated.c_str(), needed);
+    return result;
+}
+
+std::wstring util::widen(std::string_view str) {
+    std::string terminated(str);
+    size_t needed = std::mbstowcs(nullptr, terminated.c_str(), 0);
+    if (needed == size_t(-1)) {
+        return L"";
+    }
+
+    std::wstring result(needed, L'\0');
+    std::mbstowcs(result.data(), terminated.c_str(), needed);
+    return result;
+}
+#endif
 
 template<typename T>
 std::string joinInner(std::span<const T> all, std::string_view delim) {
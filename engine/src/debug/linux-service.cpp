@@ -0,0 +1,92 @@
+#include "engine/debug/service.h"
+#include "engine/log/service.h"
+
+#include <cxxabi.h>
+#include <execinfo.h>
+#include <pthread.h>
+
+#include <fstream>
+#include <memory>
+
+using namespace simcoe;
+
+// debug
+
+namespace {
+    constexpr int kMaxFrames = 128;
+
+    // linux limits thread names to 16 bytes including the null terminator
+    constexpr size_t kMaxNameLength = 15;
+
+    // backtrace_symbols gives us `module(mangled+offset) [pc]`
+    std::string demangleFrame(std::string_view frame) {
+        size_t begin = frame.find('(');
+        size_t end = frame.find('+', begin);
+        if (begin == std::string_view::npos || end == std::string_view::npos || end == begin + 1) {
+            return std::string(frame);
+        }
+
+        std::string mangled{frame.substr(begin + 1, end - begin - 1)};
+
+        int status = 0;
+        std::unique_ptr<char, decltype(&free)> pName{abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status), free};
+        if (status != 0 || pName == nullptr) {
+            return mangled;
+        }
+
+        return pName.get();
+    }
+}
+
+bool DebugService::createService() {
+    return true;
+}
+
+void DebugService::destroyService() { }
+
+debug::Backtrace DebugService::backtrace() {
+    void *frames[kMaxFrames];
+    int count = ::backtrace(frames, kMaxFrames);
+
+    std::unique_ptr<char*, decltype(&free)> pSymbols{backtrace_symbols(frames, count), free};
+
+    debug::Backtrace result;
+    for (int i = 0; i < count; i++) {
+        size_t pc = reinterpret_cast<size_t>(frames[i]);
+        if (pSymbols == nullptr) {
+            result.push_back({ "", pc });
+        } else {
+            result.push_back({ demangleFrame(pSymbols.get()[i]), pc });
+        }
+    }
+
+    return result;
+}
+
+///
+/// thread naming
+///
+
+void debug::setThreadName(std::string_view name) {
+    std::string shortName{name.substr(0, kMaxNameLength)};
+    if (int err = pthread_setname_np(pthread_self(), shortName.c_str()); err != 0) {
+        LOG_WARN("failed to set thread name `{}` (err = {})", name, err);
+    }
+}
+
+// utils
+
+bool debug::isAttached() {
+    // a traced process has a nonzero TracerPid in its status
+    std::ifstream status("/proc/self/status");
+
+    std::string line;
+    while (std::getline(status, line)) {
+        constexpr std::string_view kTracer = "TracerPid:";
+        if (!line.starts_with(kTracer)) continue;
+
+        return std::stoi(line.substr(kTracer.size())) != 0;
+    }
+
+    return false;
+}
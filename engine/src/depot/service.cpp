@@ -106,7 +106,7 @@ namespace {
 
     // listen for fs changes
     HANDLE hChange = INVALID_HANDLE_VALUE;
-    threads::ThreadHandle *pChangeNotify = nullptr;
+    threads::TimerHandle gChangeTimer;
 
     // local handles (files inside the vfs dir)
     mt::SharedMutex gMutex{"vfs"};
@@ -168,18 +168,19 @@ bool DepotService::createService() {
         debug::throwLastError("FindFirstChangeNotificationA");
     }
 
-    pChangeNotify = ThreadService::newThread(threads::eBackground, "depot", [](std::stop_token token) {
-        while (!token.stop_requested()) {
-            DWORD dwWait = WaitForSingleObject(hChange, core::intCast<DWORD>(cfgWaitInterval.getCurrentValue()));
-            if (dwWait == WAIT_TIMEOUT) continue;
-            if (dwWait == WAIT_ABANDONED) {
-                debug::throwLastError("WaitForSingleObject");
-            }
+    // poll the change handle from the timer wheel rather than parking a thread on it
+    auto interval = std::chrono::milliseconds(cfgWaitInterval.getCurrentValue());
+    gChangeTimer = ThreadService::addPeriodic("depot.changes", interval, [] {
+        DWORD dwWait = WaitForSingleObject(hChange, 0);
+        if (dwWait == WAIT_TIMEOUT) return;
+        if (dwWait != WAIT_OBJECT_0) {
+            LOG_ERROR("WaitForSingleObject failed on depot change handle: {}", debug::getErrorName());
+            return;
+        }
 
-            notifyChange();
-            if (!FindNextChangeNotification(hChange)) {
-                debug::throwLastError("FindNextChangeNotification");
-            }
+        notifyChange();
+        if (!FindNextChangeNotification(hChange)) {
+            LOG_ERROR("FindNextChangeNotification failed: {}", debug::getErrorName());
         }
     });
 
@@ -187,8 +188,8 @@ bool DepotService::createService() {
 }
 
 void DepotService::destroyService() {
-    pChangeNotify->join();
-    
+    gChangeTimer.cancel();
+
     if (hChange != INVALID_HANDLE_VALUE) {
         FindCloseChangeNotification(hChange);
     }
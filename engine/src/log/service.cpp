@@ -23,9 +23,16 @@ const config::ConfigEnumMap kLevelNames = {
     { "debug", log::eDebug },
 };
 
+const config::ConfigEnumMap kBackPressureNames = {
+    { "drop", mt::eDropOldest },
+    { "block", mt::eBlock },
+    { "fail", mt::eFail },
+};
+
 config::ConfigValue<log::Level> cfgLogLevel("logging", "level", "default logging level", log::eInfo, kLevelNames, config::eDynamic);
 
-config::ConfigValue<size_t> cfgLogQueueSize("logging/worker", "queue_size", "amount of messages to queue before blocking", 1024);
+config::ConfigValue<size_t> cfgLogQueueSize("logging/worker", "queue_size", "amount of messages to queue before applying backpressure", 1024);
+config::ConfigValue<mt::BackPressure> cfgLogBackPressure("logging/worker", "backpressure", "what to do with new messages when the queue is full", mt::eBlock, kBackPressureNames);
 config::ConfigValue<size_t> cfgLogQueueInterval("logging/worker", "wait_interval", "amount of time to wait before checking for more messages (in ms)", 5);
 
 struct LogMessage {
@@ -35,7 +42,8 @@ struct LogMessage {
     std::string msg;
 };
 
-using LogQueue = mt::BlockingMessageQueue<LogMessage>;
+// every thread logs, only the logger thread reads
+using LogQueue = mt::MpscChannel<LogMessage>;
 
 template<>
 struct std::less<LogMessage> {
@@ -53,8 +61,10 @@ namespace {
     /// all messages we need to send are sent
     std::atomic_bool gEnableLogQueue = true;
 
+    threads::ThreadHandle *gLogThread = nullptr;
+
     LogQueue *getLogQueue() {
-        static LogQueue *pQueue = new LogQueue(cfgLogQueueSize.getCurrentValue());
+        static LogQueue *pQueue = new LogQueue("logger", cfgLogQueueSize.getCurrentValue(), cfgLogBackPressure.getCurrentValue());
         return pQueue;
     }
 
@@ -67,7 +77,7 @@ namespace {
     void addMessageToQueue(LogMessage&& msg) {
         if (gEnableLogQueue) {
             auto *pQueue = getLogQueue();
-            pQueue->enqueue(std::move(msg));
+            pQueue->push(std::move(msg));
         } else {
             sendMessageToSinks(msg);
         }
@@ -80,7 +90,7 @@ LoggingService::LoggingService() {
 }
 
 bool LoggingService::createService() {
-    ThreadService::newThread(threads::eBackground, "logger", [pQueue = getLogQueue()](std::stop_token token) {
+    gLogThread = ThreadService::newThread(threads::eBackground, "logger", [pQueue = getLogQueue()](std::stop_token token) {
         auto interval = std::chrono::milliseconds(cfgLogQueueInterval.getCurrentValue());
 
         std::priority_queue<LogMessage> pendingMessages;
@@ -88,7 +98,7 @@ bool LoggingService::createService() {
         std::array<LogMessage, 32> messages;
         while (!token.stop_requested()) {
             // TODO: clean this all up
-            size_t got = pQueue->tryGetBulk(messages.data(), messages.size(), interval);
+            size_t got = pQueue->popBatch(messages.data(), messages.size(), interval);
             for (size_t i = 0; i < got; ++i) {
                 pendingMessages.push(std::move(messages[i]));
             }
@@ -109,11 +119,17 @@ bool LoggingService::createService() {
 void LoggingService::destroyService() {
     gEnableLogQueue = false;
     
+    // the queue only has room for one reader, so the logger has to be gone before we drain it
+    if (gLogThread != nullptr) {
+        gLogThread->join();
+    }
+
     // pump the rest of the messages
     std::array<LogMessage, 32> messages;
-    size_t got = getLogQueue()->tryGetBulk(messages.data(), messages.size());
-    for (size_t i = 0; i < got; ++i) {
-        sendMessageToSinks(messages[i]);
+    while (size_t got = getLogQueue()->popBatch(messages.data(), messages.size())) {
+        for (size_t i = 0; i < got; ++i) {
+            sendMessageToSinks(messages[i]);
+        }
     }
 }
 
@@ -127,11 +143,15 @@ void LoggingService::addSink(log::ISink *pSink) {
     sinks.push_back(pSink);
 }
 
+mt::ChannelStats LoggingService::getQueueStats() {
+    return getLogQueue()->getStats();
+}
+
 // private interface
 
 void LoggingService::sendMessageAlways(log::Level msgLevel, std::string msg) {
     auto threadId = ThreadService::getCurrentThreadId();
-    auto currentUtcTime = chrono::utc_clock::to_sys(chrono::utc_clock::now());
+    auto currentUtcTime = chrono::system_clock::now(); // system_clock is utc everywhere we run
 
     LogMessage message = {
         .level = msgLevel,
@@ -3,6 +3,12 @@
 
 #include <iostream>
 
+#if SM_OS_WINDOWS
+#   include "engine/core/win32.h"
+#else
+#   include <unistd.h>
+#endif
+
 #include "engine/config/system.h"
 
 using namespace simcoe;
@@ -12,12 +18,16 @@ config::ConfigValue<bool> cfgLogColour("logging/console", "colour", "enable colo
 config::ConfigValue<std::string> cfgLogPath("logging/file", "path", "path to log file", "engine.log");
 
 bool hasColourSupport() {
+#if SM_OS_WINDOWS
     DWORD dwMode = 0;
     if (!GetConsoleMode(GetStdHandle(STD_OUTPUT_HANDLE), &dwMode)) {
         return false;
     }
 
     return dwMode & ENABLE_VIRTUAL_TERMINAL_PROCESSING;
+#else
+    return isatty(STDOUT_FILENO);
+#endif
 }
 
 ConsoleSink::ConsoleSink()
@@ -1,5 +1,6 @@
 #include "engine/render/graph.h"
 
+#include "engine/core/arena.h"
 #include "engine/core/panic.h"
 
 using namespace simcoe;
@@ -165,6 +166,8 @@ bool Graph::execute() {
     if (lock) { return false; }
 
     std::lock_guard guard(mutex);
+    core::resetFrameArena();
+
     pCurrentRenderTarget = nullptr;
     pCurrentDepthStencil = nullptr;
 
@@ -214,7 +217,7 @@ void Graph::destroyIf(StateDep dep) {
 }
 
 void Graph::executePass(ICommandPass *pPass) {
-    std::vector<rhi::Transition> barriers;
+    core::ArenaVector<rhi::Transition> barriers(core::getFrameArena());
 
     for (const auto *pInput : pPass->inputs) {
         auto *pHandle = pInput->getResourceHandle();
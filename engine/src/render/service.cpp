@@ -71,8 +71,8 @@ void RenderService::shutdown() {
     pRenderThread->join();
 }
 
-void RenderService::enqueueWork(std::string name, threads::WorkItem&& work) {
-    pRenderQueue->add(std::move(name), std::move(work));
+void RenderService::enqueueWork(threads::WorkName name, threads::WorkItem&& work) {
+    pRenderQueue->add(name, std::move(work));
 } 
 
 render::Graph *RenderService::getGraph() {
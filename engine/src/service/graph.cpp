@@ -0,0 +1,263 @@
+#include "engine/service/graph.h"
+
+#include "engine/core/error.h"
+
+#include "engine/log/service.h"
+#include "engine/threads/service.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace simcoe;
+
+using namespace std::chrono_literals;
+
+namespace chrono = std::chrono;
+
+namespace {
+    // pushed onto the main queue once the last node finishes
+    constexpr size_t kWakeMain = SIZE_MAX;
+
+    bool isMainThreadService(IService *pService) {
+        return pService->getFlags() & eServiceLoadMainThread;
+    }
+}
+
+ServiceGraph::ServiceGraph(ServiceSpan services) {
+    for (IService *pService : services) {
+        addNode(pService);
+    }
+}
+
+size_t ServiceGraph::addNode(IService *pService) {
+    if (auto it = indices.find(pService); it != indices.end()) {
+        return it->second;
+    }
+
+    size_t index = nodes.size();
+    auto& pNode = nodes.emplace_back(std::make_unique<Node>());
+    pNode->pService = pService;
+    indices.emplace(pService, index);
+
+    for (IService *pDep : pService->getServiceDeps()) {
+        size_t dep = addNode(pDep);
+        nodes[index]->deps.push_back(dep);
+        nodes[dep]->dependents.push_back(index);
+    }
+
+    return index;
+}
+
+size_t ServiceGraph::getNode(IService *pService) const {
+    auto it = indices.find(pService);
+    SM_ASSERTF(it != indices.end(), "service {} is not part of the graph", pService->getName());
+    return it->second;
+}
+
+void ServiceGraph::setExternal(IService *pService, TimePoint start, TimePoint end) {
+    auto& pNode = nodes[addNode(pService)];
+    pNode->bExternal = true;
+    pNode->start = start;
+    pNode->end = end;
+}
+
+// startup
+
+void ServiceGraph::create() {
+    bTeardown = false;
+
+    std::vector<size_t> ready;
+    size_t total = 0;
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        auto& pNode = nodes[i];
+        if (pNode->bExternal) continue;
+
+        size_t pending = std::count_if(pNode->deps.begin(), pNode->deps.end(), [&](size_t dep) {
+            return !nodes[dep]->bExternal;
+        });
+
+        pNode->pending = pending;
+        if (pending == 0) ready.push_back(i);
+
+        total += 1;
+    }
+
+    remaining = total;
+    for (size_t index : ready) {
+        launchCreate(index);
+    }
+
+    waitForNodes();
+
+    auto path = getCriticalPath();
+    if (!path.empty()) {
+        chrono::microseconds length = 0us;
+        std::string chain;
+        for (const auto& [pService, time] : path) {
+            if (!chain.empty()) chain += " -> ";
+            chain += fmt::format("{} ({}ms)", pService->getName(), chrono::duration_cast<chrono::milliseconds>(time).count());
+            length += time;
+        }
+
+        LOG_INFO("startup critical path {}ms: {}", chrono::duration_cast<chrono::milliseconds>(length).count(), chain);
+    }
+
+    if (pFatalError) {
+        std::rethrow_exception(pFatalError);
+    }
+}
+
+void ServiceGraph::launchCreate(size_t index) {
+    IService *pService = nodes[index]->pService;
+
+    if (isMainThreadService(pService)) {
+        mainQueue.enqueue(std::move(index));
+    } else {
+        ThreadService::enqueueWork(pService->getName(), [this, index] {
+            runCreate(index);
+        });
+    }
+}
+
+void ServiceGraph::runCreate(size_t index) {
+    auto& pNode = nodes[index];
+
+    pNode->start = chrono::steady_clock::now();
+
+    try {
+        pNode->pService->create();
+    } catch (...) {
+        std::lock_guard guard(errorLock);
+        if (!pFatalError) pFatalError = std::current_exception();
+    }
+
+    pNode->end = chrono::steady_clock::now();
+
+    for (size_t dependent : pNode->dependents) {
+        if (--nodes[dependent]->pending == 0) {
+            launchCreate(dependent);
+        }
+    }
+
+    finishNode();
+}
+
+// teardown
+
+void ServiceGraph::destroy() {
+    bTeardown = true;
+
+    std::vector<size_t> ready;
+    size_t total = 0;
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        auto& pNode = nodes[i];
+        if (pNode->bExternal) continue;
+
+        size_t pending = std::count_if(pNode->dependents.begin(), pNode->dependents.end(), [&](size_t dependent) {
+            return !nodes[dependent]->bExternal;
+        });
+
+        pNode->pending = pending;
+        if (pending == 0) ready.push_back(i);
+
+        total += 1;
+    }
+
+    remaining = total;
+    for (size_t index : ready) {
+        launchDestroy(index);
+    }
+
+    waitForNodes();
+}
+
+void ServiceGraph::launchDestroy(size_t index) {
+    IService *pService = nodes[index]->pService;
+
+    if (isMainThreadService(pService)) {
+        mainQueue.enqueue(std::move(index));
+    } else {
+        ThreadService::enqueueWork(pService->getName(), [this, index] {
+            runDestroy(index);
+        });
+    }
+}
+
+void ServiceGraph::runDestroy(size_t index) {
+    auto& pNode = nodes[index];
+
+    try {
+        pNode->pService->destroy();
+    } catch (const core::Error& err) {
+        LOG_ERROR("failed to unload {} service: {}", pNode->pService->getName(), err.what());
+    }
+
+    for (size_t dep : pNode->deps) {
+        auto& pDep = nodes[dep];
+        if (pDep->bExternal) continue;
+
+        if (--pDep->pending == 0) {
+            launchDestroy(dep);
+        }
+    }
+
+    finishNode();
+}
+
+// shared
+
+void ServiceGraph::finishNode() {
+    if (--remaining == 0) {
+        mainQueue.enqueue(size_t(kWakeMain));
+    }
+}
+
+void ServiceGraph::waitForNodes() {
+    // the main thread runs any services that need it while the workers handle the rest
+    while (remaining > 0) {
+        size_t index = kWakeMain;
+        if (!mainQueue.tryGetMessage(index, 10ms)) continue;
+        if (index == kWakeMain) continue;
+
+        if (bTeardown) {
+            runDestroy(index);
+        } else {
+            runCreate(index);
+        }
+    }
+
+    // drain the wake message if we left before reading it
+    size_t index = kWakeMain;
+    while (mainQueue.tryGetMessage(index)) { }
+}
+
+std::vector<ServiceGraph::TimingInfo> ServiceGraph::getCriticalPath() const {
+    if (nodes.empty()) return {};
+
+    auto getLatest = [&](auto&& range) {
+        size_t latest = SIZE_MAX;
+        for (size_t index : range) {
+            if (latest == SIZE_MAX || nodes[index]->end > nodes[latest]->end) {
+                latest = index;
+            }
+        }
+
+        return latest;
+    };
+
+    std::vector<size_t> all(nodes.size());
+    std::iota(all.begin(), all.end(), 0);
+
+    // walk backwards from whatever finished last through whichever dep held it up the longest
+    std::vector<TimingInfo> path;
+    for (size_t index = getLatest(all); index != SIZE_MAX; index = getLatest(nodes[index]->deps)) {
+        const auto& pNode = nodes[index];
+        auto time = chrono::duration_cast<chrono::microseconds>(pNode->end - pNode->start);
+        path.push_back({ pNode->pService, time });
+    }
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
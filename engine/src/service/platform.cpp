@@ -120,8 +120,8 @@ void PlatformService::destroyService() {
     UnregisterClassA(kClassName, gInstance);
 }
 
-void PlatformService::enqueue(std::string name, threads::WorkItem &&task) {
-    pWorkQueue->add(std::move(name), std::move(task));
+void PlatformService::enqueue(threads::WorkName name, threads::WorkItem &&task) {
+    pWorkQueue->add(name, std::move(task));
 }
 
 void PlatformService::setup(HINSTANCE hInstance, int nCmdShow, IWindowCallbacks *pCallbacks) {
@@ -1,9 +1,11 @@
 #include "engine/service/service.h"
+#include "engine/service/graph.h"
 
 #include "engine/core/error.h"
 #include "engine/core/panic.h"
 
 #include "engine/log/service.h"
+#include "engine/debug/service.h"
 #include "engine/threads/service.h"
 
 #include "engine/profile/profile.h"
@@ -91,39 +93,27 @@ static void stopService(IService *pService) {
 
 ServiceRuntime::ServiceRuntime(ServiceSpan services)
     : services(services)
+    , pGraph(new ServiceGraph(services))
 {
     LOG_INFO("loading {} services", services.size());
 
-    // TODO: rework this to be a bit more structured
-    // 1. load config service
-    // 2. load debug service
-    // 3. load thread service
-    // 4. load all other requested services
-
-    startService(DebugService::service());
-    startService(ConfigService::service());
-    startService(ThreadService::service());
-
-    for (IService *pService : services) {
-        ThreadService::enqueueWork(std::string(pService->getName()), [pService] {
-            pService->create();
-        });
+    // the debug, config and thread services are needed before
+    // anything can be scheduled, so they are loaded up front
+    for (IService *pService : { DebugService::service(), ConfigService::service(), ThreadService::service() }) {
+        auto start = std::chrono::steady_clock::now();
+        startService(pService);
+        pGraph->setExternal(pService, start, std::chrono::steady_clock::now());
     }
 
-    for (IService *pService : services) {
-        pService->waitUntilReady();
-    }
+    // everything else is launched as soon as its dependencies are ready
+    pGraph->create();
 
     LOG_INFO("loaded {} services", services.size());
 }
 
 ServiceRuntime::~ServiceRuntime() {
-    // TODO: need a taskgraph for service teardown
-    // also reverse dependency order
-    for (size_t i = services.size(); i-- > 0;) {
-        IService *pService = services[i];
-        pService->destroy();
-    }
+    // tear down in reverse dependency order, independent services in parallel
+    pGraph->destroy();
 
     stopService(ThreadService::service());
     stopService(ConfigService::service());
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "engine/threads/thread.h"
+
+#include "engine/core/unique.h"
+#include "engine/core/units.h"
+
+#include <memory>
+#include <span>
+#include <unordered_set>
+
+template<typename T>
+struct fmt::formatter<simcoe::threads::ScheduleMask, T> : fmt::formatter<std::string_view, T> {
+    auto format(const simcoe::threads::ScheduleMask& affinity, auto& ctx) {
+        auto it = fmt::format("(group = {}, mask = {:#b})", affinity.Group, uint64_t(affinity.Mask));
+        return fmt::formatter<std::string_view, T>::format(it, ctx);
+    }
+};
+
+namespace simcoe::threads::detail {
+    struct ThreadStartInfo {
+        ThreadStart start;
+        std::stop_token token;
+        std::string_view name;
+
+        // set on platforms where the thread id is only known once the thread is running.
+        // shared so the creator can stop waiting and leave while the thread is still notifying it
+        std::shared_ptr<std::atomic<ThreadId>> pStartId = nullptr;
+    };
+
+    // shared by every backend, runs the thread body and logs any errors
+    unsigned runThread(core::UniquePtr<ThreadStartInfo> pInfo, ThreadId id);
+
+    // platform specific
+    Geometry buildGeometry();
+
+    struct GeometryBuilder {
+        std::vector<Subcore> subcores;
+        std::vector<Core> cores;
+        std::vector<Chiplet> chiplets;
+        std::vector<Package> packages;
+        std::vector<Node> nodes;
+
+        static bool isOverlapping(ScheduleMask lhs, ScheduleMask rhs) {
+            return lhs.Group == rhs.Group && (lhs.Mask & rhs.Mask);
+        }
+
+        static bool isOverlapping(const Subcore& item, ScheduleMask affinity) {
+            return isOverlapping(item.mask, affinity);
+        }
+
+        template<typename Item>
+        static bool isOverlapping(const Item& item, ScheduleMask affinity) {
+            return std::any_of(item.masks.begin(), item.masks.end(), [&](ScheduleMask mask) {
+                return isOverlapping(mask, affinity);
+            });
+        }
+
+        template<typename Index, typename Item>
+        static void getItemByMask(std::vector<Index>& ids, std::span<const Item> items, ScheduleMask affinity) {
+            std::unordered_set<Index> uniqueIds;
+            for (size_t i = 0; i < items.size(); ++i) {
+                if (isOverlapping(items[i], affinity)) {
+                    uniqueIds.insert(core::enumCast<Index>(i));
+                }
+            }
+
+            std::transform(uniqueIds.begin(), uniqueIds.end(), std::back_inserter(ids), [](Index id) {
+                return id;
+            });
+        }
+
+        void getCoresByMask(CoreIndices& ids, ScheduleMask affinity) const {
+            getItemByMask<CoreIndex, Core>(ids, cores, affinity);
+        }
+
+        void getSubcoresByMask(SubcoreIndices& ids, ScheduleMask affinity) const {
+            getItemByMask<SubcoreIndex, Subcore>(ids, subcores, affinity);
+        }
+
+        void getChipletsByMask(ChipletIndices& ids, ScheduleMask affinity) const {
+            getItemByMask<ChipletIndex, Chiplet>(ids, chiplets, affinity);
+        }
+
+        Geometry build() {
+            return {
+                .subcores = std::move(subcores),
+                .cores = std::move(cores),
+                .chiplets = std::move(chiplets),
+                .packages = std::move(packages),
+                .nodes = std::move(nodes)
+            };
+        }
+    };
+}
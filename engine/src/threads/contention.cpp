@@ -0,0 +1,253 @@
+#include "engine/threads/contention.h"
+#include "engine/threads/service.h"
+
+#include "engine/log/service.h"
+
+#include <bit>
+#include <fstream>
+#include <map>
+
+using namespace simcoe;
+using namespace simcoe::mt;
+
+using LockAtomicHistogram = std::array<std::atomic_size_t, kLockBuckets>;
+
+struct detail::LockCounters {
+    std::string name;
+
+    std::atomic_size_t acquires = 0;
+    std::atomic_size_t shared = 0;
+    std::atomic_size_t contended = 0;
+
+    std::atomic_uint64_t totalWait = 0;
+    std::atomic_uint64_t maxWait = 0;
+    std::atomic_uint64_t totalHold = 0;
+    std::atomic_uint64_t maxHold = 0;
+
+    LockAtomicHistogram waitHistogram = {};
+    LockAtomicHistogram holdHistogram = {};
+
+    // only touched when a thread has to wait, so the uncontended path stays lock free.
+    // these are std types on purpose, an mt::Mutex here would profile itself
+    std::mutex waiterLock;
+    std::unordered_map<threads::ThreadId, LockWaiter> waiters;
+};
+
+namespace {
+    constexpr size_t kFirstBucketBits = 8;
+
+    using LockRegistry = std::map<std::string, std::unique_ptr<detail::LockCounters>, std::less<>>;
+
+    // locks are created during static init, so the registry cant be a global
+    std::mutex& getRegistryLock() {
+        static std::mutex lock;
+        return lock;
+    }
+
+    LockRegistry& getRegistry() {
+        static LockRegistry registry;
+        return registry;
+    }
+
+    size_t getBucket(uint64_t time) {
+        size_t bits = std::bit_width(time);
+        if (bits <= kFirstBucketBits) return 0;
+
+        return std::min(bits - kFirstBucketBits, kLockBuckets - 1);
+    }
+
+    void updateMax(std::atomic_uint64_t& max, uint64_t value) {
+        uint64_t current = max.load(std::memory_order_relaxed);
+        while (current < value && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) { }
+    }
+
+    void copyHistogram(LockHistogram& out, const LockAtomicHistogram& histogram) {
+        for (size_t i = 0; i < kLockBuckets; i++) {
+            out[i] = histogram[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    void resetHistogram(LockAtomicHistogram& histogram) {
+        for (auto& bucket : histogram) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::string formatTime(uint64_t time) {
+        if (time < 1'000) return fmt::format("{}ns", time);
+        if (time < 1'000'000) return fmt::format("{:.1f}us", double(time) / 1'000.0);
+        if (time < 1'000'000'000) return fmt::format("{:.1f}ms", double(time) / 1'000'000.0);
+        return fmt::format("{:.2f}s", double(time) / 1'000'000'000.0);
+    }
+
+    void writeHistogram(std::ofstream& os, std::string_view label, const LockHistogram& histogram) {
+        os << fmt::format("  {}:\n", label);
+        for (size_t i = 0; i < kLockBuckets; i++) {
+            if (histogram[i] == 0) continue;
+
+            uint64_t limit = getLockBucketLimit(i);
+            std::string bound = (limit == UINT64_MAX) ? fmt::format(">{}", formatTime(getLockBucketLimit(i - 1))) : fmt::format("<{}", formatTime(limit));
+            os << fmt::format("    {:>10} {}\n", bound, histogram[i]);
+        }
+    }
+}
+
+// recording
+
+detail::LockCounters *detail::getLockCounters(std::string_view name) {
+    std::lock_guard guard(getRegistryLock());
+    LockRegistry& registry = getRegistry();
+
+    if (auto it = registry.find(name); it != registry.end()) {
+        return it->second.get();
+    }
+
+    auto pCounters = std::make_unique<LockCounters>();
+    pCounters->name = std::string(name);
+
+    auto *pResult = pCounters.get();
+    registry.emplace(std::string(name), std::move(pCounters));
+    return pResult;
+}
+
+uint64_t detail::getLockTime() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+void detail::addAcquire(LockCounters *pCounters, bool bShared) {
+    auto& counter = bShared ? pCounters->shared : pCounters->acquires;
+    counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+void detail::addContended(LockCounters *pCounters, SM_UNUSED bool bShared, uint64_t wait) {
+    pCounters->contended.fetch_add(1, std::memory_order_relaxed);
+    pCounters->totalWait.fetch_add(wait, std::memory_order_relaxed);
+    pCounters->waitHistogram[getBucket(wait)].fetch_add(1, std::memory_order_relaxed);
+    updateMax(pCounters->maxWait, wait);
+
+    auto tid = threads::getCurrentThreadId();
+
+    std::lock_guard guard(pCounters->waiterLock);
+    auto& waiter = pCounters->waiters[tid];
+    waiter.id = tid;
+    waiter.contended += 1;
+    waiter.wait += wait;
+}
+
+void detail::addHold(LockCounters *pCounters, uint64_t hold) {
+    pCounters->totalHold.fetch_add(hold, std::memory_order_relaxed);
+    pCounters->holdHistogram[getBucket(hold)].fetch_add(1, std::memory_order_relaxed);
+    updateMax(pCounters->maxHold, hold);
+}
+
+// snapshots
+
+uint64_t mt::getLockBucketLimit(size_t index) {
+    if (index >= kLockBuckets - 1) return UINT64_MAX;
+
+    return 1ull << (index + kFirstBucketBits);
+}
+
+std::vector<LockStats> mt::getLockStats(size_t maxWaiters) {
+    std::vector<LockStats> result;
+
+    std::lock_guard guard(getRegistryLock());
+    for (const auto& [name, pCounters] : getRegistry()) {
+        LockStats stats = {
+            .name = name,
+            .acquires = pCounters->acquires.load(std::memory_order_relaxed),
+            .shared = pCounters->shared.load(std::memory_order_relaxed),
+            .contended = pCounters->contended.load(std::memory_order_relaxed),
+            .totalWait = pCounters->totalWait.load(std::memory_order_relaxed),
+            .maxWait = pCounters->maxWait.load(std::memory_order_relaxed),
+            .totalHold = pCounters->totalHold.load(std::memory_order_relaxed),
+            .maxHold = pCounters->maxHold.load(std::memory_order_relaxed)
+        };
+
+        copyHistogram(stats.waitHistogram, pCounters->waitHistogram);
+        copyHistogram(stats.holdHistogram, pCounters->holdHistogram);
+
+        {
+            std::lock_guard waiterGuard(pCounters->waiterLock);
+            for (const auto& [id, waiter] : pCounters->waiters) {
+                stats.waiters.push_back(waiter);
+            }
+        }
+
+        std::sort(stats.waiters.begin(), stats.waiters.end(), [](const auto& a, const auto& b) {
+            return a.wait > b.wait;
+        });
+
+        if (stats.waiters.size() > maxWaiters) {
+            stats.waiters.resize(maxWaiters);
+        }
+
+        result.push_back(std::move(stats));
+    }
+
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.totalWait > b.totalWait;
+    });
+
+    return result;
+}
+
+void mt::resetLockStats() {
+    std::lock_guard guard(getRegistryLock());
+    for (auto& [name, pCounters] : getRegistry()) {
+        pCounters->acquires = 0;
+        pCounters->shared = 0;
+        pCounters->contended = 0;
+        pCounters->totalWait = 0;
+        pCounters->maxWait = 0;
+        pCounters->totalHold = 0;
+        pCounters->maxHold = 0;
+
+        resetHistogram(pCounters->waitHistogram);
+        resetHistogram(pCounters->holdHistogram);
+
+        std::lock_guard waiterGuard(pCounters->waiterLock);
+        pCounters->waiters.clear();
+    }
+}
+
+bool mt::dumpLockStats(const fs::path& path) {
+    std::ofstream os(path);
+    if (!os.is_open()) {
+        LOG_ERROR("failed to open lock profile {}", path.string());
+        return false;
+    }
+
+    auto stats = getLockStats(SIZE_MAX);
+    for (const LockStats& lock : stats) {
+        size_t total = lock.acquires + lock.shared;
+        if (total == 0) continue;
+
+        double rate = double(lock.contended) / double(total) * 100.0;
+        os << fmt::format("lock {}\n", lock.name);
+        os << fmt::format("  acquires: {} exclusive, {} shared, {} contended ({:.2f}%)\n", lock.acquires, lock.shared, lock.contended, rate);
+        os << fmt::format("  wait: total {}, max {}\n", formatTime(lock.totalWait), formatTime(lock.maxWait));
+        os << fmt::format("  hold: total {}, max {}\n", formatTime(lock.totalHold), formatTime(lock.maxHold));
+
+        if (lock.contended > 0) {
+            writeHistogram(os, "wait histogram", lock.waitHistogram);
+        }
+
+        if (lock.acquires > 0) {
+            writeHistogram(os, "hold histogram", lock.holdHistogram);
+        }
+
+        if (!lock.waiters.empty()) {
+            os << "  waiters:\n";
+            for (const LockWaiter& waiter : lock.waiters) {
+                os << fmt::format("    {} ({}): {} waits, {}\n", threads::getThreadName(waiter.id), waiter.id, waiter.contended, formatTime(waiter.wait));
+            }
+        }
+
+        os << "\n";
+    }
+
+    LOG_INFO("wrote lock profile for {} locks to {}", stats.size(), path.string());
+    return true;
+}
@@ -0,0 +1,126 @@
+#include "engine/threads/epoch.h"
+
+#include <algorithm>
+#include <thread>
+
+using namespace simcoe;
+using namespace simcoe::mt;
+
+namespace {
+    // where this thread last found a free slot, so it usually lands on the same cache line
+    thread_local size_t tlsSlotHint = std::hash<std::thread::id>{}(std::this_thread::get_id());
+}
+
+Epoch::Epoch(std::string_view name, size_t maxReaders)
+    : maxReaders(maxReaders)
+    , pSlots(new Slot[maxReaders])
+    , lock(name)
+{
+    SM_ASSERTF(maxReaders > 0, "epoch {} needs at least one reader slot", name);
+}
+
+Epoch::~Epoch() {
+    for (Retired& item : retired) {
+        item.deleter();
+    }
+}
+
+size_t Epoch::enter() {
+    size_t start = tlsSlotHint % maxReaders;
+
+    while (true) {
+        for (size_t i = 0; i < maxReaders; i++) {
+            size_t index = (start + i) % maxReaders;
+
+            // a reader that pins a stale epoch is still safe, it just holds back the next advance
+            uint64_t expected = 0;
+            if (pSlots[index].epoch.compare_exchange_strong(expected, current.load())) {
+                tlsSlotHint = index;
+                return index;
+            }
+        }
+
+        // every slot is taken, wait for someone to leave
+        std::this_thread::yield();
+    }
+}
+
+void Epoch::exit(size_t slot) {
+    SM_ASSERTF(slot < maxReaders, "epoch slot {} out of range", slot);
+    pSlots[slot].epoch.store(0, std::memory_order_release);
+}
+
+void Epoch::retire(Deleter&& deleter) {
+    {
+        std::lock_guard guard(lock);
+        retired.push_back({ current.load(), std::move(deleter) });
+    }
+
+    collect();
+}
+
+bool Epoch::tryAdvance() {
+    uint64_t epoch = current.load();
+
+    for (size_t i = 0; i < maxReaders; i++) {
+        uint64_t pinned = pSlots[i].epoch.load();
+        if (pinned != 0 && pinned != epoch) return false;
+    }
+
+    return current.compare_exchange_strong(epoch, epoch + 1);
+}
+
+size_t Epoch::collect() {
+    tryAdvance();
+
+    uint64_t epoch = current.load();
+    std::vector<Retired> ready;
+
+    {
+        std::lock_guard guard(lock);
+        auto it = std::partition(retired.begin(), retired.end(), [&](const Retired& item) {
+            return item.epoch + 2 > epoch;
+        });
+
+        ready.insert(ready.end(), std::make_move_iterator(it), std::make_move_iterator(retired.end()));
+        retired.erase(it, retired.end());
+    }
+
+    // deleters run outside the lock, they might retire something themselves
+    for (Retired& item : ready) {
+        item.deleter();
+    }
+
+    reclaimed.fetch_add(ready.size(), std::memory_order_relaxed);
+    return ready.size();
+}
+
+void Epoch::synchronize() {
+    while (true) {
+        collect();
+
+        {
+            std::lock_guard guard(lock);
+            if (retired.empty()) return;
+        }
+
+        std::this_thread::yield();
+    }
+}
+
+EpochStats Epoch::getStats() const {
+    EpochStats stats = {
+        .epoch = current.load(std::memory_order_relaxed),
+        .reclaimed = reclaimed.load(std::memory_order_relaxed)
+    };
+
+    for (size_t i = 0; i < maxReaders; i++) {
+        if (pSlots[i].epoch.load(std::memory_order_relaxed) != 0) {
+            stats.readers += 1;
+        }
+    }
+
+    std::lock_guard guard(lock);
+    stats.pending = retired.size();
+    return stats;
+}
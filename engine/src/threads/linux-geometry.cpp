@@ -0,0 +1,351 @@
+#include "common.h"
+
+#include "engine/core/filesystem.h"
+
+#include <charconv>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <set>
+#include <thread>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+namespace {
+    using detail::GeometryBuilder;
+
+    using CpuList = std::vector<size_t>;
+
+    const fs::path kCpuRoot = "/sys/devices/system/cpu";
+    const fs::path kNodeRoot = "/sys/devices/system/node";
+
+    constexpr size_t kGroupSize = 64;
+
+    std::optional<std::string> readLine(const fs::path& path) {
+        std::ifstream file{path};
+        std::string line;
+        if (!file.is_open() || !std::getline(file, line)) {
+            return std::nullopt;
+        }
+
+        return line;
+    }
+
+    std::optional<uint64_t> readValue(const fs::path& path) {
+        auto line = readLine(path);
+        if (!line.has_value()) return std::nullopt;
+
+        uint64_t value = 0;
+        const char *pBegin = line->data();
+        const char *pEnd = pBegin + line->size();
+        if (std::from_chars(pBegin, pEnd, value).ec != std::errc()) {
+            return std::nullopt;
+        }
+
+        return value;
+    }
+
+    // parses the kernel cpu list format, e.g. "0-3,8,10-11"
+    CpuList parseCpuList(std::string_view text) {
+        CpuList cpus;
+
+        while (!text.empty()) {
+            size_t comma = text.find(',');
+            std::string_view range = text.substr(0, comma);
+            text = (comma == std::string_view::npos) ? std::string_view{} : text.substr(comma + 1);
+
+            size_t first = 0;
+            size_t last = 0;
+            auto [pNext, ec] = std::from_chars(range.data(), range.data() + range.size(), first);
+            if (ec != std::errc()) continue;
+
+            last = first;
+            if (pNext != range.data() + range.size() && *pNext == '-') {
+                std::from_chars(pNext + 1, range.data() + range.size(), last);
+            }
+
+            for (size_t cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+
+        return cpus;
+    }
+
+    std::optional<CpuList> readCpuList(const fs::path& path) {
+        auto line = readLine(path);
+        if (!line.has_value()) return std::nullopt;
+
+        return parseCpuList(*line);
+    }
+
+    ScheduleMask getCpuMask(size_t cpu) {
+        return {
+            .Mask = 1ull << (cpu % kGroupSize),
+            .Group = uint16_t(cpu / kGroupSize)
+        };
+    }
+
+    // split a cpu list into one mask per group, the same way windows reports GroupMasks
+    std::vector<ScheduleMask> getGroupMasks(const CpuList& cpus) {
+        std::map<uint16_t, uint64_t> groups;
+        for (size_t cpu : cpus) {
+            ScheduleMask mask = getCpuMask(cpu);
+            groups[mask.Group] |= mask.Mask;
+        }
+
+        std::vector<ScheduleMask> masks;
+        for (auto [group, mask] : groups) {
+            masks.push_back({ .Mask = mask, .Group = group });
+        }
+
+        return masks;
+    }
+
+    fs::path getCpuPath(size_t cpu) {
+        return kCpuRoot / fmt::format("cpu{}", cpu);
+    }
+
+    // everything that shares an l3 cache is treated as a chiplet
+    std::optional<CpuList> getSharedL3(size_t cpu) {
+        std::error_code ec;
+        fs::path cache = getCpuPath(cpu) / "cache";
+        for (const auto& entry : fs::directory_iterator(cache, ec)) {
+            if (!entry.path().filename().string().starts_with("index")) continue;
+
+            if (readValue(entry.path() / "level") != 3) continue;
+
+            return readCpuList(entry.path() / "shared_cpu_list");
+        }
+
+        return std::nullopt;
+    }
+
+    // cpu_capacity is only present on heterogeneous systems, cpufreq is nearly always present.
+    // either one is enough to tell big cores from little cores.
+    uint64_t getCoreClass(size_t cpu) {
+        fs::path path = getCpuPath(cpu);
+        if (auto capacity = readValue(path / "cpu_capacity")) return *capacity;
+        if (auto freq = readValue(path / "cpufreq" / "cpuinfo_max_freq")) return *freq;
+
+        return 0;
+    }
+
+    // the kernel exposes a few ways of ranking cores, prefer the most detailed one available.
+    // acpi cppc gives a per core ranking on parts with preferred cores.
+    uint64_t getCorePerformance(size_t cpu) {
+        fs::path path = getCpuPath(cpu);
+        if (auto perf = readValue(path / "acpi_cppc" / "highest_perf")) return *perf;
+
+        return getCoreClass(cpu);
+    }
+
+    // the position of @param value in @param values sorted fastest first
+    template<typename T>
+    T getRank(const std::set<uint64_t, std::greater<>>& values, uint64_t value) {
+        return T(std::distance(values.begin(), values.find(value)));
+    }
+
+    struct SysfsLayout {
+        SysfsLayout(GeometryBuilder *pBuilder)
+            : pBuilder(pBuilder)
+        { }
+
+        GeometryBuilder *pBuilder;
+
+        void addCores(const CpuList& online) {
+            std::set<size_t> seen;
+
+            for (size_t cpu : online) {
+                if (seen.contains(cpu)) continue;
+
+                // without topology info treat every cpu as its own core
+                CpuList siblings = readCpuList(getCpuPath(cpu) / "topology" / "thread_siblings_list").value_or(CpuList{ cpu });
+
+                SubcoreIndices subcoreIds;
+                CpuList cpus;
+                for (size_t sibling : siblings) {
+                    if (!std::binary_search(online.begin(), online.end(), sibling)) continue;
+                    if (!seen.insert(sibling).second) continue;
+
+                    pBuilder->subcores.push_back({
+                        .mask = getCpuMask(sibling)
+                    });
+
+                    subcoreIds.push_back(core::enumCast<SubcoreIndex>(pBuilder->subcores.size() - 1));
+                    cpus.push_back(sibling);
+                }
+
+                if (cpus.empty()) continue;
+
+                // filled in by addPerformance once every core is known
+                pBuilder->cores.push_back({
+                    .schedule = 0,
+                    .efficiency = 0,
+                    .masks = getGroupMasks(cpus),
+                    .subcoreIds = subcoreIds
+                });
+
+                firstCpus.push_back(cpus[0]);
+            }
+        }
+
+        void addChiplets(const CpuList& online) {
+            std::set<CpuList> caches;
+            for (size_t cpu : online) {
+                if (auto shared = getSharedL3(cpu)) {
+                    caches.insert(*shared);
+                }
+            }
+
+            for (const CpuList& cpus : caches) {
+                CoreIndices coreIds;
+                auto masks = getGroupMasks(cpus);
+                for (ScheduleMask mask : masks) {
+                    pBuilder->getCoresByMask(coreIds, mask);
+                }
+
+                if (coreIds.empty()) continue;
+
+                pBuilder->chiplets.push_back({
+                    .masks = masks,
+                    .coreIds = coreIds
+                });
+            }
+        }
+
+        void addPackages(const CpuList& online) {
+            std::set<CpuList> packages;
+            for (size_t cpu : online) {
+                fs::path topology = getCpuPath(cpu) / "topology";
+
+                // package_cpus_list replaced core_siblings_list in linux 5.9
+                auto cpus = readCpuList(topology / "package_cpus_list");
+                if (!cpus.has_value()) cpus = readCpuList(topology / "core_siblings_list");
+
+                packages.insert(cpus.value_or(online));
+            }
+
+            for (const CpuList& cpus : packages) {
+                SubcoreIndices subcoreIds;
+                CoreIndices coreIds;
+                ChipletIndices chipletIds;
+
+                auto masks = getGroupMasks(cpus);
+                for (ScheduleMask mask : masks) {
+                    pBuilder->getCoresByMask(coreIds, mask);
+                    pBuilder->getSubcoresByMask(subcoreIds, mask);
+                    pBuilder->getChipletsByMask(chipletIds, mask);
+                }
+
+                if (coreIds.empty()) continue;
+
+                pBuilder->packages.push_back({
+                    .masks = masks,
+                    .cores = coreIds,
+                    .subcores = subcoreIds,
+                    .chiplets = chipletIds
+                });
+            }
+        }
+
+        // kernels without numa support have no node directory, everything is on node 0 then
+        void addNodes(const CpuList& online) {
+            std::map<uint32_t, CpuList> nodes;
+
+            std::error_code ec;
+            for (const auto& entry : fs::directory_iterator(kNodeRoot, ec)) {
+                std::string name = entry.path().filename().string();
+                if (!name.starts_with("node")) continue;
+
+                uint32_t id = 0;
+                if (std::from_chars(name.data() + 4, name.data() + name.size(), id).ec != std::errc()) continue;
+
+                if (auto cpus = readCpuList(entry.path() / "cpulist")) {
+                    nodes[id] = *cpus;
+                }
+            }
+
+            if (nodes.empty()) {
+                nodes[0] = online;
+            }
+
+            for (const auto& [id, cpus] : nodes) {
+                SubcoreIndices subcoreIds;
+                CoreIndices coreIds;
+                ChipletIndices chipletIds;
+
+                // memory only nodes have no cpus and nothing to schedule on them
+                auto masks = getGroupMasks(cpus);
+                for (ScheduleMask mask : masks) {
+                    pBuilder->getCoresByMask(coreIds, mask);
+                    pBuilder->getSubcoresByMask(subcoreIds, mask);
+                    pBuilder->getChipletsByMask(chipletIds, mask);
+                }
+
+                if (coreIds.empty()) continue;
+
+                pBuilder->nodes.push_back({
+                    .id = id,
+                    .masks = masks,
+                    .cores = coreIds,
+                    .subcores = subcoreIds,
+                    .chiplets = chipletIds
+                });
+            }
+        }
+
+        // windows hands us scheduling and efficiency classes directly,
+        // on linux we derive them by ranking the cores against each other
+        void addPerformance() {
+            std::vector<uint64_t> perf;
+            std::vector<uint64_t> classes;
+            std::set<uint64_t, std::greater<>> uniquePerf;
+            std::set<uint64_t, std::greater<>> uniqueClasses;
+
+            for (size_t cpu : firstCpus) {
+                uint64_t value = getCorePerformance(cpu);
+                uint64_t kind = getCoreClass(cpu);
+
+                perf.push_back(value);
+                classes.push_back(kind);
+                uniquePerf.insert(value);
+                uniqueClasses.insert(kind);
+            }
+
+            for (size_t i = 0; i < pBuilder->cores.size(); ++i) {
+                Core& item = pBuilder->cores[i];
+                item.schedule = getRank<uint16_t>(uniquePerf, perf[i]); // fastest core is 0
+                item.efficiency = getRank<uint8_t>(uniqueClasses, classes[i]); // slowest class is the most efficient
+            }
+        }
+
+    private:
+        // the first logical cpu of each core, indexed the same as cores
+        CpuList firstCpus;
+    };
+}
+
+Geometry detail::buildGeometry() {
+    GeometryBuilder builder;
+    SysfsLayout layout{&builder};
+
+    // fall back to whatever the process can see if sysfs isnt mounted
+    CpuList online = readCpuList(kCpuRoot / "online").value_or(CpuList{});
+    if (online.empty()) {
+        for (size_t i = 0; i < std::thread::hardware_concurrency(); ++i) {
+            online.push_back(i);
+        }
+    }
+
+    std::sort(online.begin(), online.end());
+
+    layout.addCores(online);
+    layout.addChiplets(online);
+    layout.addPackages(online);
+    layout.addNodes(online);
+    layout.addPerformance();
+
+    return builder.build();
+}
@@ -0,0 +1,53 @@
+#include "engine/threads/memory.h"
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+namespace {
+    constexpr size_t kMaskBits = sizeof(unsigned long) * 8;
+
+    // the kernel drops the last bit of maxnode, so leave a spare bit past the node we want
+    struct NodeMask {
+        NodeMask(uint32_t node)
+            : bits((node + 1) / kMaskBits + 1)
+        {
+            bits[node / kMaskBits] |= 1ul << (node % kMaskBits);
+        }
+
+        const unsigned long *data() const { return bits.data(); }
+        unsigned long getMaxNode() const { return bits.size() * kMaskBits; }
+
+    private:
+        std::vector<unsigned long> bits;
+    };
+}
+
+size_t detail::getPageSize() {
+    static const size_t kPageSize = size_t(sysconf(_SC_PAGESIZE));
+    return kPageSize;
+}
+
+// glibc has no wrappers for the numa syscalls and we dont want to depend on libnuma for two calls.
+// prefer rather than bind, running out of memory on one node should spill rather than fail
+void *detail::allocateNodePages(size_t size, uint32_t node, bool& bBound) {
+    void *pMemory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pMemory == MAP_FAILED) return nullptr;
+
+    NodeMask mask{node};
+    bBound = syscall(SYS_mbind, pMemory, size, MPOL_PREFERRED, mask.data(), mask.getMaxNode(), 0) == 0;
+    return pMemory;
+}
+
+void detail::freeNodePages(void *pMemory, size_t size) {
+    munmap(pMemory, size);
+}
+
+bool detail::setThreadMemoryNode(uint32_t node) {
+    NodeMask mask{node};
+    return syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(), mask.getMaxNode()) == 0;
+}
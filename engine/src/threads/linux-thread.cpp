@@ -0,0 +1,115 @@
+#include "common.h"
+
+#include "engine/core/error.h"
+#include "engine/threads/service.h"
+#include "engine/log/service.h"
+
+#include <cstring>
+#include <sched.h>
+#include <unistd.h>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+namespace {
+    // linux limits thread names to 16 bytes including the null terminator
+    constexpr size_t kMaxNameLength = 15;
+
+    cpu_set_t getCpuSet(ScheduleMask mask) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+
+        for (size_t bit = 0; bit < 64; ++bit) {
+            if (mask.Mask & (1ull << bit)) {
+                CPU_SET(size_t(mask.Group) * 64 + bit, &cpus);
+            }
+        }
+
+        return cpus;
+    }
+
+    void checkError(int err, std::string_view msg) {
+        if (err != 0) {
+            core::throwFatal("{} failed: {} ({})", msg, std::strerror(err), err);
+        }
+    }
+}
+
+void *ThreadHandle::threadThunk(void *pParameter) {
+    auto *pInfo = static_cast<detail::ThreadStartInfo*>(pParameter);
+
+    std::string name{pInfo->name.substr(0, kMaxNameLength)};
+    pthread_setname_np(pthread_self(), name.c_str());
+
+    // let the creating thread know our id, we hold our own reference to the id
+    // so it stays alive until we are done notifying even if the creator has moved on
+    ThreadId id = threads::getCurrentThreadId();
+    pInfo->pStartId->store(id);
+    pInfo->pStartId->notify_one();
+    pInfo->pStartId.reset();
+
+    uintptr_t result = detail::runThread(pInfo, id);
+    return reinterpret_cast<void*>(result);
+}
+
+ThreadHandle::ThreadHandle(ThreadInfo&& info)
+    : type(info.type)
+    , mask(info.mask)
+    , name(info.name)
+{
+    // the tid is only known once the thread is running, the thunk publishes it here
+    auto pStartId = std::make_shared<std::atomic<ThreadId>>(0);
+
+    auto *pStart = new detail::ThreadStartInfo {
+        .start = std::move(info.start),
+        .token = stopper.get_token(),
+        .name = name,
+        .pStartId = pStartId
+    };
+
+    pthread_attr_t attr;
+    checkError(pthread_attr_init(&attr), "pthread_attr_init");
+
+    // an empty mask means the thread may run anywhere
+    if (mask.Mask != 0) {
+        cpu_set_t cpus = getCpuSet(mask);
+        checkError(pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpus), fmt::format("pthread_attr_setaffinity_np with mask {}", mask));
+    }
+
+    int err = pthread_create(&hThread, &attr, ThreadHandle::threadThunk, pStart); // pStart deleted by threadThunk
+    pthread_attr_destroy(&attr);
+
+    if (err != 0) {
+        delete pStart;
+        checkError(err, "pthread_create");
+    }
+
+    pStartId->wait(0);
+    id = pStartId->load();
+
+    LOG_INFO("created thread (name={}, id={:#06x}) with mask {}", name, id, mask);
+}
+
+ThreadHandle::~ThreadHandle() {
+    if (bJoined) return;
+
+    join();
+}
+
+void ThreadHandle::join() {
+    stopper.request_stop();
+
+    // unlike WaitForSingleObject joining twice is undefined
+    if (bJoined) return;
+
+    int err = pthread_join(hThread, nullptr);
+    if (err != 0) {
+        core::throwFatal("pthread_join failed for thread (name={}, id={:#06x}): {}", name, id, std::strerror(err));
+    }
+
+    bJoined = true;
+}
+
+ThreadId threads::getCurrentThreadId() {
+    return gettid();
+}
@@ -0,0 +1,178 @@
+#include "engine/threads/memory.h"
+
+#include "engine/core/panic.h"
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+namespace {
+    struct NodeHeap {
+        NodeHeap(uint32_t node)
+            : pages(node)
+            , pool(&pages)
+        { }
+
+        NodePageResource pages;
+        std::pmr::synchronized_pool_resource pool;
+    };
+
+    // written once by setupMemory before any thread is scheduled, read only after that.
+    // heaps are never freed, thread local data can outlive the thread service
+    std::vector<NodeHeap*> gNodeHeaps;
+    std::vector<NodeIndex> gSubcoreNodes;
+    std::vector<NodeIndex> gChipletNodes;
+    std::vector<NodeIndex> gPackageNodes;
+
+    thread_local NodeIndex tlsCurrentNode = NodeIndex::eInvalid;
+
+    size_t roundToPage(size_t size) {
+        size_t page = detail::getPageSize();
+        return (size + page - 1) / page * page;
+    }
+
+    template<typename T>
+    NodeIndex lookupNode(const std::vector<NodeIndex>& nodes, T index) {
+        size_t i = size_t(index);
+        return (i < nodes.size()) ? nodes[i] : NodeIndex::eInvalid;
+    }
+}
+
+// node pages
+
+NodePageResource::NodePageResource(uint32_t node)
+    : node(node)
+{ }
+
+void *NodePageResource::do_allocate(size_t bytes, size_t align) {
+    SM_ASSERTF(align <= detail::getPageSize(), "alignment {} is larger than a page", align);
+
+    size_t size = roundToPage(bytes);
+
+    bool bPlaced = true;
+    void *pMemory = detail::allocateNodePages(size, node, bPlaced);
+    if (pMemory == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    if (!bPlaced) {
+        bBound = false;
+    }
+
+    reserved.fetch_add(size, std::memory_order_relaxed);
+    allocs.fetch_add(1, std::memory_order_relaxed);
+    return pMemory;
+}
+
+void NodePageResource::do_deallocate(void *pMemory, size_t bytes, size_t) {
+    size_t size = roundToPage(bytes);
+    detail::freeNodePages(pMemory, size);
+
+    reserved.fetch_sub(size, std::memory_order_relaxed);
+    frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool NodePageResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+NodeMemoryStats NodePageResource::getStats() const {
+    return {
+        .id = node,
+        .bBound = bBound.load(std::memory_order_relaxed),
+        .reserved = reserved.load(std::memory_order_relaxed),
+        .allocs = allocs.load(std::memory_order_relaxed),
+        .frees = frees.load(std::memory_order_relaxed)
+    };
+}
+
+// topology
+
+void threads::setupMemory(const Geometry& geometry) {
+    SM_ASSERTF(gNodeHeaps.empty(), "memory has already been setup");
+
+    gSubcoreNodes.resize(geometry.subcores.size(), NodeIndex::eInvalid);
+    gChipletNodes.resize(geometry.chiplets.size(), NodeIndex::eInvalid);
+    gPackageNodes.resize(geometry.packages.size(), NodeIndex::eInvalid);
+
+    for (size_t i = 0; i < geometry.nodes.size(); ++i) {
+        const Node& node = geometry.nodes[i];
+        gNodeHeaps.push_back(new NodeHeap(node.id));
+
+        for (SubcoreIndex subcore : node.subcores) {
+            gSubcoreNodes[size_t(subcore)] = NodeIndex(i);
+        }
+
+        // a chiplet should never span nodes, but if it does the first one wins
+        for (ChipletIndex chiplet : node.chiplets) {
+            if (gChipletNodes[size_t(chiplet)] == NodeIndex::eInvalid) {
+                gChipletNodes[size_t(chiplet)] = NodeIndex(i);
+            }
+        }
+    }
+
+    // packages can hold several nodes, use the one their first core is in
+    for (size_t i = 0; i < geometry.packages.size(); ++i) {
+        const Package& package = geometry.packages[i];
+        if (package.subcores.empty()) continue;
+
+        gPackageNodes[i] = lookupNode(gSubcoreNodes, package.subcores[0]);
+    }
+}
+
+NodeIndex threads::getSubcoreNode(SubcoreIndex subcore) {
+    return lookupNode(gSubcoreNodes, subcore);
+}
+
+std::pmr::memory_resource *threads::getNodeMemory(NodeIndex node) {
+    size_t index = size_t(node);
+    if (index >= gNodeHeaps.size()) {
+        return std::pmr::get_default_resource();
+    }
+
+    return &gNodeHeaps[index]->pool;
+}
+
+std::pmr::memory_resource *threads::getPackageMemory(PackageIndex package) {
+    return getNodeMemory(lookupNode(gPackageNodes, package));
+}
+
+std::pmr::memory_resource *threads::getChipletMemory(ChipletIndex chiplet) {
+    return getNodeMemory(lookupNode(gChipletNodes, chiplet));
+}
+
+// threads
+
+void threads::setCurrentNode(NodeIndex node) {
+    tlsCurrentNode = node;
+
+    size_t index = size_t(node);
+    if (index < gNodeHeaps.size()) {
+        detail::setThreadMemoryNode(gNodeHeaps[index]->pages.getNode());
+    }
+}
+
+NodeIndex threads::getCurrentNode() {
+    return tlsCurrentNode;
+}
+
+std::pmr::memory_resource *threads::getLocalMemory() {
+    return getNodeMemory(tlsCurrentNode);
+}
+
+void threads::firstTouch(void *pMemory, size_t size) {
+    size_t page = detail::getPageSize();
+    auto *pBytes = static_cast<volatile char*>(pMemory);
+
+    for (size_t offset = 0; offset < size; offset += page) {
+        pBytes[offset] = 0;
+    }
+}
+
+std::vector<NodeMemoryStats> threads::getNodeMemoryStats() {
+    std::vector<NodeMemoryStats> result;
+    for (const NodeHeap *pHeap : gNodeHeaps) {
+        result.push_back(pHeap->pages.getStats());
+    }
+
+    return result;
+}
@@ -12,7 +12,11 @@ BaseMutex::BaseMutex(SM_UNUSED std::string name)
     : name(name)
     , owner(0)
 #endif
-{ }
+{
+#if SM_PROFILE_LOCKS
+    pCounters = detail::getLockCounters(name);
+#endif
+}
 
 void BaseMutex::verifyOwner() {
 #if SM_DEBUG_THREADS
@@ -32,6 +36,39 @@ void BaseMutex::resetOwner() {
 #endif
 }
 
+#if SM_PROFILE_LOCKS
+// try the lock first so uncontended acquires only pay for a couple of atomics
+template<typename T>
+void BaseMutex::acquire(T& mutex) {
+    if (!mutex.try_lock()) {
+        uint64_t start = detail::getLockTime();
+        mutex.lock();
+        detail::addContended(pCounters, false, detail::getLockTime() - start);
+    }
+
+    acquired();
+}
+
+template<typename T>
+void BaseMutex::acquireShared(T& mutex) {
+    if (mutex.try_lock_shared()) {
+        detail::addAcquire(pCounters, true);
+        return;
+    }
+
+    uint64_t start = detail::getLockTime();
+    mutex.lock_shared();
+    detail::addAcquire(pCounters, true);
+    detail::addContended(pCounters, true, detail::getLockTime() - start);
+}
+#else
+template<typename T>
+void BaseMutex::acquire(T& mutex) { mutex.lock(); }
+
+template<typename T>
+void BaseMutex::acquireShared(T& mutex) { mutex.lock_shared(); }
+#endif
+
 #if SM_DEBUG_THREADS
 #   define DEBUG_TRY(...) try { __VA_ARGS__ }
 #   define DEBUG_CATCH(err, ...) catch (err) { __VA_ARGS__ }
@@ -46,7 +83,7 @@ void Mutex::lock() {
     verifyOwner();
 
     DEBUG_TRY({
-        mutex.lock();
+        acquire(mutex);
     })
     DEBUG_CATCH(const std::exception& err, {
         core::throwFatal("Failed to lock mutex '{}': {}", getName(), err.what());
@@ -58,7 +95,8 @@ bool Mutex::try_lock() {
 
     DEBUG_TRY({
         bool result = mutex.try_lock();
-        if (!result) resetOwner();
+        if (result) acquired();
+        else resetOwner();
         return result;
     })
     DEBUG_CATCH(const std::exception& err, {
@@ -67,6 +105,7 @@ bool Mutex::try_lock() {
 }
 
 void Mutex::unlock() {
+    released();
     mutex.unlock();
     resetOwner();
 }
@@ -77,7 +116,7 @@ void SharedMutex::lock() {
     verifyOwner();
 
     DEBUG_TRY({
-        mutex.lock();
+        acquire(mutex);
     })
     DEBUG_CATCH(const std::exception& err, {
         core::throwFatal("Failed to lock mutex '{}': {}", getName(), err.what());
@@ -85,6 +124,7 @@ void SharedMutex::lock() {
 }
 
 void SharedMutex::unlock() {
+    released();
     mutex.unlock();
     resetOwner();
 }
@@ -96,7 +136,7 @@ void SharedMutex::lock_shared() {
         core::throwFatal("Mutex '{}' was already locked on this thread", getName());
     }
 #endif
-    mutex.lock_shared();
+    acquireShared(mutex);
 }
 
 void SharedMutex::unlock_shared() {
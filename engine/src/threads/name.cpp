@@ -24,7 +24,3 @@ std::string_view threads::getThreadName(ThreadId id) {
 
     return "";
 }
-
-threads::ThreadId threads::getCurrentThreadId() {
-    return ::GetCurrentThreadId();
-}
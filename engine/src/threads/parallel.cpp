@@ -0,0 +1,152 @@
+#include "engine/threads/parallel.h"
+#include "engine/threads/service.h"
+
+#include <exception>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+namespace {
+    // ranges smaller than this run inline, handing them out costs more than running them
+    constexpr size_t kMinParallelSize = 2;
+
+    // aim for this many chunks per thread so fast threads can pick up slack from slow ones
+    constexpr size_t kChunksPerThread = 4;
+
+    std::atomic_size_t gCalls = 0;
+    std::atomic_size_t gSerial = 0;
+    std::atomic_size_t gChunks = 0;
+    std::atomic_size_t gHelped = 0;
+
+    // shared between the caller and any workers that picked up a helper job.
+    // helpers can start after the caller has returned, so this is reference counted
+    // and only touched by a helper once it has claimed a chunk.
+    struct ParallelState {
+        ParallelState(size_t first, size_t last, size_t grain, size_t threads, detail::ChunkFn pfnChunk, void *pUser)
+            : last(last)
+            , grain(grain)
+            , threads(threads)
+            , pfnChunk(pfnChunk)
+            , pUser(pUser)
+            , next(first)
+            , remaining(last - first)
+        { }
+
+        const size_t last;
+        const size_t grain;
+        const size_t threads;
+
+        detail::ChunkFn pfnChunk;
+        void *pUser;
+
+        alignas(64) std::atomic_size_t next;
+        alignas(64) std::atomic_size_t remaining;
+
+        std::atomic_bool bFaulted = false;
+        std::exception_ptr pError = nullptr;
+
+        // guided self scheduling, take a share of whats left so chunks shrink towards the end
+        bool claim(size_t& begin, size_t& end) {
+            size_t current = next.load(std::memory_order_relaxed);
+            while (current < last) {
+                size_t left = last - current;
+                size_t chunk = std::min(left, std::max(grain, left / (threads * 2)));
+                if (next.compare_exchange_weak(current, current + chunk, std::memory_order_relaxed)) {
+                    begin = current;
+                    end = current + chunk;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void runChunks(bool bHelper) {
+            size_t begin, end;
+            while (claim(begin, end)) {
+                try {
+                    if (!bFaulted.load(std::memory_order_relaxed)) {
+                        pfnChunk(pUser, begin, end);
+                    }
+                } catch (...) {
+                    // keep the first error and skip everything after it
+                    if (!bFaulted.exchange(true)) {
+                        pError = std::current_exception();
+                    }
+                }
+
+                gChunks += 1;
+                if (bHelper) gHelped += 1;
+
+                size_t count = end - begin;
+                if (remaining.fetch_sub(count) == count) {
+                    remaining.notify_all();
+                }
+            }
+        }
+
+        void wait() {
+            size_t current = remaining.load();
+            while (current != 0) {
+                remaining.wait(current);
+                current = remaining.load();
+            }
+        }
+    };
+}
+
+size_t threads::getParallelism() {
+    size_t workers = ThreadService::getWorkerCount();
+    size_t cores = ThreadService::getGeometry().cores.size();
+
+    // the caller always participates
+    return std::min(workers, cores) + 1;
+}
+
+ParallelStats threads::getParallelStats() {
+    return {
+        .calls = gCalls.load(),
+        .serial = gSerial.load(),
+        .chunks = gChunks.load(),
+        .helped = gHelped.load()
+    };
+}
+
+void detail::runParallel(size_t first, size_t last, size_t grain, ChunkFn pfnChunk, void *pUser) {
+    if (first >= last) return;
+
+    gCalls += 1;
+
+    size_t count = last - first;
+    size_t threads = getParallelism();
+
+    if (grain == 0) {
+        grain = std::max<size_t>(count / (threads * kChunksPerThread), 1);
+    }
+
+    // not enough work to split
+    size_t chunks = (count + grain - 1) / grain;
+    if (count < kMinParallelSize || chunks <= 1 || threads <= 1) {
+        gSerial += 1;
+        pfnChunk(pUser, first, last);
+        return;
+    }
+
+    auto pState = std::make_shared<ParallelState>(first, last, grain, threads, pfnChunk, pUser);
+
+    // one helper per worker that could have something to do, the caller takes the rest.
+    // the caller is blocked until every chunk is done, so helpers dont wait behind background work
+    size_t helpers = std::min(threads - 1, chunks - 1);
+    for (size_t i = 0; i < helpers; i++) {
+        ThreadService::enqueueWork("parallel", [pState] {
+            pState->runChunks(true);
+        }, eResponsive);
+    }
+
+    pState->runChunks(false);
+    pState->wait();
+
+    if (pState->pError) {
+        std::rethrow_exception(pState->pError);
+    }
+}
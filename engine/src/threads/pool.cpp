@@ -0,0 +1,417 @@
+#include "engine/threads/pool.h"
+
+#include "engine/core/arena.h"
+#include "engine/core/panic.h"
+
+#include <bit>
+#include <thread>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+namespace {
+    // the deque owned by the current worker, null on non-worker threads
+    thread_local WorkDeque *tlsLocalDeque = nullptr;
+
+    // nodes are freed on whichever thread ran them, so cap how many
+    // a single thread can hoard before giving them back to the heap
+    constexpr size_t kMaxCachedNodes = 256;
+
+    struct NodeCache {
+        ~NodeCache() {
+            for (WorkMessage *pNode : nodes) {
+                delete pNode;
+            }
+        }
+
+        std::vector<WorkMessage*> nodes;
+    };
+
+    thread_local NodeCache tlsNodeCache;
+}
+
+// deque
+
+WorkDeque::Buffer::Buffer(size_t capacity)
+    : capacity(capacity)
+    , mask(int64_t(capacity - 1))
+    , pItems(std::make_unique<std::atomic<WorkMessage*>[]>(capacity))
+{
+    SM_ASSERTF(std::has_single_bit(capacity), "deque capacity {} must be a power of 2", capacity);
+}
+
+WorkDeque::WorkDeque(size_t capacity) {
+    auto& buffer = buffers.emplace_back(std::make_unique<Buffer>(capacity));
+    pBuffer.store(buffer.get(), std::memory_order_relaxed);
+}
+
+WorkDeque::~WorkDeque() {
+    while (WorkMessage *pMessage = pop()) {
+        delete pMessage;
+    }
+}
+
+WorkDeque::Buffer *WorkDeque::grow(Buffer *pOld, int64_t b, int64_t t) {
+    auto& buffer = buffers.emplace_back(std::make_unique<Buffer>(pOld->getCapacity() * 2));
+    for (int64_t i = t; i < b; i++) {
+        buffer->put(i, pOld->get(i));
+    }
+
+    pBuffer.store(buffer.get(), std::memory_order_release);
+    return buffer.get();
+}
+
+void WorkDeque::push(WorkMessage *pMessage) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    Buffer *pCurrent = pBuffer.load(std::memory_order_relaxed);
+
+    if (b - t > int64_t(pCurrent->getCapacity()) - 1) {
+        pCurrent = grow(pCurrent, b, t);
+    }
+
+    pCurrent->put(b, pMessage);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+WorkMessage *WorkDeque::pop() {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    Buffer *pCurrent = pBuffer.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        // deque was empty
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    WorkMessage *pMessage = pCurrent->get(b);
+    if (t == b) {
+        // last item, race against thieves for it
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            pMessage = nullptr;
+        }
+
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    return pMessage;
+}
+
+WorkMessage *WorkDeque::steal() {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+
+    if (t >= b) return nullptr;
+
+    Buffer *pCurrent = pBuffer.load(std::memory_order_acquire);
+    WorkMessage *pMessage = pCurrent->get(t);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        // lost the race to another thief or the owner
+        return nullptr;
+    }
+
+    return pMessage;
+}
+
+size_t WorkDeque::sizeApprox() const {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_relaxed);
+    return b > t ? size_t(b - t) : 0;
+}
+
+// pool
+
+WorkPool::WorkPool(size_t slots, size_t injectSize, size_t spinCount, WorkClock::duration aging)
+    : slots(slots)
+    , spinCount(spinCount)
+    , aging(aging)
+    , pDeques(std::make_unique<WorkDeque[]>(slots))
+{
+    for (auto& pLane : lanes) {
+        pLane = std::make_unique<Lane>(injectSize);
+    }
+}
+
+WorkPool::~WorkPool() = default;
+
+void WorkPool::add(WorkName name, WorkItem&& item, ThreadType priority) {
+    size_t index = getWorkLane(priority);
+
+    if (!item.isInline()) {
+        heapJobs += 1;
+    }
+
+    if (index == eBackground && tlsLocalDeque != nullptr) {
+        tlsLocalDeque->push(newNode(name, std::move(item)));
+    } else {
+        Lane& lane = *lanes[index];
+        auto now = WorkClock::now();
+
+        // an empty lane isnt starving, start aging it from when it gets work
+        if (lane.queue.size_approx() == 0) {
+            lane.lastServed = now.time_since_epoch().count();
+        }
+
+        injected += 1;
+        lane.queue.enqueue({ name, std::move(item), now });
+    }
+
+    wakeOne();
+}
+
+void WorkPool::runWorker(size_t slot, std::stop_token token) {
+    SM_ASSERTF(slot < slots, "worker slot {} out of range (max {})", slot, slots);
+
+    WorkDeque *pLocal = &pDeques[slot];
+    tlsLocalDeque = pLocal;
+
+    size_t active = activeSlots.load();
+    while (active <= slot && !activeSlots.compare_exchange_weak(active, slot + 1)) { }
+
+    // a parked worker wont see its stop token change unless we wake it
+    std::stop_callback onStop(token, [this] { wakeAll(); });
+
+    WorkMessage message;
+    size_t lane = 0;
+    size_t spins = 0;
+    while (!token.stop_requested()) {
+        if (findWork(slot, message, lane)) {
+            execute(message, lane);
+            core::resetStaleFrameArena();
+            spins = 0;
+            continue;
+        }
+
+        if (spins++ < spinCount) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        park(token);
+        spins = 0;
+    }
+
+    // hand anything left on our deque back to the pool so retiring a worker never drops jobs
+    tlsLocalDeque = nullptr;
+    bool bHandedOff = false;
+    while (WorkMessage *pNode = pLocal->pop()) {
+        takeNode(pNode, message);
+        lanes[eBackground]->queue.enqueue(std::move(message));
+        bHandedOff = true;
+    }
+
+    if (bHandedOff) wakeAll();
+}
+
+size_t WorkPool::getPendingApprox() const {
+    size_t pending = 0;
+    for (const auto& pLane : lanes) {
+        pending += pLane->queue.size_approx();
+    }
+
+    for (size_t i = 0; i < activeSlots.load(); i++) {
+        pending += pDeques[i].sizeApprox();
+    }
+
+    return pending;
+}
+
+WorkPoolStats WorkPool::getStats() const {
+    WorkPoolStats stats = {
+        .executed = executed.load(),
+        .stolen = stolen.load(),
+        .injected = injected.load(),
+        .parked = parked.load(),
+        .sleeping = sleepers.load(),
+        .dequeNodeAllocs = dequeNodeAllocs.load(),
+        .heapJobs = heapJobs.load(),
+        .lanes = {}
+    };
+
+    for (size_t i = 0; i < kWorkLaneCount; i++) {
+        stats.lanes[i] = getLaneStats(i);
+    }
+
+    // work on the deques is always background work
+    for (size_t i = 0; i < activeSlots.load(); i++) {
+        stats.lanes[eBackground].depth += pDeques[i].sizeApprox();
+    }
+
+    return stats;
+}
+
+bool WorkPool::findWork(size_t slot, WorkMessage& dst, size_t& lane) {
+    auto now = WorkClock::now().time_since_epoch().count();
+
+    // a lane that hasnt made progress in a while goes ahead of everything above it
+    for (size_t i = kWorkLaneCount - 1; i > 0; i--) {
+        if (isStarving(i, now) && takeFromLane(i, dst, now)) {
+            lanes[i]->promoted += 1;
+            lane = i;
+            return true;
+        }
+    }
+
+    for (size_t i = 0; i < eBackground; i++) {
+        if (takeFromLane(i, dst, now)) {
+            lane = i;
+            return true;
+        }
+    }
+
+    lane = eBackground;
+
+    // our own work is usually what the job we just ran is waiting on, so it goes before other background work
+    if (WorkMessage *pNode = pDeques[slot].pop()) {
+        takeNode(pNode, dst);
+        return true;
+    }
+
+    if (takeFromLane(eBackground, dst, now)) {
+        return true;
+    }
+
+    // walk the other workers starting from our neighbour to spread out thieves
+    size_t active = activeSlots.load();
+    for (size_t i = 1; i < active; i++) {
+        size_t victim = (slot + i) % active;
+        if (WorkMessage *pNode = pDeques[victim].steal()) {
+            stolen += 1;
+            takeNode(pNode, dst);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool WorkPool::takeFromLane(size_t index, WorkMessage& dst, WorkClock::rep now) {
+    Lane& lane = *lanes[index];
+    if (!lane.queue.try_dequeue(dst)) return false;
+
+    lane.lastServed = now;
+    return true;
+}
+
+bool WorkPool::isStarving(size_t index, WorkClock::rep now) const {
+    const Lane& lane = *lanes[index];
+    if (now - lane.lastServed.load() < aging.count()) return false;
+
+    return lane.queue.size_approx() > 0;
+}
+
+void WorkPool::execute(WorkMessage& message, size_t index) {
+    Lane& lane = *lanes[index];
+
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(WorkClock::now() - message.queued);
+    uint64_t us = uint64_t(std::max<int64_t>(latency.count(), 0));
+    size_t bucket = std::min<size_t>(std::bit_width(us), kLatencyBuckets - 1);
+
+    lane.totalLatency += us;
+    lane.latencies[bucket] += 1;
+
+    uint64_t max = lane.maxLatency.load();
+    while (max < us && !lane.maxLatency.compare_exchange_weak(max, us)) { }
+
+    message.item();
+    message.item.reset();
+
+    lane.executed += 1;
+    executed += 1;
+}
+
+WorkLaneStats WorkPool::getLaneStats(size_t index) const {
+    const Lane& lane = *lanes[index];
+
+    size_t count = lane.executed.load();
+    uint64_t latency = lane.totalLatency.load();
+    uint64_t avg = (count > 0) ? latency / count : 0;
+
+    // find the bucket that the 99th percentile falls in
+    size_t total = 0;
+    std::array<size_t, kLatencyBuckets> buckets;
+    for (size_t i = 0; i < kLatencyBuckets; i++) {
+        buckets[i] = lane.latencies[i].load();
+        total += buckets[i];
+    }
+
+    uint64_t p99 = 0;
+    size_t seen = 0;
+    for (size_t i = 0; i < kLatencyBuckets && total > 0; i++) {
+        seen += buckets[i];
+        if (seen * 100 >= total * 99) {
+            p99 = (i + 1 < kLatencyBuckets) ? (1ull << i) : lane.maxLatency.load();
+            break;
+        }
+    }
+
+    return {
+        .depth = lane.queue.size_approx(),
+        .executed = count,
+        .promoted = lane.promoted.load(),
+        .totalLatency = std::chrono::microseconds(latency),
+        .avgLatency = std::chrono::microseconds(avg),
+        .p99Latency = std::chrono::microseconds(p99),
+        .maxLatency = std::chrono::microseconds(lane.maxLatency.load())
+    };
+}
+
+WorkMessage *WorkPool::newNode(WorkName name, WorkItem&& item) {
+    auto& nodes = tlsNodeCache.nodes;
+    if (nodes.empty()) {
+        dequeNodeAllocs += 1;
+        return new WorkMessage{ name, std::move(item), WorkClock::now() };
+    }
+
+    WorkMessage *pNode = nodes.back();
+    nodes.pop_back();
+
+    pNode->name = name;
+    pNode->item = std::move(item);
+    pNode->queued = WorkClock::now();
+    return pNode;
+}
+
+void WorkPool::takeNode(WorkMessage *pNode, WorkMessage& dst) {
+    dst = std::move(*pNode);
+
+    auto& nodes = tlsNodeCache.nodes;
+    if (nodes.size() < kMaxCachedNodes) {
+        nodes.push_back(pNode);
+    } else {
+        delete pNode;
+    }
+}
+
+void WorkPool::park(std::stop_token token) {
+    sleepers += 1;
+    uint32_t epoch = wakeEpoch.load();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // recheck after announcing ourselves, a producer that missed us
+    // will have published its job before reading the sleeper count
+    if (getPendingApprox() == 0 && !token.stop_requested()) {
+        parked += 1;
+        wakeEpoch.wait(epoch);
+    }
+
+    sleepers -= 1;
+}
+
+void WorkPool::wakeOne() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers.load() == 0) return;
+
+    wakeEpoch += 1;
+    wakeEpoch.notify_one();
+}
+
+void WorkPool::wakeAll() {
+    wakeEpoch += 1;
+    wakeEpoch.notify_all();
+}
@@ -5,20 +5,114 @@
 #include "engine/debug/service.h"
 #include "engine/log/service.h"
 
+#include <unordered_set>
+
 using namespace simcoe;
 using namespace simcoe::threads;
 
+namespace {
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    // like thread names this only ever grows, messages hold views into it
+    mt::SharedMutex gNameLock{"work.names"};
+    std::unordered_set<std::string, NameHash, std::equal_to<>> gNames;
+
+    std::string_view internName(std::string_view name) {
+        {
+            mt::ReadLock lock(gNameLock);
+            if (auto it = gNames.find(name); it != gNames.end()) {
+                return *it;
+            }
+        }
+
+        mt::WriteLock lock(gNameLock);
+        auto [it, _] = gNames.emplace(name);
+        return *it;
+    }
+}
+
+// names
+
+WorkName::WorkName(std::string_view str)
+    : name(internName(str))
+{ }
+
 // non-blocking
 
 bool WorkQueue::tryGetMessage() {
+    // anything a drain left in the batch is older than what is still queued
+    if (batchHead < batchCount) {
+        execute(batch[batchHead++]);
+        return true;
+    }
+
     if (workQueue.try_dequeue(message)) {
-        message.item();
+        execute(message);
         return true;
     }
 
     return false;
 }
 
+size_t WorkQueue::drain(std::chrono::microseconds budget) {
+    auto start = WorkClock::now();
+
+    size_t backlog = workQueue.size_approx() + (batchCount - batchHead);
+    if (backlog > maxBacklog.load()) {
+        maxBacklog = backlog;
+    }
+
+    size_t total = 0;
+    while (true) {
+        if (batchHead == batchCount) {
+            batchHead = 0;
+            batchCount = workQueue.try_dequeue_bulk(batch.begin(), batch.size());
+            if (batchCount == 0) break;
+        }
+
+        execute(batch[batchHead++]);
+        total += 1;
+
+        if (WorkClock::now() - start >= budget) {
+            if (batchHead < batchCount || workQueue.size_approx() > 0) overBudget += 1;
+            break;
+        }
+    }
+
+    return total;
+}
+
+WorkQueueStats WorkQueue::getStats() const {
+    size_t count = executed.load();
+    uint64_t avg = (count > 0) ? totalLatency.load() / count : 0;
+
+    return {
+        .executed = count,
+        .backlog = workQueue.size_approx(),
+        .maxBacklog = maxBacklog.load(),
+        .overBudget = overBudget.load(),
+        .avgLatency = std::chrono::microseconds(avg),
+        .maxLatency = std::chrono::microseconds(maxLatency.load())
+    };
+}
+
+void WorkQueue::execute(WorkMessage& msg) {
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(WorkClock::now() - msg.queued);
+    uint64_t us = uint64_t(latency.count());
+
+    totalLatency += us;
+    if (us > maxLatency.load()) {
+        maxLatency = us;
+    }
+
+    msg.item();
+    msg.item.reset();
+    executed += 1;
+}
+
 // blocking
 
 bool BlockingWorkQueue::tryGetMessage() {
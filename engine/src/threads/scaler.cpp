@@ -0,0 +1,72 @@
+#include "engine/threads/scaler.h"
+
+#include "engine/core/panic.h"
+
+#include <algorithm>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+WorkerScaler::WorkerScaler(const ScalerConfig& config)
+    : config(config)
+{
+    SM_ASSERTF(config.minWorkers > 0, "scaler needs at least one worker");
+    SM_ASSERTF(config.minWorkers <= config.maxWorkers, "scaler min workers {} exceeds max workers {}", config.minWorkers, config.maxWorkers);
+}
+
+size_t WorkerScaler::update(const ScalerSample& sample) {
+    size_t executed = sample.executed - last.executed;
+    auto latency = sample.latency - last.latency;
+    auto recent = (executed > 0) ? latency / int64_t(executed) : std::chrono::microseconds(0);
+    last = sample;
+
+    // jobs are waiting on workers rather than the other way around
+    bool bPressure = sample.sleeping == 0
+        && (recent >= config.growLatency || sample.pending > sample.workers * 2);
+
+    // someone is parked and nothing is waiting for them
+    bool bIdle = sample.sleeping > 0 && sample.pending == 0;
+
+    hotTicks = bPressure ? hotTicks + 1 : 0;
+    coldTicks = bIdle ? coldTicks + 1 : 0;
+
+    size_t target = std::clamp(sample.workers, config.minWorkers, config.maxWorkers);
+
+    if (cooldown > 0) {
+        cooldown -= 1;
+    } else if (hotTicks >= config.growTicks && target < config.maxWorkers) {
+        target += 1;
+    } else if (coldTicks >= config.shrinkTicks && target > config.minWorkers) {
+        target -= 1;
+    }
+
+    std::lock_guard guard(lock);
+
+    if (target != sample.workers) {
+        if (target > sample.workers) stats.grown += target - sample.workers;
+        else stats.shrunk += sample.workers - target;
+
+        hotTicks = 0;
+        coldTicks = 0;
+        cooldown = config.cooldownTicks;
+    }
+
+    stats.lastLatency = recent;
+
+    if (stats.history.size() < kHistorySize) {
+        stats.history.push_back(uint16_t(target));
+    } else {
+        stats.history[historyHead] = uint16_t(target);
+        historyHead = (historyHead + 1) % kHistorySize;
+    }
+
+    return target;
+}
+
+ScalerStats WorkerScaler::getStats() const {
+    std::lock_guard guard(lock);
+
+    ScalerStats result = stats;
+    std::rotate(result.history.begin(), result.history.begin() + ptrdiff_t(historyHead), result.history.end());
+    return result;
+}
@@ -1,12 +1,14 @@
-#if 0
 #include "engine/threads/schedule.h"
-#include "engine/threads/service.h"
 
 #include "engine/log/service.h"
 
 #include "engine/core/range.h"
+#include "engine/core/panic.h"
+#include "engine/core/units.h"
 
 #include <numeric>
+#include <tuple>
+#include <unordered_set>
 
 using namespace simcoe;
 using namespace simcoe::threads;
@@ -15,218 +17,234 @@ namespace {
     struct CorePerf {
         CoreIndex index;
         uint16_t schedule;
+        uint8_t efficiency;
     };
 
     struct ChipletPerf {
         ChipletIndex index;
-        uint16_t score;
+        uint32_t score;
     };
 
     struct PackagePerf {
         PackageIndex index;
-        uint16_t score;
+        uint32_t score;
     };
 
-    static constexpr auto kThreadCosts = std::to_array<uint16_t>({
-        /*eRealtime*/   UINT16_MAX,
+    // how much load each type of thread puts on the subcore its placed on
+    constexpr auto kThreadCosts = std::to_array<uint32_t>({
+        /*eRealtime*/   1000,
         /*eResponsive*/ 100,
         /*eBackground*/ 50,
         /*eWorker*/     5
     });
+
+    // average schedule of a set of cores, lower is faster
+    uint32_t getScore(const Geometry& geometry, std::span<const CoreIndex> cores) {
+        if (cores.empty()) return UINT32_MAX;
+
+        uint32_t total = 0;
+        for (CoreIndex core : cores) {
+            total += geometry.getCore(core).schedule;
+        }
+
+        // scaled so chiplets with similar averages dont all tie
+        return (total * 16) / uint32_t(cores.size());
+    }
 }
 
-Scheduler::Scheduler() {
-    setupThreadData();
+Scheduler::Scheduler(const Geometry& geometry, size_t realtimeCores)
+    : geometry(geometry)
+{
+    setupThreadData(realtimeCores);
 }
 
-Scheduler::~Scheduler() {
+SubcoreIndex Scheduler::addThread(ThreadType type, std::string_view name) {
     std::lock_guard guard(lock);
+    if (coreRanking.empty()) return SubcoreIndex::eInvalid;
 
-    // TODO: handle threads being destroyed while the scheduler is still running
-    threads.clear();
-}
+    CoreIndex coreIdx = getBestCore(type);
+    SubcoreIndex index = getLeastLoadedSubcore(coreIdx);
 
-Thread& Scheduler::newThread(ThreadType type, std::string_view name, ThreadStart&& start) {
-    std::lock_guard guard(lock);
-    const auto& geometry = ThreadService::getGeometry();
-    SubcoreIndex index = getBestSubcore(type, name);
-    LOG_INFO("new thread {} on thread {} with load {}", name, index, subcoreUsage[index]);
+    auto& subcore = subcoreData[size_t(index)];
+    subcore.load += kThreadCosts[type];
+    subcore.threads[type] += 1;
 
-    subcoreUsage[index] += kThreadCosts[size_t(type)];
-    threads.emplace_back(geometry.getSubcore(index), name, std::move(start));
-    return threads.back();
+    if (type == eRealtime) {
+        coreData[size_t(coreIdx)].realtime += 1;
+    }
+
+    LOG_INFO("placed thread {} on subcore {} (core={}, chiplet={}, load={})", name, index, coreIdx, coreData[size_t(coreIdx)].chiplet, getLoad(coreIdx));
+    return index;
 }
 
-uint16_t Scheduler::getCoreLoad(CoreIndex coreIdx) const {
-    const auto& geometry = ThreadService::getGeometry();
+void Scheduler::removeThread(ThreadType type, SubcoreIndex index) {
+    std::lock_guard guard(lock);
+    if (index == SubcoreIndex::eInvalid) return;
 
-    uint16_t load = 0;
+    auto& subcore = subcoreData[size_t(index)];
+    SM_ASSERTF(subcore.threads[type] > 0, "no threads of type {} on subcore {}", int(type), index);
 
-    for (SubcoreIndex subcoreId : geometry.getCore(coreIdx).subcoreIds) {
-        uint16_t threadLoad = subcoreUsage.contains(subcoreId) ? subcoreUsage.at(subcoreId) : 0;
-        if (threadLoad == UINT16_MAX) return UINT16_MAX;
+    subcore.load -= kThreadCosts[type];
+    subcore.threads[type] -= 1;
 
-        load += threadLoad;
+    if (type == eRealtime) {
+        coreData[size_t(subcore.core)].realtime -= 1;
     }
+}
 
-    return load;
+ScheduleMask Scheduler::getMask(SubcoreIndex index) const {
+    if (index == SubcoreIndex::eInvalid) return {};
+
+    return geometry.getSubcore(index).mask;
 }
 
-SubcoreIndex Scheduler::getLeastLoadedSubcore(CoreIndex coreIdx) const {
-    const auto& geometry = ThreadService::getGeometry();
+uint32_t Scheduler::getCoreLoad(CoreIndex index) const {
+    std::lock_guard guard(lock);
+    return getLoad(index);
+}
 
-    uint16_t bestLoad = UINT16_MAX;
-    SubcoreIndex bestSubcore = SubcoreIndex::eInvalid;
+bool Scheduler::isRealtimeCore(CoreIndex index) const {
+    std::lock_guard guard(lock);
+    return coreData[size_t(index)].realtime > 0;
+}
 
-    for (SubcoreIndex subcoreId : geometry.getCore(coreIdx).subcoreIds) {
-        uint16_t threadLoad = subcoreUsage.contains(subcoreId) ? subcoreUsage.at(subcoreId) : 0;
-        if (threadLoad < bestLoad) {
-            bestLoad = threadLoad;
-            bestSubcore = subcoreId;
-        }
-    }
+bool Scheduler::isReservedCore(CoreIndex index) const {
+    std::lock_guard guard(lock);
+    return coreData[size_t(index)].reserved;
+}
 
-    if (bestLoad == UINT16_MAX) {
-        LOG_ERROR("attempting to allocate a new thread on core {} but all subcores are at max load, your computer cries for help :(", coreIdx);
+uint32_t Scheduler::getLoad(CoreIndex index) const {
+    uint32_t load = 0;
+    for (SubcoreIndex subcoreIdx : geometry.getCore(index).subcoreIds) {
+        load += subcoreData[size_t(subcoreIdx)].load;
     }
 
-    return bestSubcore;
+    return load;
 }
 
-SubcoreIndex Scheduler::getBestSubcore(ThreadType type, std::string_view name) const {
-    if (type == eRealtime) {
-        // find the fastest core that has nothing running on it
-        for (CoreIndex coreIdx : coreRanking) {
-            uint16_t load = getCoreLoad(coreIdx);
-            if (load < 0) continue;
+size_t Scheduler::getChipletSpread(ThreadType type) const {
+    std::lock_guard guard(lock);
 
-            return getLeastLoadedSubcore(coreIdx);
-        }
+    std::unordered_set<ChipletIndex> chiplets;
+    for (const SubcoreData& subcore : subcoreData) {
+        if (subcore.threads[type] == 0) continue;
 
-        LOG_WARN("no free cores available for realtime thread, finding the least loaded core");
+        chiplets.insert(coreData[size_t(subcore.core)].chiplet);
+    }
 
-        // TODO: implement a way to shove threads off their current cores to make room
+    return chiplets.size();
+}
 
-        // find the fastest core that has the least amount of load
-        CoreIndex bestCore = coreRanking[0];
-        uint16_t bestLoad = getCoreLoad(bestCore);
+SubcoreIndex Scheduler::getLeastLoadedSubcore(CoreIndex index) const {
+    SubcoreIndex bestSubcore = SubcoreIndex::eInvalid;
+    uint32_t bestLoad = UINT32_MAX;
 
-        for (CoreIndex coreIdx : coreRanking) {
-            uint16_t load = getCoreLoad(coreIdx);
-            if (load < bestLoad) {
-                bestCore = coreIdx;
-                bestLoad = load;
-            }
+    for (SubcoreIndex subcoreIdx : geometry.getCore(index).subcoreIds) {
+        uint32_t load = subcoreData[size_t(subcoreIdx)].load;
+        if (load < bestLoad) {
+            bestLoad = load;
+            bestSubcore = subcoreIdx;
         }
-
-        LOG_WARN("realtime thread allocated to core {}", bestCore);
-        return getLeastLoadedSubcore(bestCore);
     }
 
-    // nothing else can run on a core with a realtime thread
-
-    if (type == eResponsive) {
-        // find the fastest core that doesnt have a realtime thread on it, can have one other thread running on it
-        CoreIndex bestCore = coreRanking[0];
-        uint16_t bestLoad = getCoreLoad(bestCore);
+    return bestSubcore;
+}
 
-        for (CoreIndex coreIdx : coreRanking) {
-            uint16_t load = getCoreLoad(coreIdx);
-            if (load < bestLoad) {
-                bestCore = coreIdx;
-                bestLoad = load;
-            }
+CoreIndex Scheduler::getBestCore(ThreadType type) const {
+    using PlaceKey = std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t>;
+
+    // every type avoids realtime cores first, then picks the lowest key.
+    // a core counts as a whole, so nothing shares an smt sibling with a realtime thread
+    const auto getKey = [&](CoreIndex index) -> PlaceKey {
+        const Core& core = geometry.getCore(index);
+        const CoreData& data = coreData[size_t(index)];
+        uint32_t load = getLoad(index);
+
+        switch (type) {
+        case eRealtime:
+            // a free reserved core, then the fastest core with the least work on it
+            return { data.realtime, !data.reserved, load, 0, 0, 0, 0, data.rank };
+
+        case eResponsive:
+            // the fastest core with the least work on it, leaving reserved cores alone
+            return { data.realtime, data.reserved, load, 0, 0, 0, 0, data.rank };
+
+        case eBackground:
+        case eWorker:
+        default: {
+            // the least loaded hardware thread, so every free one is used before anything doubles up
+            uint32_t fill = subcoreData[size_t(getLeastLoadedSubcore(index))].load;
+
+            // the most efficient cores first, filling the slowest package and then the slowest
+            // chiplet in it before spilling onto the next so workers share as much cache as possible
+            return {
+                data.realtime, data.reserved, fill,
+                uint32_t(UINT8_MAX - core.efficiency),
+                uint32_t(UINT16_MAX - data.packageRank),
+                uint32_t(UINT16_MAX - data.chipletRank),
+                load,
+                uint32_t(UINT16_MAX - data.rank)
+            };
         }
+        }
+    };
 
-        LOG_INFO("responsive thread allocated to core {}", bestCore);
-
-        return getLeastLoadedSubcore(bestCore);
-    }
+    CoreIndex bestCore = coreRanking[0];
+    auto bestKey = getKey(bestCore);
 
-    const auto& geometry = ThreadService::getGeometry();
-
-    // these threads can go anywhere
-    if (type == eBackground) {
-        // find a core that has a low performance
-        // prefer efficient cores over inefficient ones
-
-        CoreIndex bestCore = coreRanking[0];
-        uint16_t bestEfficiency = geometry.getCore(bestCore).efficiency;
-        for (CoreIndex coreIdx : coreRanking) {
-            uint16_t efficiency = geometry.getCore(coreIdx).efficiency;
-            if (efficiency > bestEfficiency) {
-                bestCore = coreIdx;
-                bestEfficiency = efficiency;
-            }
+    for (CoreIndex index : coreRanking) {
+        auto key = getKey(index);
+        if (key < bestKey) {
+            bestCore = index;
+            bestKey = key;
         }
     }
 
-    if (type == eWorker) {
-        // these threads should go on the slowest cores
-        // prefer efficient cores over inefficient ones
-
-        CoreIndex bestCore = coreRanking[0];
-        uint16_t bestEfficiency = geometry.getCore(bestCore).efficiency;
-        uint16_t worstSpeed = geometry.getCore(bestCore).schedule;
-
-        for (CoreIndex coreIdx : coreRanking) {
-            uint16_t efficiency = geometry.getCore(coreIdx).efficiency;
-            if (efficiency > bestEfficiency) {
-                bestCore = coreIdx;
-                bestEfficiency = efficiency;
-            } else if (efficiency == bestEfficiency) {
-                uint16_t speed = geometry.getCore(coreIdx).schedule;
-                if (speed > worstSpeed) {
-                    bestCore = coreIdx;
-                    worstSpeed = speed;
-                }
-            }
-        }
-
-        return getLeastLoadedSubcore(bestCore);
+    if (type == eRealtime && (std::get<0>(bestKey) > 0 || std::get<2>(bestKey) > 0)) {
+        LOG_WARN("no free cores available for realtime thread, sharing core {} (load={})", bestCore, std::get<2>(bestKey));
     }
 
-    LOG_ERROR("unknown thread type {}", int(type));
-    return SubcoreIndex::eInvalid;
+    return bestCore;
 }
 
-void Scheduler::setupThreadData() {
-    const auto& geometry = ThreadService::getGeometry();
+void Scheduler::setupThreadData(size_t realtimeCores) {
+    subcoreData.resize(geometry.subcores.size());
+    coreData.resize(geometry.cores.size());
 
     std::vector<CorePerf> corePerfs;
     for (const auto& [index, core] : core::enumerate<CoreIndex>(geometry.cores)) {
-        corePerfs.push_back({ .index = index, .schedule = core.schedule });
+        corePerfs.push_back({ .index = index, .schedule = core.schedule, .efficiency = core.efficiency });
+
+        for (SubcoreIndex subcoreIdx : core.subcoreIds) {
+            subcoreData[size_t(subcoreIdx)].core = index;
+        }
     }
 
     std::vector<ChipletPerf> chipletPerfs;
-    for (const auto& [index, cluster] : core::enumerate<ChipletIndex>(geometry.chiplets)) {
-        uint16_t score = 0;
-        for (CoreIndex core : cluster.coreIds) {
-            score += geometry.getCore(core).schedule;
-        }
+    for (const auto& [index, chiplet] : core::enumerate<ChipletIndex>(geometry.chiplets)) {
+        chipletPerfs.push_back({ .index = index, .score = getScore(geometry, chiplet.coreIds) });
 
-        chipletPerfs.push_back({ .index = index, .score = score });
+        for (CoreIndex coreIdx : chiplet.coreIds) {
+            coreData[size_t(coreIdx)].chiplet = index;
+        }
     }
 
     std::vector<PackagePerf> packPerfs;
     for (const auto& [index, package] : core::enumerate<PackageIndex>(geometry.packages)) {
-        uint16_t score = 0;
-        for (ChipletIndex chiplet : package.chiplets) {
-            score += chipletPerfs[size_t(chiplet)].score;
-        }
-
-        packPerfs.push_back({ .index = index, .score = score });
+        packPerfs.push_back({ .index = index, .score = getScore(geometry, package.cores) });
     }
 
-    std::sort(corePerfs.begin(), corePerfs.end(), [](const auto& a, const auto& b) {
-        return a.schedule < b.schedule;
+    // ties keep geometry order, so equally fast chiplets in the same package stay together
+    std::stable_sort(corePerfs.begin(), corePerfs.end(), [](const auto& a, const auto& b) {
+        // a less efficient core is a bigger core
+        return std::tie(a.schedule, a.efficiency) < std::tie(b.schedule, b.efficiency);
     });
 
-    std::sort(chipletPerfs.begin(), chipletPerfs.end(), [](const auto& a, const auto& b) {
+    std::stable_sort(chipletPerfs.begin(), chipletPerfs.end(), [](const auto& a, const auto& b) {
         return a.score < b.score;
     });
 
-    std::sort(packPerfs.begin(), packPerfs.end(), [](const auto& a, const auto& b) {
+    std::stable_sort(packPerfs.begin(), packPerfs.end(), [](const auto& a, const auto& b) {
         return a.score < b.score;
     });
 
@@ -248,6 +266,27 @@ void Scheduler::setupThreadData() {
         [](const auto& perf) { return perf.index; }
     );
 
-    LOG_INFO("collated thread performance data");
+    for (size_t i = 0; i < coreRanking.size(); ++i) {
+        coreData[size_t(coreRanking[i])].rank = uint16_t(i);
+    }
+
+    for (size_t i = 0; i < chipletRanking.size(); ++i) {
+        for (CoreIndex coreIdx : geometry.getChiplet(chipletRanking[i]).coreIds) {
+            coreData[size_t(coreIdx)].chipletRank = uint16_t(i);
+        }
+    }
+
+    for (size_t i = 0; i < packageRanking.size(); ++i) {
+        for (CoreIndex coreIdx : geometry.getPackage(packageRanking[i]).cores) {
+            coreData[size_t(coreIdx)].packageRank = uint16_t(i);
+        }
+    }
+
+    // the fastest physical cores, smt siblings included, wait for realtime threads
+    size_t reserved = coreRanking.empty() ? 0 : std::min(realtimeCores, coreRanking.size() - 1);
+    for (size_t i = 0; i < reserved; ++i) {
+        coreData[size_t(coreRanking[i])].reserved = true;
+    }
+
+    LOG_INFO("collated thread performance data (cores={}, chiplets={}, packages={}, reserved={})", coreRanking.size(), chipletRanking.size(), packageRanking.size(), reserved);
 }
-#endif
@@ -1,5 +1,8 @@
 #include "engine/threads/service.h"
 
+#include "common.h"
+
+#include "engine/core/arena.h"
 #include "engine/core/error.h"
 #include "engine/core/units.h"
 
@@ -7,8 +10,6 @@
 
 #include "engine/log/service.h"
 
-#include <unordered_set>
-
 using namespace simcoe;
 using namespace simcoe::threads;
 
@@ -16,393 +17,183 @@ using namespace std::chrono_literals;
 
 config::ConfigValue<size_t> cfgDefaultWorkerCount("threads/workers", "initial", "Default number of worker threads (0 = system default)", 0);
 config::ConfigValue<size_t> cfgMaxWorkerCount("threads/workers", "max", "Maximum number of worker threads (0 = no limit)", 0);
-config::ConfigValue<size_t> cfgWorkerDelay("threads/workers", "delay", "Delay between worker thread polls (in ms)", 50);
-
-config::ConfigValue<size_t> cfgWorkQueueSize("threads", "workQueueSize", "Size of the work queue", 256);
-config::ConfigValue<size_t> cfgMainQueueSize("threads", "mainQueueSize", "Size of the main queue", 64);
-
-namespace {
-    template<typename T>
-    T *advance(T *ptr, size_t bytes) {
-        return reinterpret_cast<T*>(reinterpret_cast<std::byte*>(ptr) + bytes);
-    }
-
-    struct ProcessorInfoIterator {
-        ProcessorInfoIterator(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *pBuffer, DWORD remaining)
-            : pBuffer(pBuffer)
-            , remaining(remaining)
-        { }
-
-        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *operator++() {
-            SM_ASSERT(remaining > 0);
-
-            remaining -= pBuffer->Size;
-            if (remaining > 0) {
-                pBuffer = advance(pBuffer, pBuffer->Size);
-            }
-
-            return pBuffer;
-        }
-
-        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *operator*() const {
-            return pBuffer;
-        }
-
-        bool operator==(const ProcessorInfoIterator& other) const {
-            return remaining == other.remaining;
-        }
-
-    private:
-        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *pBuffer;
-        DWORD remaining;
-    };
-
-    // GetLogicalProcessorInformationEx provides information about inter-core communication
-    struct ProcessorInfo {
-        ProcessorInfo(LOGICAL_PROCESSOR_RELATIONSHIP relation) {
-            if (GetLogicalProcessorInformationEx(relation, nullptr, &bufferSize)) {
-                core::throwNonFatal("GetLogicalProcessorInformationEx did not fail");
-            }
-
-            if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
-                debug::throwLastError("GetLogicalProcessorInformationEx did not fail with ERROR_INSUFFICIENT_BUFFER");
-            }
-
-            memory = std::make_unique<std::byte[]>(bufferSize);
-            pBuffer = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *>(memory.get());
-            if (!GetLogicalProcessorInformationEx(relation, pBuffer, &bufferSize)) {
-                debug::throwLastError("GetLogicalProcessorInformationEx failed");
-            }
-
-            remaining = bufferSize;
-        }
-
-        ProcessorInfoIterator begin() const {
-            return ProcessorInfoIterator(pBuffer, remaining);
-        }
-
-        ProcessorInfoIterator end() const {
-            return ProcessorInfoIterator(pBuffer, 0);
-        }
-
-    private:
-        std::unique_ptr<std::byte[]> memory;
-        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *pBuffer;
-        DWORD bufferSize = 0;
-
-        DWORD remaining = 0;
-    };
-
-    // GetSystemCpuSetInformation provides information about cpu speeds
-    struct CpuSetIterator {
-        CpuSetIterator(SYSTEM_CPU_SET_INFORMATION *pBuffer, ULONG remaining)
-            : pBuffer(pBuffer)
-            , remaining(remaining)
-        { }
-
-        SYSTEM_CPU_SET_INFORMATION *operator++() {
-            SM_ASSERT(remaining > 0);
-
-            remaining -= pBuffer->Size;
-            if (remaining > 0) {
-                pBuffer = advance(pBuffer, pBuffer->Size);
-            }
-
-            return pBuffer;
-        }
-
-        SYSTEM_CPU_SET_INFORMATION *operator*() const {
-            return pBuffer;
-        }
-
-        bool operator==(const CpuSetIterator& other) const {
-            return remaining == other.remaining;
-        }
-
-    private:
-        SYSTEM_CPU_SET_INFORMATION *pBuffer;
-        ULONG remaining;
-    };
-
-    struct CpuSetInfo {
-        CpuSetInfo() {
-            if (GetSystemCpuSetInformation(nullptr, 0, &bufferSize, GetCurrentProcess(), 0)) {
-                core::throwNonFatal("GetSystemCpuSetInformation did not fail");
-            }
-
-            if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
-                debug::throwLastError("GetSystemCpuSetInformation did not fail with ERROR_INSUFFICIENT_BUFFER");
-            }
-
-            memory = std::make_unique<std::byte[]>(bufferSize);
-            pBuffer = reinterpret_cast<SYSTEM_CPU_SET_INFORMATION *>(memory.get());
-            if (!GetSystemCpuSetInformation(pBuffer, bufferSize, &bufferSize, GetCurrentProcess(), 0)) {
-                debug::throwLastError("GetSystemCpuSetInformation failed");
-            }
+config::ConfigValue<size_t> cfgWorkerSpin("threads/workers", "spin", "Number of empty polls a worker makes before going to sleep", 64);
+config::ConfigValue<bool> cfgWorkerAutoscale("threads/workers", "autoscale", "Add and retire workers based on how busy the pool is", true);
+config::ConfigValue<size_t> cfgMinWorkerCount("threads/workers", "min", "Fewest workers the autoscaler will retire down to", 1);
+config::ConfigValue<size_t> cfgScaleInterval("threads/workers", "interval", "Time between autoscaler updates (in ms)", 50);
+config::ConfigValue<size_t> cfgScaleLatency("threads/workers", "latency", "Queueing latency that makes the autoscaler add a worker (in us)", 2000);
+config::ConfigValue<size_t> cfgWorkerAging("threads/workers", "aging", "Time a lower priority lane can go without running anything before it jumps ahead (in us)", 20000);
 
-            remaining = bufferSize;
-        }
+config::ConfigValue<size_t> cfgRealtimeCores("threads/scheduler", "realtime", "Number of the fastest cores kept free for realtime threads", 1);
 
-        CpuSetIterator begin() const {
-            return CpuSetIterator(pBuffer, remaining);
-        }
+config::ConfigValue<size_t> cfgTimerResolution("threads/timer", "resolution", "Length of a single timer wheel tick (in us)", 1000);
 
-        CpuSetIterator end() const {
-            return CpuSetIterator(pBuffer, 0);
-        }
-    private:
-        std::unique_ptr<std::byte[]> memory;
-        SYSTEM_CPU_SET_INFORMATION *pBuffer;
-        ULONG bufferSize = 0;
+config::ConfigValue<bool> cfgLocalMemory("threads/memory", "local", "Give each thread memory from the numa node it is scheduled on", true);
 
-        ULONG remaining = 0;
-    };
+config::ConfigValue<std::string> cfgLockProfilePath("threads/locks", "path", "File to write lock contention statistics to on shutdown, if lock profiling is enabled", "locks.txt");
 
-    struct GeometryBuilder {
-        std::vector<Subcore> subcores;
-        std::vector<Core> cores;
-        std::vector<Chiplet> chiplets;
-        std::vector<Package> packages;
-
-        template<typename Index, typename Item>
-        static void getItemByMask(std::vector<Index>& ids, std::span<const Item> items, GROUP_AFFINITY affinity) {
-            std::unordered_set<Index> uniqueIds;
-            for (size_t i = 0; i < items.size(); ++i) {
-                const auto& item = items[i];
-                if (item.mask.Group == affinity.Group && item.mask.Mask & affinity.Mask) {
-                    uniqueIds.insert(core::enumCast<Index>(i));
-                }
-            }
-
-            std::transform(uniqueIds.begin(), uniqueIds.end(), std::back_inserter(ids), [](Index id) {
-                return id;
-            });
-        }
-
-        void getCoresByMask(CoreIndices& ids, GROUP_AFFINITY affinity) const {
-            getItemByMask<CoreIndex, Core>(ids, cores, affinity);
-        }
-
-        void getSubcoresByMask(SubcoreIndices& ids, GROUP_AFFINITY affinity) const {
-            getItemByMask<SubcoreIndex, Subcore>(ids, subcores, affinity);
-        }
-
-        void getChipletsByMask(ChipletIndices& ids, GROUP_AFFINITY affinity) const {
-            getItemByMask<ChipletIndex, Chiplet>(ids, chiplets, affinity);
-        }
-    };
+config::ConfigValue<size_t> cfgWorkQueueSize("threads", "workQueueSize", "Size of the work queue", 256);
+config::ConfigValue<size_t> cfgMainQueueSize("threads", "mainQueueSize", "Size of the main queue", 64);
+config::ConfigValue<size_t> cfgMainBudget("threads", "mainBudget", "Time the main thread may spend draining its queue per poll (in us)", 2000);
 
-    struct ProcessorInfoLayout {
-        ProcessorInfoLayout(GeometryBuilder *pBuilder)
-            : pBuilder(pBuilder)
-        { }
+namespace {
+    // geometry data
+    Geometry gCpuGeometry = {};
+    Scheduler *gScheduler = nullptr;
 
-        GeometryBuilder *pBuilder;
-        size_t cacheCount = 0;
+    // all currently scheduled threads, only touched by writers holding the pool lock
+    mt::SharedMutex gThreadLock{"pool"};
+    ThreadList gThreadHandles;
 
-        static constexpr KAFFINITY KAFFINITY_BITS = std::numeric_limits<KAFFINITY>::digits;
+    // the copy of gThreadHandles readers see, replaced whenever a thread starts or stops.
+    // old copies and stopped handles are retired through the epoch so readers never need the pool lock
+    mt::Epoch gThreadEpoch{"pool.epoch"};
+    std::atomic<const ThreadList*> gThreadList = new ThreadList();
 
-        void addProcessorCore(const PROCESSOR_RELATIONSHIP *pInfo) {
-            SubcoreIndices subcoreIds;
+    // worker thread data
+    size_t gWorkerId = 0;
+    std::vector<threads::ThreadHandle*> gWorkers;
 
-            for (DWORD i = 0; i < pInfo->GroupCount; ++i) {
-                GROUP_AFFINITY group = pInfo->GroupMask[i];
+    // read by workers inside parallel calls, so it cant sit behind the pool lock
+    std::atomic_size_t gWorkerCount = 0;
 
-                for (size_t bit = 0; bit < KAFFINITY_BITS; ++bit) {
-                    KAFFINITY mask = 1ull << bit;
-                    if (!(group.Mask & mask)) continue;
+    // serialises resizes. held while retired workers are joined so their slots
+    // arent handed to a new worker before they exit, workers never take it
+    mt::Mutex gResizeLock{"pool.resize"};
 
-                    GROUP_AFFINITY groupAffinity = {
-                        .Mask = group.Mask & mask,
-                        .Group = group.Group,
-                    };
+    // thread communication
+    WorkQueue *gMainQueue = nullptr;
+    WorkPool *gWorkPool = nullptr;
 
-                    pBuilder->subcores.push_back({
-                        .mask = ScheduleMask(groupAffinity)
-                    });
+    // periodic and delayed work
+    TimerWheel *gTimerWheel = nullptr;
+    threads::ThreadHandle *gTimerThread = nullptr;
 
-                    subcoreIds.push_back(core::enumCast<SubcoreIndex>(pBuilder->subcores.size() - 1));
-                }
-            }
+    // worker autoscaling
+    WorkerScaler *gScaler = nullptr;
+    threads::ThreadHandle *gScalerThread = nullptr;
 
-            pBuilder->cores.push_back({
-                .efficiency = pInfo->EfficiencyClass,
-                .mask = ScheduleMask(pInfo->GroupMask[0]),
-                .subcoreIds = subcoreIds
-            });
+    ScalerConfig getScalerConfig() {
+        size_t maxWorkers = gCpuGeometry.subcores.size();
+        if (size_t limit = cfgMaxWorkerCount.getCurrentValue(); limit > 0) {
+            maxWorkers = std::min(maxWorkers, limit);
         }
 
-        void addProcessorPackage(const PROCESSOR_RELATIONSHIP *pInfo) {
-            SubcoreIndices subcoreIds;
-            CoreIndices coreIds;
-            ChipletIndices chipletIds;
+        maxWorkers = std::max<size_t>(maxWorkers, 1);
 
-            for (DWORD i = 0; i < pInfo->GroupCount; ++i) {
-                GROUP_AFFINITY group = pInfo->GroupMask[i];
-                pBuilder->getCoresByMask(coreIds, group);
-                pBuilder->getSubcoresByMask(subcoreIds, group);
-                pBuilder->getChipletsByMask(chipletIds, group);
-            }
+        return {
+            .minWorkers = std::clamp<size_t>(cfgMinWorkerCount.getCurrentValue(), 1, maxWorkers),
+            .maxWorkers = maxWorkers,
+            .growLatency = std::chrono::microseconds(cfgScaleLatency.getCurrentValue())
+        };
+    }
 
-            pBuilder->packages.push_back({
-                .mask = ScheduleMask(pInfo->GroupMask[0]),
-                .cores = coreIds,
-                .subcores = subcoreIds,
-                .chiplets = chipletIds
-            });
-        }
+    // runs on its own thread rather than the timer wheel,
+    // a worker retiring itself would have to join its own thread
+    void runScaler(std::stop_token token) {
+        auto interval = std::chrono::milliseconds(std::max<size_t>(cfgScaleInterval.getCurrentValue(), 1));
 
-        void addCache(const CACHE_RELATIONSHIP& info) {
-            if (info.Level != 3) return;
+        mt::Mutex lock{"scaler.wait"};
+        std::condition_variable_any signal;
+        std::unique_lock guard(lock);
 
-            // assume everything that shares l3 cache is in the same cluster
-            // TODO: on intel E-cores and P-cores share the same l3
-            //       but we dont want to put them in the same cluster.
-            //       for now that isnt a big problem though.
-            CoreIndices coreIds;
+        while (!signal.wait_for(guard, token, interval, [&] { return token.stop_requested(); })) {
+            auto stats = gWorkPool->getStats();
 
-            for (DWORD i = 0; i < info.GroupCount; ++i) {
-                GROUP_AFFINITY group = info.GroupMasks[i];
-                pBuilder->getCoresByMask(coreIds, group);
+            std::chrono::microseconds latency{0};
+            for (const WorkLaneStats& lane : stats.lanes) {
+                latency += lane.totalLatency;
             }
 
-            pBuilder->chiplets.push_back({
-                .mask = ScheduleMask(info.GroupMasks[0]),
-                .coreIds = coreIds
+            size_t workers = ThreadService::getWorkerCount();
+            size_t target = gScaler->update({
+                .workers = workers,
+                .pending = gWorkPool->getPendingApprox(),
+                .sleeping = stats.sleeping,
+                .executed = stats.executed,
+                .latency = latency
             });
-        }
-    };
 
-    struct CpuSetLayout {
-        CpuSetLayout(GeometryBuilder *pBuilder)
-            : pBuilder(pBuilder)
-        { }
-
-        GeometryBuilder *pBuilder;
-
-        void addCpuSet(const SYSTEM_CPU_SET_INFORMATION *pInfo) {
-            auto cpuSet = pInfo->CpuSet;
-            GROUP_AFFINITY groupAffinity = {
-                .Mask = 1ull << KAFFINITY(cpuSet.LogicalProcessorIndex),
-                .Group = cpuSet.Group
-            };
-
-            CoreIndices coreIds;
-            pBuilder->getCoresByMask(coreIds, groupAffinity);
-            for (CoreIndex coreId : coreIds) {
-                pBuilder->cores[size_t(coreId)].schedule = cpuSet.SchedulingClass;
+            if (target != workers) {
+                ThreadService::setWorkerCount(target);
             }
         }
-    };
-
-    // geometry data
-    Geometry gCpuGeometry = {};
-
-    // all currently scheduled threads
-    mt::SharedMutex gThreadLock{"pool"};
-    std::vector<threads::ThreadHandle*> gThreadHandles;
-
-    // worker thread data
-    size_t gWorkerId = 0;
-    std::vector<threads::ThreadHandle*> gWorkers;
-
-    // thread communication
-    WorkQueue *gMainQueue = nullptr;
-    BlockingWorkQueue *gWorkQueue = nullptr;
+    }
 }
 
 bool ThreadService::createService() {
-    GeometryBuilder builder;
-    ProcessorInfoLayout processorInfoLayout{&builder};
-    CpuSetLayout cpuSetLayout{&builder};
+    gCpuGeometry = detail::buildGeometry();
 
-    ProcessorInfo procInfo{RelationAll};
+    LOG_INFO("CPU layout: (packages={} chiplets={} cores={} threads={})", gCpuGeometry.packages.size(), gCpuGeometry.chiplets.size(), gCpuGeometry.cores.size(), gCpuGeometry.subcores.size());
 
-    for (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *pRelation : procInfo) {
-        switch (pRelation->Relationship) {
-        case RelationProcessorCore:
-            processorInfoLayout.addProcessorCore(&pRelation->Processor);
-            break;
+    // workers are placed before the render thread exists, so its core has to be set aside now
+    gScheduler = new Scheduler(gCpuGeometry, cfgRealtimeCores.getCurrentValue());
 
-        default:
-            break;
-        }
-    }
-
-    for (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *pRelation : procInfo) {
-        switch (pRelation->Relationship) {
-        case RelationCache:
-            processorInfoLayout.addCache(pRelation->Cache);
-            break;
-
-        default:
-            break;
-        }
-    }
+    setupMemory(gCpuGeometry);
+    LOG_INFO("memory nodes: {}", gCpuGeometry.nodes.size());
 
-    for (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *pRelation : procInfo) {
-        switch (pRelation->Relationship) {
-        case RelationProcessorPackage:
-            processorInfoLayout.addProcessorPackage(&pRelation->Processor);
-            break;
+    gMainQueue = new WorkQueue(cfgMainQueueSize.getCurrentValue());
 
-        default:
-            break;
-        }
-    }
+    // reserve a deque for every worker we could ever start
+    size_t maxWorkers = cfgMaxWorkerCount.getCurrentValue();
+    size_t slots = std::max(maxWorkers, gCpuGeometry.subcores.size());
+    auto aging = std::chrono::microseconds(cfgWorkerAging.getCurrentValue());
+    gWorkPool = new WorkPool(slots, cfgWorkQueueSize.getCurrentValue(), cfgWorkerSpin.getCurrentValue(), aging);
 
-    CpuSetInfo cpuSetInfo;
+    setWorkerCount(cfgDefaultWorkerCount.getCurrentValue());
 
-    for (SYSTEM_CPU_SET_INFORMATION *pCpuSet : cpuSetInfo) {
-        switch (pCpuSet->Type) {
-        case CpuSetInformation:
-            cpuSetLayout.addCpuSet(pCpuSet);
-            break;
+    auto resolution = std::chrono::microseconds(std::max<size_t>(cfgTimerResolution.getCurrentValue(), 1));
+    gTimerWheel = new TimerWheel(*gWorkPool, resolution);
+    gTimerThread = newThread(threads::eResponsive, "timer", [](std::stop_token token) {
+        gTimerWheel->run(token);
+    });
 
-        default:
-            break;
-        }
+    if (cfgWorkerAutoscale.getCurrentValue()) {
+        gScaler = new WorkerScaler(getScalerConfig());
+        gScalerThread = newThread(threads::eBackground, "scaler", [](std::stop_token token) {
+            runScaler(token);
+        });
     }
 
-    LOG_INFO("CPU layout: (packages={} cores={} threads={} caches={})", builder.packages.size(), builder.cores.size(), builder.subcores.size(), processorInfoLayout.cacheCount);
-
-    gCpuGeometry = {
-        .subcores = builder.subcores,
-        .cores = builder.cores,
-        .chiplets = builder.chiplets,
-        .packages = builder.packages
-    };
-
-    gMainQueue = new WorkQueue(cfgMainQueueSize.getCurrentValue());
-    gWorkQueue = new BlockingWorkQueue(cfgWorkQueueSize.getCurrentValue());
-
-    setWorkerCount(cfgDefaultWorkerCount.getCurrentValue());
-
     return true;
 }
 
 void ThreadService::destroyService() {
     ThreadService::shutdown();
+
+    if constexpr (mt::isLockProfilingEnabled()) {
+        mt::dumpLockStats(cfgLockProfilePath.getCurrentValue());
+    }
 }
 
 const Geometry& ThreadService::getGeometry() {
     return gCpuGeometry;
 }
 
+const Scheduler& ThreadService::getScheduler() {
+    SM_ASSERT(gScheduler != nullptr);
+    return *gScheduler;
+}
+
 ThreadId ThreadService::getCurrentThreadId() {
-    return GetCurrentThreadId();
+    return threads::getCurrentThreadId();
 }
 
 // main thread communication
 
-void ThreadService::enqueueMain(std::string name, WorkItem&& task) {
+void ThreadService::enqueueMain(WorkName name, WorkItem&& task) {
     SM_ASSERT(gMainQueue != nullptr);
-    gMainQueue->add(std::move(name), std::move(task));
+    gMainQueue->add(name, std::move(task));
 }
 
 void ThreadService::pollMain() {
     SM_ASSERT(gMainQueue != nullptr);
-    gMainQueue->tryGetMessage();
+    gMainQueue->drain(std::chrono::microseconds(cfgMainBudget.getCurrentValue()));
+}
+
+threads::WorkQueueStats ThreadService::getMainStats() {
+    SM_ASSERT(gMainQueue != nullptr);
+    return gMainQueue->getStats();
 }
 
 // scheduler
@@ -419,52 +210,98 @@ void ThreadService::setWorkerCount(size_t count) {
         count = maxCount;
     }
 
-    LOG_INFO("starting {} workers", count);
+    auto slotCount = gWorkPool->getSlotCount();
+    if (count > slotCount) {
+        LOG_WARN("worker count {0} exceeds available worker slots {1}, clamping to {1}", count, slotCount);
+        count = slotCount;
+    }
 
-    mt::WriteLock lock(getPoolLock());
+    std::lock_guard resize(gResizeLock);
 
-    while (gWorkers.size() < count) {
-        gWorkers.push_back(newWorkerThread());
-    }
+    std::vector<threads::ThreadHandle*> retired;
+
+    {
+        mt::WriteLock lock(getPoolLock());
+
+        // the scaler resizes the pool every few frames, only log actual changes
+        if (gWorkers.size() != count) {
+            LOG_DEBUG("resizing worker pool from {} to {} workers", gWorkers.size(), count);
+        }
+
+        while (gWorkers.size() < count) {
+            gWorkers.push_back(newWorkerThread());
+        }
 
-    while (gWorkers.size() > count) {
-        auto *pWorker = gWorkers.back();
-        std::erase(gThreadHandles, pWorker); // TODO: should we use a set instead?
+        while (gWorkers.size() > count) {
+            auto *pWorker = gWorkers.back();
+            std::erase(gThreadHandles, pWorker); // TODO: should we use a set instead?
 
-        gWorkers.pop_back();
-        pWorker->requestStop();
-        delete pWorker;
+            gWorkers.pop_back();
+            pWorker->requestStop();
+            retired.push_back(pWorker);
+        }
+
+        gWorkerCount.store(gWorkers.size());
+        publishThreads();
+    }
+
+    // a retiring worker may still be finishing a parallel call,
+    // so it has to be joined without the pool lock held
+    for (auto *pWorker : retired) {
+        deleteThread(pWorker);
     }
 }
 
 size_t ThreadService::getWorkerCount() {
-    mt::ReadLock lock(getPoolLock());
-    return gWorkers.size();
+    return gWorkerCount.load();
+}
+
+void ThreadService::enqueueWork(threads::WorkName name, threads::WorkItem&& func, threads::ThreadType priority) {
+    SM_ASSERT(gWorkPool != nullptr);
+    gWorkPool->add(name, std::move(func), priority);
 }
 
-void ThreadService::enqueueWork(std::string name, threads::WorkItem&& func) {
-    SM_ASSERT(gWorkQueue != nullptr);
-    gWorkQueue->add(std::move(name), std::move(func));
+threads::WorkPoolStats ThreadService::getWorkStats() {
+    SM_ASSERT(gWorkPool != nullptr);
+    return gWorkPool->getStats();
+}
+
+// timers
+
+threads::TimerHandle ThreadService::addTimer(threads::WorkName name, threads::TimerClock::duration delay, threads::WorkItem&& fn) {
+    SM_ASSERT(gTimerWheel != nullptr);
+    return gTimerWheel->addOnce(name, delay, std::move(fn));
+}
+
+threads::TimerHandle ThreadService::addPeriodic(threads::WorkName name, threads::TimerClock::duration period, threads::WorkItem&& fn) {
+    SM_ASSERT(gTimerWheel != nullptr);
+    return gTimerWheel->addPeriodic(name, period, std::move(fn));
+}
+
+std::optional<threads::ScalerStats> ThreadService::getScalerStats() {
+    if (gScaler == nullptr) return std::nullopt;
+
+    return gScaler->getStats();
+}
+
+threads::TimerStats ThreadService::getTimerStats() {
+    SM_ASSERT(gTimerWheel != nullptr);
+    return gTimerWheel->getStats();
 }
 
 threads::ThreadHandle *ThreadService::newThread(threads::ThreadType type, std::string name, threads::ThreadStart&& start) {
     auto *pHandle = newThreadInner(type, name, std::move(start));
 
     mt::WriteLock lock(getPoolLock());
-    getPool().push_back(pHandle);
+    gThreadHandles.push_back(pHandle);
+    publishThreads();
     return pHandle;
 }
 
 threads::ThreadHandle *ThreadService::newWorkerThread() {
-    const auto kWorkerBody = [](std::stop_token token) {
-        WorkMessage msg;
-        auto interval = std::chrono::milliseconds(cfgWorkerDelay.getCurrentValue());
-
-        while (!token.stop_requested()) {
-            if (gWorkQueue->tryGetMessage(msg, interval)) {
-                msg.item();
-            }
-        }
+    // workers are always added and removed from the back, so the slot is our position
+    const auto kWorkerBody = [slot = gWorkers.size()](std::stop_token token) {
+        gWorkPool->runWorker(slot, token);
     };
 
     auto id = fmt::format("work.{}", gWorkerId++);
@@ -474,33 +311,100 @@ threads::ThreadHandle *ThreadService::newWorkerThread() {
 }
 
 threads::ThreadHandle *ThreadService::newThreadInner(threads::ThreadType type, std::string name, threads::ThreadStart&& start) {
-    ScheduleMask mask = {};
+    SubcoreIndex subcore = gScheduler->addThread(type, name);
+
+    // threads stay on their subcore, so whatever they own should live on the same node
+    if (NodeIndex node = getSubcoreNode(subcore); node != NodeIndex::eInvalid && cfgLocalMemory.getCurrentValue()) {
+        start = [node, inner = std::move(start)](std::stop_token token) {
+            setCurrentNode(node);
+            core::setFrameArenaMemory(getLocalMemory());
+
+            inner(token);
+        };
+    }
+
     auto *pHandle = new threads::ThreadHandle({
         .type = type,
-        .mask = mask,
+        .mask = gScheduler->getMask(subcore),
         .name = name,
         .start = std::move(start)
     });
 
+    pHandle->subcore = subcore;
     return pHandle;
 }
 
+void ThreadService::publishThreads() {
+    const ThreadList *pOld = gThreadList.exchange(new ThreadList(gThreadHandles), std::memory_order_acq_rel);
+    gThreadEpoch.retire(pOld);
+}
+
+void ThreadService::unpublishThread(threads::ThreadHandle *pHandle) {
+    {
+        mt::WriteLock lock(getPoolLock());
+        std::erase(gThreadHandles, pHandle);
+        publishThreads();
+    }
+
+    deleteThread(pHandle);
+}
+
+void ThreadService::deleteThread(threads::ThreadHandle *pHandle) {
+    ThreadType type = pHandle->getType();
+    SubcoreIndex subcore = pHandle->getSubcore();
+
+    pHandle->join();
+    gScheduler->removeThread(type, subcore);
+
+    // the handle has to be unpublished already, but a ThreadView taken before that could still be using it
+    gThreadEpoch.retire(pHandle);
+}
+
 void ThreadService::shutdown() {
-    mt::WriteLock lock(getPoolLock());
+    // the scaler resizes the pool, so it has to finish before the workers go away
+    if (gScalerThread != nullptr) {
+        unpublishThread(gScalerThread);
+        gScalerThread = nullptr;
+    }
 
     // TODO: make sure all other threads are stopped
 
+    // stop dispatching timers before the workers they dispatch to go away
+    if (gTimerThread != nullptr) {
+        unpublishThread(gTimerThread);
+        gTimerThread = nullptr;
+    }
+
     // services are expected to join their own threads
     // we only need to join the worker threads here
-    for (auto *pHandle : gWorkers) {
-        pHandle->join();
+    std::lock_guard resize(gResizeLock);
+
+    std::vector<threads::ThreadHandle*> workers;
+
+    {
+        mt::WriteLock lock(getPoolLock());
+
+        for (auto *pHandle : gWorkers) {
+            pHandle->requestStop();
+            std::erase(gThreadHandles, pHandle);
+        }
+
+        workers = std::move(gWorkers);
+        gWorkers.clear();
+        gWorkerCount.store(0);
+
+        publishThreads();
     }
 
-    for (auto *pHandle : gWorkers) {
-        delete pHandle;
+    // like resizing, workers are joined without the pool lock held
+    for (auto *pHandle : workers) {
+        deleteThread(pHandle);
     }
-    gWorkers.clear();
+
+    // nothing we stopped is left for a reader to find
+    gThreadEpoch.synchronize();
 }
 
 mt::SharedMutex &ThreadService::getPoolLock() { return gThreadLock; }
-std::vector<threads::ThreadHandle*> &ThreadService::getPool() { return gThreadHandles; }
+threads::ThreadView ThreadService::getThreads() { return { gThreadEpoch, gThreadList }; }
+mt::EpochStats ThreadService::getThreadEpochStats() { return gThreadEpoch.getStats(); }
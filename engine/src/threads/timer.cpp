@@ -0,0 +1,265 @@
+#include "engine/threads/timer.h"
+#include "engine/threads/pool.h"
+
+#include "engine/core/panic.h"
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+struct detail::TimerEntry {
+    WorkName name;
+    WorkItem fn;
+
+    TimerClock::duration period; // zero for one shot timers
+    TimerClock::time_point deadline;
+    uint64_t expires = 0; // the tick this entry is due on
+
+    std::atomic_uint32_t state = 0;
+};
+
+namespace {
+    constexpr uint32_t kRunning = (1 << 0);
+    constexpr uint32_t kCancelled = (1 << 1);
+    constexpr uint32_t kDone = (1 << 2);
+
+    // the timer callback running on this thread, lets a callback cancel its own timer
+    thread_local detail::TimerEntry *tlsCurrentEntry = nullptr;
+}
+
+// handle
+
+void TimerHandle::cancel() {
+    if (pEntry == nullptr) return;
+
+    uint32_t state = pEntry->state.fetch_or(kCancelled);
+
+    // waiting on ourselves would never finish
+    if (tlsCurrentEntry == pEntry.get()) return;
+
+    while (state & kRunning) {
+        pEntry->state.wait(state);
+        state = pEntry->state.load();
+    }
+}
+
+bool TimerHandle::isActive() const {
+    if (pEntry == nullptr) return false;
+
+    return (pEntry->state.load() & (kCancelled | kDone)) == 0;
+}
+
+// wheel
+
+TimerWheel::TimerWheel(WorkPool& pool, Duration resolution, TimePoint start)
+    : pool(pool)
+    , resolution(resolution)
+    , start(start)
+{
+    SM_ASSERTF(resolution.count() > 0, "timer resolution must be positive");
+}
+
+TimerHandle TimerWheel::addOnce(WorkName name, Duration delay, WorkItem&& fn) {
+    return addAt(name, TimerClock::now() + delay, std::move(fn));
+}
+
+TimerHandle TimerWheel::addAt(WorkName name, TimePoint deadline, WorkItem&& fn) {
+    auto pEntry = std::make_shared<detail::TimerEntry>(name, std::move(fn), Duration::zero(), deadline);
+    return addEntry(std::move(pEntry));
+}
+
+TimerHandle TimerWheel::addPeriodic(WorkName name, Duration period, WorkItem&& fn) {
+    SM_ASSERTF(period.count() > 0, "timer {} has an empty period", name.get());
+
+    auto pEntry = std::make_shared<detail::TimerEntry>(name, std::move(fn), period, TimerClock::now() + period);
+    return addEntry(std::move(pEntry));
+}
+
+TimerHandle TimerWheel::addEntry(EntryPtr pEntry) {
+    TimerHandle handle{pEntry};
+
+    std::lock_guard guard(lock);
+    pEntry->expires = getTick(pEntry->deadline);
+    insert(std::move(pEntry));
+    active += 1;
+
+    // the new timer may be due before whatever the thread is waiting on
+    bChanged = true;
+    signal.notify_one();
+
+    return handle;
+}
+
+void TimerWheel::run(std::stop_token token) {
+    std::unique_lock guard(lock);
+
+    while (!token.stop_requested()) {
+        advanceTo(TimerClock::now());
+
+        bChanged = false;
+        const auto kWake = [&] { return bChanged; };
+
+        if (active == 0) {
+            signal.wait(guard, token, kWake);
+        } else {
+            signal.wait_until(guard, token, getTime(getNextTick()), kWake);
+        }
+    }
+}
+
+void TimerWheel::poll(TimePoint now) {
+    std::lock_guard guard(lock);
+    advanceTo(now);
+}
+
+TimerStats TimerWheel::getStats() const {
+    size_t count = 0;
+    {
+        std::lock_guard guard(lock);
+        count = active;
+    }
+
+    return {
+        .active = count,
+        .fired = fired.load(),
+        .skipped = skipped.load(),
+        .overruns = overruns.load(),
+        .cascades = cascades.load()
+    };
+}
+
+uint64_t TimerWheel::getTick(TimePoint time) const {
+    // round up so timers never fire early
+    auto ticks = (time - start + resolution - Duration(1)) / resolution;
+    return std::max<uint64_t>(ticks, currentTick + 1);
+}
+
+TimerWheel::TimePoint TimerWheel::getTime(uint64_t tick) const {
+    return start + resolution * tick;
+}
+
+void TimerWheel::insert(EntryPtr pEntry) {
+    // a cascade runs before the current slot is dispatched, so entries due this tick
+    // land in that slot and fire now rather than a tick late
+    uint64_t expires = std::max(pEntry->expires, currentTick);
+    uint64_t delta = expires - currentTick;
+
+    for (size_t level = 0; level < kLevelCount; level++) {
+        size_t shift = kLevelBits * level;
+        bool bLast = level == kLevelCount - 1;
+        uint64_t range = 1ull << (shift + kLevelBits);
+
+        if (delta >= range && !bLast) continue;
+
+        // anything beyond the wheel is parked in the furthest slot and reinserted when it cascades
+        uint64_t tick = (delta >= range) ? currentTick + range - 1 : expires;
+        levels[level][(tick >> shift) & kSlotMask].push_back(std::move(pEntry));
+        return;
+    }
+}
+
+void TimerWheel::cascade(size_t level) {
+    size_t shift = kLevelBits * level;
+    Slot& slot = levels[level][(currentTick >> shift) & kSlotMask];
+
+    Slot entries = std::move(slot);
+    slot.clear();
+
+    cascades += entries.size();
+    for (EntryPtr& pEntry : entries) {
+        insert(std::move(pEntry));
+    }
+}
+
+void TimerWheel::advance() {
+    currentTick += 1;
+
+    // when the lower levels wrap around pull the next slot of the level above down,
+    // starting from the top so entries can fall more than one level at once
+    size_t wrapped = 0;
+    while (wrapped + 1 < kLevelCount) {
+        uint64_t mask = (1ull << (kLevelBits * (wrapped + 1))) - 1;
+        if ((currentTick & mask) != 0) break;
+
+        wrapped += 1;
+    }
+
+    for (size_t level = wrapped; level > 0; level--) {
+        cascade(level);
+    }
+
+    Slot& slot = levels[0][currentTick & kSlotMask];
+    Slot due = std::move(slot);
+    slot.clear();
+
+    TimePoint now = getTime(currentTick);
+    for (EntryPtr& pEntry : due) {
+        if (pEntry->expires > currentTick) {
+            insert(std::move(pEntry));
+        } else {
+            fire(std::move(pEntry), now);
+        }
+    }
+}
+
+void TimerWheel::advanceTo(TimePoint now) {
+    while (getTime(currentTick + 1) <= now) {
+        advance();
+    }
+}
+
+void TimerWheel::fire(EntryPtr pEntry, TimePoint now) {
+    uint32_t state = pEntry->state.load();
+    if (state & kCancelled) {
+        active -= 1;
+        return;
+    }
+
+    bool bPeriodic = pEntry->period.count() > 0;
+
+    if (bPeriodic) {
+        // schedule from the old deadline so the period doesnt drift,
+        // but dont try and make up for periods we missed entirely
+        pEntry->deadline += pEntry->period;
+        if (pEntry->deadline <= now) {
+            auto missed = (now - pEntry->deadline) / pEntry->period + 1;
+            pEntry->deadline += pEntry->period * missed;
+            overruns += size_t(missed);
+        }
+
+        pEntry->expires = getTick(pEntry->deadline);
+        insert(pEntry);
+    } else {
+        active -= 1;
+    }
+
+    // a periodic timer thats still running from last time skips this period
+    uint32_t expected = 0;
+    uint32_t desired = bPeriodic ? kRunning : (kRunning | kDone);
+    if (!pEntry->state.compare_exchange_strong(expected, desired)) {
+        skipped += 1;
+        return;
+    }
+
+    fired += 1;
+    WorkName name = pEntry->name;
+    pool.add(name, [pEntry = std::move(pEntry)] {
+        tlsCurrentEntry = pEntry.get();
+        pEntry->fn();
+        tlsCurrentEntry = nullptr;
+
+        pEntry->state.fetch_and(~kRunning);
+        pEntry->state.notify_all();
+    }, eResponsive);
+}
+
+uint64_t TimerWheel::getNextTick() const {
+    // the next level 0 slot with anything in it, or the next cascade if theres nothing before it
+    uint64_t boundary = (currentTick | kSlotMask) + 1;
+    for (uint64_t tick = currentTick + 1; tick < boundary; tick++) {
+        if (!levels[0][tick & kSlotMask].empty()) {
+            return tick;
+        }
+    }
+
+    return boundary;
+}
@@ -0,0 +1,351 @@
+#include "common.h"
+
+#include "engine/core/error.h"
+#include "engine/debug/service.h"
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+namespace {
+    using detail::GeometryBuilder;
+
+    template<typename T>
+    T *advance(T *ptr, size_t bytes) {
+        return reinterpret_cast<T*>(reinterpret_cast<std::byte*>(ptr) + bytes);
+    }
+
+    // older versions of windows leave the group count as 0 and only fill in the first mask
+    ScheduleMasks getGroupMasks(const GROUP_AFFINITY *pGroups, WORD count) {
+        ScheduleMasks masks;
+        for (WORD i = 0; i < std::max<WORD>(count, 1); ++i) {
+            masks.push_back(ScheduleMask(pGroups[i]));
+        }
+
+        return masks;
+    }
+
+    struct ProcessorInfoIterator {
+        ProcessorInfoIterator(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *pBuffer, DWORD remaining)
+            : pBuffer(pBuffer)
+            , remaining(remaining)
+        { }
+
+        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *operator++() {
+            SM_ASSERT(remaining > 0);
+
+            remaining -= pBuffer->Size;
+            if (remaining > 0) {
+                pBuffer = advance(pBuffer, pBuffer->Size);
+            }
+
+            return pBuffer;
+        }
+
+        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *operator*() const {
+            return pBuffer;
+        }
+
+        bool operator==(const ProcessorInfoIterator& other) const {
+            return remaining == other.remaining;
+        }
+
+    private:
+        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *pBuffer;
+        DWORD remaining;
+    };
+
+    // GetLogicalProcessorInformationEx provides information about inter-core communication
+    struct ProcessorInfo {
+        ProcessorInfo(LOGICAL_PROCESSOR_RELATIONSHIP relation) {
+            if (GetLogicalProcessorInformationEx(relation, nullptr, &bufferSize)) {
+                core::throwNonFatal("GetLogicalProcessorInformationEx did not fail");
+            }
+
+            if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
+                debug::throwLastError("GetLogicalProcessorInformationEx did not fail with ERROR_INSUFFICIENT_BUFFER");
+            }
+
+            memory = std::make_unique<std::byte[]>(bufferSize);
+            pBuffer = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *>(memory.get());
+            if (!GetLogicalProcessorInformationEx(relation, pBuffer, &bufferSize)) {
+                debug::throwLastError("GetLogicalProcessorInformationEx failed");
+            }
+
+            remaining = bufferSize;
+        }
+
+        ProcessorInfoIterator begin() const {
+            return ProcessorInfoIterator(pBuffer, remaining);
+        }
+
+        ProcessorInfoIterator end() const {
+            return ProcessorInfoIterator(pBuffer, 0);
+        }
+
+    private:
+        std::unique_ptr<std::byte[]> memory;
+        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *pBuffer;
+        DWORD bufferSize = 0;
+
+        DWORD remaining = 0;
+    };
+
+    // GetSystemCpuSetInformation provides information about cpu speeds
+    struct CpuSetIterator {
+        CpuSetIterator(SYSTEM_CPU_SET_INFORMATION *pBuffer, ULONG remaining)
+            : pBuffer(pBuffer)
+            , remaining(remaining)
+        { }
+
+        SYSTEM_CPU_SET_INFORMATION *operator++() {
+            SM_ASSERT(remaining > 0);
+
+            remaining -= pBuffer->Size;
+            if (remaining > 0) {
+                pBuffer = advance(pBuffer, pBuffer->Size);
+            }
+
+            return pBuffer;
+        }
+
+        SYSTEM_CPU_SET_INFORMATION *operator*() const {
+            return pBuffer;
+        }
+
+        bool operator==(const CpuSetIterator& other) const {
+            return remaining == other.remaining;
+        }
+
+    private:
+        SYSTEM_CPU_SET_INFORMATION *pBuffer;
+        ULONG remaining;
+    };
+
+    struct CpuSetInfo {
+        CpuSetInfo() {
+            if (GetSystemCpuSetInformation(nullptr, 0, &bufferSize, GetCurrentProcess(), 0)) {
+                core::throwNonFatal("GetSystemCpuSetInformation did not fail");
+            }
+
+            if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
+                debug::throwLastError("GetSystemCpuSetInformation did not fail with ERROR_INSUFFICIENT_BUFFER");
+            }
+
+            memory = std::make_unique<std::byte[]>(bufferSize);
+            pBuffer = reinterpret_cast<SYSTEM_CPU_SET_INFORMATION *>(memory.get());
+            if (!GetSystemCpuSetInformation(pBuffer, bufferSize, &bufferSize, GetCurrentProcess(), 0)) {
+                debug::throwLastError("GetSystemCpuSetInformation failed");
+            }
+
+            remaining = bufferSize;
+        }
+
+        CpuSetIterator begin() const {
+            return CpuSetIterator(pBuffer, remaining);
+        }
+
+        CpuSetIterator end() const {
+            return CpuSetIterator(pBuffer, 0);
+        }
+    private:
+        std::unique_ptr<std::byte[]> memory;
+        SYSTEM_CPU_SET_INFORMATION *pBuffer;
+        ULONG bufferSize = 0;
+
+        ULONG remaining = 0;
+    };
+
+    struct ProcessorInfoLayout {
+        ProcessorInfoLayout(GeometryBuilder *pBuilder)
+            : pBuilder(pBuilder)
+        { }
+
+        GeometryBuilder *pBuilder;
+
+        static constexpr KAFFINITY KAFFINITY_BITS = std::numeric_limits<KAFFINITY>::digits;
+
+        void addProcessorCore(const PROCESSOR_RELATIONSHIP *pInfo) {
+            SubcoreIndices subcoreIds;
+
+            for (DWORD i = 0; i < pInfo->GroupCount; ++i) {
+                GROUP_AFFINITY group = pInfo->GroupMask[i];
+
+                for (size_t bit = 0; bit < KAFFINITY_BITS; ++bit) {
+                    KAFFINITY mask = 1ull << bit;
+                    if (!(group.Mask & mask)) continue;
+
+                    GROUP_AFFINITY groupAffinity = {
+                        .Mask = group.Mask & mask,
+                        .Group = group.Group,
+                    };
+
+                    pBuilder->subcores.push_back({
+                        .mask = ScheduleMask(groupAffinity)
+                    });
+
+                    subcoreIds.push_back(core::enumCast<SubcoreIndex>(pBuilder->subcores.size() - 1));
+                }
+            }
+
+            pBuilder->cores.push_back({
+                .efficiency = pInfo->EfficiencyClass,
+                .masks = getGroupMasks(pInfo->GroupMask, pInfo->GroupCount),
+                .subcoreIds = subcoreIds
+            });
+        }
+
+        void addProcessorPackage(const PROCESSOR_RELATIONSHIP *pInfo) {
+            SubcoreIndices subcoreIds;
+            CoreIndices coreIds;
+            ChipletIndices chipletIds;
+
+            for (DWORD i = 0; i < pInfo->GroupCount; ++i) {
+                ScheduleMask group = ScheduleMask(pInfo->GroupMask[i]);
+                pBuilder->getCoresByMask(coreIds, group);
+                pBuilder->getSubcoresByMask(subcoreIds, group);
+                pBuilder->getChipletsByMask(chipletIds, group);
+            }
+
+            pBuilder->packages.push_back({
+                .masks = getGroupMasks(pInfo->GroupMask, pInfo->GroupCount),
+                .cores = coreIds,
+                .subcores = subcoreIds,
+                .chiplets = chipletIds
+            });
+        }
+
+        void addCache(const CACHE_RELATIONSHIP& info) {
+            if (info.Level != 3) return;
+
+            // assume everything that shares l3 cache is in the same cluster
+            // TODO: on intel E-cores and P-cores share the same l3
+            //       but we dont want to put them in the same cluster.
+            //       for now that isnt a big problem though.
+            CoreIndices coreIds;
+
+            for (DWORD i = 0; i < info.GroupCount; ++i) {
+                ScheduleMask group = ScheduleMask(info.GroupMasks[i]);
+                pBuilder->getCoresByMask(coreIds, group);
+            }
+
+            pBuilder->chiplets.push_back({
+                .masks = getGroupMasks(info.GroupMasks, info.GroupCount),
+                .coreIds = coreIds
+            });
+        }
+
+        void addNumaNode(const NUMA_NODE_RELATIONSHIP& info) {
+            SubcoreIndices subcoreIds;
+            CoreIndices coreIds;
+            ChipletIndices chipletIds;
+
+            // older versions of windows only fill in GroupMask and leave GroupCount as 0
+            WORD groupCount = std::max<WORD>(info.GroupCount, 1);
+            for (WORD i = 0; i < groupCount; ++i) {
+                ScheduleMask group = ScheduleMask(info.GroupMasks[i]);
+                pBuilder->getCoresByMask(coreIds, group);
+                pBuilder->getSubcoresByMask(subcoreIds, group);
+                pBuilder->getChipletsByMask(chipletIds, group);
+            }
+
+            if (coreIds.empty()) return;
+
+            pBuilder->nodes.push_back({
+                .id = info.NodeNumber,
+                .masks = getGroupMasks(info.GroupMasks, groupCount),
+                .cores = coreIds,
+                .subcores = subcoreIds,
+                .chiplets = chipletIds
+            });
+        }
+    };
+
+    struct CpuSetLayout {
+        CpuSetLayout(GeometryBuilder *pBuilder)
+            : pBuilder(pBuilder)
+        { }
+
+        GeometryBuilder *pBuilder;
+
+        void addCpuSet(const SYSTEM_CPU_SET_INFORMATION *pInfo) {
+            auto cpuSet = pInfo->CpuSet;
+            GROUP_AFFINITY groupAffinity = {
+                .Mask = 1ull << KAFFINITY(cpuSet.LogicalProcessorIndex),
+                .Group = cpuSet.Group
+            };
+
+            CoreIndices coreIds;
+            pBuilder->getCoresByMask(coreIds, ScheduleMask(groupAffinity));
+            for (CoreIndex coreId : coreIds) {
+                pBuilder->cores[size_t(coreId)].schedule = cpuSet.SchedulingClass;
+            }
+        }
+    };
+}
+
+Geometry detail::buildGeometry() {
+    GeometryBuilder builder;
+    ProcessorInfoLayout processorInfoLayout{&builder};
+    CpuSetLayout cpuSetLayout{&builder};
+
+    ProcessorInfo procInfo{RelationAll};
+
+    for (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *pRelation : procInfo) {
+        switch (pRelation->Relationship) {
+        case RelationProcessorCore:
+            processorInfoLayout.addProcessorCore(&pRelation->Processor);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    for (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *pRelation : procInfo) {
+        switch (pRelation->Relationship) {
+        case RelationCache:
+            processorInfoLayout.addCache(pRelation->Cache);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    for (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *pRelation : procInfo) {
+        switch (pRelation->Relationship) {
+        case RelationProcessorPackage:
+            processorInfoLayout.addProcessorPackage(&pRelation->Processor);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    for (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *pRelation : procInfo) {
+        switch (pRelation->Relationship) {
+        case RelationNumaNode:
+            processorInfoLayout.addNumaNode(pRelation->NumaNode);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    CpuSetInfo cpuSetInfo;
+
+    for (SYSTEM_CPU_SET_INFORMATION *pCpuSet : cpuSetInfo) {
+        switch (pCpuSet->Type) {
+        case CpuSetInformation:
+            cpuSetLayout.addCpuSet(pCpuSet);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return builder.build();
+}
@@ -0,0 +1,34 @@
+#include "engine/threads/memory.h"
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+size_t detail::getPageSize() {
+    static const size_t kPageSize = [] {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return size_t(info.dwPageSize);
+    }();
+
+    return kPageSize;
+}
+
+// VirtualAllocExNuma is only a preference, windows will still fall back to other nodes when this one is full
+void *detail::allocateNodePages(size_t size, uint32_t node, bool& bBound) {
+    if (void *pMemory = VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node)) {
+        return pMemory;
+    }
+
+    bBound = false;
+    return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void detail::freeNodePages(void *pMemory, size_t) {
+    VirtualFree(pMemory, 0, MEM_RELEASE);
+}
+
+// windows already allocates from the node of a threads ideal processor,
+// and our threads are pinned, so there is no policy to set
+bool detail::setThreadMemoryNode(uint32_t) {
+    return false;
+}
@@ -0,0 +1,74 @@
+#include "common.h"
+
+#include "engine/threads/service.h"
+#include "engine/log/service.h"
+#include "engine/debug/service.h"
+
+#include <intsafe.h>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+DWORD WINAPI ThreadHandle::threadThunk(LPVOID lpParameter) {
+    auto *pInfo = static_cast<detail::ThreadStartInfo*>(lpParameter);
+    debug::setThreadName(pInfo->name);
+
+    return detail::runThread(pInfo, threads::getCurrentThreadId());
+}
+
+ThreadHandle::ThreadHandle(ThreadInfo&& info)
+    : type(info.type)
+    , mask(info.mask)
+    , name(info.name)
+{
+    auto *pStart = new detail::ThreadStartInfo {
+        .start = std::move(info.start),
+        .token = stopper.get_token(),
+        .name = name
+    };
+
+    hThread = CreateThread(
+        /*lpThreadAttributes=*/ nullptr,
+        /*dwStackSize=*/ 0,
+        /*lpStartAddress=*/ ThreadHandle::threadThunk,
+        /*lpParameter=*/ pStart, // deleted by threadThunk
+        /*dwCreationFlags=*/ CREATE_SUSPENDED,
+        /*lpThreadId=*/ &id
+    );
+
+    if (hThread == nullptr) {
+        debug::throwLastError("CreateThread");
+    }
+
+    const GROUP_AFFINITY affinity = mask;
+    if (SetThreadGroupAffinity(hThread, &affinity, nullptr) == 0) {
+        auto msg = fmt::format("SetThreadGroupAffinity failed. thread affinity mask: {}", mask);
+        debug::throwLastError(msg);
+    }
+
+    if (ResumeThread(hThread) == DWORD_MAX) {
+        debug::throwLastError("ResumeThread");
+    }
+
+    LOG_INFO("created thread (name={}, id={:#06x}) with mask {}", name, id, mask);
+}
+
+ThreadHandle::~ThreadHandle() {
+    if (hThread == nullptr) return;
+
+    // TODO: make sure the thread closes
+    join();
+
+    CloseHandle(hThread);
+}
+
+void ThreadHandle::join() {
+    stopper.request_stop();
+    if (WaitForSingleObject(hThread, INFINITE) != WAIT_OBJECT_0) {
+        debug::throwLastError(fmt::format("WaitForSingleObject failed for thread (name={}, id={:#06x})", name, id));
+    }
+}
+
+ThreadId threads::getCurrentThreadId() {
+    return ::GetCurrentThreadId();
+}
@@ -0,0 +1,200 @@
+#include "test.h"
+
+#include "engine/core/bitmap.h"
+
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace simcoe;
+using namespace simcoe::core;
+
+// checks both bitmaps against a reference set of free bits
+
+namespace {
+    // sizes either side of a word and of each summary level
+    constexpr size_t kSizes[] = {
+        1, 2, 63, 64, 65, 100, 127, 128, 129,
+        4095, 4096, 4097,
+        262143, 262144, 262145,
+        65536 // the descriptor heap
+    };
+
+    constexpr size_t kThreads = 4;
+
+    template<typename M>
+    using Index = typename M::Index;
+
+    // allocating from empty hands out every bit in order, then nothing
+    template<typename M>
+    void testFill(M& map, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            if (!SM_CHECK(map.alloc() == Index<M>(i))) return;
+        }
+
+        SM_CHECK(map.alloc() == Index<M>::eInvalid);
+        SM_CHECK(map.countSetBits() == size);
+    }
+
+    template<typename M>
+    void testFullAndRefill(size_t size) {
+        M map{size};
+        SM_CHECK(map.getTotalBits() == size);
+        SM_CHECK(map.getCapacity() >= size);
+
+        testFill(map, size);
+
+        // free every third bit, they come back lowest first
+        std::vector<size_t> freed;
+        for (size_t i = 0; i < size; i += 3) {
+            map.release(Index<M>(i));
+            freed.push_back(i);
+        }
+
+        SM_CHECK(map.countSetBits() == size - freed.size());
+
+        for (size_t i : freed) {
+            if (!SM_CHECK(map.alloc() == Index<M>(i))) break;
+        }
+
+        SM_CHECK(map.alloc() == Index<M>::eInvalid);
+
+        // releasing something that was never set changes nothing
+        map.release(Index<M>(size - 1));
+        map.release(Index<M>(size - 1));
+        SM_CHECK(map.countSetBits() == size - 1);
+        SM_CHECK(map.alloc() == Index<M>(size - 1));
+
+        map.reset();
+        SM_CHECK(map.countSetBits() == 0);
+        testFill(map, size);
+    }
+
+    // random allocs and releases, every alloc must be the lowest free bit
+    template<typename M>
+    void testReference(size_t size, size_t steps) {
+        M map{size};
+        std::set<size_t> free;
+        for (size_t i = 0; i < size; i++) {
+            free.insert(i);
+        }
+
+        std::mt19937_64 rng{size};
+        for (size_t step = 0; step < steps; step++) {
+            size_t roll = rng() % 8;
+            if (roll < 4) {
+                Index<M> index = map.alloc();
+                if (free.empty()) {
+                    if (!SM_CHECK(index == Index<M>::eInvalid)) return;
+                    continue;
+                }
+
+                if (!SM_CHECK(index == Index<M>(*free.begin()))) return;
+                free.erase(free.begin());
+            } else if (roll < 7) {
+                size_t bit = rng() % size;
+                map.release(Index<M>(bit));
+                free.insert(bit);
+            } else {
+                size_t bit = rng() % size;
+                bool bSet = map.testSet(bit);
+                if (!SM_CHECK(bSet == free.contains(bit))) return;
+                free.erase(bit);
+            }
+
+            if (!SM_CHECK(map.countSetBits() == size - free.size())) return;
+        }
+
+        for (size_t i = 0; i < size; i++) {
+            if (!SM_CHECK(map.test(Index<M>(i)) != free.contains(i))) return;
+        }
+    }
+
+    // threads churn through the map, no bit may be handed to two threads at once
+    void testConcurrent(size_t size, size_t iterations) {
+        AtomicBitMap map{size};
+        std::unique_ptr<std::atomic_bool[]> owned{new std::atomic_bool[size]};
+        for (size_t i = 0; i < size; i++) {
+            owned[i].store(false);
+        }
+
+        std::atomic_size_t duplicates = 0;
+        std::atomic_size_t invalid = 0;
+
+        std::vector<std::jthread> threads;
+        for (size_t t = 0; t < kThreads; t++) {
+            threads.emplace_back([&, t] {
+                std::mt19937_64 rng{t};
+                std::vector<size_t> held;
+
+                for (size_t i = 0; i < iterations; i++) {
+                    // hold on to up to a quarter of the map each so it runs close to full
+                    if (held.size() < size / kThreads && rng() % 3 != 0) {
+                        AtomicBitMap::Index index = map.alloc();
+                        if (index == AtomicBitMap::Index::eInvalid) {
+                            invalid += 1;
+                            continue;
+                        }
+
+                        if (owned[size_t(index)].exchange(true)) {
+                            duplicates += 1;
+                        }
+
+                        held.push_back(size_t(index));
+                    } else if (!held.empty()) {
+                        size_t at = rng() % held.size();
+                        size_t bit = held[at];
+                        held[at] = held.back();
+                        held.pop_back();
+
+                        owned[bit].store(false);
+                        map.release(AtomicBitMap::Index(bit));
+                    }
+                }
+
+                for (size_t bit : held) {
+                    owned[bit].store(false);
+                    map.release(AtomicBitMap::Index(bit));
+                }
+            });
+        }
+
+        for (std::jthread& thread : threads) {
+            thread.join();
+        }
+
+        SM_CHECK(duplicates == 0);
+        SM_CHECK(invalid == 0);
+        SM_CHECK(map.countSetBits() == 0);
+
+        // whatever state the summary was left in, every bit is still reachable
+        std::set<size_t> seen;
+        for (size_t i = 0; i < size; i++) {
+            AtomicBitMap::Index index = map.alloc();
+            if (!SM_CHECK(index != AtomicBitMap::Index::eInvalid)) break;
+            seen.insert(size_t(index));
+        }
+
+        SM_CHECK(seen.size() == size);
+        SM_CHECK(map.alloc() == AtomicBitMap::Index::eInvalid);
+    }
+}
+
+int main() {
+    for (size_t size : kSizes) {
+        testFullAndRefill<BitMap>(size);
+        testFullAndRefill<AtomicBitMap>(size);
+    }
+
+    for (size_t size : { 1, 63, 65, 300, 5000, 70000 }) {
+        testReference<BitMap>(size, 50000);
+        testReference<AtomicBitMap>(size, 50000);
+    }
+
+    testConcurrent(64, 200000);
+    testConcurrent(4097, 200000);
+    testConcurrent(65536, 200000);
+
+    return test::finish("bitmap");
+}
@@ -0,0 +1,278 @@
+#include "test.h"
+
+#include "engine/threads/messages.h"
+
+#include <thread>
+#include <vector>
+
+using namespace simcoe;
+using namespace simcoe::mt;
+
+// pushes sequence numbers through channels and checks what comes out the other end
+
+namespace {
+    using namespace std::chrono_literals;
+    using TestClock = std::chrono::steady_clock;
+
+    constexpr size_t kItems = 200000;
+    constexpr size_t kProducers = 4;
+
+    // producer in the top bits, sequence in the bottom bits
+    constexpr size_t kProducerShift = 40;
+    constexpr size_t kSequenceMask = (size_t(1) << kProducerShift) - 1;
+
+    template<typename C>
+    void produce(C& channel, size_t producer, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            channel.push((producer << kProducerShift) | i);
+        }
+    }
+
+    void testSpscOrder() {
+        SpscChannel<size_t> channel{"test.spsc", 64};
+
+        std::jthread producer([&] { produce(channel, 0, kItems); });
+
+        size_t expected = 0;
+        size_t item = 0;
+        while (expected < kItems && channel.pop(item, 1s)) {
+            if (!SM_CHECK(item == expected)) break;
+            expected += 1;
+        }
+
+        producer.join();
+
+        ChannelStats stats = channel.getStats();
+        SM_CHECK(expected == kItems);
+        SM_CHECK(stats.pushed == kItems);
+        SM_CHECK(stats.popped == kItems);
+        SM_CHECK(stats.dropped == 0);
+        SM_CHECK(stats.failed == 0);
+    }
+
+    // every producers items arrive in order, and none go missing
+    void testMpscOrder() {
+        MpscChannel<size_t> channel{"test.mpsc", 64};
+
+        std::vector<std::jthread> producers;
+        for (size_t i = 0; i < kProducers; i++) {
+            producers.emplace_back([&, i] { produce(channel, i, kItems); });
+        }
+
+        std::vector<size_t> next(kProducers, 0);
+        size_t total = 0;
+
+        std::array<size_t, 16> items;
+        while (total < kItems * kProducers) {
+            size_t got = channel.popBatch(items.data(), items.size(), 1s);
+            if (!SM_CHECK(got > 0)) break;
+
+            for (size_t i = 0; i < got; i++) {
+                size_t producer = items[i] >> kProducerShift;
+                size_t sequence = items[i] & kSequenceMask;
+
+                SM_CHECK(producer < kProducers);
+                SM_CHECK(sequence == next[producer]);
+                next[producer] = sequence + 1;
+            }
+
+            total += got;
+        }
+
+        for (std::jthread& producer : producers) {
+            producer.join();
+        }
+
+        for (size_t count : next) {
+            SM_CHECK(count == kItems);
+        }
+
+        SM_CHECK(channel.getStats().pushed == kItems * kProducers);
+        SM_CHECK(channel.getStats().popped == kItems * kProducers);
+    }
+
+    void testFail() {
+        SpscChannel<size_t> channel{"test.fail", 4, eFail};
+        SM_CHECK(channel.getCapacity() == 4);
+
+        for (size_t i = 0; i < 4; i++) {
+            SM_CHECK(channel.push(size_t(i)));
+        }
+
+        // a full channel rejects new items and keeps the old ones
+        SM_CHECK(!channel.push(4));
+        SM_CHECK(!channel.tryPush(5));
+
+        size_t item = 0;
+        SM_CHECK(channel.tryPop(item) && item == 0);
+
+        // a batch only gets in as far as there is room
+        std::array<size_t, 3> batch = { 10, 11, 12 };
+        SM_CHECK(channel.pushBatch(batch.data(), batch.size()) == 1);
+
+        std::array<size_t, 8> items;
+        SM_CHECK(channel.popBatch(items.data(), items.size()) == 4);
+        SM_CHECK(items[0] == 1 && items[1] == 2 && items[2] == 3 && items[3] == 10);
+
+        ChannelStats stats = channel.getStats();
+        SM_CHECK(stats.pushed == 5);
+        SM_CHECK(stats.failed == 4);
+        SM_CHECK(stats.dropped == 0);
+    }
+
+    void testDropOldest() {
+        MpscChannel<size_t> channel{"test.drop", 4, eDropOldest};
+
+        for (size_t i = 0; i < 10; i++) {
+            SM_CHECK(channel.push(size_t(i)));
+        }
+
+        std::array<size_t, 8> items;
+        SM_CHECK(channel.popBatch(items.data(), items.size()) == 4);
+        SM_CHECK(items[0] == 6 && items[1] == 7 && items[2] == 8 && items[3] == 9);
+
+        ChannelStats stats = channel.getStats();
+        SM_CHECK(stats.pushed == 10);
+        SM_CHECK(stats.dropped == 6);
+        SM_CHECK(stats.failed == 0);
+    }
+
+    void testBlock() {
+        SpscChannel<size_t> channel{"test.block", 4, eBlock};
+        for (size_t i = 0; i < 4; i++) {
+            channel.push(size_t(i));
+        }
+
+        std::atomic_bool bPushed = false;
+        std::jthread producer([&] {
+            channel.push(4);
+            bPushed.store(true);
+        });
+
+        // give the producer time to run out of spins and go to sleep
+        std::this_thread::sleep_for(50ms);
+        SM_CHECK(!bPushed.load());
+
+        size_t item = 0;
+        SM_CHECK(channel.tryPop(item) && item == 0);
+        producer.join();
+
+        SM_CHECK(bPushed.load());
+        for (size_t i = 1; i <= 4; i++) {
+            SM_CHECK(channel.tryPop(item) && item == i);
+        }
+
+        ChannelStats stats = channel.getStats();
+        SM_CHECK(stats.blocked >= 1);
+        SM_CHECK(stats.dropped == 0);
+        SM_CHECK(stats.failed == 0);
+    }
+
+    // producers pop the head to make room while the consumer is popping it too,
+    // every item must come out at most once and in order, and the counts must add up
+    void testDropRace() {
+        MpscChannel<size_t> channel{"test.drop.race", 8, eDropOldest};
+
+        std::atomic_bool bDone = false;
+        std::vector<std::jthread> producers;
+        for (size_t i = 0; i < kProducers; i++) {
+            producers.emplace_back([&, i] { produce(channel, i, kItems); });
+        }
+
+        std::vector<size_t> next(kProducers, 0);
+        size_t popped = 0;
+
+        auto check = [&](size_t item) {
+            size_t producer = item >> kProducerShift;
+            size_t sequence = item & kSequenceMask;
+            if (!SM_CHECK(producer < kProducers)) return;
+
+            // dropped items leave gaps, but nothing repeats or goes backwards
+            SM_CHECK(sequence >= next[producer]);
+            next[producer] = sequence + 1;
+            popped += 1;
+        };
+
+        std::jthread stopper([&] {
+            for (std::jthread& producer : producers) {
+                producer.join();
+            }
+
+            bDone.store(true);
+        });
+
+        size_t item = 0;
+        while (!bDone.load()) {
+            if (channel.tryPop(item)) {
+                check(item);
+            }
+        }
+
+        stopper.join();
+        while (channel.tryPop(item)) {
+            check(item);
+        }
+
+        ChannelStats stats = channel.getStats();
+        SM_CHECK(stats.pushed == kItems * kProducers);
+        SM_CHECK(stats.popped == popped);
+        SM_CHECK(stats.popped + stats.dropped == stats.pushed);
+        SM_CHECK(stats.failed == 0);
+    }
+
+    void testPopTimeout() {
+        SpscChannel<size_t> channel{"test.timeout", 16};
+        std::array<size_t, 8> items;
+
+        // an empty channel waits out the whole timeout
+        auto start = TestClock::now();
+        SM_CHECK(channel.popBatch(items.data(), items.size(), 20ms) == 0);
+        SM_CHECK(TestClock::now() - start >= 20ms);
+        SM_CHECK(channel.getStats().waits == 1);
+
+        // a push wakes the consumer long before the timeout
+        std::jthread producer([&] {
+            std::this_thread::sleep_for(20ms);
+            channel.push(42);
+        });
+
+        start = TestClock::now();
+        SM_CHECK(channel.popBatch(items.data(), items.size(), 10s) == 1);
+        SM_CHECK(TestClock::now() - start < 5s);
+        SM_CHECK(items[0] == 42);
+
+        // items already queued dont wait at all
+        channel.push(1);
+        channel.push(2);
+        SM_CHECK(channel.popBatch(items.data(), items.size(), 10s) == 2);
+        SM_CHECK(channel.getStats().waits == 2);
+    }
+
+    // whatever is still queued is destroyed with the channel
+    void testDestroy() {
+        auto pShared = std::make_shared<int>(0);
+        {
+            SpscChannel<std::shared_ptr<int>> channel{"test.destroy", 8};
+            for (size_t i = 0; i < 5; i++) {
+                channel.push(std::shared_ptr<int>(pShared));
+            }
+
+            SM_CHECK(pShared.use_count() == 6);
+        }
+
+        SM_CHECK(pShared.use_count() == 1);
+    }
+}
+
+int main() {
+    testSpscOrder();
+    testMpscOrder();
+    testFail();
+    testDropOldest();
+    testBlock();
+    testDropRace();
+    testPopTimeout();
+    testDestroy();
+
+    return test::finish("channel");
+}
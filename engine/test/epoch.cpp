@@ -0,0 +1,235 @@
+#include "test.h"
+
+#include "engine/threads/epoch.h"
+#include "engine/threads/service.h"
+#include "engine/service/service.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace simcoe;
+using namespace simcoe::mt;
+using namespace simcoe::threads;
+
+// readers race a writer that keeps swapping out and retiring the object they read.
+// retired objects are only marked dead rather than freed, so a reader that
+// sees a dead object caught a reclamation that happened under its guard.
+
+namespace {
+    constexpr size_t kReaders = 8;
+    constexpr size_t kWrites = 20000;
+
+    struct Node {
+        std::atomic_bool bAlive = true;
+        size_t value = 0;
+        size_t check = 0;
+    };
+
+    struct Shared {
+        Shared(size_t writes)
+            : nodes(writes + 1)
+        {
+            for (size_t i = 0; i < nodes.size(); i++) {
+                nodes[i].value = i;
+                nodes[i].check = ~i;
+            }
+
+            pCurrent.store(&nodes[0]);
+        }
+
+        // every node outlives the test, reclaiming one only marks it dead
+        std::vector<Node> nodes;
+        std::atomic<Node*> pCurrent;
+
+        std::atomic_size_t retired = 0;
+        std::atomic_size_t reclaimed = 0;
+        std::atomic_size_t violations = 0;
+        std::atomic_size_t reads = 0;
+    };
+
+    void readLoop(Epoch& epoch, Shared& shared, std::stop_token token) {
+        while (!token.stop_requested()) {
+            EpochGuard guard(epoch);
+            Node *pNode = shared.pCurrent.load();
+
+            // the node must stay alive for as long as the guard is held
+            for (size_t i = 0; i < 16; i++) {
+                if (!pNode->bAlive.load() || pNode->check != ~pNode->value) {
+                    shared.violations += 1;
+                    break;
+                }
+            }
+
+            shared.reads += 1;
+        }
+    }
+
+    void retireNode(Epoch& epoch, Shared& shared, Node *pOld) {
+        shared.retired += 1;
+        epoch.retire([&shared, pOld] {
+            pOld->bAlive.store(false);
+            shared.reclaimed += 1;
+        });
+    }
+
+    // more readers than slots so enter also has to wait for a free slot
+    void testConcurrentReaders(size_t maxReaders) {
+        Epoch epoch{"test.epoch", maxReaders};
+        Shared shared{kWrites};
+
+        std::vector<std::jthread> readers;
+        for (size_t i = 0; i < kReaders; i++) {
+            readers.emplace_back([&](std::stop_token token) { readLoop(epoch, shared, token); });
+        }
+
+        // a second thread collects on its own to race the retiring thread
+        std::jthread collector([&](std::stop_token token) {
+            while (!token.stop_requested()) {
+                epoch.collect();
+                std::this_thread::yield();
+            }
+        });
+
+        for (size_t i = 1; i <= kWrites; i++) {
+            Node *pOld = shared.pCurrent.exchange(&shared.nodes[i]);
+            retireNode(epoch, shared, pOld);
+        }
+
+        collector.request_stop();
+        collector.join();
+
+        for (std::jthread& reader : readers) {
+            reader.request_stop();
+            reader.join();
+        }
+
+        epoch.synchronize();
+
+        EpochStats stats = epoch.getStats();
+        SM_CHECK(shared.violations == 0);
+        SM_CHECK(shared.reads > 0);
+        SM_CHECK(shared.retired == kWrites);
+        SM_CHECK(shared.reclaimed == kWrites);
+        SM_CHECK(stats.reclaimed == kWrites);
+        SM_CHECK(stats.pending == 0);
+        SM_CHECK(stats.readers == 0);
+
+        // the node still published was never retired
+        SM_CHECK(shared.pCurrent.load()->bAlive);
+    }
+
+    // a pinned reader holds back reclamation no matter how often collect is called
+    void testPinnedReader() {
+        Epoch epoch{"test.epoch.pinned"};
+        Shared shared{1};
+
+        std::atomic_bool bPinned = false;
+        std::atomic_bool bRelease = false;
+
+        std::jthread reader([&] {
+            EpochGuard guard(epoch);
+            Node *pNode = shared.pCurrent.load();
+
+            bPinned.store(true);
+            bPinned.notify_one();
+            bRelease.wait(false);
+
+            SM_CHECK(pNode->bAlive);
+        });
+
+        bPinned.wait(false);
+
+        Node *pOld = shared.pCurrent.exchange(&shared.nodes[1]);
+        retireNode(epoch, shared, pOld);
+
+        for (size_t i = 0; i < 16; i++) {
+            epoch.collect();
+        }
+
+        SM_CHECK(pOld->bAlive);
+        SM_CHECK(epoch.getStats().pending == 1);
+        SM_CHECK(epoch.getStats().readers == 1);
+
+        bRelease.store(true);
+        bRelease.notify_one();
+        reader.join();
+
+        epoch.synchronize();
+        SM_CHECK(!pOld->bAlive);
+        SM_CHECK(epoch.getStats().pending == 0);
+    }
+
+    // deleters run outside the retire lock and may retire more objects
+    void testNestedRetire() {
+        Epoch epoch{"test.epoch.nested"};
+        size_t freed = 0;
+
+        epoch.retire([&] {
+            freed += 1;
+            epoch.retire([&] { freed += 1; });
+        });
+
+        epoch.synchronize();
+        SM_CHECK(freed == 2);
+        SM_CHECK(epoch.getStats().reclaimed == 2);
+    }
+
+    // the worker pool grows and shrinks under readers walking the published thread list,
+    // stopped handles are retired through the epoch so a reader never sees a freed one
+    void testWorkerResize() {
+        ServiceRuntime runtime{{}};
+
+        std::atomic_size_t reads = 0;
+        std::atomic_size_t violations = 0;
+
+        std::vector<std::jthread> readers;
+        for (size_t i = 0; i < kReaders; i++) {
+            readers.emplace_back([&](std::stop_token token) {
+                while (!token.stop_requested()) {
+                    ThreadView view = ThreadService::getThreads();
+                    for (ThreadHandle *pHandle : view) {
+                        if (pHandle->getName().empty() || pHandle->getType() >= eCount) {
+                            violations += 1;
+                        }
+                    }
+
+                    reads += 1;
+                }
+            });
+        }
+
+        // the pool has a worker slot per subcore unless its configured otherwise
+        size_t most = std::min<size_t>(4, ThreadService::getGeometry().subcores.size());
+        for (size_t i = 0; i < 200; i++) {
+            ThreadService::setWorkerCount(1 + (i % most));
+        }
+
+        for (std::jthread& reader : readers) {
+            reader.request_stop();
+            reader.join();
+        }
+
+        // the scaler may still be resizing, but never while the pool lock is held
+        mt::ReadLock lock(ThreadService::getPoolLock());
+
+        size_t workers = 0;
+        for (ThreadHandle *pHandle : ThreadService::getThreads()) {
+            workers += pHandle->getType() == eWorker;
+        }
+
+        SM_CHECK(violations == 0);
+        SM_CHECK(reads > 0);
+        SM_CHECK(workers == ThreadService::getWorkerCount());
+    }
+}
+
+int main() {
+    testConcurrentReaders(Epoch::kDefaultReaders);
+    testConcurrentReaders(kReaders / 2);
+    testPinnedReader();
+    testNestedRetire();
+    testWorkerResize();
+
+    return test::finish("epoch");
+}
@@ -0,0 +1,59 @@
+#include "test.h"
+
+#include "engine/threads/queue.h"
+
+#include <thread>
+#include <vector>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+// budgeted drains of the main thread queue
+
+namespace {
+    using namespace std::chrono_literals;
+
+    // every message outlasts the budget on its own, so each drain runs exactly one
+    void testBudget() {
+        WorkQueue queue{64};
+        std::vector<size_t> order;
+
+        for (size_t i = 0; i < 40; i++) {
+            queue.add("test", [&order, i] {
+                std::this_thread::sleep_for(1ms);
+                order.push_back(i);
+            });
+        }
+
+        SM_CHECK(queue.drain(100us) == 1);
+        SM_CHECK(queue.drain(0us) == 1);
+        SM_CHECK(queue.getStats().overBudget == 2);
+
+        // whatever was left in the batch runs before anything still queued
+        SM_CHECK(queue.tryGetMessage());
+        SM_CHECK(queue.drain(10s) == 37);
+        SM_CHECK(queue.drain(10s) == 0);
+
+        SM_CHECK(order.size() == 40);
+        for (size_t i = 0; i < order.size(); i++) {
+            if (!SM_CHECK(order[i] == i)) break;
+        }
+
+        SM_CHECK(queue.getStats().executed == 40);
+        SM_CHECK(queue.getStats().overBudget == 2);
+    }
+
+    void testEmpty() {
+        WorkQueue queue{64};
+        SM_CHECK(queue.drain(0us) == 0);
+        SM_CHECK(!queue.tryGetMessage());
+        SM_CHECK(queue.getStats().overBudget == 0);
+    }
+}
+
+int main() {
+    testBudget();
+    testEmpty();
+
+    return test::finish("queue");
+}
@@ -0,0 +1,189 @@
+#include "test.h"
+
+#include "engine/threads/scaler.h"
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+// the worker scaler fed synthetic pool samples, one update per tick
+
+namespace {
+    using namespace std::chrono_literals;
+
+    enum Load {
+        eHot, // jobs pile up and nobody sleeps
+        eCold, // a worker is parked with nothing to do
+        eSteady // everyone is busy but keeping up
+    };
+
+    // a pool that resizes to whatever the scaler asks for
+    struct SimPool {
+        SimPool(const ScalerConfig& config, size_t workers)
+            : scaler(config)
+        {
+            sample.workers = workers;
+        }
+
+        size_t tick(Load load) {
+            sample.executed += 100;
+            sample.latency += 100 * 10us;
+            sample.pending = (load == eHot) ? sample.workers * 4 : 0;
+            sample.sleeping = (load == eCold) ? 1 : 0;
+
+            sample.workers = scaler.update(sample);
+            return sample.workers;
+        }
+
+        WorkerScaler scaler;
+        ScalerSample sample;
+    };
+
+    ScalerConfig makeConfig() {
+        return {
+            .minWorkers = 2,
+            .maxWorkers = 6,
+            .growLatency = 1ms,
+            .growTicks = 3,
+            .shrinkTicks = 10,
+            .cooldownTicks = 4
+        };
+    }
+
+    void testGrow() {
+        SimPool pool{makeConfig(), 2};
+
+        SM_CHECK(pool.tick(eHot) == 2);
+        SM_CHECK(pool.tick(eHot) == 2);
+        SM_CHECK(pool.tick(eHot) == 3);
+
+        // a quiet tick resets the count
+        for (size_t i = 0; i < 4; i++) pool.tick(eSteady);
+        SM_CHECK(pool.tick(eHot) == 3);
+        SM_CHECK(pool.tick(eHot) == 3);
+        SM_CHECK(pool.tick(eSteady) == 3);
+        SM_CHECK(pool.tick(eHot) == 3);
+        SM_CHECK(pool.tick(eHot) == 3);
+        SM_CHECK(pool.tick(eHot) == 4);
+
+        SM_CHECK(pool.scaler.getStats().grown == 2);
+        SM_CHECK(pool.scaler.getStats().shrunk == 0);
+    }
+
+    // slow jobs count as pressure even when the queues look short
+    void testGrowOnLatency() {
+        SimPool pool{makeConfig(), 2};
+
+        for (size_t i = 0; i < 3; i++) {
+            pool.sample.latency += 100 * 5ms;
+            pool.tick(eSteady);
+        }
+
+        SM_CHECK(pool.sample.workers == 3);
+        SM_CHECK(pool.scaler.getStats().lastLatency >= 1ms);
+    }
+
+    void testShrink() {
+        SimPool pool{makeConfig(), 5};
+
+        for (size_t i = 1; i < 10; i++) {
+            if (!SM_CHECK(pool.tick(eCold) == 5)) break;
+        }
+
+        SM_CHECK(pool.tick(eCold) == 4);
+        SM_CHECK(pool.scaler.getStats().shrunk == 1);
+    }
+
+    // after a change nothing moves for cooldownTicks, whatever the load
+    void testCooldown() {
+        ScalerConfig config = makeConfig();
+        config.growTicks = 1;
+        config.shrinkTicks = 1;
+
+        SimPool pool{config, 3};
+        SM_CHECK(pool.tick(eHot) == 4);
+
+        for (size_t i = 0; i < config.cooldownTicks; i++) {
+            if (!SM_CHECK(pool.tick(eCold) == 4)) break;
+        }
+
+        SM_CHECK(pool.tick(eCold) == 3);
+
+        for (size_t i = 0; i < config.cooldownTicks; i++) {
+            if (!SM_CHECK(pool.tick(eHot) == 3)) break;
+        }
+
+        SM_CHECK(pool.tick(eHot) == 4);
+    }
+
+    // load that swings back and forth faster than growTicks never changes the count
+    void testNoFlapping() {
+        SimPool pool{makeConfig(), 4};
+
+        for (size_t i = 0; i < 200; i++) {
+            Load load = (i % 4 < 2) ? eHot : eCold;
+            if (!SM_CHECK(pool.tick(load) == 4)) break;
+        }
+
+        ScalerStats stats = pool.scaler.getStats();
+        SM_CHECK(stats.grown == 0);
+        SM_CHECK(stats.shrunk == 0);
+        SM_CHECK(stats.history.size() == 200);
+    }
+
+    void testClamp() {
+        ScalerConfig config = makeConfig();
+        config.growTicks = 1;
+        config.shrinkTicks = 1;
+        config.cooldownTicks = 0;
+
+        // a pool sized outside the limits is pulled back in straight away
+        SimPool over{config, 9};
+        SM_CHECK(over.tick(eSteady) == 6);
+
+        SimPool under{config, 1};
+        SM_CHECK(under.tick(eSteady) == 2);
+
+        // and never pushed past them
+        SimPool hot{config, 2};
+        for (size_t i = 0; i < 20; i++) hot.tick(eHot);
+        SM_CHECK(hot.sample.workers == 6);
+        SM_CHECK(hot.scaler.getStats().grown == 4);
+
+        SimPool cold{config, 6};
+        for (size_t i = 0; i < 20; i++) cold.tick(eCold);
+        SM_CHECK(cold.sample.workers == 2);
+        SM_CHECK(cold.scaler.getStats().shrunk == 4);
+    }
+
+    // the history is a ring of the most recent targets, oldest first
+    void testHistory() {
+        ScalerConfig config = makeConfig();
+        config.growTicks = 1;
+        config.cooldownTicks = 0;
+        config.maxWorkers = 1000;
+
+        SimPool pool{config, 2};
+        for (size_t i = 0; i < WorkerScaler::kHistorySize + 10; i++) {
+            pool.tick(eHot);
+        }
+
+        ScalerStats stats = pool.scaler.getStats();
+        SM_CHECK(stats.history.size() == WorkerScaler::kHistorySize);
+        SM_CHECK(stats.history.back() == pool.sample.workers);
+        for (size_t i = 1; i < stats.history.size(); i++) {
+            if (!SM_CHECK(stats.history[i] == stats.history[i - 1] + 1)) break;
+        }
+    }
+}
+
+int main() {
+    testGrow();
+    testGrowOnLatency();
+    testShrink();
+    testCooldown();
+    testNoFlapping();
+    testClamp();
+    testHistory();
+
+    return test::finish("scaler");
+}
@@ -0,0 +1,252 @@
+#include "test.h"
+
+#include "engine/threads/schedule.h"
+
+#include <set>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+// places threads against made up topologies, no threads are started
+
+namespace {
+    struct TopologyBuilder {
+        Geometry geometry;
+
+        TopologyBuilder() {
+            addPackage();
+        }
+
+        // chiplets added after this go in the new package
+        void addPackage() {
+            geometry.packages.push_back({});
+        }
+
+        ChipletIndex addChiplet() {
+            geometry.chiplets.push_back({});
+            return ChipletIndex(geometry.chiplets.size() - 1);
+        }
+
+        // @param schedule lower is faster, @param efficiency higher is more efficient
+        void addCores(ChipletIndex chiplet, size_t count, uint16_t schedule, uint8_t efficiency, size_t smt) {
+            for (size_t i = 0; i < count; ++i) {
+                auto coreIdx = CoreIndex(geometry.cores.size());
+                Core core = { .schedule = schedule, .efficiency = efficiency, .masks = {}, .subcoreIds = {} };
+
+                for (size_t j = 0; j < smt; ++j) {
+                    auto subcoreIdx = SubcoreIndex(geometry.subcores.size());
+                    geometry.subcores.push_back({ .mask = {} });
+
+                    core.subcoreIds.push_back(subcoreIdx);
+                    geometry.packages.back().subcores.push_back(subcoreIdx);
+                }
+
+                geometry.cores.push_back(core);
+                geometry.chiplets[size_t(chiplet)].coreIds.push_back(coreIdx);
+                geometry.packages.back().cores.push_back(coreIdx);
+            }
+
+            geometry.packages.back().chiplets.push_back(chiplet);
+        }
+
+        CoreIndex getCore(SubcoreIndex subcore) const {
+            for (size_t i = 0; i < geometry.cores.size(); ++i) {
+                for (SubcoreIndex it : geometry.cores[i].subcoreIds) {
+                    if (it == subcore) return CoreIndex(i);
+                }
+            }
+
+            return CoreIndex::eInvalid;
+        }
+
+        PackageIndex getPackage(SubcoreIndex subcore) const {
+            for (size_t i = 0; i < geometry.packages.size(); ++i) {
+                for (SubcoreIndex it : geometry.packages[i].subcores) {
+                    if (it == subcore) return PackageIndex(i);
+                }
+            }
+
+            return PackageIndex::eInvalid;
+        }
+    };
+
+    // a ryzen 9 7950x, two ccds of eight cores with two threads each
+    TopologyBuilder makeDualChiplet() {
+        TopologyBuilder builder;
+        for (size_t i = 0; i < 2; ++i) {
+            builder.addCores(builder.addChiplet(), 8, 0, 0, 2);
+        }
+
+        return builder;
+    }
+
+    // an i9 13900k, eight smt performance cores and sixteen efficiency cores in clusters of four
+    TopologyBuilder makeHybrid() {
+        TopologyBuilder builder;
+        builder.addCores(builder.addChiplet(), 8, 0, 0, 2);
+        for (size_t i = 0; i < 4; ++i) {
+            builder.addCores(builder.addChiplet(), 4, 1, 1, 1);
+        }
+
+        return builder;
+    }
+
+    // a dual socket board, each package has a fast and a slow chiplet of four smt cores.
+    // the second package is slower overall but its fast chiplet beats the first packages slow one,
+    // so ranking chiplets alone would interleave the two packages
+    TopologyBuilder makeDualPackage() {
+        TopologyBuilder builder;
+        builder.addCores(builder.addChiplet(), 4, 0, 0, 2);
+        builder.addCores(builder.addChiplet(), 4, 2, 0, 2);
+
+        builder.addPackage();
+        builder.addCores(builder.addChiplet(), 4, 1, 0, 2);
+        builder.addCores(builder.addChiplet(), 4, 2, 0, 2);
+
+        return builder;
+    }
+
+    // every worker is placed before the realtime thread, like ThreadService startup
+    void testRealtimeAfterWorkers(const TopologyBuilder& builder) {
+        const Geometry& geometry = builder.geometry;
+        Scheduler scheduler{geometry, 1};
+
+        std::set<CoreIndex> workerCores;
+        for (size_t i = 0; i < geometry.cores.size(); ++i) {
+            workerCores.insert(builder.getCore(scheduler.addThread(eWorker, "worker")));
+        }
+
+        SubcoreIndex render = scheduler.addThread(eRealtime, "render");
+        CoreIndex renderCore = builder.getCore(render);
+
+        // the fastest core was held back, and no worker sits on it or its sibling
+        SM_CHECK(renderCore == scheduler.getCoreRanking()[0]);
+        SM_CHECK(scheduler.isReservedCore(renderCore));
+        SM_CHECK(!workerCores.contains(renderCore));
+
+        // responsive threads leave the realtime core alone
+        SubcoreIndex input = scheduler.addThread(eResponsive, "input");
+        SM_CHECK(builder.getCore(input) != renderCore);
+    }
+
+    void testWorkersShareChiplet() {
+        TopologyBuilder builder = makeDualChiplet();
+        Scheduler scheduler{builder.geometry, 1};
+
+        for (size_t i = 0; i < 7; ++i) {
+            scheduler.addThread(eWorker, "worker");
+        }
+
+        SM_CHECK(scheduler.getChipletSpread(eWorker) == 1);
+    }
+
+    void testHybridPlacement() {
+        TopologyBuilder builder = makeHybrid();
+        Scheduler scheduler{builder.geometry, 1};
+
+        // workers go to the efficiency cores first
+        SubcoreIndex worker = scheduler.addThread(eWorker, "worker");
+        SM_CHECK(builder.geometry.getCore(builder.getCore(worker)).efficiency == 1);
+
+        // realtime threads go to a performance core
+        SubcoreIndex render = scheduler.addThread(eRealtime, "render");
+        SM_CHECK(builder.geometry.getCore(builder.getCore(render)).schedule == 0);
+    }
+
+    // every efficiency core gets a worker before any performance core does
+    void testHybridFillsEfficiencyCores() {
+        TopologyBuilder builder = makeHybrid();
+        Scheduler scheduler{builder.geometry};
+
+        for (size_t i = 0; i < 16; ++i) {
+            SubcoreIndex worker = scheduler.addThread(eWorker, "worker");
+            if (!SM_CHECK(builder.geometry.getCore(builder.getCore(worker)).efficiency == 1)) return;
+        }
+
+        // then every performance core thread, before any efficiency core doubles up
+        std::set<SubcoreIndex> performanceThreads;
+        for (size_t i = 0; i < 16; ++i) {
+            SubcoreIndex worker = scheduler.addThread(eWorker, "worker");
+            SM_CHECK(builder.geometry.getCore(builder.getCore(worker)).efficiency == 0);
+            performanceThreads.insert(worker);
+        }
+
+        SM_CHECK(performanceThreads.size() == 16);
+
+        // with every thread busy, the efficiency cores take the next one
+        SubcoreIndex worker = scheduler.addThread(eWorker, "worker");
+        SM_CHECK(builder.geometry.getCore(builder.getCore(worker)).efficiency == 1);
+    }
+
+    // workers fill every hardware thread in one package before crossing to the other
+    void testWorkersSharePackage() {
+        TopologyBuilder builder = makeDualPackage();
+        Scheduler scheduler{builder.geometry, 1};
+
+        std::set<PackageIndex> packages;
+        for (size_t i = 0; i < 16; ++i) {
+            packages.insert(builder.getPackage(scheduler.addThread(eWorker, "worker")));
+        }
+
+        SM_CHECK(packages.size() == 1);
+        SM_CHECK(scheduler.getChipletSpread(eWorker) == 2);
+
+        // they stay off the package holding the fastest core, which was kept for realtime threads
+        PackageIndex fastest = scheduler.getPackageRanking()[0];
+        SM_CHECK(!packages.contains(fastest));
+
+        SubcoreIndex render = scheduler.addThread(eRealtime, "render");
+        SM_CHECK(builder.getPackage(render) == fastest);
+
+        // once its full they cross over rather than doubling up
+        SubcoreIndex worker = scheduler.addThread(eWorker, "worker");
+        SM_CHECK(builder.getPackage(worker) == fastest);
+    }
+
+    void testReleaseRestoresLoad() {
+        TopologyBuilder builder = makeDualChiplet();
+        Scheduler scheduler{builder.geometry, 1};
+
+        SubcoreIndex render = scheduler.addThread(eRealtime, "render");
+        CoreIndex renderCore = builder.getCore(render);
+        SM_CHECK(scheduler.isRealtimeCore(renderCore));
+
+        scheduler.removeThread(eRealtime, render);
+        SM_CHECK(!scheduler.isRealtimeCore(renderCore));
+        SM_CHECK(scheduler.getCoreLoad(renderCore) == 0);
+    }
+
+    // with a single core there is nothing to reserve, everything shares it
+    void testSingleCore() {
+        TopologyBuilder builder;
+        builder.addCores(builder.addChiplet(), 1, 0, 0, 2);
+
+        Scheduler scheduler{builder.geometry, 1};
+        SM_CHECK(!scheduler.isReservedCore(CoreIndex(0)));
+
+        SubcoreIndex worker = scheduler.addThread(eWorker, "worker");
+        SubcoreIndex render = scheduler.addThread(eRealtime, "render");
+        SM_CHECK(worker != SubcoreIndex::eInvalid);
+        SM_CHECK(render != SubcoreIndex::eInvalid);
+    }
+
+    void testEmptyGeometry() {
+        Scheduler scheduler{Geometry{}, 1};
+        SM_CHECK(scheduler.addThread(eWorker, "worker") == SubcoreIndex::eInvalid);
+    }
+}
+
+int main() {
+    testRealtimeAfterWorkers(makeDualChiplet());
+    testRealtimeAfterWorkers(makeHybrid());
+    testWorkersShareChiplet();
+    testHybridPlacement();
+    testHybridFillsEfficiencyCores();
+    testRealtimeAfterWorkers(makeDualPackage());
+    testWorkersSharePackage();
+    testReleaseRestoresLoad();
+    testSingleCore();
+    testEmptyGeometry();
+
+    return test::finish("scheduler");
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdio>
+
+// just enough to write checks with, a test exits nonzero if any of its checks failed
+namespace simcoe::test {
+    inline int gFailures = 0;
+
+    inline bool check(bool bPassed, const char *pzExpr, const char *pzFile, int line) {
+        if (!bPassed) {
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", pzFile, line, pzExpr);
+            gFailures += 1;
+        }
+
+        return bPassed;
+    }
+
+    inline int finish(const char *pzName) {
+        if (gFailures > 0) {
+            std::fprintf(stderr, "%s: %d checks failed\n", pzName, gFailures);
+            return 1;
+        }
+
+        std::printf("%s: passed\n", pzName);
+        return 0;
+    }
+}
+
+#define SM_CHECK(EXPR) simcoe::test::check(bool(EXPR), #EXPR, __FILE__, __LINE__)
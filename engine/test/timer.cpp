@@ -0,0 +1,137 @@
+#include "test.h"
+
+#include "engine/threads/pool.h"
+#include "engine/threads/timer.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace simcoe;
+using namespace simcoe::threads;
+
+// drives a timer wheel by hand and checks every timer fires on exactly the tick it is due.
+// no workers run, a one shot timer stops being active as soon as it is dispatched
+
+namespace {
+    using namespace std::chrono_literals;
+
+    constexpr TimerClock::duration kResolution = 1ms;
+    constexpr TimerClock::time_point kStart = {};
+
+    // 64 slots per level, so each level starts at a power of 64
+    constexpr uint64_t kLevel1 = 64;
+    constexpr uint64_t kLevel2 = 64 * 64;
+    constexpr uint64_t kLevel3 = 64 * 64 * 64;
+    constexpr uint64_t kBeyond = 64 * 64 * 64 * 64;
+
+    TimerClock::time_point atTick(uint64_t tick) {
+        return kStart + kResolution * tick;
+    }
+
+    struct Timer {
+        uint64_t tick;
+        TimerHandle handle;
+    };
+
+    // poll up to the tick before each timer is due, then the tick its due
+    void checkTimers(TimerWheel& wheel, std::vector<Timer>& timers) {
+        std::sort(timers.begin(), timers.end(), [](const Timer& a, const Timer& b) { return a.tick < b.tick; });
+
+        for (Timer& timer : timers) {
+            wheel.poll(atTick(timer.tick - 1));
+            if (!SM_CHECK(timer.handle.isActive())) {
+                std::fprintf(stderr, "timer due on tick %llu fired early\n", (unsigned long long)timer.tick);
+            }
+
+            wheel.poll(atTick(timer.tick));
+            if (!SM_CHECK(!timer.handle.isActive())) {
+                std::fprintf(stderr, "timer due on tick %llu fired late\n", (unsigned long long)timer.tick);
+            }
+        }
+
+        SM_CHECK(wheel.getStats().active == 0);
+        SM_CHECK(wheel.getStats().fired == timers.size());
+    }
+
+    // timers added at the start land on, either side of, and past every level boundary
+    void testBoundaries() {
+        WorkPool pool{1, 64, 0, 1s};
+        TimerWheel wheel{pool, kResolution, kStart};
+
+        std::vector<Timer> timers;
+        for (uint64_t boundary : { kLevel1, kLevel2, kLevel3, kBeyond }) {
+            for (uint64_t tick : { boundary - 1, boundary, boundary + 1, boundary * 2, boundary * 3 - 1 }) {
+                timers.push_back({ tick, wheel.addAt("test", atTick(tick), [] { }) });
+            }
+        }
+
+        timers.push_back({ 1, wheel.addAt("test", atTick(1), [] { }) });
+        checkTimers(wheel, timers);
+
+        SM_CHECK(wheel.getStats().cascades > 0);
+    }
+
+    // timers added partway through, so their boundaries dont line up with when they were added
+    void testBoundariesFromOffset() {
+        WorkPool pool{1, 64, 0, 1s};
+        TimerWheel wheel{pool, kResolution, kStart};
+
+        uint64_t offset = kLevel2 + 37;
+        wheel.poll(atTick(offset));
+
+        std::vector<Timer> timers;
+        for (uint64_t boundary : { kLevel1, kLevel2, kLevel3 }) {
+            uint64_t next = (offset / boundary + 1) * boundary;
+            for (uint64_t tick : { next - 1, next, next + 1, next + boundary }) {
+                timers.push_back({ tick, wheel.addAt("test", atTick(tick), [] { }) });
+            }
+        }
+
+        checkTimers(wheel, timers);
+    }
+
+    // a deadline between ticks rounds up, a deadline in the past fires on the next tick
+    void testRounding() {
+        WorkPool pool{1, 64, 0, 1s};
+        TimerWheel wheel{pool, kResolution, kStart};
+
+        wheel.poll(atTick(10));
+
+        TimerHandle late = wheel.addAt("test", atTick(5), [] { });
+        TimerHandle between = wheel.addAt("test", atTick(kLevel1) - 1us, [] { });
+
+        wheel.poll(atTick(10));
+        SM_CHECK(late.isActive());
+
+        wheel.poll(atTick(11));
+        SM_CHECK(!late.isActive());
+
+        wheel.poll(atTick(kLevel1 - 1));
+        SM_CHECK(between.isActive());
+
+        wheel.poll(atTick(kLevel1));
+        SM_CHECK(!between.isActive());
+    }
+
+    void testCancel() {
+        WorkPool pool{1, 64, 0, 1s};
+        TimerWheel wheel{pool, kResolution, kStart};
+
+        TimerHandle handle = wheel.addAt("test", atTick(kLevel1), [] { });
+        handle.cancel();
+        SM_CHECK(!handle.isActive());
+
+        wheel.poll(atTick(kLevel1));
+        SM_CHECK(wheel.getStats().fired == 0);
+        SM_CHECK(wheel.getStats().active == 0);
+    }
+}
+
+int main() {
+    testBoundaries();
+    testBoundariesFromOffset();
+    testRounding();
+    testCancel();
+
+    return test::finish("timer");
+}